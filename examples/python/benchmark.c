@@ -0,0 +1,49 @@
+// program for benchmark.py, keeps the core busy with RAM and register access
+#include <stdint.h>
+#include <avr/interrupt.h>
+
+#define BUFSIZE 128
+
+volatile uint16_t crc;
+volatile uint16_t timer2_ticks;
+uint8_t buffer[BUFSIZE];
+
+ISR(TIMER2_COMP_vect) {
+  timer2_ticks++;
+}
+
+static uint16_t crc16_update(uint16_t c, uint8_t a) {
+  c ^= a;
+  for(uint8_t i = 0; i < 8; i++) {
+    if(c & 1)
+      c = (c >> 1) ^ 0xa001;
+    else
+      c = c >> 1;
+  }
+  return c;
+}
+
+int main(void) {
+  uint8_t seed = 1;
+
+  /* Timer 2 by CLK/64, ~2ms on 4MHz */
+  TCNT2 = 0;
+  OCR2 = 124;
+  TCCR2 = 0x0b;
+  TIMSK = _BV(OCIE2);
+
+  sei();
+
+  while(1) {
+    for(uint8_t i = 0; i < BUFSIZE; i++) {
+      seed = seed * 13 + 7;
+      buffer[i] = seed;
+    }
+    uint16_t c = 0xffff;
+    for(uint8_t i = 0; i < BUFSIZE; i++)
+      c = crc16_update(c, buffer[i]);
+    crc = c;
+  }
+
+  return 0;
+}
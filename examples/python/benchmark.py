@@ -0,0 +1,45 @@
+# -*- coding: utf-8 -*-
+# Python script to compare simulation speed with and without instruction trace
+from sys import argv
+from time import time
+
+import pysimulavr
+from ex_utils import SimulavrAdapter
+
+class Benchmark(SimulavrAdapter):
+
+  # simulated time for one run, 200ms
+  RUNTIME = 200000000
+
+  def run(self, proc, elffile, traced, **options):
+    dev = self.loadDevice(proc, elffile)
+    for k, v in list(options.items()): setattr(dev, k, v)
+    dev.trace_on = 1 if traced else 0
+    sc = pysimulavr.SystemClock.Instance()
+    t = time()
+    sc.RunTimeRange(self.RUNTIME)
+    t = time() - t
+    dev.trace_on = 0
+    return t
+
+if __name__ == "__main__":
+
+  proc, elffile = argv[1].split(":")
+
+  # trace output isn't of interest here, but it has to be written
+  pysimulavr.cvar.sysConHandler.SetTraceFile("/dev/null")
+
+  b = Benchmark()
+  clk = b.DEFAULT_CLOCK_SETTING
+  cycles = b.RUNTIME / clk
+  modes = (("untraced", False, {}),
+           ("untraced, threaded dispatch", False, {"threadedDispatch": True}),
+           ("untraced, block dispatch", False, {"blockDispatch": True}),
+           ("traced", True, {}))
+  base = None
+  for name, traced, options in modes:
+    t = b.run(proc, elffile, traced, **options)
+    if base is None: base = t
+    print("%-30s %8.3f s  %12.0f cycles/s  %6.2fx" % (name, t, cycles / t, base / t))
+
+# EOF
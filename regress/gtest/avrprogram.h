@@ -0,0 +1,100 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef AVRPROGRAM
+#define AVRPROGRAM
+
+#include <vector>
+
+#include "avrdevice.h"
+#include "flash.h"
+
+//! Assembles a small AVR program, so that tests can run without avr cross compiler
+/*! Every method appends one instruction, addresses are flash word addresses.
+  Jumps to a label before the current position take the label from Here(). */
+class AvrProgram {
+
+    public:
+        std::vector<word> code; //!< assembled program
+
+        //! Flash word address of the next instruction
+        unsigned int Here(void) const { return code.size(); }
+        //! Fills with nop up to word address addr
+        void Org(unsigned int addr) { while(code.size() < addr) code.push_back(0); }
+        //! Writes the program to flash of dev and resets dev
+        void Load(AvrDevice *dev) const {
+            std::vector<unsigned char> bytes;
+            for(size_t i = 0; i < code.size(); i++) {
+                bytes.push_back(code[i] & 0xff);
+                bytes.push_back(code[i] >> 8);
+            }
+            dev->Flash->WriteMem(&bytes[0], 0, bytes.size());
+            dev->Reset();
+        }
+
+        void Nop(void) { Emit(0x0000); }
+        void Sei(void) { Emit(0x9478); }
+        void Cli(void) { Emit(0x94f8); }
+        void Ret(void) { Emit(0x9508); }
+        void Reti(void) { Emit(0x9518); }
+        void Wdr(void) { Emit(0x95a8); }
+        void Spm(void) { Emit(0x95e8); }
+        void Ldi(int d, int k) { Emit(0xe000 | ((k & 0xf0) << 4) | ((d - 16) << 4) | (k & 0x0f)); }
+        void Andi(int d, int k) { Emit(0x7000 | ((k & 0xf0) << 4) | ((d - 16) << 4) | (k & 0x0f)); }
+        void Ori(int d, int k) { Emit(0x6000 | ((k & 0xf0) << 4) | ((d - 16) << 4) | (k & 0x0f)); }
+        void Cpi(int d, int k) { Emit(0x3000 | ((k & 0xf0) << 4) | ((d - 16) << 4) | (k & 0x0f)); }
+        void Mov(int d, int r) { Emit(0x2c00 | ((r & 0x10) << 5) | (d << 4) | (r & 0x0f)); }
+        void Inc(int d) { Emit(0x9403 | (d << 4)); }
+        void Dec(int d) { Emit(0x940a | (d << 4)); }
+        void Push(int r) { Emit(0x920f | (r << 4)); }
+        void Pop(int d) { Emit(0x900f | (d << 4)); }
+        //! st X+, r
+        void StX(int r) { Emit(0x920d | (r << 4)); }
+        void In(int d, int a) { Emit(0xb000 | ((a & 0x30) << 5) | (d << 4) | (a & 0x0f)); }
+        void Out(int a, int r) { Emit(0xb800 | ((a & 0x30) << 5) | (r << 4) | (a & 0x0f)); }
+        void Lds(int d, unsigned int k) { Emit(0x9000 | (d << 4)); Emit(k); }
+        void Sts(unsigned int k, int r) { Emit(0x9200 | (r << 4)); Emit(k); }
+        void Sbrs(int r, int b) { Emit(0xfe00 | (r << 4) | b); }
+        void Sbrc(int r, int b) { Emit(0xfc00 | (r << 4) | b); }
+        void Jmp(unsigned int k) { Emit(0x940c | ((k >> 13) & 0x1f0) | ((k >> 16) & 1)); Emit(k & 0xffff); }
+        void Call(unsigned int k) { Emit(0x940e | ((k >> 13) & 0x1f0) | ((k >> 16) & 1)); Emit(k & 0xffff); }
+        void Rjmp(unsigned int k) { Emit(0xc000 | ((k - Here() - 1) & 0x0fff)); }
+        void Rcall(unsigned int k) { Emit(0xd000 | ((k - Here() - 1) & 0x0fff)); }
+        void Brne(unsigned int k) { Emit(0xf401 | (((k - Here() - 1) & 0x7f) << 3)); }
+        void Breq(unsigned int k) { Emit(0xf001 | (((k - Here() - 1) & 0x7f) << 3)); }
+        void Brpl(unsigned int k) { Emit(0xf402 | (((k - Here() - 1) & 0x7f) << 3)); }
+
+        //! Sets stack pointer to a, uses r16
+        void InitStack(unsigned int a) { Ldi(16, a & 0xff); Out(0x3d, 16); Ldi(16, a >> 8); Out(0x3e, 16); }
+        //! Sets X to a, wraps of X are done by WrapX
+        void InitX(unsigned int a) { Ldi(26, a & 0xff); Ldi(27, a >> 8); }
+        //! Keeps X in 0x200 till 0x3ff
+        void WrapX(void) { Andi(27, 0x03); Ori(27, 0x02); }
+
+    private:
+        void Emit(unsigned int w) { code.push_back(w); }
+};
+
+#endif
@@ -0,0 +1,265 @@
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "simulationcontext.h"
+#include "systemclock.h"
+#include "net.h"
+
+#include "avrprogram.h"
+
+// Idle hardware isn't stepped on every cycle, it catches up by SkipCpuCycles.
+// The results have to be the same as with stepping every cycle (hwSkip off),
+// also if the core runs basic blocks and skips idle loops.
+
+enum RunMode { STEP_ALL, SKIP_HW, SKIP_ALL };
+
+// runs prog with 4MHz for time ns, returns registers, RAM, PC and the flash
+// word at byte address 0x2000, TXD and RXD of the first UART are connected
+static vector<int> RunProgram(const char *device, const AvrProgram &prog, RunMode mode, SystemClockOffset time) {
+    SimulationContext context;
+    context.Activate();
+    AvrDevice *dev = AvrFactory::instance().makeDevice(device);
+    prog.Load(dev);
+    dev->SetClockFreq(250);
+    dev->hwSkip = (mode != STEP_ALL);
+    if(mode == SKIP_ALL) {
+        dev->threadedDispatch = true;
+        dev->blockDispatch = true;
+        dev->idleSkip = true;
+    }
+    vector<int> state;
+    {
+        bool mega8 = string(device) == "atmega8";
+        Net net;
+        net.Add(dev->GetPin(mega8 ? "D0" : "E0"));
+        net.Add(dev->GetPin(mega8 ? "D1" : "E1"));
+
+        context.GetSystemClock().Add(dev);
+        context.GetSystemClock().Run(time);
+
+        unsigned int ramStart = dev->GetMemRegisterSize() + dev->GetMemIOSize();
+        for(unsigned int a = 0; a < 32; a++)
+            state.push_back(dev->GetRWMem(a));
+        for(unsigned int a = ramStart; a < ramStart + dev->GetMemIRamSize(); a++)
+            state.push_back(dev->GetRWMem(a));
+        state.push_back(dev->PC);
+        if(dev->Flash->GetSize() > 0x2000)
+            state.push_back(dev->Flash->ReadMemWord(0x2000));
+    }
+    delete dev;
+    SimulationContext::Deactivate();
+    return state;
+}
+
+// returns the results, registers first
+static vector<int> ExpectSameResults(const char *device, const AvrProgram &prog, SystemClockOffset time) {
+    vector<int> all = RunProgram(device, prog, STEP_ALL, time);
+    EXPECT_TRUE(all == RunProgram(device, prog, SKIP_HW, time)) << "results differ with hardware skipping" << endl;
+    EXPECT_TRUE(all == RunProgram(device, prog, SKIP_ALL, time)) << "results differ with hardware skipping and block dispatch" << endl;
+    return all;
+}
+
+static vector<int> ExpectSameResults(const AvrProgram &prog, SystemClockOffset time) {
+    return ExpectSameResults("atmega128", prog, time);
+}
+
+// ISR at addr: increments counter register r
+static void CountIrq(AvrProgram &p, unsigned int addr, int r) {
+    p.Org(addr);
+    p.Push(16);
+    p.In(16, 0x3f);
+    p.Inc(r);
+    p.Out(0x3f, 16);
+    p.Pop(16);
+    p.Reti();
+}
+
+// timer 0 - 3 with overflow interrupts of timer 0 and 1, samples the counters
+static AvrProgram TimerProgram(int tccr0, int tccr1b) {
+    AvrProgram p;
+    p.Jmp(0x60);
+    p.Org(0x1c);
+    p.Jmp(0x50);    // TIMER1 OVF
+    p.Org(0x20);
+    p.Jmp(0x58);    // TIMER0 OVF
+    CountIrq(p, 0x50, 21);
+    CountIrq(p, 0x58, 20);
+
+    p.Org(0x60);
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, tccr0);
+    p.Out(0x33, 16);    // TCCR0
+    p.Out(0x25, 16);    // TCCR2
+    p.Ldi(16, tccr1b);
+    p.Out(0x2e, 16);    // TCCR1B
+    p.Sts(0x8a, 16);    // TCCR3B
+    p.Ldi(16, 0x05);
+    p.Out(0x37, 16);    // TIMSK: TOIE1, TOIE0
+    p.Sei();
+    unsigned int loop = p.Here();
+    p.In(16, 0x32);     // TCNT0
+    p.StX(16);
+    p.In(17, 0x2c);     // TCNT1
+    p.In(18, 0x2d);
+    p.StX(17);
+    p.StX(18);
+    p.In(17, 0x24);     // TCNT2
+    p.StX(17);
+    p.Lds(17, 0x88);    // TCNT3
+    p.Lds(18, 0x89);
+    p.StX(17);
+    p.StX(18);
+    p.In(19, 0x36);     // TIFR
+    p.StX(19);
+    p.StX(20);
+    p.StX(21);
+    p.WrapX();
+    // variable delay, so that the counters are sampled on different cycles
+    p.Mov(25, 16);
+    p.Andi(25, 0x07);
+    unsigned int delay = p.Here();
+    p.Dec(25);
+    p.Brpl(delay);
+    p.Rjmp(loop);
+    return p;
+}
+
+// UART 0 sends a counter, received by loopback, samples UCSR0A and UDR0
+static AvrProgram UartProgram(int ubrr, int ucsra) {
+    AvrProgram p;
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, ucsra);
+    p.Out(0x0b, 16);    // UCSR0A: U2X
+    p.Ldi(16, ubrr);
+    p.Out(0x09, 16);    // UBRR0L
+    p.Ldi(16, 0x18);
+    p.Out(0x0a, 16);    // UCSR0B: RXEN, TXEN
+    unsigned int loop = p.Here();
+    p.In(16, 0x0b);
+    p.StX(16);
+    p.Sbrc(16, 7);      // RXC
+    p.In(17, 0x0c);
+    p.StX(17);
+    p.Inc(21);
+    p.Sbrc(16, 5);      // UDRE
+    p.Out(0x0c, 21);
+    p.WrapX();
+    p.Rjmp(loop);
+    return p;
+}
+
+// ADC in free running mode, samples ADCSRA and the result
+static AvrProgram AdcProgram(int prescaler) {
+    AvrProgram p;
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, 0x40);
+    p.Out(0x07, 16);    // ADMUX: AVCC, channel 0
+    p.Ldi(16, 0xe0 | prescaler);
+    p.Out(0x06, 16);    // ADCSRA: ADEN, ADSC, ADFR
+    unsigned int loop = p.Here();
+    p.In(16, 0x06);
+    p.StX(16);
+    p.In(17, 0x04);     // ADCL
+    p.In(18, 0x05);     // ADCH
+    p.StX(17);
+    p.StX(18);
+    p.WrapX();
+    p.Rjmp(loop);
+    return p;
+}
+
+// watchdog resets the core (atmega8), the resets are counted in RAM
+static AvrProgram WatchdogProgram(int wdtcr) {
+    AvrProgram p;
+    p.InitStack(0x45f);
+    p.Lds(16, 0x100);
+    p.Inc(16);
+    p.Sts(0x100, 16);
+    p.Mov(24, 16);
+    p.In(16, 0x34);     // MCUCSR
+    p.Sts(0x101, 16);
+    p.Ldi(16, 0x08 | wdtcr);
+    p.Out(0x21, 16);    // WDTCR: WDE
+    unsigned int loop = p.Here();
+    p.Inc(20);
+    p.Sts(0x102, 20);
+    p.Rjmp(loop);
+    return p;
+}
+
+// SPM from boot section: page erase, fill, page write, RWW enable, samples SPMCSR
+static AvrProgram FlashProgram(void) {
+    AvrProgram p;
+    p.Jmp(0xf000);
+    p.Org(0xf000);
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, 0x34);
+    p.Mov(0, 16);
+    p.Ldi(16, 0x12);
+    p.Mov(1, 16);
+    int ops[] = { 0x03, 0x01, 0x05, 0x11 };
+    for(int i = 0; i < 4; i++) {
+        p.Ldi(30, 0x00);
+        p.Ldi(31, 0x20);
+        p.Ldi(17, ops[i]);
+        p.Sts(0x68, 17);    // SPMCSR
+        p.Spm();
+        unsigned int wait = p.Here();
+        p.Lds(16, 0x68);
+        p.StX(16);
+        p.Sbrc(16, 0);      // SPMEN
+        p.Rjmp(wait);
+    }
+    unsigned int loop = p.Here();
+    p.Inc(20);
+    p.Rjmp(loop);
+    return p;
+}
+
+TEST( SESSION_HW_SKIP, TIMER )
+{
+    for(int cs = 1; cs <= 7; cs++) {
+        vector<int> res = ExpectSameResults(TimerProgram(cs, (cs % 5) + 1), 4000000);
+        if(cs == 1)
+            EXPECT_LT(0, res[20]) << "no timer 0 overflow" << endl;
+    }
+}
+
+TEST( SESSION_HW_SKIP, UART )
+{
+    int ubrr[] = { 0, 3, 12 };
+    for(int i = 0; i < 3; i++) {
+        vector<int> res = ExpectSameResults(UartProgram(ubrr[i], 0x00), 2000000);
+        EXPECT_NE(0, res[17]) << "nothing received" << endl;
+        ExpectSameResults(UartProgram(ubrr[i], 0x02), 2000000);
+    }
+}
+
+TEST( SESSION_HW_SKIP, ADC )
+{
+    for(int prescaler = 2; prescaler <= 7; prescaler++)
+        ExpectSameResults(AdcProgram(prescaler), 4000000);
+}
+
+TEST( SESSION_HW_SKIP, WATCHDOG )
+{
+    for(int wdp = 0; wdp <= 2; wdp++) {
+        vector<int> res = ExpectSameResults("atmega8", WatchdogProgram(wdp), 100000000);
+        EXPECT_LT(1, res[24]) << "no watchdog reset" << endl;
+    }
+}
+
+TEST( SESSION_HW_SKIP, FLASH_PROGRAMMING )
+{
+    vector<int> res = ExpectSameResults(FlashProgram(), 20000000);
+    EXPECT_EQ(0x1234, res.back()) << "flash page not written" << endl;
+}
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "gtest.h"
+
+#include "pin.h"
+#include "net.h"
+
+// A net resolves the output stages of all pins to one input, which is given
+// to the pins. Only the changed pin gets its input again, if the resolved
+// value doesn't change.
+
+// pin, which records the input from net
+class ProbePin: public Pin {
+
+    public:
+        int inputs; //!< count of SetInState calls
+        T_Pinstate input; //!< state of last input
+
+        ProbePin(T_Pinstate ps): Pin(ps), inputs(0), input(TRISTATE) {}
+        using Pin::operator=;
+
+        void SetInState(const Pin &p) override {
+            inputs++;
+            input = p.outState;
+            Pin::SetInState(p);
+        }
+};
+
+// connects pins with output stages from states (see Pin::operator char) and
+// returns the state of the resolved input
+static char Resolve(const string &states) {
+    vector<ProbePin *> pins;
+    for(size_t i = 0; i < states.size(); i++)
+        pins.push_back(new ProbePin(Pin::TRISTATE));
+    Pin input;
+    {
+        Net net;
+        for(size_t i = 0; i < pins.size(); i++)
+            net.Add(pins[i]);
+        for(size_t i = 0; i < pins.size(); i++)
+            *pins[i] = states[i];
+        input.outState = pins[0]->input;
+        for(size_t i = 1; i < pins.size(); i++)
+            EXPECT_EQ(pins[0]->input, pins[i]->input) << "pins see different inputs" << endl;
+    }
+    for(size_t i = 0; i < pins.size(); i++)
+        delete pins[i];
+    return (char)input;
+}
+
+TEST( SESSION_NET, RESOLVE )
+{
+    // driven
+    EXPECT_EQ('H', Resolve("Ht"));
+    EXPECT_EQ('L', Resolve("tL"));
+    EXPECT_EQ('H', Resolve("Hl"));
+    EXPECT_EQ('L', Resolve("hL"));
+    EXPECT_EQ('S', Resolve("HL"));
+    EXPECT_EQ('S', Resolve("SH"));
+    EXPECT_EQ('S', Resolve("Sh"));
+    EXPECT_EQ('t', Resolve("ttt"));
+
+    // more pull resistors in parallel are stronger, same count is floating
+    EXPECT_EQ('h', Resolve("ht"));
+    EXPECT_EQ('t', Resolve("hl"));
+    EXPECT_EQ('h', Resolve("hhl"));
+    EXPECT_EQ('l', Resolve("lhl"));
+    EXPECT_EQ('t', Resolve("hhll"));
+
+    // a analog pin can only drive the net alone
+    EXPECT_EQ('a', Resolve("at"));
+    EXPECT_EQ('A', Resolve("aH"));
+    EXPECT_EQ('A', Resolve("ah"));
+    EXPECT_EQ('A', Resolve("aa"));
+    EXPECT_EQ('A', Resolve("Sa"));
+    EXPECT_EQ('A', Resolve("At"));
+    EXPECT_EQ('A', Resolve("AH"));
+}
+
+TEST( SESSION_NET, ANALOG_VALUE )
+{
+    ProbePin drive(Pin::TRISTATE), sense(Pin::TRISTATE);
+    Net net;
+    net.Add(&drive);
+    net.Add(&sense);
+    drive = 'a';
+    drive.SetAnalogValue(2.5);
+    EXPECT_EQ(Pin::ANALOG, sense.input);
+    EXPECT_EQ(2.5, sense.GetRawAnalog());
+    drive.SetAnalogValue(1.0);
+    EXPECT_EQ(1.0, sense.GetRawAnalog()) << "new analog value not given to pins" << endl;
+}
+
+TEST( SESSION_NET, PIN_CHANGED )
+{
+    ProbePin a(Pin::TRISTATE), b(Pin::TRISTATE), c(Pin::TRISTATE);
+    Net net;
+    net.Add(&a);
+    net.Add(&b);
+    net.Add(&c);
+
+    a = 'H';
+    EXPECT_EQ(Pin::HIGH, c.input);
+    int before[] = { a.inputs, b.inputs, c.inputs };
+
+    // net stays HIGH: only the changed pin gets its input
+    b = 'h';
+    EXPECT_EQ(before[0], a.inputs) << "pin notified without change" << endl;
+    EXPECT_EQ(before[1] + 1, b.inputs) << "changed pin not notified" << endl;
+    EXPECT_EQ(Pin::HIGH, b.input);
+    EXPECT_EQ(before[2], c.inputs) << "pin notified without change" << endl;
+    b = 'l';
+    EXPECT_EQ(before[0], a.inputs);
+    EXPECT_EQ(before[2], c.inputs);
+
+    // net changes to SHORTED: all pins get the input
+    c = 'L';
+    EXPECT_EQ(before[0] + 1, a.inputs);
+    EXPECT_EQ(before[1] + 3, b.inputs);
+    EXPECT_EQ(before[2] + 1, c.inputs);
+    EXPECT_EQ(Pin::SHORTED, a.input);
+    EXPECT_EQ(Pin::SHORTED, b.input);
+
+    // back to LOW, with pulldown of b
+    a = 't';
+    EXPECT_EQ(Pin::LOW, a.input);
+    EXPECT_EQ(Pin::LOW, b.input);
+    EXPECT_EQ(Pin::LOW, c.input);
+
+    // removed pin doesn't count any more
+    c = 't';
+    EXPECT_EQ(Pin::PULLDOWN, a.input);
+    net.Delete(&b);
+    a = 'h';
+    EXPECT_EQ(Pin::PULLUP, c.input);
+}
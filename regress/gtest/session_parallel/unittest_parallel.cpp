@@ -0,0 +1,197 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "simulationcontext.h"
+#include "systemclock.h"
+#include "net.h"
+
+#include "avrprogram.h"
+
+// Devices, which aren't connected by nets, run in parallel on several
+// threads, if SystemClock::SetParallel is set. Connected devices stay in one
+// group, if the net has no delay. The results have to be the same as with a
+// serial run.
+
+// timer 0 with overflow interrupt, samples the counter
+static AvrProgram TimerProgram(int tccr0) {
+    AvrProgram p;
+    p.Jmp(0x60);
+    p.Org(0x20);
+    p.Jmp(0x50);        // TIMER0 OVF
+    p.Org(0x50);
+    p.Inc(20);
+    p.Reti();
+
+    p.Org(0x60);
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, tccr0);
+    p.Out(0x33, 16);    // TCCR0
+    p.Ldi(16, 0x01);
+    p.Out(0x37, 16);    // TIMSK: TOIE0
+    p.Sei();
+    unsigned int loop = p.Here();
+    p.In(16, 0x32);     // TCNT0
+    p.StX(16);
+    p.StX(20);
+    p.WrapX();
+    p.Rjmp(loop);
+    return p;
+}
+
+// toggles PB0 with a variable delay
+static AvrProgram TogglerProgram(void) {
+    AvrProgram p;
+    p.Ldi(16, 0x01);
+    p.Out(0x17, 16);    // DDRB
+    unsigned int loop = p.Here();
+    p.Inc(18);
+    p.Out(0x18, 18);    // PORTB
+    p.Mov(25, 18);
+    p.Andi(25, 0x0f);
+    unsigned int delay = p.Here();
+    p.Dec(25);
+    p.Brpl(delay);
+    p.Rjmp(loop);
+    return p;
+}
+
+// samples PINB
+static AvrProgram SamplerProgram(void) {
+    AvrProgram p;
+    p.InitX(0x200);
+    unsigned int loop = p.Here();
+    p.In(16, 0x16);     // PINB
+    p.StX(16);
+    p.Inc(20);
+    p.StX(20);
+    p.WrapX();
+    p.Rjmp(loop);
+    return p;
+}
+
+// runs a toggler, which drives PB0 of a sampler over a net with delay, and 3
+// timer devices with threads, returns registers, RAM and PC of all devices
+static vector<int> RunDevices(unsigned int threads, SystemClockOffset window, SystemClockOffset time, SystemClockOffset delay, unsigned int &groups) {
+    SimulationContext context;
+    context.Activate();
+    AvrProgram progs[] = { TogglerProgram(), SamplerProgram(), TimerProgram(1), TimerProgram(2), TimerProgram(3) };
+    int periods[] = { 250, 100, 125, 333, 250 };
+    vector<AvrDevice *> devices;
+    for(int i = 0; i < 5; i++) {
+        AvrDevice *dev = AvrFactory::instance().makeDevice("atmega128");
+        progs[i].Load(dev);
+        dev->SetClockFreq(periods[i]);
+        devices.push_back(dev);
+    }
+    vector<int> state;
+    {
+        Net net;
+        net.Add(devices[0]->GetPin("B0"));
+        net.Add(devices[1]->GetPin("B0"));
+        net.SetDelay(delay);
+
+        SystemClock &clock = context.GetSystemClock();
+        for(size_t i = 0; i < devices.size(); i++)
+            clock.Add(devices[i]);
+        clock.SetParallel(threads, window);
+        clock.Run(time);
+        groups = clock.GetParallelGroups();
+
+        for(size_t i = 0; i < devices.size(); i++) {
+            AvrDevice *dev = devices[i];
+            unsigned int ramStart = dev->GetMemRegisterSize() + dev->GetMemIOSize();
+            for(unsigned int a = 0; a < 32; a++)
+                state.push_back(dev->GetRWMem(a));
+            for(unsigned int a = ramStart; a < ramStart + 0x300; a++)
+                state.push_back(dev->GetRWMem(a));
+            state.push_back(dev->PC);
+        }
+    }
+    // the context deletes the devices
+    SimulationContext::Deactivate();
+    return state;
+}
+
+TEST( SESSION_PARALLEL, SAME_AS_SERIAL )
+{
+    unsigned int groups;
+    vector<int> serial = RunDevices(1, 100000, 2000000, 0, groups);
+    EXPECT_EQ(0u, groups) << "serial run used groups" << endl;
+
+    SystemClockOffset windows[] = { 700, 100000, 3000000 };
+    for(int w = 0; w < 3; w++) {
+        for(unsigned int threads = 2; threads <= 4; threads++) {
+            vector<int> parallel = RunDevices(threads, windows[w], 2000000, 0, groups);
+            // toggler and sampler are connected, they stay in one group
+            EXPECT_EQ(4u, groups) << "run wasn't parallel" << endl;
+            EXPECT_TRUE(serial == parallel) << "results differ with " << threads << " threads, window " << windows[w] << endl;
+        }
+    }
+}
+
+TEST( SESSION_PARALLEL, NET_WITH_DELAY )
+{
+    unsigned int groups;
+    vector<int> serial = RunDevices(1, 100000, 2000000, 1000, groups);
+    EXPECT_EQ(0u, groups) << "serial run used groups" << endl;
+    EXPECT_FALSE(serial == RunDevices(1, 100000, 2000000, 0, groups)) << "sampler doesn't see the delay" << endl;
+
+    // the window is shortened to the delay
+    SystemClockOffset windows[] = { 300, 100000 };
+    for(int w = 0; w < 2; w++) {
+        for(unsigned int threads = 2; threads <= 4; threads++) {
+            vector<int> parallel = RunDevices(threads, windows[w], 2000000, 1000, groups);
+            // toggler and sampler run in different groups
+            EXPECT_EQ(5u, groups) << "run wasn't parallel" << endl;
+            EXPECT_TRUE(serial == parallel) << "results differ with " << threads << " threads, window " << windows[w] << endl;
+        }
+    }
+}
+
+// runs 2 timer devices till 1ms, 1.5ms and 3ms, returns their registers, every
+// run uses threads[run]
+static vector<int> RunSplit(const unsigned int threads[3], unsigned int &groups) {
+    SimulationContext context;
+    context.Activate();
+    AvrDevice *dev = AvrFactory::instance().makeDevice("atmega128");
+    TimerProgram(1).Load(dev);
+    dev->SetClockFreq(250);
+    AvrDevice *dev2 = AvrFactory::instance().makeDevice("atmega128");
+    TimerProgram(2).Load(dev2);
+    dev2->SetClockFreq(100);
+    SystemClock &clock = context.GetSystemClock();
+    clock.Add(dev);
+    clock.Add(dev2);
+    SystemClockOffset ends[] = { 1000000, 1500000, 3000000 };
+    groups = 0;
+    for(int run = 0; run < 3; run++) {
+        clock.SetParallel(threads[run], 7000);
+        clock.Run(ends[run]);
+        groups = max(groups, clock.GetParallelGroups());
+    }
+    vector<int> state;
+    for(unsigned int a = 0; a < 32; a++) {
+        state.push_back(dev->GetRWMem(a));
+        state.push_back(dev2->GetRWMem(a));
+    }
+    SimulationContext::Deactivate();
+    return state;
+}
+
+TEST( SESSION_PARALLEL, CONTINUE )
+{
+    // runs one after the other, serial and parallel mixed
+    unsigned int groups;
+    unsigned int serial[] = { 1, 1, 1 };
+    unsigned int mixed[] = { 2, 1, 2 };
+    vector<int> res = RunSplit(serial, groups);
+    EXPECT_TRUE(res == RunSplit(mixed, groups)) << "results differ for runs one after the other" << endl;
+    EXPECT_EQ(2u, groups) << "run wasn't parallel" << endl;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <vector>
+#include <cstdio>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "simulationcontext.h"
+#include "systemclock.h"
+#include "net.h"
+
+#include "avrprogram.h"
+
+// A run, which is saved to a snapshot file, restored on a new device and
+// continued, has to give the same results as a uninterrupted run.
+
+static const char *snapshotFile = "unittest_snapshot.snap";
+
+// ISR at addr: increments counter register r
+static void CountIrq(AvrProgram &p, unsigned int addr, int r) {
+    p.Org(addr);
+    p.Push(16);
+    p.In(16, 0x3f);
+    p.Inc(r);
+    p.Out(0x3f, 16);
+    p.Pop(16);
+    p.Reti();
+}
+
+// timer 0 and 1 with overflow interrupts, timer 2 and 3 running, UART 0
+// sends a counter by loopback, ADC in free running mode, samples all of them
+static AvrProgram MixedProgram(void) {
+    AvrProgram p;
+    p.Jmp(0x60);
+    p.Org(0x1c);
+    p.Jmp(0x50);    // TIMER1 OVF
+    p.Org(0x20);
+    p.Jmp(0x58);    // TIMER0 OVF
+    CountIrq(p, 0x50, 21);
+    CountIrq(p, 0x58, 20);
+
+    p.Org(0x60);
+    p.InitStack(0x10ff);
+    p.InitX(0x200);
+    p.Ldi(16, 0x02);
+    p.Out(0x33, 16);    // TCCR0
+    p.Out(0x25, 16);    // TCCR2
+    p.Ldi(16, 0x01);
+    p.Out(0x2e, 16);    // TCCR1B
+    p.Ldi(16, 0x03);
+    p.Sts(0x8a, 16);    // TCCR3B
+    p.Ldi(16, 0x05);
+    p.Out(0x37, 16);    // TIMSK: TOIE1, TOIE0
+    p.Ldi(16, 3);
+    p.Out(0x09, 16);    // UBRR0L
+    p.Ldi(16, 0x18);
+    p.Out(0x0a, 16);    // UCSR0B: RXEN, TXEN
+    p.Ldi(16, 0x40);
+    p.Out(0x07, 16);    // ADMUX: AVCC, channel 0
+    p.Ldi(16, 0xe4);
+    p.Out(0x06, 16);    // ADCSRA: ADEN, ADSC, ADFR, prescaler 16
+    p.Sei();
+    unsigned int loop = p.Here();
+    p.In(16, 0x32);     // TCNT0
+    p.StX(16);
+    p.In(17, 0x2c);     // TCNT1
+    p.In(18, 0x2d);
+    p.StX(17);
+    p.StX(18);
+    p.In(17, 0x24);     // TCNT2
+    p.StX(17);
+    p.Lds(17, 0x88);    // TCNT3
+    p.StX(17);
+    p.In(16, 0x0b);     // UCSR0A
+    p.StX(16);
+    p.Sbrc(16, 7);      // RXC
+    p.In(17, 0x0c);
+    p.StX(17);
+    p.Inc(22);
+    p.Sbrc(16, 5);      // UDRE
+    p.Out(0x0c, 22);
+    p.In(17, 0x04);     // ADCL
+    p.In(18, 0x05);     // ADCH
+    p.StX(17);
+    p.StX(18);
+    p.StX(20);
+    p.StX(21);
+    p.WrapX();
+    // variable delay, so that the hardware is sampled on different cycles
+    p.Mov(25, 16);
+    p.Andi(25, 0x07);
+    unsigned int delay = p.Here();
+    p.Dec(25);
+    p.Brpl(delay);
+    p.Rjmp(loop);
+    return p;
+}
+
+// runs prog with 4MHz till time ns, saves a snapshot before at save ns, if
+// save isn't 0, or restores the snapshot first, if restore is set, returns
+// time, registers, RAM and PC, TXD and RXD of the first UART are connected,
+// start is the time of the saved or restored snapshot
+static vector<int> RunProgram(const AvrProgram &prog, bool fast, SystemClockOffset save, bool restore, SystemClockOffset time, SystemClockOffset &start) {
+    SimulationContext context;
+    context.Activate();
+    AvrDevice *dev = AvrFactory::instance().makeDevice("atmega128");
+    prog.Load(dev);
+    dev->SetClockFreq(250);
+    dev->blockDispatch = fast;
+    dev->idleSkip = fast;
+    vector<int> state;
+    {
+        Net net;
+        net.Add(dev->GetPin("E0"));
+        net.Add(dev->GetPin("E1"));
+
+        SystemClock &clock = context.GetSystemClock();
+        clock.Add(dev);
+        if(restore)
+            dev->RestoreSnapshot(snapshotFile);
+        start = clock.GetCurrentTime();
+        if(save != 0) {
+            clock.Run(save);
+            start = clock.GetCurrentTime();
+            dev->SaveSnapshot(snapshotFile);
+        }
+        clock.Run(time);
+
+        state.push_back((int)clock.GetCurrentTime());
+        unsigned int ramStart = dev->GetMemRegisterSize() + dev->GetMemIOSize();
+        for(unsigned int a = 0; a < 32; a++)
+            state.push_back(dev->GetRWMem(a));
+        for(unsigned int a = ramStart; a < ramStart + dev->GetMemIRamSize(); a++)
+            state.push_back(dev->GetRWMem(a));
+        state.push_back(dev->PC);
+    }
+    SimulationContext::Deactivate();
+    return state;
+}
+
+TEST( SESSION_SNAPSHOT, SAVE_RESTORE_CONTINUE )
+{
+    AvrProgram prog = MixedProgram();
+    SystemClockOffset saves[] = { 1000, 333333, 1250000 };
+    SystemClockOffset saved, restored;
+    for(int fast = 0; fast < 2; fast++) {
+        vector<int> all = RunProgram(prog, fast, 0, false, 3000000, saved);
+        EXPECT_LT(0, all[1 + 21]) << "no timer 1 overflow" << endl;
+        EXPECT_NE(0, all[1 + 22]) << "nothing sent" << endl;
+        for(int s = 0; s < 3; s++) {
+            vector<int> res = RunProgram(prog, fast, saves[s], false, 3000000, saved);
+            EXPECT_TRUE(all == res) << "saving changes the run, saved at " << saves[s] << endl;
+            res = RunProgram(prog, fast, 0, true, 3000000, restored);
+            EXPECT_LE(saves[s], saved) << "saved too early" << endl;
+            EXPECT_EQ(saved, restored) << "time not restored" << endl;
+            EXPECT_TRUE(all == res) << "results differ after restore, saved at " << saves[s] << ", fast " << fast << endl;
+        }
+    }
+    remove(snapshotFile);
+}
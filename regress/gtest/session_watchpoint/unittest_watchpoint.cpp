@@ -0,0 +1,161 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "simulationcontext.h"
+#include "systemclock.h"
+
+#include "avrprogram.h"
+
+// Watchpoints (gdb Z2, Z3, Z4) stop the core before the instruction after
+// the access, break- and exitpoints are found by the flag table of the
+// device, which has to follow Add, Remove and Clear of BP and EP.
+
+static const unsigned int watched = 0x100; // data address
+
+// word 0: ldi r17, word 1: inc r17, word 2: sts, word 4: nop, word 5: lds,
+// word 7: nop
+static const unsigned int afterWrite = 4;
+static const unsigned int readAt = 5;
+static const unsigned int afterRead = 7;
+
+static AvrProgram AccessProgram(void) {
+    AvrProgram p;
+    p.Ldi(17, 0);
+    unsigned int loop = p.Here();
+    p.Inc(17);
+    p.Sts(watched, 17);
+    p.Nop();
+    p.Lds(16, watched);
+    p.Nop();
+    p.Rjmp(loop);
+    return p;
+}
+
+class WatchpointTest: public ::testing::TestWithParam<bool> {
+
+    protected:
+        SimulationContext *context;
+        AvrDevice *dev;
+
+        void SetUp() {
+            context = new SimulationContext;
+            context->Activate();
+            dev = AvrFactory::instance().makeDevice("atmega128");
+            AccessProgram().Load(dev);
+            dev->SetClockFreq(250);
+            dev->blockDispatch = GetParam();
+            dev->idleSkip = GetParam();
+            context->GetSystemClock().Add(dev);
+        }
+
+        void TearDown() {
+            SimulationContext::Deactivate();
+            delete context;
+        }
+
+        //! Runs for 100us at most, returns true, if the run was stopped before
+        bool RunStops(void) {
+            SystemClock &clock = context->GetSystemClock();
+            SystemClockOffset limit = clock.GetCurrentTime() + 100000;
+            clock.Run(limit);
+            return clock.GetCurrentTime() < limit;
+        }
+};
+
+TEST_P( WatchpointTest, WRITE )
+{
+    EXPECT_TRUE(dev->AddWatchpoint(watched, 1, AvrDevice::WATCH_WRITE));
+    for(int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(RunStops()) << "no stop on write" << endl;
+        EXPECT_EQ(afterWrite, dev->PC);
+        EXPECT_EQ(AvrDevice::WATCH_WRITE, dev->watchHitType);
+        EXPECT_EQ(watched, dev->watchHitAddr);
+        EXPECT_EQ(i, dev->GetCoreReg(17));
+        EXPECT_EQ(i, dev->GetRWMem(watched));
+    }
+    EXPECT_TRUE(dev->RemoveWatchpoint(watched, 1, AvrDevice::WATCH_WRITE));
+    EXPECT_FALSE(dev->RemoveWatchpoint(watched, 1, AvrDevice::WATCH_WRITE));
+    EXPECT_FALSE(RunStops()) << "stop after remove" << endl;
+}
+
+TEST_P( WatchpointTest, READ )
+{
+    // a range, which covers the watched address
+    EXPECT_TRUE(dev->AddWatchpoint(watched - 2, 4, AvrDevice::WATCH_READ));
+    for(int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(RunStops()) << "no stop on read" << endl;
+        EXPECT_EQ(afterRead, dev->PC);
+        EXPECT_EQ(AvrDevice::WATCH_READ, dev->watchHitType);
+        EXPECT_EQ(watched, dev->watchHitAddr);
+        EXPECT_EQ(i, dev->GetCoreReg(16));
+    }
+    // other length or type doesn't remove it
+    EXPECT_FALSE(dev->RemoveWatchpoint(watched - 2, 4, AvrDevice::WATCH_WRITE));
+    EXPECT_TRUE(RunStops()) << "watchpoint removed by other type" << endl;
+    EXPECT_TRUE(dev->RemoveWatchpoint(watched - 2, 4, AvrDevice::WATCH_READ));
+    EXPECT_FALSE(RunStops()) << "stop after remove" << endl;
+}
+
+TEST_P( WatchpointTest, ACCESS )
+{
+    EXPECT_TRUE(dev->AddWatchpoint(watched, 1, AvrDevice::WATCH_ACCESS));
+    for(int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(RunStops()) << "no stop on write" << endl;
+        EXPECT_EQ(afterWrite, dev->PC);
+        ASSERT_TRUE(RunStops()) << "no stop on read" << endl;
+        EXPECT_EQ(afterRead, dev->PC);
+        EXPECT_EQ(watched, dev->watchHitAddr);
+    }
+    // a write watchpoint on the same cell is kept, if access is removed
+    EXPECT_TRUE(dev->AddWatchpoint(watched, 1, AvrDevice::WATCH_WRITE));
+    EXPECT_TRUE(dev->RemoveWatchpoint(watched, 1, AvrDevice::WATCH_ACCESS));
+    ASSERT_TRUE(RunStops()) << "no stop on write" << endl;
+    EXPECT_EQ(afterWrite, dev->PC);
+    EXPECT_TRUE(RunStops()) << "no stop on next write" << endl;
+    EXPECT_EQ(afterWrite, dev->PC);
+    dev->DeleteAllBreakpoints();
+    EXPECT_FALSE(RunStops()) << "stop after DeleteAllBreakpoints" << endl;
+}
+
+TEST_P( WatchpointTest, BREAKPOINT_FLAGS )
+{
+    // unreachable breakpoints and ones on odd or invalid addresses
+    for(unsigned int i = 0; i < 100; i++)
+        dev->BP.Add(0x1000 + 2 * i);
+    dev->BP.Add(2 * readAt + 1);
+    dev->BP.Add(0x7fffffff);
+    EXPECT_FALSE(RunStops()) << "stop on unreachable breakpoint" << endl;
+
+    // the same address twice, the flag is kept till the last one is removed
+    dev->BP.Add(2 * readAt);
+    dev->BP.Add(2 * readAt);
+    ASSERT_TRUE(RunStops()) << "no stop on breakpoint" << endl;
+    EXPECT_EQ(readAt, dev->PC);
+    EXPECT_EQ(0, dev->watchHitType);
+    dev->BP.Remove(2 * readAt);
+    EXPECT_TRUE(RunStops()) << "breakpoint lost after first remove" << endl;
+    EXPECT_EQ(readAt, dev->PC);
+    dev->BP.Remove(2 * readAt);
+    EXPECT_FALSE(RunStops()) << "stop after last remove" << endl;
+
+    // a removed exitpoint doesn't end the simulation
+    dev->EP.Add(2 * readAt);
+    dev->EP.Remove(2 * readAt);
+    EXPECT_FALSE(RunStops()) << "stop after exitpoint removed" << endl;
+
+    // break- and exitpoint on one word, the exitpoint stays after BP.Clear
+    // and ends the simulation of the device
+    dev->BP.Add(2 * readAt);
+    dev->EP.Add(2 * readAt);
+    ASSERT_TRUE(RunStops()) << "no stop on breakpoint" << endl;
+    EXPECT_EQ(readAt, dev->PC);
+    dev->BP.Clear();
+    EXPECT_TRUE(RunStops()) << "exitpoint lost by BP.Clear" << endl;
+    EXPECT_EQ(readAt, dev->PC);
+}
+
+INSTANTIATE_TEST_CASE_P( SESSION_WATCHPOINT, WatchpointTest, ::testing::Bool() );
@@ -165,8 +165,7 @@ class GdbRemoteSerialProtocol:
 		return regs
 	
 	def write_regs(self, regs):
-		arr = array.array('B')
-		arr.fromstring(struct.pack('<33BHL', *regs))
+		arr = array.array('B', struct.pack('<33BHL', *regs))
 		self.send('G'+self.bin2str(arr))
 		reply = self.recv()
 		if reply != b'OK':
@@ -186,13 +185,12 @@ class GdbRemoteSerialProtocol:
 		return val[0]
 
 	def write_reg(self, reg, val):
-		arr = array.array('B')
 		if reg < Reg.SP:
-			arr.fromstring(struct.pack('<B', val))
+			arr = array.array('B', struct.pack('<B', val))
 		elif reg < Reg.PC:
-			arr.fromstring(struct.pack('<H', val)) # SP is 16 bit
+			arr = array.array('B', struct.pack('<H', val)) # SP is 16 bit
 		else:
-			arr.fromstring(struct.pack('<L', val)) # PC is 32 bit
+			arr = array.array('B', struct.pack('<L', val)) # PC is 32 bit
 
 		self.send('P%x=%s' % (reg, self.bin2str(arr)))
 		reply = self.recv()
@@ -25,10 +25,10 @@
 
 #include "application.h"
 #include "printable.h"
+#include "simulationcontext.h"
 
 Application* Application::GetInstance() {
-    static Application instance;
-    return &instance;
+    return SimulationContext::Current().GetApplication();
 }
 
 void Application::RegisterPrintable(Printable *p) {
@@ -24,15 +24,22 @@
  */
 
 #include <limits>
+#include <typeinfo>
 
 #include "avrdevice.h"
 #include "traceval.h"
 #include "helper.h"
 #include "irqsystem.h"  //GetNewPc
 #include "systemclock.h"
+#include "simulationcontext.h"
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "avrreadelf.h"
+#include "snapshot.h"
+#include "instructionobserver.h"
+#include "bintrace.h"
+#include "flightrecorder.h"
+#include "rwmem.h"
 #include <assert.h>
 
 #include "avrdevice_impl.h"
@@ -47,24 +54,79 @@ void AvrDevice::AddToResetList(Hardware *hw) {
 }
 
 void AvrDevice::AddToCycleList(Hardware *hw) {
-    if(find(hwCycleList.begin(), hwCycleList.end(), hw) == hwCycleList.end())
+    if(find(hwCycleList.begin(), hwCycleList.end(), hw) == hwCycleList.end()) {
         hwCycleList.push_back(hw);
+        // due in current cycle, if added by a hardware while stepping hardware
+        hw->cycleLast = hwCycles;
+        hw->cycleDue = hwCycles;
+        hwNextDue = 0;
+    }
 }
         
 void AvrDevice::RemoveFromCycleList(Hardware *hw) {
     std::vector<Hardware*>::iterator element;
     element=find(hwCycleList.begin(), hwCycleList.end(), hw);
-    if(element != hwCycleList.end())
+    if(element != hwCycleList.end()) {
         hwCycleList.erase(element);
+        hw->cycleLast = cycleNever;
+        hw->cycleDue = cycleNever;
+        hwNextDue = 0; // next due cycle isn't known, if removed while stepping hardware
+    }
+}
+
+bool AvrDevice::IsHardwarePending(Hardware *hw) {
+    if(hwStepIndex < 0)
+        return false;
+    for(unsigned i = hwStepIndex + 1; i < hwCycleList.size(); i++) {
+        if(hwCycleList[i] == hw)
+            return true;
+    }
+    return false;
+}
+
+void AvrDevice::SyncHardware(Hardware *hw) {
+    if(hw->cycleLast == cycleNever)
+        return; // not in cycle list
+    // a due cycle, which isn't processed yet, is left to CpuCycle, the
+    // current cycle is left to StepHardware, if hw isn't stepped yet
+    unsigned long long next = hwCycles + 1;
+    if(hw->cycleDue < next)
+        next = hw->cycleDue;
+    else if(IsHardwarePending(hw))
+        next = hwCycles;
+    if(hw->cycleLast + 1 < next) {
+        hw->SkipCpuCycles(next - 1 - hw->cycleLast);
+        hw->cycleLast = next - 1;
+    }
+}
+
+void AvrDevice::RescheduleHardware(Hardware *hw) {
+    if(hw->cycleLast == cycleNever)
+        return; // not in cycle list
+    SyncHardware(hw);
+    unsigned long long due = IsHardwarePending(hw) ? hwCycles : hwCycles + 1;
+    if(hw->cycleDue > due)
+        hw->cycleDue = due;
+    if(hwNextDue > hw->cycleDue)
+        hwNextDue = hw->cycleDue;
+}
+
+void AvrDevice::RescheduleAllHardware(void) {
+    for(unsigned i = 0; i < hwCycleList.size(); i++)
+        RescheduleHardware(hwCycleList[i]);
 }
 
 void AvrDevice::Load(const char* fname) {
     actualFilename = fname;
     ELFLoad(this);
+    // devices of same type with the same program use one flash image
+    Flash->ShareImage(std::string(typeid(*this).name()) + ":" + devName);
 }
 
 void AvrDevice::SetClockFreq(SystemClockOffset nanosec) {
    clockFreq = nanosec;
+   // idle cycles of time based hardware depend on clock period
+   RescheduleAllHardware();
 }
 
 SystemClockOffset AvrDevice::GetClockFreq() const {
@@ -79,7 +141,10 @@ Pin *AvrDevice::GetPin(const char *name) {
 }
 
 AvrDevice::~AvrDevice() {
+    context->RemoveDevice(this);
     if (dumpManager) {
+        if(outOfScope)
+            dumpManager->Suspend(false);
         // unregister device on DumpManager
         dumpManager->unregisterAvrDevice(this);
     }
@@ -90,23 +155,38 @@ AvrDevice::~AvrDevice() {
         delete invalidRW[idx];
     delete [] invalidRW;
     
+    // delete watchpoint cells
+    for(std::map<unsigned int, WatchpointMember *>::iterator ii = watchpoints.begin(); ii != watchpoints.end(); ii++)
+        delete ii->second;
+    
     // delete Ram cells and registers
-    for(unsigned idx = 0; idx < registerSpaceSize; idx++)
-        delete rw[idx];
-    size = registerSpaceSize + ioSpaceSize + iRamSize + eRamSize;
-    for(unsigned idx = (registerSpaceSize + ioSpaceSize); idx < size; idx++)
-        delete rw[idx];
+    for(unsigned idx = 0; idx < ramCellCount; idx++)
+        ramCells[idx].~RAM();
+    ::operator delete(ramCells);
     
     // delete rw and other allocated objects
     delete Flash;
     delete statusRegister;
     delete status;
     delete [] rw;
+    delete [] dataMem;
+    delete [] directMem;
+    delete [] noDirectMem;
     delete data;
     delete fuses;
     delete lockbits;
 }
 
+/*! PC changes with nearly every instruction, so it's compared on every cycle
+ * and not signaled by the core. */
+class PcTV : public TraceValue {
+public:
+    PcTV(const std::string &_name, const unsigned int *pc)
+        : TraceValue(32, _name, -1, pc) {}
+
+    bool sampled() const override { return true; }
+};
+
 /*! To ease debugging, also supply the option to have the PC*2 in the trace
  * output file. This is also the format the other normal tracing will output
  * addresses and the format avr-objdump produces disassemblies in. */
@@ -120,6 +200,8 @@ public:
         change(ref->value()*2);
         set_written();
     }
+
+    bool sampled() const override { return true; }
 private:
     TraceValue *ref; // Reference value that will be doubled
 };
@@ -135,8 +217,28 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     iRamSize(IRamSize),
     eRamSize(ERamSize),
     devSignature(std::numeric_limits<unsigned int>::max()),
+    codePointChanges(0),
+    watchPending(false),
+    binaryTrace(NULL),
+    outOfScope(false),
+    scopeTraceOn(0),
+    currentBlock(nullptr),
+    currentBlockGeneration(0),
+    currentBlockChanges(0),
+    hwCycles(0),
+    hwNextDue(0),
+    hwStepIndex(-1),
+    BP(&codePointFlags, &codePointChanges),
+    EP(&codePointFlags, &codePointChanges),
     PC_size(pcSize),
     abortOnInvalidAccess(false),
+    threadedDispatch(false),
+    blockDispatch(false),
+    idleSkip(false),
+    hwSkip(true),
+    watchSuspended(false),
+    flightRecorder(NULL),
+    traceScope(this),
     coreTraceGroup(this),
     deferIrq(false),
     newIrqPc(0xffffffff),
@@ -153,13 +255,18 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     flagTiny10(false),
     flagTiny1x(false),
     flagXMega(false),
-    wado(nullptr)
+    wado(nullptr),
+    watchHitType(0),
+    watchHitAddr(0)
 {
-    dumpManager = DumpManager::Instance();
+    context = &SimulationContext::Current();
+    context->AddDevice(this);
+    dumpManager = context->GetDumpManager();
     dumpManager->registerAvrDevice(this);
     DebugRecentJumpsIndex = 0;
     
-    TraceValue* pc_tracer=trace_direct(&coreTraceGroup, "PC", &cPC);
+    TraceValue* pc_tracer=new PcTV(coreTraceGroup.GetTraceValuePrefix()+"PC", &cPC);
+    coreTraceGroup.RegisterTraceValue(pc_tracer);
     coreTraceGroup.RegisterTraceValue(new TwiceTV(coreTraceGroup.GetTraceValuePrefix()+"PCb",  pc_tracer));
     trace_on = 0;
     
@@ -175,6 +282,20 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     unsigned invalidSize = totalIoSpace - registerSpaceSize - IRamSize - ERamSize; 
     rw = new RWMemoryMember* [totalIoSpace];
     invalidRW = new RWMemoryMember* [invalidSize];
+
+    // plain byte store for registers and RAM, RAM cells hold their value there
+    dataMem = new unsigned char [totalIoSpace];
+    directMem = new unsigned char [totalIoSpace];
+    noDirectMem = new unsigned char [totalIoSpace];
+    std::fill(dataMem, dataMem + totalIoSpace, 0);
+    std::fill(directMem, directMem + totalIoSpace, 0);
+    std::fill(noDirectMem, noDirectMem + totalIoSpace, 0);
+    directAccess = directMem;
+    tracedStep = false;
+
+    // the RAM cells are allocated in one block instead of one heap object per byte
+    ramCells = static_cast<RAM *>(::operator new(sizeof(RAM) * (registerSpaceSize + IRamSize + ERamSize)));
+    ramCellCount = 0;
     
     // the status register is generic to all devices
     status = new HWSreg();
@@ -189,6 +310,7 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     
     // create the flash area with specified size
     Flash = new AvrFlash(this, flashSize);
+    codePointFlags.resize(flashSize / 2, 0);
     if(Flash == nullptr)
         avr_error("Not enough memory for Flash in AvrDevice::AvrDevice");
 
@@ -197,9 +319,7 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     unsigned invalidRWOffset = 0;
 
     for(unsigned ii = 0; ii < registerSpaceSize; ii++) {
-        rw[currentOffset] = new RAM(this,currentOffset,&coreTraceGroup, "r", ii, registerSpaceSize);
-        if(rw[currentOffset] == NULL)
-            avr_error("Not enough memory for registers in AvrDevice::AvrDevice");
+        rw[currentOffset] = new(&ramCells[ramCellCount++]) RAM(this,currentOffset,&coreTraceGroup, "r", ii, registerSpaceSize);
         currentOffset++;
     }      
 
@@ -219,18 +339,14 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
 
     // create the internal ram handlers 
     for(unsigned ii = 0; ii < IRamSize; ii++ ) {
-        rw[currentOffset] = new RAM(this,currentOffset, &coreTraceGroup, "IRAM", ii, IRamSize);
-        if(rw[currentOffset] == nullptr)
-            avr_error("Not enough memory for IRAM in AvrDevice::AvrDevice");
+        rw[currentOffset] = new(&ramCells[ramCellCount++]) RAM(this,currentOffset, &coreTraceGroup, "IRAM", ii, IRamSize);
         currentOffset++;
     }
 
     // create the external ram handlers, TODO: make the configuration from
     // mcucr available here
     for(unsigned ii = 0; ii < ERamSize; ii++ ) {
-        rw[currentOffset] = new RAM(this,currentOffset,&coreTraceGroup, "ERAM", ii, ERamSize);
-        if(rw[currentOffset] == nullptr)
-            avr_error("Not enough memory for io space in AvrDevice::AvrDevice");
+        rw[currentOffset] = new(&ramCells[ramCellCount++]) RAM(this,currentOffset,&coreTraceGroup, "ERAM", ii, ERamSize);
         currentOffset++;
     }
 
@@ -242,49 +358,336 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
             avr_error("Not enough memory for fill address space in AvrDevice::AvrDevice");
         rw[currentOffset] = invalidRW[invalidRWOffset];
     }
+
+    UpdateDirectMem();
 }
 
 // do a single core step, (0)->a real hardware step, (1) until the uC finish the opcode!
 int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    // trace_on is set from outside, so follow it here, the untraced loop
+    // itself has no checks for tracing
+    if((trace_on != 0) != tracedStep)
+        SetTracedStep(trace_on != 0);
+    int res;
+    if(tracedStep)
+        res = StepT<true>(untilCoreStepFinished, nextStepIn_ns);
+    else
+        res = StepT<false>(untilCoreStepFinished, nextStepIn_ns);
+    // scope is checked for the next instruction, before system clock
+    // writes the time stamp for the next trace line
+    if((outOfScope || traceScope.IsSet()) && cpuCycles <= 0)
+        UpdateTraceScope();
+    return res;
+}
+
+void AvrDevice::SetTracedStep(bool traced) {
+    tracedStep = traced;
+    // traced memory access has to go through RWMemoryMember, which writes the trace
+    directAccess = (traced || binaryTrace != NULL) ? noDirectMem : directMem;
+}
+
+void AvrDevice::UpdateTraceScope(void) {
+    bool out = traceScope.IsSet() && !traceScope.InScope(PC);
+    if(out != outOfScope) {
+        outOfScope = out;
+        if(out) {
+            scopeTraceOn = trace_on;
+            trace_on = 0;
+        } else
+            trace_on = scopeTraceOn;
+        if(dumpManager != NULL)
+            dumpManager->Suspend(out);
+    } else if(out && trace_on != 0) {
+        // trace was switched on from outside, e.g. for all members
+        scopeTraceOn = trace_on;
+        trace_on = 0;
+    }
+}
+
+bool AvrDevice::TraceScopeActive(void) const {
+    if(!traceScope.IsSet())
+        return false;
+    // trace, which is on or suspended by scope, and dumps
+    if((outOfScope ? scopeTraceOn : trace_on) != 0)
+        return true;
+    return dumpManager != NULL && dumpManager->HasDumpers();
+}
+
+void AvrDevice::SetTraceOn(bool on) {
+    if(outOfScope)
+        scopeTraceOn = on;
+    else
+        trace_on = on;
+}
+
+void AvrDevice::AddInstructionObserver(InstructionObserver *observer) {
+    instructionObservers.push_back(observer);
+}
+
+void AvrDevice::RemoveInstructionObserver(InstructionObserver *observer) {
+    std::vector<InstructionObserver *>::iterator i = std::find(instructionObservers.begin(), instructionObservers.end(), observer);
+    if(i != instructionObservers.end())
+        instructionObservers.erase(i);
+}
+
+void AvrDevice::SetBinaryTrace(BinaryTrace *trace) {
+    binaryTrace = trace;
+    SetTracedStep(tracedStep);
+}
+
+template<bool traced>
+int AvrDevice::StepT(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
     if(cpuCycles <= 0)
         cPC=PC;
 
-    if(trace_on) {
+    if(traced) {
         traceOut << actualFilename << " ";
         traceOut << HexShort(cPC << 1) << std::dec << ": ";
 
-        std::string sym(Flash->GetSymbolAtAddress(cPC<<1));
-        traceOut << sym << " ";
-        for(int len = sym.length(); len < 30;len++)
+        size_t len = Flash->WriteSymbolAtAddress(traceOut, cPC<<1);
+        traceOut << " ";
+        for(; len < 30; len++)
             traceOut << " " ;
     }
 
+    bool hwWait = StepHardware();
+    int res = StepCore<traced>(hwWait, untilCoreStepFinished, nextStepIn_ns);
+    // every instruction is recorded, if traced, scope is checked per
+    // instruction, if there is something to suspend
+    if(traced || binaryTrace != NULL || TraceScopeActive())
+        return res;
+
+    // run further cycles in this time slot, as long as no other simulation
+    // member has to be stepped before
+    if(blockDispatch) {
+        while(res == 0) {
+            if(idleSkip)
+                SkipIdleLoop();
+            if(RunBlock(res, untilCoreStepFinished, nextStepIn_ns))
+                continue;
+            if(!context->GetSystemClock().ContinueSlot(this, clockFreq))
+                break;
+            res = StepBlock(untilCoreStepFinished, nextStepIn_ns);
+        }
+    } else if(idleSkip && res == 0)
+        SkipIdleLoop();
+
+    return res;
+}
+
+void AvrDevice::SkipIdleLoop(void) {
+    // only on a instruction boundary, on which the core wouldn't do anything else
+    if(cpuCycles > 0 || deferIrq || (status->I == 1 && irqSystem->IsIrqPending()))
+        return;
+    // no hardware has to be stepped in the next cycle
+    if(hwNextDue <= hwCycles + 1)
+        return;
+    // traced values have to be dumped on every cycle
+    if(dumpManager->HasDumpers())
+        return;
+
+    // idle loops: "rjmp .-2" or "sleep" followed by "rjmp .-4", sleep is
+    // executed like a nop, so it's only idle in a loop
+    unsigned int size = Flash->GetSize() >> 1;
+    if(PC >= size)
+        return;
+    unsigned int opcode = Flash->ReadMemRawWord(PC << 1);
+    unsigned int loopPC, jumpPC, cycles;
+    if(opcode == 0xcfff) {
+        loopPC = jumpPC = PC;
+        cycles = 2;
+    } else if(opcode == 0x9588 && PC + 1 < size && Flash->ReadMemRawWord((PC + 1) << 1) == 0xcffe) {
+        loopPC = PC;
+        jumpPC = PC + 1;
+        cycles = 3;
+    } else if(opcode == 0xcffe && PC > 0 && Flash->ReadMemRawWord((PC - 1) << 1) == 0x9588) {
+        loopPC = PC - 1;
+        jumpPC = PC;
+        cycles = 3;
+    } else
+        return;
+    if(Flash->IsRWWLock(jumpPC << 1))
+        return;
+
+    // break- and exitpoints are checked on every instruction
+    if(HasCodePoint(loopPC, jumpPC + 1))
+        return;
+
+    unsigned long long steps = context->GetSystemClock().ContinueSlot(this, clockFreq, hwNextDue - hwCycles - 1, cycles);
+    if(steps == 0)
+        return;
+    hwCycles += steps;
+
+    // the loop ends on the same PC, but rjmp has recorded its jumps
+    unsigned long long jumps = steps / cycles;
+    const unsigned long long recentJumps = sizeof DebugRecentJumps / sizeof DebugRecentJumps[0];
+    if(jumps > recentJumps)
+        jumps = recentJumps + jumps % recentJumps;
+    unsigned int savedPC = PC;
+    PC = jumpPC;
+    for(; jumps > 0; jumps--)
+        DebugOnJump();
+    PC = savedPC;
+}
+
+bool AvrDevice::StepHardware(void) {
+    hwCycles++;
+    if(hwCycles < hwNextDue)
+        return false; // all hardware is idle in this cycle
+
     bool hwWait = false;
+    hwNextDue = cycleNever;
     for(unsigned i = 0; i < hwCycleList.size(); i++) {
         Hardware * p = hwCycleList[i];
-        if (p->CpuCycle() > 0)
-            hwWait = true;
+        hwStepIndex = i;
+        if(p->cycleDue <= hwCycles) {
+            if(p->cycleLast + 1 < hwCycles)
+                p->SkipCpuCycles(hwCycles - 1 - p->cycleLast);
+            p->cycleLast = hwCycles;
+            if (p->CpuCycle() > 0)
+                hwWait = true;
+            // hardware could have removed itself from cycle list
+            if(p->cycleLast == cycleNever)
+                continue;
+            p->cycleDue = hwCycles + 1 + (hwSkip ? p->GetIdleCycles() : 0);
+        }
+        if(hwNextDue > p->cycleDue)
+            hwNextDue = p->cycleDue;
+    }
+    hwStepIndex = -1;
+    return hwWait;
+}
+
+int AvrDevice::StepBlock(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    if(cpuCycles <= 0)
+        cPC=PC;
+
+    bool hwWait = StepHardware();
+
+    // all special cases are handled by StepCore
+    if(hwWait || cpuCycles > 0 || deferIrq || watchPending ||
+       (status->I == 1 && irqSystem->IsIrqPending()) || !EnterBlock())
+        return StepCore<false>(hwWait, untilCoreStepFinished, nextStepIn_ns);
+
+    for(size_t i = 0; i < instructionObservers.size(); i++)
+        instructionObservers[i]->Instruction(PC, hwCycles);
+    const ThreadedInstruction *ti = Flash->GetThreadedInstruction(PC);
+    cpuCycles = ti->GetHandler()(this, ti);
+    // report changes on status
+    statusRegister->trigger_change();
+
+    PC++;
+    cpuCycles--;
+
+    if(nextStepIn_ns != nullptr)
+        *nextStepIn_ns = clockFreq;
+
+    untilCoreStepFinished = !(cpuCycles > 0);
+    dumpManager->cycle();
+    return (cpuCycles < 0) ? cpuCycles : 0;
+}
+
+bool AvrDevice::RunBlock(int &res, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    SystemClock &clock = context->GetSystemClock();
+    BasicBlock *block = nullptr;
+
+    // only on instruction boundaries without the special cases of StepBlock
+    // and without value dumps, which need every cycle
+    while(cpuCycles <= 0 && !deferIrq && !watchPending &&
+          !(status->I == 1 && irqSystem->IsIrqPending()) && !dumpManager->HasDumpers()) {
+        // the next block is left to StepT, which checks for idle loops first
+        if(!EnterBlock() || (block != nullptr && currentBlock != block))
+            break;
+        // no hardware and no other simulation member is due in the first cycle
+        if(hwNextDue <= hwCycles + 1 || clock.SlotSteps(this, clockFreq, 1) == 0)
+            break;
+        block = currentBlock;
+        clock.AdvanceSlot(clockFreq, 1);
+        hwCycles++;
+
+        cPC = PC;
+        for(size_t i = 0; i < instructionObservers.size(); i++)
+            instructionObservers[i]->Instruction(PC, hwCycles);
+        const ThreadedInstruction *ti = Flash->GetThreadedInstruction(PC);
+        cpuCycles = ti->GetHandler()(this, ti);
+        // report changes on status
+        statusRegister->trigger_change();
+        PC++;
+        cpuCycles--;
+        if(cpuCycles < 0)
+            break;
+
+        // the remaining cycles of the instruction at once, if the instruction
+        // hasn't scheduled hardware or other simulation members in them
+        if(cpuCycles > 0 && hwNextDue > hwCycles + cpuCycles &&
+           clock.SlotSteps(this, clockFreq, cpuCycles) == (unsigned long long)cpuCycles) {
+            clock.AdvanceSlot(clockFreq, cpuCycles);
+            hwCycles += cpuCycles;
+            cpuCycles = 0;
+        }
+    }
+    if(block == nullptr)
+        return false;
+
+    if(nextStepIn_ns != nullptr)
+        *nextStepIn_ns = clockFreq;
+    untilCoreStepFinished = !(cpuCycles > 0);
+    res = (cpuCycles < 0) ? cpuCycles : 0;
+    return true;
+}
+
+bool AvrDevice::EnterBlock(void) {
+    BasicBlockCache *cache = Flash->GetBlockCache();
+
+    if(currentBlock != nullptr && currentBlockGeneration == cache->GetGeneration()) {
+        if(PC < currentBlock->start || PC >= currentBlock->end)
+            currentBlock = cache->GetLinked(currentBlock, PC);
+        else if(currentBlockChanges == codePointChanges)
+            return true;
+    } else {
+        currentBlock = cache->Get(PC);
+        currentBlockGeneration = cache->GetGeneration();
     }
+    if(currentBlock == nullptr)
+        return false;
 
+    // break- and exitpoints are checked by StepCore
+    if(HasCodePoint(currentBlock->start, currentBlock->end)) {
+        currentBlock = nullptr;
+        return false;
+    }
+    currentBlockChanges = codePointChanges;
+    return true;
+}
+
+template<bool traced>
+int AvrDevice::StepCore(bool hwWait, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
     if(hwWait) {
-        if(trace_on)
+        if(traced)
             traceOut << "CPU-Hold by IO-Hardware ";
     } else if(cpuCycles <= 0) {
 
-            //check for enabled breakpoints here
-            if(BP.end() != find(BP.begin(), BP.end(), PC<<1)) {
-                if(trace_on)
-                    traceOut << "Breakpoint found at 0x" << std::hex << (PC<<1) << std::dec << std::endl;
-                if(nextStepIn_ns != nullptr)
-                    *nextStepIn_ns = clockFreq;
-                untilCoreStepFinished = !(cpuCycles > 0);
-                dumpManager->cycle();
-                return BREAK_POINT;
-            }
+            //check for enabled break-, exit- and watchpoints here
+            if(watchPending || (PC < codePointFlags.size() && codePointFlags[PC] != 0)) {
+                if(watchPending || (codePointFlags[PC] & CodePoints::FLAG_BREAK)) {
+                    if(traced) {
+                        if(watchPending)
+                            traceOut << "Watchpoint hit at 0x" << std::hex << watchHitAddr << std::dec << std::endl;
+                        else
+                            traceOut << "Breakpoint found at 0x" << std::hex << (PC<<1) << std::dec << std::endl;
+                    }
+                    if(!watchPending)
+                        watchHitType = 0;
+                    watchPending = false;
+                    if(nextStepIn_ns != nullptr)
+                        *nextStepIn_ns = clockFreq;
+                    untilCoreStepFinished = !(cpuCycles > 0);
+                    dumpManager->cycle();
+                    return BREAK_POINT;
+                }
 
-            if(EP.end() != find(EP.begin(), EP.end(), PC<<1)) {
                 avr_message("Simulation finished!");
-                SystemClock::Instance().Stop();
+                context->GetSystemClock().Stop();
                 dumpManager->cycle();
                 return 0;
             }
@@ -313,7 +716,7 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
 
                     if ( newIrqPc != 0xffffffff )
                     {
-                        if(trace_on)
+                        if(traced)
                             traceOut << "IRQ DETECTED: VectorAddr: " << newIrqPc ;
 
                         // now we clear the irq flag for the served IRQ
@@ -321,12 +724,10 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
 
                         irqSystem->IrqHandlerStarted(stack->GetStackPointer(), actualIrqVector);
 
-                        stack->SetReturnPoint(stack->GetStackPointer(), 
-                                              [irqSystem=irqSystem,actualIrqVector=actualIrqVector](uint32_t stackPointer) 
-                                              {
-                                                  irqSystem->IrqHandlerFinished( stackPointer, actualIrqVector ); 
-                                              }
-                                              );
+                        stack->SetReturnPoint(stack->GetStackPointer(), irqSystem, actualIrqVector);
+
+                        for(size_t i = 0; i < instructionObservers.size(); i++)
+                            instructionObservers[i]->Interrupt(actualIrqVector, PC, newIrqPc, hwCycles);
 
                         stack->PushAddr(PC);
                         cpuCycles = 4; //push needs 4 cycles! (on external RAM +2, this is handled from HWExtRam!)
@@ -350,15 +751,21 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                     std::ostringstream os;
                     os << actualFilename << " Simulation runs out of Flash Space at " << std::hex << (PC << 1);
                     std::string s = os.str();
-                    if(trace_on)
+                    if(traced)
                         traceOut << s << std::endl;
                     avr_error("%s", s.c_str());
                 }
 
-                DecodedInstruction *de = (Flash->GetInstruction(PC));
-                if(trace_on) {
-                    cpuCycles = de->Trace();
+                for(size_t i = 0; i < instructionObservers.size(); i++)
+                    instructionObservers[i]->Instruction(PC, hwCycles);
+
+                if(traced) {
+                    cpuCycles = Flash->GetInstruction(PC)->Trace();
+                } else if(threadedDispatch) {
+                    const ThreadedInstruction *ti = Flash->GetThreadedInstruction(PC);
+                    cpuCycles = ti->GetHandler()(this, ti);
                 } else {
+                    DecodedInstruction *de = (Flash->GetInstruction(PC));
                     cpuCycles = (*de)(); 
                 }
                 // report changes on status
@@ -368,7 +775,7 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
             PC++;
             cpuCycles--;
     } else { //cpuCycles>0
-        if(trace_on == 1)
+        if(traced)
             traceOut << "CPU-waitstate";
         cpuCycles--;
     }
@@ -376,9 +783,9 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
     if(nextStepIn_ns != nullptr)
         *nextStepIn_ns = clockFreq;
 
-    if(trace_on == 1) {
+    if(traced) {
         traceOut << std::endl;
-        sysConHandler.TraceNextLine();
+        GetSystemConsoleHandler().TraceNextLine();
     }
 
     untilCoreStepFinished = !((cpuCycles > 0) || hwWait);
@@ -389,6 +796,9 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
 void AvrDevice::Reset() {
     cPC = PC = fuses->GetResetAddr();
 
+    // bring skipped cycles in before hardware state is reset
+    RescheduleAllHardware();
+
     std::vector<Hardware *>::iterator ii;
     for(ii= hwResetList.begin(); ii != hwResetList.end(); ii++)
         (*ii)->Reset();
@@ -397,10 +807,223 @@ void AvrDevice::Reset() {
 
     // init the old static vars from Step()
     cpuCycles = 0;
+
+    for(size_t i = 0; i < instructionObservers.size(); i++)
+        instructionObservers[i]->Reset();
+    irqSystem->ClearActiveHandlers();
+}
+
+void AvrDevice::Checkpoint(Snapshot &snap) {
+    // a snapshot can only be restored on a device of the same type
+    snap.Section("device");
+    std::string name = devName;
+    unsigned int sizes[5] = { Flash->GetSize(), ioSpaceSize, iRamSize, eRamSize, (unsigned int)hwResetList.size() };
+    unsigned int savedSizes[5];
+    std::copy(sizes, sizes + 5, savedSizes);
+    snap.Value(name);
+    snap.Value(savedSizes);
+    if(name != devName || !std::equal(sizes, sizes + 5, savedSizes))
+        avr_error("snapshot: was taken on another device type, can't restore it");
+
+    snap.Section("core");
+    snap.Value(clockFreq);
+    snap.Value(PC);
+    snap.Value(cPC);
+    snap.Value(cpuCycles);
+    snap.Value(deferIrq);
+    snap.Value(newIrqPc);
+    snap.Value(actualIrqVector);
+    snap.Value(DebugRecentJumps);
+    snap.Value(DebugRecentJumpsIndex);
+    snap.Value(status->I);
+    snap.Value(status->T);
+    snap.Value(status->H);
+    snap.Value(status->S);
+    snap.Value(status->V);
+    snap.Value(status->N);
+    snap.Value(status->Z);
+    snap.Value(status->C);
+    snap.Value(hwCycles);
+    snap.Value(hwNextDue);
+
+    // registers and RAM, IO registers are saved by the hardware, which holds them
+    snap.Bytes(dataMem, registerSpaceSize + ioSpaceSize + iRamSize + eRamSize);
+    // written flags of the cells, they are dumped with the trace values
+    for(unsigned idx = 0; idx < ramCellCount; idx++) {
+        RAM *cell = &ramCells[idx];
+        unsigned addr = cell->GetAddress();
+        bool written = (directMem[addr] == directWritten) || cell->IsWritten();
+        snap.Value(written);
+        if(snap.IsRestoring()) {
+            if(directMem[addr] != 0)
+                directMem[addr] = written ? directWritten : directUnwritten;
+            else if(written && cell->IsTraced())
+                cell->SyncTraceValue();
+        }
+    }
+    if(snap.IsRestoring()) {
+        currentBlock = nullptr;
+        hwStepIndex = -1;
+    }
+    stack->Checkpoint(snap);
+    for(unsigned addr = registerSpaceSize; addr < registerSpaceSize + ioSpaceSize; addr++) {
+        RWMemoryMember *member = rw[addr];
+        WatchpointMember *watched = dynamic_cast<WatchpointMember *>(member);
+        if(watched != nullptr)
+            member = watched->GetCell();
+        IOSpecialReg *reg = dynamic_cast<IOSpecialReg *>(member);
+        if(reg != nullptr)
+            reg->Checkpoint(snap);
+    }
+
+    snap.Section("hardware");
+    for(unsigned i = 0; i < hwResetList.size(); i++) {
+        Hardware *hw = hwResetList[i];
+        snap.Value(hw->cycleLast);
+        snap.Value(hw->cycleDue);
+        hw->Checkpoint(snap);
+    }
+    // cycle list is saved as index in reset list, order matters for stepping
+    unsigned int cnt = hwCycleList.size();
+    snap.Value(cnt);
+    std::vector<Hardware *> cycleList;
+    for(unsigned i = 0; i < cnt; i++) {
+        unsigned int idx = 0;
+        if(!snap.IsRestoring()) {
+            idx = std::find(hwResetList.begin(), hwResetList.end(), hwCycleList[i]) - hwResetList.begin();
+            if(idx == hwResetList.size())
+                avr_error("snapshot: hardware in cycle list isn't in reset list");
+        }
+        snap.Value(idx);
+        if(idx >= hwResetList.size())
+            avr_error("snapshot: invalid hardware index %u", idx);
+        cycleList.push_back(hwResetList[idx]);
+    }
+    if(snap.IsRestoring())
+        hwCycleList.swap(cycleList);
+
+    irqSystem->Checkpoint(snap);
+    Flash->Checkpoint(snap);
+    lockbits->Checkpoint(snap);
+
+    snap.Section("clock");
+    SystemClock &clock = context->GetSystemClock();
+    SystemClockOffset now = clock.GetCurrentTime();
+    snap.Value(now);
+    if(snap.IsRestoring())
+        clock.SetCurrentTime(now);
+    clock.CheckpointMember(snap, this);
+}
+
+void AvrDevice::SaveSnapshot(const char *filename) {
+    Snapshot snap;
+    Checkpoint(snap);
+    snap.WriteFile(filename);
+}
+
+void AvrDevice::RestoreSnapshot(const char *filename) {
+    Snapshot snap;
+    snap.ReadFile(filename);
+    Checkpoint(snap);
 }
 
 void AvrDevice::DeleteAllBreakpoints() {
-    BP.erase(BP.begin(), BP.end());
+    BP.Clear();
+    for(std::map<unsigned int, WatchpointMember *>::iterator ii = watchpoints.begin(); ii != watchpoints.end(); ii++) {
+        WatchpointMember *cell = ii->second;
+        if(rw[ii->first] == cell)
+            rw[ii->first] = cell->GetCell();
+        delete cell;
+    }
+    watchpoints.clear();
+    ClearWatchpointHit();
+    UpdateDirectMem();
+}
+
+bool AvrDevice::AddWatchpoint(unsigned int addr, unsigned int len, WatchpointType type) {
+    if(len == 0 || addr >= totalIoSpace || len > totalIoSpace - addr)
+        return false;
+    for(unsigned int a = addr; a < addr + len; a++) {
+        WatchpointMember *&cell = watchpoints[a];
+        if(cell == nullptr) {
+            cell = new WatchpointMember(this, a, rw[a]);
+            rw[a] = cell;
+        }
+        cell->Add(type);
+    }
+    UpdateDirectMem();
+    return true;
+}
+
+bool AvrDevice::RemoveWatchpoint(unsigned int addr, unsigned int len, WatchpointType type) {
+    bool found = false;
+    for(unsigned int a = addr; a < addr + len; a++) {
+        std::map<unsigned int, WatchpointMember *>::iterator ii = watchpoints.find(a);
+        if(ii == watchpoints.end() || !ii->second->Remove(type))
+            continue;
+        found = true;
+        WatchpointMember *cell = ii->second;
+        if(cell->IsUsed())
+            continue;
+        // give back the original cell, fast access is possible again
+        if(rw[a] == cell)
+            rw[a] = cell->GetCell();
+        delete cell;
+        watchpoints.erase(ii);
+    }
+    UpdateDirectMem();
+    return found;
+}
+
+void AvrDevice::WatchpointHit(unsigned int addr, WatchpointType type) {
+    // the first hit in an instruction is reported
+    if(watchPending || watchSuspended)
+        return;
+    watchPending = true;
+    watchHitType = type;
+    watchHitAddr = addr;
+}
+
+bool AvrDevice::HasCodePoint(unsigned int start, unsigned int end) const {
+    if(end > codePointFlags.size())
+        end = codePointFlags.size();
+    for(unsigned int idx = start; idx < end; idx++)
+        if(codePointFlags[idx] != 0)
+            return true;
+    return false;
+}
+
+void CodePoints::UpdateFlag(dword addr) {
+    // only the start of a word can be hit by PC
+    unsigned int idx = (unsigned int)addr >> 1;
+    if((addr & 1) != 0 || idx >= flags->size())
+        return;
+    if(Contains(addr))
+        (*flags)[idx] |= mask;
+    else
+        (*flags)[idx] &= ~mask;
+    // blocks, which the device has entered, are checked again
+    (*changes)++;
+}
+
+void CodePoints::Add(dword addr) {
+    points.push_back(addr);
+    UpdateFlag(addr);
+}
+
+void CodePoints::Remove(dword addr) {
+    std::vector<dword>::iterator ii = std::find(points.begin(), points.end(), addr);
+    if(ii == points.end())
+        return;
+    points.erase(ii);
+    UpdateFlag(addr);
+}
+
+void CodePoints::Clear(void) {
+    std::vector<dword> old;
+    old.swap(points);
+    for(const_iterator ii = old.begin(); ii != old.end(); ii++)
+        UpdateFlag(*ii);
 }
 
 void AvrDevice::SetDeviceNameAndSignature(const std::string &name, unsigned int signature) {
@@ -412,11 +1035,13 @@ void AvrDevice::ReplaceIoRegister(unsigned int offset, RWMemoryMember *newMember
     if (offset >= ioSpaceSize + registerSpaceSize)
         avr_error("Could not replace register in non existing IoRegisterSpace");
     rw[offset] = newMember;
+    directMem[offset] = 0;
 }
 
 bool AvrDevice::ReplaceMemRegister(unsigned int offset, RWMemoryMember *newMember) {
     if(offset < totalIoSpace) {
         rw[offset] = newMember;
+        directMem[offset] = 0;
         return true;
     }
     return false;
@@ -434,7 +1059,7 @@ void AvrDevice::RegisterTerminationSymbol(const char *symbol) {
     assert(false);  // TODO: Implement loading symbols from ELF file
 #endif
     unsigned int epa = Flash->GetAddressAtSymbol(symbol);
-    EP.push_back(epa);
+    EP.Add(epa);
 }
 
 void AvrDevice::DebugOnJump()
@@ -446,28 +1071,28 @@ void AvrDevice::DebugOnJump()
     DebugRecentJumps[next] = -1;
 }
 
-unsigned char AvrDevice::GetRWMem(unsigned addr) {
-    if(addr >= GetMemTotalSize())
-        return 0;
-    return *(rw[addr]);
-}
-
-bool AvrDevice::SetRWMem(unsigned addr, unsigned char val) {
-    if(addr >= GetMemTotalSize())
-        return false;
-    *(rw[addr]) = val;
-    return true;
+void AvrDevice::UpdateDirectMem(void) {
+    for(unsigned idx = 0; idx < ramCellCount; idx++) {
+        RAM *cell = &ramCells[idx];
+        unsigned addr = cell->GetAddress();
+        bool direct = (rw[addr] == cell) && !cell->IsTraced();
+        if(!direct) {
+            if(directMem[addr] == directWritten)
+                cell->SyncTraceValue();
+            directMem[addr] = 0;
+        } else if(directMem[addr] == 0)
+            directMem[addr] = directUnwritten;
+    }
 }
 
-unsigned char AvrDevice::GetCoreReg(unsigned addr) {
-    assert(addr < registerSpaceSize);
+unsigned char AvrDevice::ReadMember(unsigned addr) {
     return *(rw[addr]);
 }
 
-bool AvrDevice::SetCoreReg(unsigned addr, unsigned char val) {
-    assert(addr < registerSpaceSize);
+void AvrDevice::WriteMember(unsigned addr, unsigned char val) {
+    if(binaryTrace != NULL)
+        binaryTrace->Write(addr, val);
     *(rw[addr]) = val;
-    return true;
 }
 
 unsigned char AvrDevice::GetIOReg(unsigned addr) {
@@ -477,38 +1102,28 @@ unsigned char AvrDevice::GetIOReg(unsigned addr) {
 
 bool AvrDevice::SetIOReg(unsigned addr, unsigned char val) {
     assert(addr < ioSpaceSize);  // callers do use 0x00 base, not 0x20
+    if(binaryTrace != NULL)
+        binaryTrace->Write(addr + registerSpaceSize, val);
     *(rw[addr + registerSpaceSize]) = val;
     return true;
 }
 
 bool AvrDevice::SetIORegBit(unsigned addr, unsigned bitaddr) {
     assert(addr < 0x20);  // only first 32 IO registers are bit-settable
+    if(binaryTrace != NULL)
+        binaryTrace->WriteBit(addr + registerSpaceSize, bitaddr, true);
     (rw[addr + registerSpaceSize])->set_bit( bitaddr );
     return true;
 }
 
 bool AvrDevice::ClearIORegBit( unsigned addr, unsigned bitaddr ) {
     assert(addr < 0x20);  // only first 32 IO registers are bit-settable
+    if(binaryTrace != NULL)
+        binaryTrace->WriteBit(addr + registerSpaceSize, bitaddr, false);
     (rw[addr + registerSpaceSize])->clear_bit( bitaddr );
     return true;
 }
 
-unsigned AvrDevice::GetRegX(void) {
-    // R27:R26
-    return (*(rw[27]) << 8) + *(rw[26]);
-}
-
-unsigned AvrDevice::GetRegY(void) {
-    // R29:R28
-    return (*(rw[29]) << 8) + *(rw[28]);
-}
-
-unsigned AvrDevice::GetRegZ(void) {
-    // R31:R30
-    return (*(rw[31]) << 8) + *(rw[30]);
-}
-
-
 std::string AvrDevice::GetInterruptVectorName( unsigned int vectorNumber )
 {
     unsigned int cnt;
@@ -32,11 +32,13 @@
 #include "net.h"
 #include "traceval.h"
 #include "flashprog.h"
+#include "tracescope.h"
 
 #include <string>
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <assert.h>
 #include "types.h" // for dword
 
 // transfered from global.h
@@ -44,14 +46,70 @@
 #define INVALID_OPCODE -1
 
 // transfered from breakpoint.h
-class Breakpoints: public std::vector<dword> { };
-class Exitpoints: public std::vector<dword> { };
+//! List of flash byte addresses, which are marked in a flag table per flash word
+/*! The device tests the flag of PC on every instruction instead of searching
+  the list, so the count of addresses doesn't matter. The same address can be
+  added more than once, the flag is cleared, if the last one is removed. */
+class CodePoints {
+    
+    protected:
+        std::vector<dword> points; //!< byte addresses in flash
+        std::vector<unsigned char> *flags; //!< flag table of device, one entry per flash word
+        unsigned long *changes; //!< counter of device, incremented on every update of flags
+        unsigned char mask; //!< bit of this list in flags
+        
+        //! Sets or clears the flag for addr, depending on points
+        void UpdateFlag(dword addr);
+        
+    public:
+        //! Flags in flag table
+        enum {
+            FLAG_BREAK = 1, //!< word has a breakpoint
+            FLAG_EXIT = 2   //!< word has a exitpoint
+        };
+        
+        typedef std::vector<dword>::const_iterator const_iterator;
+        
+        CodePoints(std::vector<unsigned char> *f, unsigned long *c, unsigned char m): flags(f), changes(c), mask(m) {}
+        
+        //! Adds a byte address
+        void Add(dword addr);
+        //! Removes a byte address once, does nothing, if it isn't in list
+        void Remove(dword addr);
+        //! Removes all addresses
+        void Clear(void);
+        //! True, if a byte address is in list
+        bool Contains(dword addr) const { return std::find(points.begin(), points.end(), addr) != points.end(); }
+        
+        const_iterator begin(void) const { return points.begin(); }
+        const_iterator end(void) const { return points.end(); }
+        size_t size(void) const { return points.size(); }
+        bool empty(void) const { return points.empty(); }
+};
+
+class Breakpoints: public CodePoints {
+    
+    public:
+        Breakpoints(std::vector<unsigned char> *f, unsigned long *c): CodePoints(f, c, FLAG_BREAK) {}
+        
+        //! Adds a breakpoint on byte address bp
+        void AddBreakpoint(unsigned bp) { Add(bp); }
+        //! Removes a breakpoint on byte address bp
+        void RemoveBreakpoint(unsigned bp) { Remove(bp); }
+};
+
+class Exitpoints: public CodePoints {
+    
+    public:
+        Exitpoints(std::vector<unsigned char> *f, unsigned long *c): CodePoints(f, c, FLAG_EXIT) {}
+};
 
 // from hwsreg.h, but not included, because of circular include with this header
 class HWSreg;
 class RWSreg;
 
 class AvrFlash;
+struct BasicBlock;
 class HWEeprom;
 class HWStack;
 class HWWado;
@@ -60,7 +118,14 @@ class HWIrqSystem;
 class RWMemoryMember;
 class Hardware;
 class DumpManager;
+class SimulationContext;
 class AddressExtensionRegister;
+class RAM;
+class Snapshot;
+class InstructionObserver;
+class BinaryTrace;
+class FlightRecorder;
+class WatchpointMember;
 
 //! Basic AVR device, contains the core functionality
 class AvrDevice: public SimulationMember, public TraceValueRegister {
@@ -75,8 +140,35 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         unsigned int devSignature; //!< hold the device signature for this core
         std::string devName; //!< hold the device name, which this core simulate
 
+        RAM *ramCells; //!< memory cells for R0-R31, internal and external RAM, allocated as one block
+        unsigned int ramCellCount; //!< count of cells in ramCells
+        unsigned char *directMem; //!< not 0 for addresses, which can be accessed in dataMem without RWMemoryMember, see directWritten
+        static const unsigned char directWritten = 1; //!< directMem value of a address, which was written by direct access
+        static const unsigned char directUnwritten = 2; //!< directMem value of a address, which wasn't written since it has direct access
+        unsigned char *noDirectMem; //!< all 0, used instead of directMem, if core is traced
+        unsigned char *directAccess; //!< directMem or noDirectMem, used by fast memory access
+        bool tracedStep; //!< core loop runs traced, follows trace_on on next Step call
+        std::vector<unsigned char> codePointFlags; //!< CodePoints flags per flash word for BP and EP
+        unsigned long codePointChanges; //!< count of updates of codePointFlags
+        std::map<unsigned int, WatchpointMember *> watchpoints; //!< memory cells with watchpoints by address
+        bool watchPending; //!< a watchpoint was hit, core stops before next instruction
+        std::vector<InstructionObserver *> instructionObservers; //!< observers, which get every instruction and interrupt
+        BinaryTrace *binaryTrace; //!< binary trace, which records instructions and writes, or NULL
+        bool outOfScope; //!< core is out of traceScope, trace and dumps are suspended
+        int scopeTraceOn; //!< trace_on, which is restored, if core enters traceScope again
+
         friend class DumpManager;
+        friend class SystemClock;
         void detachDumpManager() { dumpManager = NULL; }
+        //! Computes directMem from the current rw mapping and trace state of memory cells
+        void UpdateDirectMem(void);
+        //! Selects traced or untraced core loop and memory access
+        void SetTracedStep(bool traced);
+
+        //! Reads a memory cell by RWMemoryMember, used, if fast access isn't possible
+        unsigned char ReadMember(unsigned addr);
+        //! Writes a memory cell by RWMemoryMember, used, if fast access isn't possible
+        void WriteMember(unsigned addr, unsigned char val);
 
     protected:
         SystemClockOffset clockFreq;  ///< Period of a tick (1/F_OSC) in [ns]
@@ -85,6 +177,39 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         
         /// Count of cycles before next instruction is executed (i.e. countdown)
         int cpuCycles;
+        
+        BasicBlock *currentBlock; //!< block, in which PC is, used by block dispatch
+        unsigned long currentBlockGeneration; //!< block cache generation of currentBlock
+        unsigned long currentBlockChanges; //!< codePointChanges, when currentBlock was checked for break- and exitpoints
+
+        unsigned long long hwCycles; //!< count of cycles, for which hardware was stepped
+        unsigned long long hwNextDue; //!< first cycle, in which a hardware in hwCycleList needs CpuCycle
+        int hwStepIndex; //!< index in hwCycleList, which is stepped now, or -1 outside of StepHardware
+
+        //! Returns true, if hw will be stepped later in the current cycle
+        bool IsHardwarePending(Hardware *hw);
+
+        //! Calls CpuCycle for all hardware in hwCycleList, which is due, returns true, if one holds the core
+        bool StepHardware(void);
+        //! Step with or without instruction trace, instantiated for both cases
+        template<bool traced>
+        int StepT(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Processes a clock cycle for the core, after hardware was stepped
+        template<bool traced>
+        int StepCore(bool hwWait, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Processes a clock cycle, executes instruction from a basic block, if possible
+        int StepBlock(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Runs instructions of the basic block at PC, while no hardware and no other simulation member is due
+        /*! The cycles of an instruction are accounted at once, instead of
+          stepping every cycle. Returns false, if no instruction was run,
+          otherwise res is set like by StepBlock. */
+        bool RunBlock(int &res, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Sets currentBlock to the block for PC, returns false, if there is no block without break- or exitpoint
+        bool EnterBlock(void);
+        //! Skips whole iterations of an idle loop at PC, as long as hardware and other simulation members are idle
+        void SkipIdleLoop(void);
+        //! True, if a break- or exitpoint is on a flash word from start to end (exclusive)
+        bool HasCodePoint(unsigned int start, unsigned int end) const;
 
     public:
         Breakpoints BP;
@@ -103,6 +228,13 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         AddressExtensionRegister *rampz; //!< RAMPZ address extension register
         AddressExtensionRegister *eind; //!< EIND address extension register
         bool abortOnInvalidAccess; //!< Flag, that simulation abort if an invalid access occured, default is false
+        bool threadedDispatch; //!< Flag, that instructions are executed by threaded code records of AvrFlash, default is false
+        bool blockDispatch; //!< Flag, that the core runs basic blocks and as many cycles as possible in one Step call, default is false
+        bool idleSkip; //!< Flag, that idle loops (sleep or jump to itself) are skipped till the next event, default is false
+        bool hwSkip; //!< Flag, that idle hardware isn't stepped on every cycle (see Hardware::GetIdleCycles), default is true
+        bool watchSuspended; //!< Flag, that watchpoints ignore accesses, e.g. memory access of a debugger, default is false
+        FlightRecorder *flightRecorder; //!< ring buffer of the last executed instructions, default is NULL
+        TraceScope traceScope; //!< restricts instruction trace and dumps, default is no restriction
         TraceValueCoreRegister coreTraceGroup;
         bool deferIrq;  ///< Almost always false.
         unsigned int newIrqPc;
@@ -125,6 +257,7 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         int DebugRecentJumpsIndex;  ///< Index to address of the most recent jump
 
         RWMemoryMember **rw;  ///< The whole memory: R0-R31, IO, Internal RAM.
+        unsigned char *dataMem;  ///< Byte store for R0-R31, internal and external RAM, indexed by data address
 
         HWStack *stack;
         HWSreg *status;           //!< the status register itself
@@ -135,6 +268,7 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         std::vector<Hardware *> hwCycleList; 
 
         DumpManager *dumpManager;
+        SimulationContext *context; //!< simulation context, in which this device was created
     
         AvrDevice(unsigned int ioSpaceSize, unsigned int IRamSize, unsigned int ERamSize, unsigned int flashSize, unsigned int pcSize = 2);
         virtual ~AvrDevice();
@@ -153,6 +287,22 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         //! Removes from the cycle list, if possible.
         /*! Does nothing if the part is not in the cycle list. */
         void RemoveFromCycleList(Hardware *hw);
+
+        //! Value for a cycle, which will never come
+        static const unsigned long long cycleNever = 0xffffffffffffffffULL;
+
+        //! Gives the cycles, which were skipped for hw till now, to hw
+        /*! After this call, the state of hw is valid for the current cycle.
+          Does nothing, if hw isn't in the cycle list. */
+        void SyncHardware(Hardware *hw);
+
+        //! Syncs hw and calls its CpuCycle again on next cycle
+        /*! Has to be called by a hardware, before a register access changes,
+          when it needs the next CpuCycle call. */
+        void RescheduleHardware(Hardware *hw);
+
+        //! Reschedules all hardware in the cycle list
+        void RescheduleAllHardware(void);
     
         void Load(const char* n); //!< Load flash, eeprom, signature, fuses from elf file, wrapper for LoadBFD or LoadSimpleELF
         void ReplaceIoRegister(unsigned int offset, RWMemoryMember *);
@@ -166,6 +316,16 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
           single clock cycle. */
         int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns =0) override;
         void Reset();
+
+        //! Saves or restores the state of core, memory and all hardware, see Snapshot
+        /*! The device has to be created and loaded with the same program before
+          restore. Time of the system clock is restored too. */
+        void Checkpoint(Snapshot &snap);
+        //! Saves the state of the device to a snapshot file
+        void SaveSnapshot(const char *filename);
+        //! Restores the state of the device from a snapshot file
+        void RestoreSnapshot(const char *filename);
+
         void SetClockFreq(SystemClockOffset f);
         SystemClockOffset GetClockFreq() const;
 
@@ -173,13 +333,47 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
             allPins.insert(std::pair<std::string, Pin*>(name, p));
         }
 
-        //! Clear all breakpoints in device
+        //! Clear all break- and watchpoints in device
         void DeleteAllBreakpoints(void);
+        
+        //! Kind of a data watchpoint
+        enum WatchpointType {
+            WATCH_WRITE = 1, //!< stop after write access
+            WATCH_READ = 2,  //!< stop after read access
+            WATCH_ACCESS = 3 //!< stop after read or write access
+        };
+        //! Adds a watchpoint for len bytes from data address addr
+        /*! Only the watched memory cells are replaced by a WatchpointMember,
+          the core stops with BREAK_POINT before the next instruction, if one
+          is accessed. Returns false, if the range isn't in data space. */
+        bool AddWatchpoint(unsigned int addr, unsigned int len, WatchpointType type);
+        //! Removes a watchpoint, which was added with the same parameters
+        /*! Returns false, if there was no such watchpoint. */
+        bool RemoveWatchpoint(unsigned int addr, unsigned int len, WatchpointType type);
+        //! Called by WatchpointMember, if a watched cell is accessed
+        void WatchpointHit(unsigned int addr, WatchpointType type);
+        //! Forgets the last watchpoint hit, a pending stop is dropped
+        void ClearWatchpointHit(void) { watchPending = false; watchHitType = 0; }
+        int watchHitType; //!< WatchpointType of last hit, 0 if the last stop was no watchpoint
+        unsigned int watchHitAddr; //!< data address of last watchpoint hit
 
         //! Return filename from loaded program
         const std::string &GetFname(void) { return actualFilename; }
         //! Return device name
         const std::string &GetDeviceName(void) { return devName; }
+
+        //! Adds a observer, which gets all following instructions and interrupts of core
+        void AddInstructionObserver(InstructionObserver *observer);
+        //! Removes a observer, which was added by AddInstructionObserver
+        void RemoveInstructionObserver(InstructionObserver *observer);
+        //! Starts (or stops with NULL) recording of a binary trace, all memory writes of core go through WriteMember then
+        void SetBinaryTrace(BinaryTrace *trace);
+        //! Suspends or resumes trace and dumps, if PC has left or entered traceScope
+        void UpdateTraceScope(void);
+        //! Returns true, if traceScope is set and can change trace or dump output
+        bool TraceScopeActive(void) const;
+        //! Switches instruction trace on or off, also while core is out of traceScope
+        void SetTraceOn(bool on);
         //! Return device signature
         unsigned int GetDeviceSignature(void) { return devSignature; }
         //! Set device signature and name
@@ -197,13 +391,41 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         unsigned int GetMemERamSize(void) { return eRamSize; }
         
         //! Get a value of RW memory cell
-        unsigned char GetRWMem(unsigned addr);
+        unsigned char GetRWMem(unsigned addr) {
+            if(addr >= totalIoSpace)
+                return 0;
+            if(directAccess[addr])
+                return dataMem[addr];
+            return ReadMember(addr);
+        }
         //! Set a value to RW memory cell
-        bool SetRWMem(unsigned addr, unsigned char val);
+        bool SetRWMem(unsigned addr, unsigned char val) {
+            if(addr >= totalIoSpace)
+                return false;
+            if(directAccess[addr]) {
+                dataMem[addr] = val;
+                directAccess[addr] = directWritten;
+            } else
+                WriteMember(addr, val);
+            return true;
+        }
         //! Get a value from core register
-        unsigned char GetCoreReg(unsigned addr);
+        unsigned char GetCoreReg(unsigned addr) {
+            assert(addr < registerSpaceSize);
+            if(directAccess[addr])
+                return dataMem[addr];
+            return ReadMember(addr);
+        }
         //! Set a value to core register
-        bool SetCoreReg(unsigned addr, unsigned char val);
+        bool SetCoreReg(unsigned addr, unsigned char val) {
+            assert(addr < registerSpaceSize);
+            if(directAccess[addr]) {
+                dataMem[addr] = val;
+                directAccess[addr] = directWritten;
+            } else
+                WriteMember(addr, val);
+            return true;
+        }
         //! Get a value from IO register (without offset of 0x20!)
         unsigned char GetIOReg(unsigned addr);
         //! Set a value to IO register (without offset of 0x20!)
@@ -214,11 +436,11 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         bool ClearIORegBit(unsigned addr, unsigned bitaddr);
 
         //! Get value of X register (16bit)
-        unsigned GetRegX(void);
+        unsigned GetRegX(void) { return (GetCoreReg(27) << 8) + GetCoreReg(26); }
         //! Get value of Y register (16bit)
-        unsigned GetRegY(void);
+        unsigned GetRegY(void) { return (GetCoreReg(29) << 8) + GetCoreReg(28); }
         //! Get value of Z register (16bit)
-        unsigned GetRegZ(void);
+        unsigned GetRegZ(void) { return (GetCoreReg(31) << 8) + GetCoreReg(30); }
 
         //! Get names of interrupt vectors
         virtual void GetInterruptVectorNames(const char*const*& names, unsigned int& cnt) const { cnt = 0; } 
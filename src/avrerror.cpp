@@ -42,6 +42,7 @@
 
 #include "avrerror.h"
 #include "helper.h"
+#include "flightrecorder.h"
 
 /* for preprocessor symbol HAVE_SYS_MINGW */
 #include "config.h"
@@ -76,6 +77,12 @@ void SystemConsoleHandler::SetWarningStream(std::ostream *s) {
     wrnStream = s;
 }
 
+void SystemConsoleHandler::TakeOverSettings(const SystemConsoleHandler &h) {
+    useExitAndAbort = h.useExitAndAbort;
+    msgStream = h.msgStream;
+    wrnStream = h.wrnStream;
+}
+
 void SystemConsoleHandler::SetTraceFile(const char *name, unsigned int maxlines) {
     StopTrace();
     std::ofstream* os = new std::ofstream();
@@ -188,6 +195,7 @@ void SystemConsoleHandler::vffatal(const char *file, int line, const char *fmt,
     va_start(ap, fmt);
     vsnprintf(messageStringBuffer, sizeof(messageStringBuffer), mfmt, ap);
     va_end(ap);
+    FlightRecorder::DumpAll(messageStringBuffer, true);
     if(useExitAndAbort) {
         *wrnStream << "\n" << messageStringBuffer << "\n" << std::endl;
         exit(1);
@@ -197,6 +205,7 @@ void SystemConsoleHandler::vffatal(const char *file, int line, const char *fmt,
 }
 
 void SystemConsoleHandler::AbortApplication(int code) {
+    FlightRecorder::DumpAll("abort", true);
     if(useExitAndAbort) {
 #if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
         /* TODO: changed because of problems on windows7 with abort call, with abort it will bring up a
@@ -212,6 +221,7 @@ void SystemConsoleHandler::AbortApplication(int code) {
 }
 
 void SystemConsoleHandler::ExitApplication(int code) {
+    FlightRecorder::DumpAll("exit", false);
     if(useExitAndAbort) {
         exit(code);
     } else {
@@ -234,13 +244,10 @@ char* SystemConsoleHandler::getFormatString(const char *prefix,
     return formatStringBuffer;
 }
 
-// create the handler instance
-SystemConsoleHandler sysConHandler;
-
 int global_verbose_on = 0;
 
 void trioaccess(const char *t, unsigned char val) {
-    sysConHandler.traceOutStream() << t << "=" << HexChar(val) << " ";
+    GetSystemConsoleHandler().traceOutStream() << t << "=" << HexChar(val) << " ";
 }
 
 // EOF
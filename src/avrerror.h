@@ -48,8 +48,8 @@ class SystemConsoleHandler {
     
     public:
         //! creates a SystemConsoleHandler instance
-        /*! This is needed only once for a application, see global variable
-          sysConHandler, where such instance is created by default. */
+        /*! This is needed only once for a simulation, see SimulationContext,
+          where such instance is created. Use GetSystemConsoleHandler to access it. */
         SystemConsoleHandler();
         ~SystemConsoleHandler();
         
@@ -59,6 +59,8 @@ class SystemConsoleHandler {
         void SetMessageStream(std::ostream *s);
         //! Sets the output stream, where warnings and errors are sent to
         void SetWarningStream(std::ostream *s);
+        //! Uses the exit mode, message and warning stream of h, but not its trace
+        void TakeOverSettings(const SystemConsoleHandler &h);
         
         //! Sets the trace to file stream and enables tracing global
         void SetTraceFile(const char *name, unsigned int maxlines = 0);
@@ -121,11 +123,11 @@ class SystemConsoleHandler {
         char *getFormatString(const char *prefix, const char *file, int line, const char *fmtstr);
 };
 
-//! The SystemConsoleHandler instance for common usage
-extern SystemConsoleHandler sysConHandler;
+//! Returns the SystemConsoleHandler instance of the current simulation context
+SystemConsoleHandler &GetSystemConsoleHandler(void);
 
 // redirect old definition ostream traceOut to SystemConsoleHandler.traceStream
-#define traceOut sysConHandler.traceOutStream()
+#define traceOut GetSystemConsoleHandler().traceOutStream()
 
 // moved from trace.h
 //! Verbose enable flag
@@ -135,9 +137,9 @@ extern int global_verbose_on;
 //! Helper function for writing trace (trace IO access)
 void trioaccess(const char *t, unsigned char val);
 
-#define avr_message(...) sysConHandler.vfmessage(__VA_ARGS__)
-#define avr_warning(...) sysConHandler.vfwarning(__FILE__, __LINE__, ## __VA_ARGS__)
-#define avr_failure(...) sysConHandler.vferror(__FILE__, __LINE__, ## __VA_ARGS__)
-#define avr_error(...)   sysConHandler.vffatal(__FILE__, __LINE__, ## __VA_ARGS__)
+#define avr_message(...) GetSystemConsoleHandler().vfmessage(__VA_ARGS__)
+#define avr_warning(...) GetSystemConsoleHandler().vfwarning(__FILE__, __LINE__, ## __VA_ARGS__)
+#define avr_failure(...) GetSystemConsoleHandler().vferror(__FILE__, __LINE__, ## __VA_ARGS__)
+#define avr_error(...)   GetSystemConsoleHandler().vffatal(__FILE__, __LINE__, ## __VA_ARGS__)
 
 #endif /* SIM_AVRERROR_H */
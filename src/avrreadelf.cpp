@@ -33,6 +33,8 @@
 #include <string>
 #include <map>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #include "avrdevice_impl.h"
 
@@ -131,22 +133,20 @@ unsigned int ELFGetSignature(const char *filename) {
     return std::numeric_limits<unsigned int>::max();
 }
 
-#endif
-
-#ifndef _MSC_VER
+void ELFLoadSymbols(const char *filename, Memory *flash, Memory *data) {}
 
-void ELFLoad(const AvrDevice * core) {
-    ELFIO::elfio reader;
+bool ELFGetLineTable(const char *filename,
+                     std::vector<std::string> &files,
+                     std::vector<ELFLineRange> &ranges) {
+    return false;
+}
 
-    if(!reader.load(core->actualFilename))
-        avr_error("File '%s' not found or isn't a elf object",
-                  core->actualFilename.c_str());
+#endif
 
-    if(reader.get_machine() != EM_AVR)
-        avr_error("ELF file '%s' is not for Atmel AVR architecture (%d)",
-                  core->actualFilename.c_str(),
-                  reader.get_machine());
+#ifndef _MSC_VER
 
+// add symbols of elf file to flash, data and eeprom symbol tables
+static void ELFAddSymbols(ELFIO::elfio &reader, Memory *flash, Memory *data, Memory *eeprom) {
     // over all symbols ...
     ELFIO::Elf_Half sec_num = reader.sections.size();
 
@@ -184,19 +184,20 @@ void ELFLoad(const AvrDevice * core) {
                 if(value < 0x800000) {
                     // range of flash space (.text)
                     std::pair<unsigned int, std::string> p(value , name);
-                    core->Flash->AddSymbol(p);
+                    flash->AddSymbol(p);
 
                 } else if(value < 0x810000) {
                     // range of ram (.data)
                     ELFIO::Elf64_Addr offset = value - 0x800000;
                     std::pair<unsigned int, std::string> p(offset, name);
-                    core->data->AddSymbol(p);
+                    data->AddSymbol(p);
 
                 } else if(value < 0x820000) {
                     // range of eeprom (.eeprom)
                     ELFIO::Elf64_Addr offset = value - 0x810000;
                     std::pair<unsigned int, std::string> p(offset, name);
-                    core->eeprom->AddSymbol(p);
+                    if(eeprom != NULL)
+                        eeprom->AddSymbol(p);
 
                 } else if(value < 0x820400) {
                     /* fuses space starting from 0x820000, do nothing */;
@@ -212,9 +213,25 @@ void ELFLoad(const AvrDevice * core) {
             }
         }
     }
+}
+
+void ELFLoad(const AvrDevice * core) {
+    ELFIO::elfio reader;
+
+    if(!reader.load(core->actualFilename))
+        avr_error("File '%s' not found or isn't a elf object",
+                  core->actualFilename.c_str());
+
+    if(reader.get_machine() != EM_AVR)
+        avr_error("ELF file '%s' is not for Atmel AVR architecture (%d)",
+                  core->actualFilename.c_str(),
+                  reader.get_machine());
+
+    ELFAddSymbols(reader, core->Flash, core->data, core->eeprom);
 
     // load program, data and - if available - eeprom, fuses and signature
     ELFIO::Elf_Half seg_num = reader.segments.size();
+    ELFIO::Elf64_Addr dataEnd = 0;
 
     for(ELFIO::Elf_Half i = 0; i < seg_num; i++) {
         ELFIO::segment* pseg = reader.segments[i];
@@ -224,6 +241,10 @@ void ELFLoad(const AvrDevice * core) {
             ELFIO::Elf64_Addr vma = pseg->get_virtual_address();
             ELFIO::Elf64_Addr pma = pseg->get_physical_address();
 
+            // end of static data (.data, .bss, .noinit) in ram
+            if(vma >= 0x800000 && vma < 0x810000 && vma + pseg->get_memory_size() - 0x800000 > dataEnd)
+                dataEnd = vma + pseg->get_memory_size() - 0x800000;
+
             if(filesize == 0)
                 continue;
 
@@ -261,6 +282,18 @@ void ELFLoad(const AvrDevice * core) {
             }
         }
     }
+
+    // stack must not grow into static data
+    core->stack->SetStackLimit(dataEnd);
+}
+
+void ELFLoadSymbols(const char *filename, Memory *flash, Memory *data) {
+    ELFIO::elfio reader;
+
+    if(!reader.load(filename))
+        avr_error("File '%s' not found or isn't a elf object", filename);
+
+    ELFAddSymbols(reader, flash, data, NULL);
 }
 
 unsigned int ELFGetSignature(const char *filename) {
@@ -305,6 +338,339 @@ unsigned int ELFGetSignature(const char *filename) {
     return signature;
 }
 
+//! Reads values from a DWARF section, stops at end of data
+class DwarfReader {
+    public:
+        const unsigned char *data;
+        size_t size;
+        size_t pos;
+
+        DwarfReader(const unsigned char *d, size_t s): data(d), size(s), pos(0) {}
+
+        bool AtEnd(void) const { return pos >= size; }
+
+        unsigned long long Fixed(unsigned int len) {
+            unsigned long long val = 0;
+            for(unsigned int i = 0; i < len && pos < size; i++, pos++)
+                val |= (unsigned long long)data[pos] << (i * 8);
+            return val;
+        }
+
+        unsigned long long ULeb(void) {
+            unsigned long long val = 0;
+            unsigned int shift = 0;
+            while(pos < size) {
+                unsigned char b = data[pos++];
+                if(shift < 64)
+                    val |= (unsigned long long)(b & 0x7f) << shift;
+                shift += 7;
+                if((b & 0x80) == 0)
+                    break;
+            }
+            return val;
+        }
+
+        long long SLeb(void) {
+            long long val = 0;
+            unsigned int shift = 0;
+            unsigned char b = 0;
+            while(pos < size) {
+                b = data[pos++];
+                if(shift < 64)
+                    val |= (long long)(b & 0x7f) << shift;
+                shift += 7;
+                if((b & 0x80) == 0)
+                    break;
+            }
+            if(shift < 64 && (b & 0x40))
+                val |= -((long long)1 << shift);
+            return val;
+        }
+
+        std::string String(void) {
+            size_t start = pos;
+            while(pos < size && data[pos] != 0)
+                pos++;
+            std::string str((const char *)data + start, pos - start);
+            if(pos < size)
+                pos++;
+            return str;
+        }
+};
+
+static std::string DwarfSectionString(ELFIO::section *sec, unsigned long long offset) {
+    if(sec == NULL || offset >= sec->get_size())
+        return "";
+    DwarfReader r((const unsigned char *)sec->get_data(), sec->get_size());
+    r.pos = offset;
+    return r.String();
+}
+
+// DWARF 5 entry formats of directory and file tables
+static bool DwarfReadEntryTable(DwarfReader &r, bool dwarf64,
+                                ELFIO::section *lineStr, ELFIO::section *str,
+                                std::vector<std::string> &names,
+                                std::vector<unsigned int> &dirs) {
+    unsigned int formatCount = r.Fixed(1);
+    std::vector<std::pair<unsigned long long, unsigned long long> > format;
+    for(unsigned int i = 0; i < formatCount; i++) {
+        unsigned long long type = r.ULeb();
+        format.push_back(std::make_pair(type, r.ULeb()));
+    }
+    unsigned long long count = r.ULeb();
+    for(unsigned long long n = 0; n < count && !r.AtEnd(); n++) {
+        std::string name;
+        unsigned long long dir = 0;
+        for(size_t i = 0; i < format.size(); i++) {
+            unsigned long long val = 0;
+            std::string sval;
+            switch(format[i].second) {
+                case 0x08: sval = r.String(); break; // DW_FORM_string
+                case 0x1f: sval = DwarfSectionString(lineStr, r.Fixed(dwarf64 ? 8 : 4)); break; // DW_FORM_line_strp
+                case 0x0e: sval = DwarfSectionString(str, r.Fixed(dwarf64 ? 8 : 4)); break; // DW_FORM_strp
+                case 0x0b: val = r.Fixed(1); break; // DW_FORM_data1
+                case 0x05: val = r.Fixed(2); break; // DW_FORM_data2
+                case 0x06: val = r.Fixed(4); break; // DW_FORM_data4
+                case 0x07: val = r.Fixed(8); break; // DW_FORM_data8
+                case 0x1e: r.pos += 16; break; // DW_FORM_data16
+                case 0x0f: val = r.ULeb(); break; // DW_FORM_udata
+                case 0x09: r.pos += r.ULeb(); break; // DW_FORM_block
+                default:
+                    return false;
+            }
+            if(format[i].first == 1) // DW_LNCT_path
+                name = sval;
+            else if(format[i].first == 2) // DW_LNCT_directory_index
+                dir = val;
+        }
+        names.push_back(name);
+        dirs.push_back(dir);
+    }
+    return true;
+}
+
+// true, if a function symbol of the program starts on flash address
+static bool ELFHasFunctionAt(ELFIO::elfio &reader, ELFIO::Elf64_Addr address) {
+    for(ELFIO::Elf_Half i = 0; i < reader.sections.size(); i++) {
+        ELFIO::section* psec = reader.sections[i];
+        if(psec->get_type() != SHT_SYMTAB)
+            continue;
+        const ELFIO::symbol_section_accessor symbols(reader, psec);
+        for(ELFIO::Elf_Xword j = 0; j < symbols.get_symbols_num(); j++) {
+            std::string       name;
+            ELFIO::Elf64_Addr value = 0;
+            ELFIO::Elf_Xword  size = 0;
+            unsigned char     bind = 0;
+            unsigned char     type = 0;
+            ELFIO::Elf_Half   section_index = 0;
+            unsigned char     other = 0;
+            symbols.get_symbol(j, name, value, size, bind,
+                                  type, section_index, other);
+            if(type == STT_FUNC && value == address && size > 0 &&
+               section_index != SHN_UNDEF && section_index != SHN_ABS)
+                return true;
+        }
+    }
+    return false;
+}
+
+bool ELFGetLineTable(const char *filename,
+                     std::vector<std::string> &files,
+                     std::vector<ELFLineRange> &ranges) {
+    ELFIO::elfio reader;
+
+    if(!reader.load(filename))
+        avr_error("File '%s' not found or isn't a elf object", filename);
+
+    // with --gc-sections the line sequences of removed functions start on
+    // address 0, they are dropped, if no function is there (vector table)
+    bool functionAtZero = ELFHasFunctionAt(reader, 0);
+
+    ELFIO::section *lineSec = reader.sections[".debug_line"];
+    if(lineSec == NULL || lineSec->get_data() == NULL)
+        return false;
+    ELFIO::section *lineStr = reader.sections[".debug_line_str"];
+    ELFIO::section *str = reader.sections[".debug_str"];
+
+    std::map<std::string, unsigned int> fileIndex;
+    DwarfReader sec((const unsigned char *)lineSec->get_data(), lineSec->get_size());
+
+    while(!sec.AtEnd()) {
+        // header of line number program
+        bool dwarf64 = false;
+        unsigned long long unitLength = sec.Fixed(4);
+        if(unitLength == 0xffffffff) {
+            dwarf64 = true;
+            unitLength = sec.Fixed(8);
+        }
+        size_t unitEnd = sec.pos + unitLength;
+        if(unitEnd > sec.size)
+            break;
+        DwarfReader r(sec.data, unitEnd);
+        r.pos = sec.pos;
+        sec.pos = unitEnd;
+
+        unsigned int version = r.Fixed(2);
+        if(version < 2 || version > 5)
+            continue;
+        if(version >= 5)
+            r.pos += 2; // address_size, segment_selector_size
+        unsigned long long headerLength = r.Fixed(dwarf64 ? 8 : 4);
+        size_t programStart = r.pos + headerLength;
+        unsigned int minInstLength = r.Fixed(1);
+        if(version >= 4)
+            r.Fixed(1); // maximum_operations_per_instruction, always 1 on AVR
+        r.Fixed(1); // default_is_stmt, all rows are used
+        int lineBase = (signed char)r.Fixed(1);
+        unsigned int lineRange = r.Fixed(1);
+        unsigned int opcodeBase = r.Fixed(1);
+        if(lineRange == 0 || opcodeBase == 0)
+            continue;
+        std::vector<unsigned int> opcodeLengths(opcodeBase, 0);
+        for(unsigned int i = 1; i < opcodeBase; i++)
+            opcodeLengths[i] = r.Fixed(1);
+
+        std::vector<std::string> dirNames, fileNames;
+        std::vector<unsigned int> fileDirs, unused;
+        if(version >= 5) {
+            if(!DwarfReadEntryTable(r, dwarf64, lineStr, str, dirNames, unused) ||
+               !DwarfReadEntryTable(r, dwarf64, lineStr, str, fileNames, fileDirs))
+                continue;
+        } else {
+            // index 0 is the compilation directory and the primary file
+            dirNames.push_back("");
+            fileNames.push_back("");
+            fileDirs.push_back(0);
+            for(;;) {
+                std::string d = r.String();
+                if(d.empty())
+                    break;
+                dirNames.push_back(d);
+            }
+            for(;;) {
+                std::string f = r.String();
+                if(f.empty())
+                    break;
+                fileNames.push_back(f);
+                fileDirs.push_back(r.ULeb());
+                r.ULeb(); // modification time
+                r.ULeb(); // length
+            }
+        }
+
+        // map file numbers of this unit to the global file list
+        std::vector<unsigned int> unitFiles;
+        for(size_t i = 0; i < fileNames.size(); i++) {
+            std::string path = fileNames[i];
+            if(!path.empty() && path[0] != '/' && fileDirs[i] < dirNames.size() && !dirNames[fileDirs[i]].empty())
+                path = dirNames[fileDirs[i]] + "/" + path;
+            std::map<std::string, unsigned int>::iterator it = fileIndex.find(path);
+            if(it == fileIndex.end()) {
+                it = fileIndex.insert(std::make_pair(path, (unsigned int)files.size())).first;
+                files.push_back(path);
+            }
+            unitFiles.push_back(it->second);
+        }
+
+        // run line number program, a range ends with the next row
+        r.pos = programStart;
+        unsigned long long address = 0;
+        unsigned long long file = 1;
+        long long line = 1;
+        bool haveRow = false;
+        ELFLineRange row = { 0, 0, 0, 0 };
+        std::vector<ELFLineRange> sequence; // rows of the current sequence
+        auto endOfSequence = [&]() {
+            if(!sequence.empty() && (sequence[0].start != 0 || functionAtZero))
+                ranges.insert(ranges.end(), sequence.begin(), sequence.end());
+            sequence.clear();
+        };
+        while(!r.AtEnd()) {
+            unsigned int op = r.Fixed(1);
+            bool emit = false, endSequence = false;
+            if(op >= opcodeBase) {
+                unsigned int adj = op - opcodeBase;
+                address += (adj / lineRange) * minInstLength;
+                line += lineBase + (int)(adj % lineRange);
+                emit = true;
+            } else if(op == 0) {
+                unsigned long long len = r.ULeb();
+                size_t next = r.pos + len;
+                unsigned int sub = len > 0 ? r.Fixed(1) : 0;
+                if(sub == 1) { // DW_LNE_end_sequence
+                    emit = endSequence = true;
+                } else if(sub == 2) { // DW_LNE_set_address
+                    address = r.Fixed(len - 1);
+                } else if(sub == 3) { // DW_LNE_define_file
+                    std::string f = r.String();
+                    unsigned long long d = r.ULeb();
+                    std::string path = f;
+                    if(!path.empty() && path[0] != '/' && d < dirNames.size() && !dirNames[d].empty())
+                        path = dirNames[d] + "/" + path;
+                    std::map<std::string, unsigned int>::iterator it = fileIndex.find(path);
+                    if(it == fileIndex.end()) {
+                        it = fileIndex.insert(std::make_pair(path, (unsigned int)files.size())).first;
+                        files.push_back(path);
+                    }
+                    unitFiles.push_back(it->second);
+                }
+                r.pos = next;
+            } else {
+                switch(op) {
+                    case 1: emit = true; break; // DW_LNS_copy
+                    case 2: address += r.ULeb() * minInstLength; break; // DW_LNS_advance_pc
+                    case 3: line += r.SLeb(); break; // DW_LNS_advance_line
+                    case 4: file = r.ULeb(); break; // DW_LNS_set_file
+                    case 8: address += ((255 - opcodeBase) / lineRange) * minInstLength; break; // DW_LNS_const_add_pc
+                    case 9: address += r.Fixed(2); break; // DW_LNS_fixed_advance_pc
+                    default:
+                        // DW_LNS_set_column, set_isa and unknown opcodes: skip arguments
+                        for(unsigned int i = 0; i < opcodeLengths[op]; i++)
+                            r.ULeb();
+                        break;
+                }
+            }
+            if(!emit)
+                continue;
+
+            if(haveRow && address > row.start) {
+                row.end = address;
+                if(row.end <= 0x800000) // only flash address space
+                    sequence.push_back(row);
+            }
+            if(endSequence) {
+                endOfSequence();
+                haveRow = false;
+                address = 0;
+                file = 1;
+                line = 1;
+            } else {
+                haveRow = true;
+                row.start = address;
+                row.file = (file < unitFiles.size()) ? unitFiles[file] : 0;
+                row.line = (line > 0) ? line : 0;
+            }
+        }
+        endOfSequence();
+    }
+
+    // other sequences of removed functions could overlap, first one wins
+    std::stable_sort(ranges.begin(), ranges.end(),
+                     [](const ELFLineRange &a, const ELFLineRange &b) { return a.start < b.start; });
+    size_t kept = 0;
+    for(size_t i = 0; i < ranges.size(); i++) {
+        if(kept > 0 && ranges[i].start < ranges[kept - 1].end) {
+            if(ranges[i].end <= ranges[kept - 1].end)
+                continue;
+            ranges[i].start = ranges[kept - 1].end;
+        }
+        ranges[kept++] = ranges[i];
+    }
+    ranges.resize(kept);
+
+    return !ranges.empty();
+}
+
 #endif
 
 // EOF
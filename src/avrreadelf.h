@@ -28,7 +28,30 @@
 
 #include "avrdevice.h"
 
+#include <string>
+#include <vector>
+
+class Memory;
+
+//! Range of flash addresses, which belongs to one source line
+struct ELFLineRange {
+    unsigned int start; //!< first byte address of range
+    unsigned int end; //!< first byte address behind range
+    unsigned int file; //!< index of source file in file list
+    unsigned int line; //!< line number in source file
+};
+
 unsigned int ELFGetSignature(const char *filename);
 void ELFLoad(const AvrDevice * core);
 
+//! Reads only the symbols of a elf file into the symbol tables of flash and data
+void ELFLoadSymbols(const char *filename, Memory *flash, Memory *data);
+
+//! Reads the line table (.debug_line, DWARF 2 to 5) of a elf file
+/*! Returns false, if the file has no line table. Ranges are in flash address
+  space, sorted by start address and don't overlap. */
+bool ELFGetLineTable(const char *filename,
+                     std::vector<std::string> &files,
+                     std::vector<ELFLineRange> &ranges);
+
 #endif
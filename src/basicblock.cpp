@@ -0,0 +1,108 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "basicblock.h"
+#include "flash.h"
+
+BasicBlockCache::BasicBlockCache(AvrFlash *f, unsigned int _words):
+    flash(f),
+    words(_words),
+    count(0),
+    generation(0) {}
+
+BasicBlockCache::~BasicBlockCache() {
+    Clear();
+}
+
+BasicBlock *BasicBlockCache::Translate(unsigned int pc) {
+    unsigned int addr = pc;
+
+    // collect instructions till a instruction, which changes program flow
+    while(addr < words && (addr - pc) < maxLength) {
+        if(flash->ThreadedMem[addr].GetHandler() == AvrFlash::DecodeOnFetch)
+            flash->PrecompileWord(addr, false);
+        const ThreadedInstruction &ti = flash->ThreadedMem[addr];
+        addr += ti.size2Word ? 2 : 1;
+        if(ti.endsBlock)
+            break;
+    }
+
+    BasicBlock *block = new BasicBlock;
+    block->start = pc;
+    block->end = (addr < words) ? addr : words;
+    block->next = nullptr;
+    block->nextGeneration = generation;
+    blocks[pc] = block;
+    count++;
+    return block;
+}
+
+BasicBlock *BasicBlockCache::Get(unsigned int pc) {
+    if(pc >= words)
+        return nullptr;
+    if(blocks.empty())
+        blocks.resize(words, nullptr);
+    if(blocks[pc] != nullptr)
+        return blocks[pc];
+    return Translate(pc);
+}
+
+BasicBlock *BasicBlockCache::GetLinked(BasicBlock *from, unsigned int pc) {
+    if(from->next != nullptr && from->nextGeneration == generation && from->next->start == pc)
+        return from->next;
+    BasicBlock *block = Get(pc);
+    from->next = block;
+    from->nextGeneration = generation;
+    return block;
+}
+
+void BasicBlockCache::Invalidate(unsigned int pc) {
+    if(count == 0)
+        return;
+    // a block, which contains pc, can start maxLength words before pc
+    unsigned int addr = (pc > maxLength) ? pc - maxLength : 0;
+    for(; addr <= pc && addr < blocks.size(); addr++) {
+        BasicBlock *block = blocks[addr];
+        if(block != nullptr && block->end > pc) {
+            delete block;
+            blocks[addr] = nullptr;
+            count--;
+            generation++;
+        }
+    }
+}
+
+void BasicBlockCache::Clear(void) {
+    for(unsigned int i = 0; count > 0 && i < blocks.size(); i++) {
+        if(blocks[i] != nullptr) {
+            delete blocks[i];
+            blocks[i] = nullptr;
+            count--;
+        }
+    }
+    generation++;
+}
+
+// EOF
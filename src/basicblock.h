@@ -0,0 +1,85 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef BASICBLOCK_H_INCLUDED
+#define BASICBLOCK_H_INCLUDED
+
+#include <vector>
+
+class AvrFlash;
+
+//! Run of instructions in flash, which ends with a change of program flow
+/*! A block is translated once from the threaded code records of AvrFlash and
+  then used by AvrDevice to execute instructions without checking for
+  breakpoints and flash end on every instruction. */
+struct BasicBlock {
+    unsigned int start; //!< word address of first instruction
+    unsigned int end; //!< word address behind last instruction
+    BasicBlock *next; //!< successor block, linked on first use
+    unsigned long nextGeneration; //!< cache generation, for which next is valid
+};
+
+//! Holds translated basic blocks for a AvrFlash instance
+/*! Blocks are dropped, if a flash word, which is part of a block, is decoded
+  again, for example by a program load, a SPM page write or a flash write from
+  gdb. Then the generation of the cache changes and pointers to blocks, which
+  are held outside of the cache, are invalid. */
+class BasicBlockCache {
+
+    protected:
+        AvrFlash *flash;
+        unsigned int words; //!< flash size in words
+        std::vector<BasicBlock*> blocks; //!< blocks by word address of first instruction, allocated on first use
+        unsigned int count; //!< number of blocks in cache
+        unsigned long generation; //!< changes, if blocks are dropped
+
+        //! Translates a new block beginning at word address pc
+        BasicBlock *Translate(unsigned int pc);
+
+    public:
+        //! Max count of words in a block (plus second word of last instruction)
+        static const unsigned int maxLength = 64;
+
+        BasicBlockCache(AvrFlash *f, unsigned int words);
+        ~BasicBlockCache();
+
+        //! Returns block beginning at word address pc, translates it, if necessary
+        /*! Returns nullptr, if pc is outside of flash. */
+        BasicBlock *Get(unsigned int pc);
+
+        //! Like Get, but try the link of block 'from' first and link the result
+        BasicBlock *GetLinked(BasicBlock *from, unsigned int pc);
+
+        //! Drops all blocks, which contain word address pc
+        void Invalidate(unsigned int pc);
+
+        //! Drops all blocks
+        void Clear(void);
+
+        //! Returns current generation, block pointers from a other generation are invalid
+        unsigned long GetGeneration(void) const { return generation; }
+};
+
+#endif
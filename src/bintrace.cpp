@@ -0,0 +1,345 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "bintrace.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+
+#include <set>
+#include <cstring>
+#include <stdint.h>
+
+static const char traceMagic[8] = { 'S', 'A', 'V', 'R', 'T', 'R', 'C', 'E' };
+static const size_t minMatch = 4; //!< shortest match of LZ compression
+static const unsigned int hashBits = 12; //!< size of hash table of LZ compression
+static const uint32_t maxRawBlock = 16 * 1024 * 1024; //!< larger blocks in a file are corrupt
+
+//! Flushes open traces, if the program ends by exit, e.g. by RWExit
+static struct OpenTraces {
+    std::set<BinaryTrace *> traces;
+    ~OpenTraces() {
+        for(std::set<BinaryTrace *>::iterator i = traces.begin(); i != traces.end(); i++)
+            (*i)->FlushBlock();
+    }
+} openTraces;
+
+static void PutLE(std::ostream &os, unsigned long long val, size_t len) {
+    for(size_t i = 0; i < len; i++)
+        os.put((char)((val >> (i * 8)) & 0xff));
+}
+
+static bool GetLE(std::istream &is, unsigned long long &val, size_t len) {
+    unsigned char buf[8];
+    if(!is.read((char *)buf, len))
+        return false;
+    val = 0;
+    for(size_t i = len; i > 0; i--)
+        val = (val << 8) | buf[i - 1];
+    return true;
+}
+
+BinaryTrace::BinaryTrace(AvrDevice *core, const std::string &_filename):
+    file(_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+    filename(_filename),
+    lastCycle(0),
+    lastPC(core->PC - 1) {
+    if(!file)
+        avr_error("binary trace: can't create file '%s'", filename.c_str());
+
+    file.write(traceMagic, sizeof(traceMagic));
+    PutLE(file, version, 4);
+    const std::string &name = core->GetDeviceName();
+    PutLE(file, name.size(), 2);
+    file.write(name.data(), name.size());
+    PutLE(file, core->GetClockFreq(), 8);
+
+    block.reserve(blockSize + 64);
+    packed.resize(blockSize + blockSize / 255 + 64);
+    StartBlock();
+    openTraces.traces.insert(this);
+}
+
+BinaryTrace::~BinaryTrace() {
+    openTraces.traces.erase(this);
+    FlushBlock();
+}
+
+void BinaryTrace::StartBlock(void) {
+    block.clear();
+    block.push_back(TAG_SYNC);
+    PutVarint(lastCycle);
+    PutVarint(lastPC);
+    syncSize = block.size();
+}
+
+void BinaryTrace::Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) {
+    if(block.size() >= blockLimit)
+        FlushBlock();
+    block.push_back(TAG_INTERRUPT);
+    PutVarint(cycle - lastCycle);
+    PutVarint(vector);
+    lastCycle = cycle;
+}
+
+void BinaryTrace::FlushBlock(void) {
+    if(block.size() <= syncSize)
+        return;
+    if(packed.size() < block.size() + block.size() / 255 + 16)
+        packed.resize(block.size() + block.size() / 255 + 16);
+    size_t len = Compress(&block[0], block.size(), &packed[0]);
+    PutLE(file, block.size(), 4);
+    if(len < block.size()) {
+        PutLE(file, len, 4);
+        file.write((const char *)&packed[0], len);
+    } else {
+        PutLE(file, block.size(), 4);
+        file.write((const char *)&block[0], block.size());
+    }
+    file.flush();
+    if(!file)
+        avr_error("binary trace: can't write file '%s'", filename.c_str());
+    StartBlock();
+}
+
+static inline uint32_t Read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static unsigned char *PutLength(unsigned char *op, size_t len) {
+    while(len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+// LZ77 with the sequence layout of LZ4: token (literal length, match length),
+// literals, 16 bit offset, the last sequence has literals only
+size_t BinaryTrace::Compress(const unsigned char *in, size_t n, unsigned char *out) {
+    uint32_t table[1 << hashBits];
+    memset(table, 0, sizeof(table));
+    unsigned char *op = out;
+    size_t ip = 0, anchor = 0;
+
+    while(ip + minMatch <= n) {
+        uint32_t seq = Read32(in + ip);
+        uint32_t h = (seq * 2654435761u) >> (32 - hashBits);
+        size_t ref = table[h];
+        table[h] = ip + 1;
+        if(ref == 0 || ip - (ref - 1) > 0xffff || Read32(in + ref - 1) != seq) {
+            ip++;
+            continue;
+        }
+        size_t m = ref - 1;
+        size_t len = minMatch;
+        while(ip + len < n && in[m + len] == in[ip + len])
+            len++;
+
+        size_t lit = ip - anchor;
+        size_t ml = len - minMatch;
+        *op++ = (unsigned char)(((lit < 15 ? lit : 15) << 4) | (ml < 15 ? ml : 15));
+        if(lit >= 15)
+            op = PutLength(op, lit - 15);
+        memcpy(op, in + anchor, lit);
+        op += lit;
+        *op++ = (ip - m) & 0xff;
+        *op++ = (ip - m) >> 8;
+        if(ml >= 15)
+            op = PutLength(op, ml - 15);
+
+        ip += len;
+        anchor = ip;
+    }
+
+    size_t lit = n - anchor;
+    *op++ = (unsigned char)((lit < 15 ? lit : 15) << 4);
+    if(lit >= 15)
+        op = PutLength(op, lit - 15);
+    memcpy(op, in + anchor, lit);
+    op += lit;
+    return op - out;
+}
+
+bool BinaryTrace::Decompress(const unsigned char *in, size_t n, unsigned char *out, size_t outSize) {
+    size_t ip = 0, op = 0;
+    while(ip < n) {
+        unsigned char token = in[ip++];
+        size_t lit = token >> 4;
+        if(lit == 15) {
+            unsigned char b;
+            do {
+                if(ip >= n)
+                    return false;
+                b = in[ip++];
+                lit += b;
+            } while(b == 255);
+        }
+        if(lit > n - ip || lit > outSize - op)
+            return false;
+        memcpy(out + op, in + ip, lit);
+        ip += lit;
+        op += lit;
+        if(ip == n)
+            break; // last sequence
+
+        if(n - ip < 2)
+            return false;
+        size_t offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        size_t len = token & 0x0f;
+        if(len == 15) {
+            unsigned char b;
+            do {
+                if(ip >= n)
+                    return false;
+                b = in[ip++];
+                len += b;
+            } while(b == 255);
+        }
+        len += minMatch;
+        if(offset == 0 || offset > op || len > outSize - op)
+            return false;
+        // byte by byte, match could overlap with output
+        for(size_t i = 0; i < len; i++, op++)
+            out[op] = out[op - offset];
+    }
+    return op == outSize;
+}
+
+BinaryTraceReader::BinaryTraceReader(const std::string &_filename):
+    file(_filename.c_str(), std::ios::in | std::ios::binary),
+    filename(_filename),
+    clockPeriod(0),
+    pos(0),
+    cycle(0),
+    pc(0) {
+    if(!file)
+        avr_error("binary trace: can't open file '%s'", filename.c_str());
+
+    char magic[sizeof(traceMagic)];
+    unsigned long long v, len;
+    if(!file.read(magic, sizeof(magic)) || memcmp(magic, traceMagic, sizeof(magic)) != 0)
+        avr_error("binary trace: '%s' isn't a binary trace", filename.c_str());
+    if(!GetLE(file, v, 4) || v == 0 || v > BinaryTrace::version)
+        avr_error("binary trace: format version of '%s' isn't supported", filename.c_str());
+    if(!GetLE(file, len, 2))
+        avr_error("binary trace: '%s' is truncated", filename.c_str());
+    deviceName.resize(len);
+    if((len > 0 && !file.read(&deviceName[0], len)) || !GetLE(file, clockPeriod, 8))
+        avr_error("binary trace: '%s' is truncated", filename.c_str());
+}
+
+bool BinaryTraceReader::ReadBlock(void) {
+    unsigned long long raw, stored;
+    if(!GetLE(file, raw, 4))
+        return false;
+    if(!GetLE(file, stored, 4) || raw > maxRawBlock || stored > raw)
+        avr_error("binary trace: '%s' is corrupt", filename.c_str());
+    block.resize(raw);
+    pos = 0;
+    if(stored == raw) {
+        if(raw > 0 && !file.read((char *)&block[0], raw))
+            avr_error("binary trace: '%s' is truncated", filename.c_str());
+        return true;
+    }
+    packed.resize(stored);
+    if(stored > 0 && !file.read((char *)&packed[0], stored))
+        avr_error("binary trace: '%s' is truncated", filename.c_str());
+    if(!BinaryTrace::Decompress(&packed[0], stored, &block[0], raw))
+        avr_error("binary trace: block in '%s' is corrupt", filename.c_str());
+    return true;
+}
+
+unsigned char BinaryTraceReader::GetByte(void) {
+    if(pos >= block.size())
+        avr_error("binary trace: record in '%s' is truncated", filename.c_str());
+    return block[pos++];
+}
+
+unsigned long long BinaryTraceReader::GetVarint(void) {
+    unsigned long long val = 0;
+    unsigned int shift = 0;
+    unsigned char b;
+    do {
+        b = GetByte();
+        if(shift < 64)
+            val |= (unsigned long long)(b & 0x7f) << shift;
+        shift += 7;
+    } while(b & 0x80);
+    return val;
+}
+
+bool BinaryTraceReader::Next(Event &ev) {
+    for(;;) {
+        while(pos >= block.size()) {
+            if(!ReadBlock())
+                return false;
+        }
+
+        unsigned char tag = GetByte();
+        if(tag >= BinaryTrace::TAG_REGISTER_WRITE && tag < BinaryTrace::TAG_REGISTER_WRITE + 32) {
+            ev.type = EV_WRITE;
+            ev.address = tag - BinaryTrace::TAG_REGISTER_WRITE;
+            ev.value = GetByte();
+        } else if(tag >= BinaryTrace::TAG_NEXT_INSTRUCTION && tag < BinaryTrace::TAG_REGISTER_WRITE) {
+            cycle += tag - BinaryTrace::TAG_NEXT_INSTRUCTION;
+            pc++;
+            ev.type = EV_INSTRUCTION;
+        } else if(tag == BinaryTrace::TAG_INSTRUCTION) {
+            cycle += GetVarint();
+            unsigned long long z = GetVarint();
+            long long delta = (long long)(z >> 1) ^ -(long long)(z & 1);
+            pc += 1 + delta;
+            ev.type = EV_INSTRUCTION;
+        } else if(tag == BinaryTrace::TAG_WRITE) {
+            ev.type = EV_WRITE;
+            ev.address = GetVarint();
+            ev.value = GetByte();
+        } else if(tag == BinaryTrace::TAG_BIT_WRITE) {
+            ev.address = GetVarint();
+            unsigned char b = GetByte();
+            ev.type = (b & 0x80) ? EV_BIT_SET : EV_BIT_CLEAR;
+            ev.value = b & 0x07;
+        } else if(tag == BinaryTrace::TAG_INTERRUPT) {
+            cycle += GetVarint();
+            ev.type = EV_INTERRUPT;
+            ev.address = GetVarint();
+        } else if(tag == BinaryTrace::TAG_SYNC) {
+            cycle = GetVarint();
+            pc = GetVarint();
+            continue;
+        } else
+            avr_error("binary trace: unknown record 0x%02x in '%s'", tag, filename.c_str());
+
+        ev.cycle = cycle;
+        ev.pc = pc;
+        return true;
+    }
+}
+
+// EOF
@@ -0,0 +1,193 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef BINTRACE
+#define BINTRACE
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "instructionobserver.h"
+
+class AvrDevice;
+
+//! Writes a binary trace of executed instructions, memory writes and interrupts
+/*! The file starts with a header (magic, version, device name, clock period in
+  ns), then blocks follow. Every block has a header with raw and stored size
+  (32 bit little endian) and is LZ compressed, if this makes it smaller. A
+  block starts with a sync record and can be decoded without the blocks
+  before. Records in a block:
+
+  - 0x01 cycle pc: sync, sets cycle and PC of last instruction
+  - 0x02 delta pcdelta: instruction, cycle delta and signed PC delta to last PC + 1
+  - 0x03 address value: write to data memory
+  - 0x04 delta vector: interrupt entered
+  - 0x05 address bit: bit set (bit + 0x80) or cleared by sbi or cbi
+  - 0x40 + delta: instruction on last PC + 1, cycle delta < 64
+  - 0x80 + register, value: write to R0 to R31
+
+  Numbers are unsigned LEB128 varints, signed ones zigzag encoded, values are
+  one byte. */
+class BinaryTrace: public InstructionObserver {
+
+    public:
+        static const unsigned int version = 2; //!< version of file format, version 1 has no bit records
+        static const unsigned int blockSize = 65536; //!< maximum raw size of a block
+
+        //! Record tags
+        enum {
+            TAG_SYNC = 0x01,
+            TAG_INSTRUCTION = 0x02,
+            TAG_WRITE = 0x03,
+            TAG_INTERRUPT = 0x04,
+            TAG_BIT_WRITE = 0x05,
+            TAG_NEXT_INSTRUCTION = 0x40,
+            TAG_REGISTER_WRITE = 0x80
+        };
+
+        //! Creates trace file for core
+        BinaryTrace(AvrDevice *core, const std::string &filename);
+        //! Writes the last block and closes file
+        ~BinaryTrace();
+
+        void Instruction(unsigned int pc, unsigned long long cycle) override {
+            if(block.size() >= blockLimit)
+                FlushBlock();
+            unsigned long long delta = cycle - lastCycle;
+            if(pc == lastPC + 1 && delta < 0x40)
+                block.push_back(TAG_NEXT_INSTRUCTION + delta);
+            else {
+                block.push_back(TAG_INSTRUCTION);
+                PutVarint(delta);
+                PutVarint(ZigZag((long long)pc - (long long)lastPC - 1));
+            }
+            lastCycle = cycle;
+            lastPC = pc;
+        }
+
+        //! Called by core for a write to data memory (registers, io and ram)
+        void Write(unsigned int addr, unsigned char val) {
+            if(addr < 32)
+                block.push_back(TAG_REGISTER_WRITE + addr);
+            else {
+                block.push_back(TAG_WRITE);
+                PutVarint(addr);
+            }
+            block.push_back(val);
+        }
+
+        //! Called by core, if sbi or cbi sets or clears bit of a io register
+        void WriteBit(unsigned int addr, unsigned int bit, bool set) {
+            block.push_back(TAG_BIT_WRITE);
+            PutVarint(addr);
+            block.push_back(bit | (set ? 0x80 : 0));
+        }
+
+        void Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) override;
+
+        //! Writes collected records as block to file
+        void FlushBlock(void);
+
+        //! Compresses n bytes from in to out, out needs n + n / 255 + 16 bytes, returns size of out
+        static size_t Compress(const unsigned char *in, size_t n, unsigned char *out);
+        //! Decompresses n bytes from in to out with outSize bytes, returns false, if data is corrupt
+        static bool Decompress(const unsigned char *in, size_t n, unsigned char *out, size_t outSize);
+
+    private:
+        static const unsigned int blockLimit = blockSize - 32; //!< flush, if a record could exceed blockSize
+
+        std::ofstream file; //!< the trace file
+        std::string filename; //!< name of trace file, for messages
+        std::vector<unsigned char> block; //!< records of current block
+        std::vector<unsigned char> packed; //!< buffer for compressed block
+        unsigned long long lastCycle; //!< cycle of last instruction or interrupt
+        unsigned int lastPC; //!< flash word of last instruction
+        size_t syncSize; //!< size of sync record at begin of block
+
+        void PutVarint(unsigned long long val) {
+            while(val >= 0x80) {
+                block.push_back((val & 0x7f) | 0x80);
+                val >>= 7;
+            }
+            block.push_back(val);
+        }
+        static unsigned long long ZigZag(long long val) {
+            return ((unsigned long long)val << 1) ^ (unsigned long long)(val >> 63);
+        }
+        //! Starts a new block with a sync record
+        void StartBlock(void);
+};
+
+//! Reads a binary trace file record by record
+class BinaryTraceReader {
+
+    public:
+        //! Kind of a event
+        enum EventType {
+            EV_INSTRUCTION, //!< instruction on pc started in cycle
+            EV_WRITE, //!< value written to data memory address
+            EV_BIT_SET, //!< bit (in value) of data memory address set
+            EV_BIT_CLEAR, //!< bit (in value) of data memory address cleared
+            EV_INTERRUPT //!< interrupt vector entered in cycle
+        };
+
+        //! A event of the trace
+        struct Event {
+            EventType type; //!< kind of event
+            unsigned long long cycle; //!< cycle of last instruction or of interrupt
+            unsigned int pc; //!< flash word of last instruction
+            unsigned int address; //!< data address for EV_WRITE and bit events, vector number for EV_INTERRUPT
+            unsigned char value; //!< written value for EV_WRITE, bit number for bit events
+        };
+
+        //! Opens trace file, aborts, if it isn't a binary trace
+        BinaryTraceReader(const std::string &filename);
+
+        //! Returns the next event, false at end of file
+        bool Next(Event &ev);
+
+        //! Device name from trace header
+        const std::string &GetDeviceName(void) const { return deviceName; }
+        //! Clock period in ns from trace header
+        unsigned long long GetClockPeriod(void) const { return clockPeriod; }
+
+    private:
+        std::ifstream file; //!< the trace file
+        std::string filename; //!< name of trace file, for messages
+        std::string deviceName; //!< device name from header
+        unsigned long long clockPeriod; //!< clock period from header
+        std::vector<unsigned char> block; //!< decoded records of current block
+        std::vector<unsigned char> packed; //!< stored data of current block
+        size_t pos; //!< read position in block
+        unsigned long long cycle; //!< cycle of last instruction or interrupt
+        unsigned int pc; //!< flash word of last instruction
+
+        bool ReadBlock(void);
+        unsigned long long GetVarint(void);
+        unsigned char GetByte(void);
+};
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#if !defined(HAVE_SYS_MINGW) && !defined(_MSC_VER)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include "config.h"
+#include "forkserver.h"
+#include "avrerror.h"
+#include "systemclock.h"
+#include "specialmem.h"
+#include "string2.h"
+#include "traceval.h"
+
+//! Description of one job, read from a line on stdin
+struct ForkServerJob {
+    std::string id; //!< name of job in result line
+    std::string stimulus; //!< file for read pipe register or empty
+    std::string output; //!< file for write pipe register or empty
+    unsigned long long maxRunTime; //!< run time in ns after fork, 0 for endless
+    std::vector<std::string> terminate; //!< labels or addresses, which stop the job
+};
+
+//! Exit code of a job, if maxruntime was reached (like timeout command)
+static const int jobTimeoutCode = 124;
+
+//! Parses a job line, returns false and sets error, if the line is invalid
+static bool ParseJob(const std::string &line, ForkServerJob &job, std::string &error) {
+    std::istringstream is(line);
+    std::string item;
+    while(is >> item) {
+        size_t eq = item.find('=');
+        if(eq == std::string::npos || eq == 0) {
+            error = "item isn't key=value: " + item;
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string val = item.substr(eq + 1);
+        if(key == "id")
+            job.id = val;
+        else if(key == "stimulus")
+            job.stimulus = val;
+        else if(key == "output")
+            job.output = val;
+        else if(key == "terminate")
+            job.terminate.push_back(val);
+        else if(key == "maxruntime") {
+            char *end;
+            if(!StringToUnsignedLongLong(val.c_str(), &job.maxRunTime, &end, 10) || *end != '\0') {
+                error = "maxruntime is not a number: " + val;
+                return false;
+            }
+        } else {
+            error = "unknown key: " + key;
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+
+int RunForkServer(AvrDevice *dev,
+                  unsigned long readFromPipeOffset,
+                  unsigned long writeToPipeOffset,
+                  unsigned long long defaultRunTime,
+                  unsigned int maxJobs) {
+    avr_error("fork server isn't available on this platform");
+    return 1;
+}
+
+void ForkServerTakeStdout(void) {}
+
+#else
+
+//! File descriptor of the former stdout, to which result lines are written
+static int resultFd = -1;
+
+void ForkServerTakeStdout(void) {
+    if(resultFd >= 0)
+        return;
+    std::cout.flush();
+    fflush(stdout);
+    resultFd = dup(STDOUT_FILENO);
+    if(resultFd < 0)
+        avr_error("fork server: can't duplicate stdout");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+}
+
+//! Writes a result line for a job
+static void WriteResult(const std::string &id, const std::string &result) {
+    std::string line = "job " + id + " " + result + "\n";
+    size_t pos = 0;
+    while(pos < line.size()) {
+        ssize_t n = write(resultFd, line.data() + pos, line.size() - pos);
+        if(n <= 0)
+            avr_error("fork server: can't write result");
+        pos += n;
+    }
+}
+
+//! Runs a job in the child process, doesn't return
+static void RunJob(AvrDevice *dev,
+                   const ForkServerJob &job,
+                   unsigned long readFromPipeOffset,
+                   unsigned long writeToPipeOffset) {
+    // registers without trace name, the server may have created the named ones already
+    if(job.stimulus != "")
+        dev->ReplaceIoRegister(readFromPipeOffset, new RWReadFromFile(dev, "", job.stimulus));
+    if(job.output != "")
+        dev->ReplaceIoRegister(writeToPipeOffset, new RWWriteToFile(dev, "", job.output));
+    for(size_t i = 0; i < job.terminate.size(); i++)
+        dev->RegisterTerminationSymbol(job.terminate[i].c_str());
+
+    SystemClock &clock = SystemClock::Instance();
+    int code = 0;
+    if(job.maxRunTime == 0)
+        clock.Endless();
+    else {
+        SystemClockOffset limit = clock.GetCurrentTime() + job.maxRunTime;
+        clock.Run(limit);
+        if(clock.GetCurrentTime() >= limit)
+            code = jobTimeoutCode;
+    }
+    DumpManager::Instance()->stopApplication();
+    // don't run exit handlers of the server, only flush the own streams
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(NULL);
+    _exit(code);
+}
+
+//! Waits for a child and writes its result line
+static void WaitForJob(std::map<pid_t, std::string> &running) {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid < 0)
+        avr_error("fork server: waitpid failed");
+    std::map<pid_t, std::string>::iterator ii = running.find(pid);
+    if(ii == running.end())
+        return;
+    if(WIFSIGNALED(status))
+        WriteResult(ii->second, "signal " + std::to_string(WTERMSIG(status)));
+    else
+        WriteResult(ii->second, "exit " + std::to_string(WEXITSTATUS(status)));
+    running.erase(ii);
+}
+
+int RunForkServer(AvrDevice *dev,
+                  unsigned long readFromPipeOffset,
+                  unsigned long writeToPipeOffset,
+                  unsigned long long defaultRunTime,
+                  unsigned int maxJobs) {
+    std::map<pid_t, std::string> running;
+    std::string line;
+    unsigned long count = 0;
+
+    if(maxJobs == 0)
+        maxJobs = 1;
+    ForkServerTakeStdout();
+    avr_message("Fork server ready at %lld ns", (long long)SystemClock::Instance().GetCurrentTime());
+    while(std::getline(std::cin, line)) {
+        // skip empty and comment lines
+        size_t first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos || line[first] == '#')
+            continue;
+        count++;
+
+        ForkServerJob job;
+        job.id = std::to_string(count);
+        job.maxRunTime = defaultRunTime;
+        std::string error;
+        if(!ParseJob(line, job, error)) {
+            WriteResult(job.id, "error " + error);
+            continue;
+        }
+
+        while(running.size() >= maxJobs)
+            WaitForJob(running);
+
+        // child must not write buffered output of the server again
+        std::cout.flush();
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if(pid < 0)
+            avr_error("fork server: fork failed");
+        if(pid == 0) {
+            // stdin holds the jobs, the job gets no input. stdin is moved
+            // away from the job list first, so that dropping the input, which
+            // stdio has read ahead, can't move the file offset of the server
+            int null = open("/dev/null", O_RDONLY);
+            if(null >= 0) {
+                dup2(null, STDIN_FILENO);
+                close(null);
+            }
+            if(freopen("/dev/null", "r", stdin) == NULL)
+                _exit(1);
+            close(resultFd);
+            RunJob(dev, job, readFromPipeOffset, writeToPipeOffset);
+        }
+        running[pid] = job.id;
+    }
+
+    while(!running.empty())
+        WaitForJob(running);
+    return 0;
+}
+
+#endif
+
+// EOF
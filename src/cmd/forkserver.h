@@ -0,0 +1,61 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include <string>
+
+#include "../avrdevice.h"
+
+//! Runs jobs as forked copies of a device, which has done its boot already
+/*! Reads one job per line from stdin, a job is a list of key=value items:
+  id=<name>, stimulus=<file> (read pipe register), output=<file> (write pipe
+  register), maxruntime=<ns> (relative to fork) and terminate=<label>, which
+  may be given more than once. Every job runs in a child process created by
+  fork(), so it starts with the simulation state of the server. For every
+  job, a line "job <id> exit <code>" or "job <id> signal <number>" is
+  written to stdout, when the child is finished. Exit code 124 means, that
+  maxruntime was reached. stdout carries only these result lines, see
+  ForkServerTakeStdout, and jobs read from /dev/null instead of stdin.
+  @param dev device, which is added to the system clock and booted
+  @param readFromPipeOffset IO offset for the register, which reads stimulus
+  @param writeToPipeOffset IO offset for the register, which writes output
+  @param defaultRunTime maxruntime for jobs without own maxruntime, 0 for endless
+  @param maxJobs count of jobs, which run at the same time
+  @return exit code for simulavr */
+extern int RunForkServer(AvrDevice *dev,
+                         unsigned long readFromPipeOffset,
+                         unsigned long writeToPipeOffset,
+                         unsigned long long defaultRunTime,
+                         unsigned int maxJobs);
+
+//! Keeps stdout for the result lines of RunForkServer
+/*! Everything else, which is written to stdout from now on, like messages
+  or a write pipe register, goes to stderr. Call this before the boot of
+  the server, RunForkServer calls it otherwise. */
+extern void ForkServerTakeStdout(void);
+
+#endif
@@ -166,6 +166,7 @@ class GdbServer: public SimulationMember {
         void gdb_select_thread(const char *pkt);
         void gdb_is_thread_alive(const char *pkt);
         void gdb_get_thread_list(const char *pkt);
+        void gdb_monitor(const char *pkt);
         int gdb_get_signal(const char *pkt);
         int gdb_parse_packet(const char *pkt);
         int gdb_receive_and_process_packet(int blocking);
@@ -24,6 +24,7 @@
  */
 
 #include <iostream>
+#include <sstream>
 
 #include <assert.h>
 #include <stdio.h>
@@ -45,6 +46,9 @@
 #include "avrdevice.h"
 #include "avrdevice_impl.h"
 #include "gdb.h"
+#include "irqsystem.h"
+#include "flightrecorder.h"
+#include "string2.h"
 
 #ifdef _MSC_VER
 #  define snprintf _snprintf
@@ -348,13 +352,11 @@ void GdbServer::avr_core_flash_write_lo8(int addr, byte val) {
 }
 
 void GdbServer::avr_core_remove_breakpoint(dword pc) {
-    pc=pc<<1;
-    Breakpoints::iterator ii;
-    if ((ii= find(core->BP.begin(), core->BP.end(), pc)) != core->BP.end()) core->BP.erase(ii);
+    core->BP.Remove(pc<<1);
 }
 
 void GdbServer::avr_core_insert_breakpoint(dword pc) {
-    core->BP.push_back(pc<<1);
+    core->BP.Add(pc<<1);
 }
 
 int GdbServer::signal_has_occurred(int signo) {return 0;}
@@ -1063,24 +1065,34 @@ void GdbServer::gdb_break_point(const char *pkt) {
             break;
 
         case '2':               /* write watchpoint */
-            //cout << "Try to set a watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;
-            break;
-
         case '3':               /* read watchpoint */
-            //cout << "Try to set a read watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;
-            break;
-
         case '4':               /* access watchpoint */
-            //cout << "try to set a access watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;             /* unsupported yet */
+        {
+            AvrDevice::WatchpointType type = AvrDevice::WATCH_WRITE;
+            if(t == '3')
+                type = AvrDevice::WATCH_READ;
+            else if(t == '4')
+                type = AvrDevice::WATCH_ACCESS;
+
+            /* only data space can be watched */
+            if((addr & MEM_SPACE_MASK) != SRAM_OFFSET) {
+                avr_warning( "Attempt to set watchpoint outside of data space\n" );
+                gdb_send_reply( "E01" );
+                return;
+            }
+            addr &= ~MEM_SPACE_MASK;
+
+            bool ok;
+            if (z == 'z')
+                ok = core->RemoveWatchpoint( addr, len, type );
+            else
+                ok = core->AddWatchpoint( addr, len, type );
+            if(!ok) {
+                gdb_send_reply( "E01" );
+                return;
+            }
+            break;
+        }
     }
 
     gdb_send_reply( "OK" );
@@ -1193,6 +1205,73 @@ int GdbServer::gdb_get_signal(const char *pkt) {
     return signo;
 }
 
+/*! Handle a gdb "monitor" command, pkt is the hex encoded command line. The
+output is sent as console output packets, each hex encoded chunk fits into
+the send buffer of MAX_BUF bytes. */
+void GdbServer::gdb_monitor(const char *pkt)
+{
+    std::string cmd;
+    while(pkt[0] != '\0' && pkt[1] != '\0') {
+        cmd += (char)((hex2nib(pkt[0]) << 4) + hex2nib(pkt[1]));
+        pkt += 2;
+    }
+
+    std::string output;
+    if(cmd == "irqstat" || cmd == "irqstat text")
+        output = core->irqSystem->GetIrqStatistic("text");
+    else if(cmd == "irqstat json")
+        output = core->irqSystem->GetIrqStatistic("json");
+    else if(cmd == "irqstat csv")
+        output = core->irqSystem->GetIrqStatistic("csv");
+    else if(cmd == "irqstat reset") {
+        core->irqSystem->ResetIrqStatistic();
+        output = "irq statistic cleared\n";
+    } else if(cmd.compare(0, 9, "flightrec") == 0 && (cmd.size() == 9 || cmd[9] == ' ')) {
+        unsigned long count = 20;
+        if(core->flightRecorder == NULL)
+            output = "flight recorder isn't enabled, use option --flight-recorder\n";
+        else if(cmd.size() > 10 && !StringToUnsignedLong(cmd.c_str() + 10, &count, NULL, 10))
+            output = "flightrec: count isn't a number\n";
+        else {
+            std::ostringstream os;
+            core->flightRecorder->Write(os, count);
+            output = os.str();
+        }
+    } else if(cmd == "tracescope") {
+        output = core->traceScope.ToString();
+        if(output.empty())
+            output = "no trace scope, trace isn't restricted\n";
+    } else if(cmd.compare(0, 15, "tracescope add ") == 0) {
+        if(core->traceScope.Add(cmd.substr(15)))
+            output = "trace scope added\n";
+        else
+            output = "tracescope: invalid scope or unknown function\n";
+    } else if(cmd == "tracescope clear") {
+        core->traceScope.Clear();
+        output = "trace scopes cleared\n";
+    } else if(cmd == "trace on" || cmd == "trace off") {
+        core->SetTraceOn(cmd == "trace on");
+        output = "trace " + cmd.substr(6) + "\n";
+    } else
+        output = "monitor commands:\n"
+                 "  irqstat [text|json|csv]  show irq latency statistic\n"
+                 "  irqstat reset            clear irq latency statistic\n"
+                 "  flightrec [count]        show the last count (default 20) instructions\n"
+                 "                           of the flight recorder\n"
+                 "  trace on|off             switch instruction trace on or off\n"
+                 "  tracescope               show scopes, which restrict trace and dumps\n"
+                 "  tracescope add <scope>   add a function, <start>-<end>, irq:<vector>\n"
+                 "                           or time:<start>-[<end>] scope\n"
+                 "  tracescope clear         remove all scopes\n";
+    if(!enableIRQStatistic && cmd.compare(0, 7, "irqstat") == 0)
+        output += "irq statistic isn't enabled, use option -s or --irqstatistic-file\n";
+
+    const size_t chunk = (MAX_BUF - 8) / 2;
+    for(size_t pos = 0; pos < output.size(); pos += chunk)
+        gdb_send_hex_reply("O", output.substr(pos, chunk).c_str());
+    gdb_send_reply("OK");
+}
+
 /*! Parse the packet. Assumes that packet is null terminated.
 Return GDB_RET_KILL_REQUEST if packet is 'kill' command,
 GDB_RET_OK otherwise. */
@@ -1308,6 +1387,9 @@ int GdbServer::gdb_parse_packet(const char *pkt) {
             } else if(strcmp(pkt, "qsThreadInfo") == 0) {
                 gdb_send_reply(  "l" );  // note lowercase "L"
                 return GDB_RET_OK;
+            } else if(memcmp(pkt, "qRcmd,", 6) == 0) {
+                gdb_monitor(pkt + 6);
+                return GDB_RET_OK;
             }
             
             if(global_debug_on)
@@ -1372,7 +1454,10 @@ int GdbServer::gdb_receive_and_process_packet(int blocking) {
             /* always acknowledge a well formed packet immediately */
             gdb_send_ack();
 
+            // memory accesses of gdb don't hit watchpoints
+            core->watchSuspended = true;
             res = gdb_parse_packet(pkt_buf.c_str());
+            core->watchSuspended = false;
             if(res < 0)
                 return res;
 
@@ -1611,6 +1696,19 @@ void GdbServer::SendPosition(int signo) {
             pc & 0xff, (pc >> 8) & 0xff, (pc >> 16) & 0xff, (pc >> 24) & 0xff,
             thread_id);
 
+    /* watchpoint, which stopped the core */
+    if(signo == GDB_SIGTRAP && core->watchHitType != 0) {
+        const char *kind = "awatch";
+        if(core->watchHitType == AvrDevice::WATCH_WRITE)
+            kind = "watch";
+        else if(core->watchHitType == AvrDevice::WATCH_READ)
+            kind = "rwatch";
+        bytes = strlen(reply);
+        snprintf(reply + bytes, sizeof(reply) - bytes, "%s:%x;",
+                 kind, core->watchHitAddr | SRAM_OFFSET);
+    }
+    core->ClearWatchpointHit();
+
     gdb_send_reply(reply);
     /* Next "read registers" command will be related to the new thread. */
     m_gdb_thread_id = thread_id;
@@ -56,8 +56,13 @@
 #include "helper.h"
 #include "specialmem.h"
 #include "irqsystem.h"
+#include "profiler.h"
+#include "coverage.h"
+#include "bintrace.h"
+#include "flightrecorder.h"
 
 #include "dumpargs.h"
+#include "forkserver.h"
 
 const char *SplitOffsetFile(const char *arg,
                             const char *name,
@@ -88,6 +93,33 @@ const char *SplitOffsetFile(const char *arg,
     return end;
 }
 
+//! Runs simulation till PC is on label or address or till simulation time
+/*! The whole argument is a simulation time in ns, if it's a decimal number,
+  otherwise a label or a hex address. Adds the count of simulation steps to
+  steps and returns false, if the point wasn't reached. */
+bool RunTo(AvrDevice *dev,
+           const std::string &at,
+           unsigned long long maxRunTime,
+           long &steps)
+{
+    unsigned long long atTime;
+    char *end;
+    
+    if(StringToUnsignedLongLong(at.c_str(), &atTime, &end, 10) && *end == '\0') {
+        if(maxRunTime != 0 && atTime > maxRunTime)
+            return false;
+        steps += SystemClock::Instance().Run(atTime);
+        return SystemClock::Instance().GetCurrentTime() >= (SystemClockOffset)atTime;
+    }
+    
+    unsigned int addr = dev->Flash->GetAddressAtSymbol(at);
+    // stop on a temporary breakpoint
+    dev->BP.Add(addr);
+    steps += SystemClock::Instance().Run(maxRunTime == 0 ? INVALID : maxRunTime);
+    dev->BP.Remove(addr);
+    return dev->PC * 2 == addr;
+}
+
 const char Usage[] = 
     "AVR-Simulator Version " VERSION "\n"
     "-u                    run with user interface for external pin\n"
@@ -101,6 +133,20 @@ const char Usage[] =
     "-M                    disable messages for bad I/O and memory references\n"
     "-p  <port>            use <port> for gdb server\n"
     "-t --trace <file>     enable trace outputs to <file>\n"
+    "   --bintrace <file>  record executed instructions, memory writes and interrupts\n"
+    "                      in a compact binary trace <file>, show it with\n"
+    "                      simulavr-tracedump\n"
+    "   --flight-recorder <number>\n"
+    "                      keep the last <number> executed instructions (default 65536,\n"
+    "                      0 disables) and dump them on a error, abort or stack overflow\n"
+    "   --flight-recorder-file <file>\n"
+    "                      write flight recorder dumps to <file> instead of stderr and\n"
+    "                      dump also, if simulation is stopped\n"
+    "   --trace-scope <scope>\n"
+    "                      trace instructions and dump values only in <scope>, can be\n"
+    "                      given more than once: a function name, a flash address range\n"
+    "                      <start>-<end> (end exclusive, hex with 0x), irq:<vector>\n"
+    "                      for a interrupt handler or time:<start>-[<end>] in ns\n"
     "-l --linestotrace <number>\n"
     "                      maximum number of lines in each trace file.\n"
     "                      0 means endless. Attention: if you use gdb & trace, please use always 0!\n"
@@ -108,6 +154,18 @@ const char Usage[] =
     "-F --cpufrequency     set the cpu frequency to <Hz> \n"
     "-s --irqstatistic     prints statistic informations about irq usage after simulation\n"
     "                      is stopped\n"
+    "   --irqstatistic-file <file>\n"
+    "                      collect irq latency statistic and write it to <file> as\n"
+    "                      JSON or as CSV, if <file> ends with .csv\n"
+    "   --irqstatistic-interval <nanoseconds>\n"
+    "                      write irq statistic file every <nanoseconds> simulation time\n"
+    "                      and not only after simulation is stopped\n"
+    "   --profile <file>   count cycles per instruction and call of the program and\n"
+    "                      write them to <file> in callgrind format, after simulation\n"
+    "                      is stopped (for kcachegrind or callgrind_annotate)\n"
+    "   --coverage <file>  collect executed instructions and taken/not taken branches\n"
+    "                      and write them per source line to <file> in lcov format,\n"
+    "                      after simulation is stopped (needs line info, compile with -g)\n"
     "-W --writetopipe <offset>,<file>\n"
     "                      add a special pipe register to device at\n"
     "                      IO-Offset and opens <file> for writing\n"
@@ -121,7 +179,27 @@ const char Usage[] =
     "                      add a special register at IO-offset\n"
     "                      which exits simulator run\n"
     "-C --core-dump <name> dump a core memory image <name> to file on exit\n"
+    "   --save-at <label>,<file> or <address>,<file> or <nanoseconds>,<file>\n"
+    "                      save a snapshot of the device state to <file>, if PC runs\n"
+    "                      on <label> or hex <address> or at the given (decimal)\n"
+    "                      simulation time, then simulation continues\n"
+    "   --restore <file>   restore device state from snapshot <file> after loading\n"
+    "                      the program, device and program have to be the same as on save\n"
+    "   --fork-server <label> or <address> or <nanoseconds>\n"
+    "                      run till <label>, hex <address> or the given simulation time,\n"
+    "                      then read jobs from stdin and run every job in a forked\n"
+    "                      copy of the simulation, -m is the run time of every job\n"
+    "   --fork-jobs <number>\n"
+    "                      maximum number of jobs, which run at the same time (default 1)\n"
     "-v --verbose          output some hints to console\n"
+    "-X --threaded         execute instructions by threaded code (faster, not used\n"
+    "                      while tracing)\n"
+    "-b --basicblocks      execute instructions by threaded code in basic blocks and\n"
+    "                      run the core without rescheduling, while no other part is\n"
+    "                      due (fastest, not used while tracing or with gdb)\n"
+    "-S --skipidle         skip idle loops (sleep or jump to itself) of the program\n"
+    "                      till the next hardware or simulation event (not used\n"
+    "                      while tracing, with -c tracers or with gdb)\n"
     "-T --terminate <label> or <address>\n"
     "                      stops simulation if PC runs on <label> or <address>\n"
     "-B --breakpoint <label> or <address>\n"
@@ -162,7 +240,31 @@ int main(int argc, char *argv[]) {
     
     std::vector<std::string> tracer_opts;
     bool tracer_dump_avail = false;
+    bool threadedDispatch = false;
+    bool blockDispatch = false;
+    bool idleSkip = false;
     std::string tracer_avail_out;
+    std::string saveAtArg = "";
+    std::string saveAtFileName = "";
+    std::string restoreFileName = "";
+    std::string forkServerArg = "";
+    unsigned long forkJobs = 1;
+    std::string irqStatisticFileName = "";
+    unsigned long long irqStatisticInterval = 0;
+    std::string profileFileName = "";
+    std::string coverageFileName = "";
+    std::string binaryTraceFileName = "";
+    unsigned long flightRecorderSize = FlightRecorder::defaultSize;
+    std::string flightRecorderFileName = "";
+    std::vector<std::string> traceScopes;
+
+    // a fork server writes only the job results to stdout, also messages
+    // while parsing the options and output of the boot go to stderr
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "-k") == 0 || arg.compare(0, 13, "--fork-server") == 0)
+            ForkServerTakeStdout();
+    }
     
     while (1) {
         //int this_option_optind = optind ? optind : 1;
@@ -177,6 +279,10 @@ int main(int argc, char *argv[]) {
             {"maxruntime", 1, 0, 'm'},
             {"nogdbwait", 0, 0, 'n'},
             {"trace", 1, 0, 't'},
+            {"bintrace", 1, 0, 'Z'},
+            {"flight-recorder", 1, 0, 'J'},
+            {"flight-recorder-file", 1, 0, 'K'},
+            {"trace-scope", 1, 0, 'E'},
             {"version", 0, 0, 'V'},
             {"cpufrequency", 1, 0, 'F'},
             {"readfrompipe", 1, 0, 'R'},
@@ -188,11 +294,22 @@ int main(int argc, char *argv[]) {
             {"breakpoint", 1, 0, 'B'},
             {"core-dump", 1, 0, 'C'},
             {"irqstatistic", 0, 0, 's'},
+            {"irqstatistic-file", 1, 0, 'I'},
+            {"irqstatistic-interval", 1, 0, 'P'},
+            {"profile", 1, 0, 'O'},
+            {"coverage", 1, 0, 'Y'},
+            {"threaded", 0, 0, 'X'},
+            {"basicblocks", 0, 0, 'b'},
+            {"skipidle", 0, 0, 'S'},
+            {"save-at", 1, 0, 'A'},
+            {"restore", 1, 0, 'r'},
+            {"fork-server", 1, 0, 'k'},
+            {"fork-jobs", 1, 0, 'j'},
             {"help", 0, 0, 'h'},
             {0, 0, 0, 0}
         };
         
-        c = getopt_long(argc, argv, "a:e:f:d:gGm:p:t:uxyzhvnisF:R:W:VT:B:c:C:o:l:", long_options, &option_index);
+        c = getopt_long(argc, argv, "a:e:f:d:gGm:p:t:uxyzhvnisXbSF:R:W:VT:B:c:C:o:l:A:r:k:j:I:P:O:Y:Z:J:K:E:", long_options, &option_index);
         if(c == -1)
             break;
         
@@ -249,7 +366,7 @@ int main(int argc, char *argv[]) {
                     std::cerr << "linestotrace is not a number" << std::endl;
                     exit(1);
                 }
-                sysConHandler.SetNumberOfTraceLines(linestotrace);
+                GetSystemConsoleHandler().SetNumberOfTraceLines(linestotrace);
                 break;
 
             case 'm':
@@ -302,7 +419,7 @@ int main(int argc, char *argv[]) {
                 avr_message("Running in Trace Mode with maximum %lld lines per file",
                             linestotrace);
 
-                sysConHandler.SetTraceFile(optarg, linestotrace);
+                GetSystemConsoleHandler().SetTraceFile(optarg, linestotrace);
                 break;
             
             case 'V':
@@ -331,11 +448,98 @@ int main(int argc, char *argv[]) {
                 enableIRQStatistic = true;
                 break;
             
+            case 'I':
+                avr_message("Write irq statistic to file: %s", optarg);
+                irqStatisticFileName = optarg;
+                enableIRQStatistic = true;
+                break;
+            
+            case 'P':
+                if(!StringToUnsignedLongLong(optarg, &irqStatisticInterval, NULL, 10)) {
+                    std::cerr << "irqstatistic-interval is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+            
+            case 'O':
+                avr_message("Write profile to file: %s", optarg);
+                profileFileName = optarg;
+                break;
+            
+            case 'Z':
+                avr_message("Write binary trace to file: %s", optarg);
+                binaryTraceFileName = optarg;
+                break;
+            
+            case 'J':
+                if(!StringToUnsignedLong(optarg, &flightRecorderSize, NULL, 10)) {
+                    std::cerr << "flight-recorder is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+            
+            case 'K':
+                avr_message("Write flight recorder dumps to file: %s", optarg);
+                flightRecorderFileName = optarg;
+                break;
+            
+            case 'E':
+                avr_message("Add trace scope: %s", optarg);
+                traceScopes.push_back(optarg);
+                break;
+            
+            case 'Y':
+                avr_message("Write coverage to file: %s", optarg);
+                coverageFileName = optarg;
+                break;
+            
+            case 'X':
+                threadedDispatch = true;
+                break;
+            
+            case 'b':
+                blockDispatch = true;
+                break;
+            
+            case 'S':
+                idleSkip = true;
+                break;
+            
             case 'C':
                 avr_message("Write core dump on exit to file: %s", optarg);
                 coredumpfile = optarg;
                 break;
             
+            case 'A': {
+                std::string arg(optarg);
+                size_t comma = arg.find(',');
+                if(comma == std::string::npos || comma == 0 || comma + 1 == arg.size()) {
+                    std::cerr << "save-at: argument has to be <label|address|time>,<file>" << std::endl;
+                    exit(1);
+                }
+                saveAtArg = arg.substr(0, comma);
+                saveAtFileName = arg.substr(comma + 1);
+                avr_message("Save snapshot at %s to file: %s", saveAtArg.c_str(), saveAtFileName.c_str());
+                break;
+            }
+            
+            case 'r':
+                avr_message("Restore snapshot from file: %s", optarg);
+                restoreFileName = optarg;
+                break;
+            
+            case 'k':
+                avr_message("Run as fork server from: %s", optarg);
+                forkServerArg = optarg;
+                break;
+            
+            case 'j':
+                if(!StringToUnsignedLong(optarg, &forkJobs, NULL, 10) || forkJobs == 0) {
+                    std::cerr << "fork-jobs is not a number or zero" << std::endl;
+                    exit(1);
+                }
+                break;
+            
             default:
                 std::cout << Usage
                      << "Supported devices:" << std::endl
@@ -397,6 +601,8 @@ int main(int argc, char *argv[]) {
     
     //if we want to insert some special "pipe" Registers we could do this here:
     if(readFromPipeFileName != "") {
+        if(forkServerArg != "" && readFromPipeFileName == "-")
+            avr_error("fork-server: stdin holds the jobs, it can't be read by the read pipe register");
         avr_message("Add ReadFromPipe-Register at 0x%lx and read from file: %s",
                     readFromPipeOffset, readFromPipeFileName.c_str());
         dev1->ReplaceIoRegister(readFromPipeOffset,
@@ -436,31 +642,119 @@ int main(int argc, char *argv[]) {
     ui = (userinterface_flag == 1) ? new UserInterface(7777) : NULL;
     
     dev1->SetClockFreq(1000000000 / fcpu); // time base is 1ns!
+    dev1->threadedDispatch = threadedDispatch;
+    dev1->blockDispatch = blockDispatch;
+    dev1->idleSkip = idleSkip;
     
-    if(sysConHandler.GetTraceState())
+    if(GetSystemConsoleHandler().GetTraceState())
         dev1->trace_on = 1;
     
+    IrqStatisticWriter *irqStatisticWriter = NULL;
+    if(irqStatisticFileName != "") {
+        irqStatisticWriter = new IrqStatisticWriter(dev1->irqSystem, irqStatisticFileName, irqStatisticInterval);
+        if(irqStatisticInterval > 0)
+            SystemClock::Instance().Add(irqStatisticWriter);
+    } else if(irqStatisticInterval > 0) {
+        std::cerr << "--irqstatistic-interval needs --irqstatistic-file" << std::endl;
+        exit(1);
+    }
+    
+    Profiler *profiler = NULL;
+    if(profileFileName != "") {
+        profiler = new Profiler(dev1);
+        dev1->AddInstructionObserver(profiler);
+    }
+    BinaryTrace *binaryTrace = NULL;
+    if(binaryTraceFileName != "" && forkServerArg != "") {
+        std::cerr << "--bintrace can't be used with --fork-server" << std::endl;
+        exit(1);
+    }
+    if(binaryTraceFileName != "") {
+        binaryTrace = new BinaryTrace(dev1, binaryTraceFileName);
+        dev1->AddInstructionObserver(binaryTrace);
+        dev1->SetBinaryTrace(binaryTrace);
+    }
+    FlightRecorder *flightRecorder = NULL;
+    if(flightRecorderSize > 0) {
+        flightRecorder = new FlightRecorder(dev1, flightRecorderSize);
+        if(flightRecorderFileName != "")
+            flightRecorder->SetFile(flightRecorderFileName);
+        dev1->AddInstructionObserver(flightRecorder);
+        dev1->flightRecorder = flightRecorder;
+    } else if(flightRecorderFileName != "") {
+        std::cerr << "--flight-recorder-file needs a flight recorder size above 0" << std::endl;
+        exit(1);
+    }
+    for(size_t i = 0; i < traceScopes.size(); i++) {
+        if(!dev1->traceScope.Add(traceScopes[i])) {
+            std::cerr << "invalid trace scope or unknown function: " << traceScopes[i] << std::endl;
+            exit(1);
+        }
+    }
+    Coverage *coverage = NULL;
+    if(coverageFileName != "") {
+        coverage = new Coverage(dev1);
+        dev1->AddInstructionObserver(coverage);
+    }
+    
     dman->start(); // start dump session
     
     long steps = 0;
+    if(gdbserver_flag && (saveAtArg != "" || restoreFileName != "" || forkServerArg != "")) {
+        std::cerr << "--save-at, --restore and --fork-server can't be used with gdb" << std::endl;
+        exit(1);
+    }
     if(gdbserver_flag == 0) { // no gdb
         SystemClock::Instance().Add(dev1);
+        if(restoreFileName != "")
+            dev1->RestoreSnapshot(restoreFileName.c_str());
+        if(saveAtArg != "") {
+            if(RunTo(dev1, saveAtArg, maxRunTime, steps)) {
+                avr_message("Save snapshot at %lld ns to file: %s",
+                            (long long)SystemClock::Instance().GetCurrentTime(), saveAtFileName.c_str());
+                dev1->SaveSnapshot(saveAtFileName.c_str());
+            } else
+                avr_warning("save-at: '%s' wasn't reached, no snapshot saved", saveAtArg.c_str());
+        }
+        if(forkServerArg != "") {
+            // -m is the run time of every job, not of the boot
+            if(!RunTo(dev1, forkServerArg, 0, steps))
+                avr_error("fork-server: '%s' wasn't reached", forkServerArg.c_str());
+            int code = RunForkServer(dev1, readFromPipeOffset, writeToPipeOffset,
+                                     maxRunTime, forkJobs);
+            dman->stopApplication();
+            delete ui;
+            delete dev1;
+            return code;
+        }
         if(maxRunTime == 0) {
-            steps = SystemClock::Instance().Endless();
+            steps += SystemClock::Instance().Endless();
             std::cout << "SystemClock::std::endless stopped" << std::endl
                  << "number of cpu cycles simulated: " << std::dec << steps << std::endl;
         } else {                                           // limited
-            steps = SystemClock::Instance().Run(maxRunTime);
+            steps += SystemClock::Instance().Run(maxRunTime);
             std::cout << "Ran too long.  Terminated after " << std::dec << maxRunTime
                  << " ns (simulated) and " << std::endl 
                  << std::dec << steps << " cpu cycles" << std::endl;
         }
+        if(irqStatisticWriter != NULL)
+            irqStatisticWriter->WriteFile();
+        if(profiler != NULL)
+            profiler->WriteFile(profileFileName, filename);
+        if(coverage != NULL)
+            coverage->WriteFile(coverageFileName, filename);
         Application::GetInstance()->PrintResults();
     } else { // gdb should be activated
         avr_message("Waiting for gdb connection ...");
         GdbServer gdb1(dev1, global_gdbserver_port, global_gdb_debug, globalWaitForGdbConnection);
         SystemClock::Instance().Add(&gdb1);
         SystemClock::Instance().Endless();
+        if(irqStatisticWriter != NULL)
+            irqStatisticWriter->WriteFile();
+        if(profiler != NULL)
+            profiler->WriteFile(profileFileName, filename);
+        if(coverage != NULL)
+            coverage->WriteFile(coverageFileName, filename);
         if(global_verbose_on) {
             std::cout << "SystemClock::std::endless stopped" << std::endl
                  << "number of cpu cycles simulated: " << std::dec << steps << std::endl;
@@ -468,6 +762,9 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    if(flightRecorder != NULL && flightRecorder->HasFile())
+        flightRecorder->Dump("simulation stopped");
+    
     dman->stopApplication(); // stop dump session. Close dump files, if necessary
     
     if(coredumpfile != "unknown") {
@@ -476,6 +773,11 @@ int main(int argc, char *argv[]) {
     }
 
     // delete ui and device
+    delete irqStatisticWriter;
+    delete profiler;
+    delete coverage;
+    delete binaryTrace;
+    delete flightRecorder;
     delete ui;
     delete dev1;
     
@@ -0,0 +1,211 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <iostream>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _MSC_VER
+#  include <getopt.h>
+#else
+#  include "../getopt/getopt.h"
+#endif
+
+#include "bintrace.h"
+#include "memory.h"
+#include "avrreadelf.h"
+#include "string2.h"
+
+const char Usage[] =
+    "simulavr-tracedump [options] <trace-file>\n"
+    "shows a binary trace of simulavr (option --bintrace) as text\n"
+    "-f --file <name>      take symbols from elf-file <name>\n"
+    "   --from <cycle>     show events from cpu cycle <cycle>\n"
+    "   --to <cycle>       show events till cpu cycle <cycle>\n"
+    "   --function <name>  show only instructions in function <name> and interrupts\n"
+    "   --no-writes        don't show memory writes\n"
+    "-h --help             print this help\n"
+    "\n";
+
+//! Writes one line per instruction, memory writes are appended to their instruction
+class TraceDumper {
+    public:
+        std::string prefix; //!< file or device name at begin of each line
+        Data flash; //!< flash symbols
+        Data data; //!< data symbols
+        unsigned long long from;
+        unsigned long long to;
+        std::string function;
+        bool showWrites;
+
+        TraceDumper(): from(0), to(~0ULL), showWrites(true), lineOpen(false), lineShown(false) {}
+
+        void Event(const BinaryTraceReader::Event &ev) {
+            switch(ev.type) {
+                case BinaryTraceReader::EV_INSTRUCTION:
+                    EndLine();
+                    lineShown = ev.cycle >= from && ev.cycle <= to && InFunction(ev.pc);
+                    if(lineShown) {
+                        char buf[64];
+                        snprintf(buf, sizeof(buf), "%llu %s 0x%04x: ", ev.cycle, prefix.c_str(), ev.pc << 1);
+                        std::cout << buf;
+                        size_t len = flash.WriteSymbolAtAddress(std::cout, ev.pc << 1);
+                        std::cout << " ";
+                        for(; len < 30; len++)
+                            std::cout << " ";
+                        lineOpen = true;
+                    }
+                    break;
+
+                case BinaryTraceReader::EV_WRITE:
+                    if(lineShown && showWrites) {
+                        char buf[32];
+                        if(ev.address < 32) {
+                            snprintf(buf, sizeof(buf), "R%u=0x%02x ", ev.address, ev.value);
+                            std::cout << buf;
+                        } else {
+                            snprintf(buf, sizeof(buf), "MEM[0x%04x,", ev.address);
+                            std::cout << buf;
+                            data.WriteSymbolAtAddress(std::cout, ev.address);
+                            snprintf(buf, sizeof(buf), "]=0x%02x ", ev.value);
+                            std::cout << buf;
+                        }
+                    }
+                    break;
+
+                case BinaryTraceReader::EV_BIT_SET:
+                case BinaryTraceReader::EV_BIT_CLEAR:
+                    if(lineShown && showWrites) {
+                        char buf[32];
+                        snprintf(buf, sizeof(buf), "MEM[0x%04x,", ev.address);
+                        std::cout << buf;
+                        data.WriteSymbolAtAddress(std::cout, ev.address);
+                        snprintf(buf, sizeof(buf), "].%u=%d ", ev.value, ev.type == BinaryTraceReader::EV_BIT_SET);
+                        std::cout << buf;
+                    }
+                    break;
+
+                case BinaryTraceReader::EV_INTERRUPT:
+                    EndLine();
+                    lineShown = false;
+                    if(ev.cycle >= from && ev.cycle <= to)
+                        std::cout << ev.cycle << " " << prefix << " IRQ DETECTED: Vector " << ev.address << std::endl;
+                    break;
+            }
+        }
+
+        void EndLine(void) {
+            if(lineOpen)
+                std::cout << std::endl;
+            lineOpen = false;
+        }
+
+    private:
+        bool lineOpen; //!< a instruction line is written, but not ended
+        bool lineShown; //!< writes belong to a shown instruction
+
+        bool InFunction(unsigned int pc) {
+            if(function.empty())
+                return true;
+            unsigned int offset;
+            std::string_view label = flash.FindSymbol(pc << 1, offset);
+            return label == function;
+        }
+};
+
+int main(int argc, char *argv[]) {
+    TraceDumper dumper;
+    std::string elfFile;
+
+    while(1) {
+        static struct option long_options[] = {
+            {"file", 1, 0, 'f'},
+            {"from", 1, 0, 'F'},
+            {"to", 1, 0, 'T'},
+            {"function", 1, 0, 'u'},
+            {"no-writes", 0, 0, 'w'},
+            {"help", 0, 0, 'h'},
+            {0, 0, 0, 0}
+        };
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "f:F:T:u:wh", long_options, &option_index);
+        if(c == -1)
+            break;
+
+        switch(c) {
+            case 'f':
+                elfFile = optarg;
+                break;
+
+            case 'F':
+                if(!StringToUnsignedLongLong(optarg, &dumper.from, NULL, 10)) {
+                    std::cerr << "from is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+
+            case 'T':
+                if(!StringToUnsignedLongLong(optarg, &dumper.to, NULL, 10)) {
+                    std::cerr << "to is not a number" << std::endl;
+                    exit(1);
+                }
+                break;
+
+            case 'u':
+                dumper.function = optarg;
+                break;
+
+            case 'w':
+                dumper.showWrites = false;
+                break;
+
+            default:
+                std::cout << Usage;
+                exit(0);
+        }
+    }
+
+    if(optind + 1 != argc) {
+        std::cout << Usage;
+        exit(1);
+    }
+
+    BinaryTraceReader reader(argv[optind]);
+    dumper.prefix = reader.GetDeviceName();
+    if(!elfFile.empty()) {
+        ELFLoadSymbols(elfFile.c_str(), &dumper.flash, &dumper.data);
+        dumper.prefix = elfFile;
+    }
+
+    std::cout << "# device " << reader.GetDeviceName() << ", cpu cycle "
+              << reader.GetClockPeriod() << " ns" << std::endl;
+    BinaryTraceReader::Event ev;
+    while(reader.Next(ev))
+        dumper.Event(ev);
+    dumper.EndLine();
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "coverage.h"
+#include "avrreadelf.h"
+#include "decoder.h"
+#include "avrerror.h"
+
+#include <map>
+#include <algorithm>
+#include <fstream>
+
+Coverage::Coverage(AvrDevice *_core):
+    core(_core),
+    flags(_core->Flash->GetSize() >> 1, 0),
+    branchPC(0),
+    branchPending(false) {}
+
+void Coverage::Clear(void) {
+    std::fill(flags.begin(), flags.end(), 0);
+    branchPending = false;
+}
+
+//! Coverage of one source line
+struct CoverageLine {
+    bool hit; //!< one instruction of line was executed
+    std::vector<unsigned char> branches; //!< flags of conditional instructions of line
+
+    CoverageLine(): hit(false) {}
+};
+
+bool Coverage::WriteLcov(std::ostream &os, const std::string &elfFile) {
+    std::vector<std::string> files;
+    std::vector<ELFLineRange> ranges;
+    if(!ELFGetLineTable(elfFile.c_str(), files, ranges))
+        return false;
+
+    // lines by file and line number
+    std::vector<std::map<unsigned int, CoverageLine> > lines(files.size());
+    for(size_t i = 0; i < ranges.size(); i++) {
+        const ELFLineRange &r = ranges[i];
+        if(r.line == 0)
+            continue; // code without a source line
+        CoverageLine &l = lines[r.file][r.line];
+        unsigned int word = r.start >> 1;
+        while(word < ((r.end + 1) >> 1) && word < flags.size()) {
+            if(flags[word] & FLAG_EXECUTED)
+                l.hit = true;
+            if(IsConditional(core->Flash->ReadMemRawWord(word << 1)))
+                l.branches.push_back(flags[word]);
+            word += core->Flash->GetDecoded(word)->IsInstruction2Words() ? 2 : 1;
+        }
+    }
+
+    // functions from flash symbols, which have a source line
+    std::vector<std::map<std::string, std::pair<unsigned int, bool> > > functions(files.size());
+    for(auto it = core->Flash->sym.begin(); it != core->Flash->sym.end(); it++) {
+        unsigned int addr = it->first;
+        size_t lo = 0, hi = ranges.size();
+        while(lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if(ranges[mid].end <= addr)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if(lo == ranges.size() || ranges[lo].start > addr)
+            continue;
+        functions[ranges[lo].file][it->second] = std::make_pair(ranges[lo].line, (GetFlags(addr >> 1) & FLAG_EXECUTED) != 0);
+    }
+
+    for(size_t f = 0; f < files.size(); f++) {
+        if(lines[f].empty())
+            continue;
+        os << "TN:" << std::endl
+           << "SF:" << files[f] << std::endl;
+
+        unsigned int fnHit = 0;
+        for(auto it = functions[f].begin(); it != functions[f].end(); it++)
+            os << "FN:" << it->second.first << "," << it->first << std::endl;
+        for(auto it = functions[f].begin(); it != functions[f].end(); it++) {
+            os << "FNDA:" << (it->second.second ? 1 : 0) << "," << it->first << std::endl;
+            if(it->second.second)
+                fnHit++;
+        }
+        os << "FNF:" << functions[f].size() << std::endl
+           << "FNH:" << fnHit << std::endl;
+
+        unsigned int brFound = 0, brHit = 0;
+        for(auto it = lines[f].begin(); it != lines[f].end(); it++) {
+            const CoverageLine &l = it->second;
+            for(size_t b = 0; b < l.branches.size(); b++) {
+                const unsigned char results[2] = { FLAG_TAKEN, FLAG_NOT_TAKEN };
+                for(unsigned int k = 0; k < 2; k++) {
+                    os << "BRDA:" << it->first << ",0," << (b * 2 + k) << ",";
+                    if(!l.hit)
+                        os << "-";
+                    else
+                        os << ((l.branches[b] & results[k]) ? 1 : 0);
+                    os << std::endl;
+                    brFound++;
+                    if(l.branches[b] & results[k])
+                        brHit++;
+                }
+            }
+        }
+        os << "BRF:" << brFound << std::endl
+           << "BRH:" << brHit << std::endl;
+
+        unsigned int lineHit = 0;
+        for(auto it = lines[f].begin(); it != lines[f].end(); it++) {
+            os << "DA:" << it->first << "," << (it->second.hit ? 1 : 0) << std::endl;
+            if(it->second.hit)
+                lineHit++;
+        }
+        os << "LF:" << lines[f].size() << std::endl
+           << "LH:" << lineHit << std::endl
+           << "end_of_record" << std::endl;
+    }
+    return true;
+}
+
+void Coverage::WriteFile(const std::string &filename, const std::string &elfFile) {
+    std::ofstream f(filename.c_str(), std::ios::out | std::ios::trunc);
+    if(!f)
+        avr_error("coverage: can't create file '%s'", filename.c_str());
+    if(!WriteLcov(f, elfFile))
+        avr_warning("coverage: '%s' has no line table (compile with -g), no lines written", elfFile.c_str());
+    if(!f)
+        avr_error("coverage: can't write file '%s'", filename.c_str());
+}
+
+// EOF
@@ -0,0 +1,110 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef COVERAGE
+#define COVERAGE
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "avrdevice.h"
+#include "flash.h"
+#include "instructionobserver.h"
+
+//! Collects code coverage of the program in flash
+/*! A flag table per flash word holds, if the instruction was executed and for
+  conditional branches and skips (BRBS, BRBC, CPSE, SBRC, SBRS, SBIC, SBIS),
+  if the branch was taken and not taken. The table is added as
+  InstructionObserver to the core, the result of a branch is known with the
+  next instruction or interrupt. Memory doesn't grow with the simulation time. The
+  flags are mapped by the line table of the elf file to source lines and
+  written in lcov format. */
+class Coverage: public InstructionObserver {
+
+    public:
+        static const unsigned char FLAG_EXECUTED = 1; //!< instruction was executed
+        static const unsigned char FLAG_TAKEN = 2; //!< branch was taken or instruction skipped
+        static const unsigned char FLAG_NOT_TAKEN = 4; //!< branch wasn't taken
+
+    private:
+        AvrDevice *core; //!< the observed core
+        std::vector<unsigned char> flags; //!< flags per flash word
+        unsigned int branchPC; //!< flash word of conditional instruction, which isn't resolved yet
+        bool branchPending; //!< true, if branchPC has to be resolved
+
+        //! True, if opcode is a conditional branch or skip
+        static bool IsConditional(unsigned int op) {
+            return (op & 0xf800) == 0xf000 || // BRBS, BRBC
+                   (op & 0xfc00) == 0x1000 || // CPSE
+                   (op & 0xfc08) == 0xfc00 || // SBRC, SBRS
+                   (op & 0xfd00) == 0x9900;   // SBIC, SBIS
+        }
+
+        //! Sets taken or not taken flag for branchPC, next is the flash word executed next
+        void ResolveBranch(unsigned int next) {
+            branchPending = false;
+            flags[branchPC] |= (next == branchPC + 1) ? FLAG_NOT_TAKEN : FLAG_TAKEN;
+        }
+
+    public:
+        //! Creates coverage table for core
+        Coverage(AvrDevice *core);
+
+        void Instruction(unsigned int pc, unsigned long long cycle) override {
+            if(branchPending)
+                ResolveBranch(pc);
+            if(pc >= flags.size())
+                return;
+            flags[pc] |= FLAG_EXECUTED;
+            if(IsConditional(core->Flash->ReadMemRawWord(pc << 1))) {
+                branchPending = true;
+                branchPC = pc;
+            }
+        }
+
+        void Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) override {
+            if(branchPending)
+                ResolveBranch(returnPC);
+        }
+
+        void Reset(void) override { branchPending = false; }
+
+        //! Returns the flags for a flash word
+        unsigned char GetFlags(unsigned int word) const { return (word < flags.size()) ? flags[word] : 0; }
+
+        //! Clears all collected flags
+        void Clear(void);
+
+        //! Writes coverage in lcov tracefile format
+        /*! Lines are taken from the line table of elf file. Returns false, if
+          the elf file has no line table, then nothing is written. */
+        bool WriteLcov(std::ostream &os, const std::string &elfFile);
+
+        //! Writes coverage in lcov tracefile format to file
+        void WriteFile(const std::string &filename, const std::string &elfFile);
+};
+
+#endif
@@ -30,16 +30,11 @@
 #include "hwsreg.h"
 #include "avrerror.h"
 #include "ioregs.h"
+#include "decoder_flags.h"
+#include "decoder_ops.h"
 
 static int n_bit_unsigned_to_signed(unsigned int val, int n );
 
-static int get_add_carry( byte res, byte rd, byte rr, int b );
-static int get_add_overflow( byte res, byte rd, byte rr );
-static int get_sub_carry( byte res, byte rd, byte rr, int b );
-static int get_sub_overflow( byte res, byte rd, byte rr );
-static int get_compare_carry( byte res, byte rd, byte rr, int b );
-static int get_compare_overflow( byte res, byte rd, byte rr );
-
 enum decoder_operand_masks {
     /** 2 bit register id  ( R24, R26, R28, R30 ) */
     mask_Rd_2     = 0x0030,
@@ -109,21 +104,8 @@ avr_op_ADC::avr_op_ADC(word opcode, AvrDevice *c):
 unsigned char avr_op_ADC::GetModifiedR() const {
     return R1;
 }
-int avr_op_ADC::operator()() { 
-    unsigned char rd = core->GetCoreReg(R1);
-    unsigned char rr = core->GetCoreReg(R2);
-    unsigned char res = rd + rr + status->C;
-
-    status->H = get_add_carry(res, rd, rr, 3);
-    status->V = get_add_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_add_carry(res, rd, rr, 7);
-
-    core->SetCoreReg(R1, res);
-
-    return 1;   //used clocks
+int avr_op_ADC::operator()() {
+    return exec_ADC(core, R1, R2);
 }
 
 avr_op_ADD::avr_op_ADD(word opcode, AvrDevice *c): 
@@ -135,21 +117,8 @@ avr_op_ADD::avr_op_ADD(word opcode, AvrDevice *c):
 unsigned char avr_op_ADD::GetModifiedR() const {
     return R1;
 }
-int avr_op_ADD::operator()() { 
-    unsigned char rd = core->GetCoreReg(R1);
-    unsigned char rr = core->GetCoreReg(R2);
-    unsigned char res = rd + rr;
-
-    status->H = get_add_carry(res, rd, rr, 3);
-    status->V = get_add_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_add_carry(res, rd, rr, 7);
-
-    core->SetCoreReg(R1, res);
-
-    return 1;   //used clocks
+int avr_op_ADD::operator()() {
+    return exec_ADD(core, R1, R2);
 }
 
 avr_op_ADIW::avr_op_ADIW(word opcode, AvrDevice *c): 
@@ -167,21 +136,7 @@ unsigned char avr_op_ADIW::GetModifiedRHi() const {
     return Rh;
 }
 int avr_op_ADIW::operator()() {
-    word rd = (core->GetCoreReg(Rh) << 8) + core->GetCoreReg(Rl);
-    word res = rd + K;
-    unsigned char rdh = core->GetCoreReg(Rh);
-
-
-    status->V = ~(rdh >> 7 & 0x1) & (res >> 15 & 0x1); 
-    status->N = (res >> 15) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xffff) == 0;
-    status->C = ~(res >> 15 & 0x1) & (rdh >> 7 & 0x1); 
-
-    core->SetCoreReg(Rl, res & 0xff);
-    core->SetCoreReg(Rh, res >> 8);
-
-    return 2; 
+    return exec_ADIW(core, Rl, K);
 }
 
 avr_op_AND::avr_op_AND(word opcode, AvrDevice *c):
@@ -191,16 +146,7 @@ avr_op_AND::avr_op_AND(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_AND::operator()() {
-    unsigned char res = core->GetCoreReg(R1) & core->GetCoreReg(R2);
-
-    status->V = 0;
-    status->N = (res >> 7) & 0x1; 
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0; 
-
-    core->SetCoreReg(R1, res);
-
-    return 1; 
+    return exec_AND(core, R1, R2);
 }
 
 avr_op_ANDI::avr_op_ANDI(word opcode, AvrDevice *c):
@@ -210,17 +156,7 @@ avr_op_ANDI::avr_op_ANDI(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_ANDI::operator()() {
-    unsigned char rd = core->GetCoreReg(R1);
-    unsigned char res = rd & K;
-
-    status->V = 0;
-    status->N = (res >> 7) & 0x1; 
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0; 
-
-    core->SetCoreReg(R1, res);
-    
-    return 1;
+    return exec_ANDI(core, R1, K);
 }
 
 avr_op_ASR::avr_op_ASR(word opcode, AvrDevice *c):
@@ -229,18 +165,7 @@ avr_op_ASR::avr_op_ASR(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_ASR::operator()() {
-    unsigned char rd = core->GetCoreReg(R1); 
-    unsigned char res = (rd >> 1) + (rd & 0x80);
-
-    status->N = (res >> 7) & 0x1;
-    status->C = rd & 0x1;
-    status->V = status->N ^ status->C;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_ASR(core, R1);
 }
 
 
@@ -250,9 +175,7 @@ avr_op_BCLR::avr_op_BCLR(word opcode, AvrDevice *c):
     Kbit(get_sreg_bit(opcode)) {}
 
 int avr_op_BCLR::operator()() {
-    *status = (*status) & ~(1 << Kbit);
-    
-    return 1;
+    return exec_BCLR(core, 1 << Kbit);
 }
 
 avr_op_BLD::avr_op_BLD(word opcode, AvrDevice *c):
@@ -262,18 +185,7 @@ avr_op_BLD::avr_op_BLD(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_BLD::operator()() {
-    unsigned char rd = core->GetCoreReg(R1);
-    int T = status->T;
-    unsigned char res;
-
-    if(T == 0)
-        res = rd & ~(1 << Kbit);
-    else
-        res = rd | (1 << Kbit); 
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_BLD(core, R1, 1 << Kbit);
 }
 
 avr_op_BRBC::avr_op_BRBC(word opcode, AvrDevice *c):
@@ -283,17 +195,7 @@ avr_op_BRBC::avr_op_BRBC(word opcode, AvrDevice *c):
     offset(n_bit_unsigned_to_signed(get_k_7(opcode), 7)) {}
 
 int avr_op_BRBC::operator()() {
-    int clks;
-
-    if((bitmask & (*(status))) == 0) {
-        core->DebugOnJump();
-        core->PC += offset;
-        clks = 2;
-    } else {
-        clks = 1;
-    }
-
-    return clks;
+    return exec_BRBC(core, bitmask, offset);
 }
 
 avr_op_BRBS::avr_op_BRBS(word opcode, AvrDevice *c):
@@ -303,17 +205,7 @@ avr_op_BRBS::avr_op_BRBS(word opcode, AvrDevice *c):
     offset(n_bit_unsigned_to_signed(get_k_7(opcode), 7)) {}
 
 int avr_op_BRBS::operator()() {
-    int clks;
-
-    if((bitmask & (*(status))) != 0) {
-        core->DebugOnJump();
-        core->PC += offset;
-        clks = 2;
-    } else {
-        clks = 1;
-    }
-
-    return clks;
+    return exec_BRBS(core, bitmask, offset);
 }
 
 avr_op_BSET::avr_op_BSET(word opcode, AvrDevice *c):
@@ -322,9 +214,7 @@ avr_op_BSET::avr_op_BSET(word opcode, AvrDevice *c):
     Kbit(get_sreg_bit(opcode)) {}
 
 int avr_op_BSET::operator()() {
-    *(status) = *(status) | 1 << Kbit;
-    
-    return 1;
+    return exec_BSET(core, 1 << Kbit);
 }
 
 avr_op_BST::avr_op_BST(word opcode, AvrDevice *c):
@@ -334,27 +224,15 @@ avr_op_BST::avr_op_BST(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_BST::operator()() {
-    status->T = ((core->GetCoreReg(R1) & (1 << Kbit)) != 0); 
-
-    return 1;
+    return exec_BST(core, R1, 1 << Kbit);
 }
 
 avr_op_CALL::avr_op_CALL(word opcode, AvrDevice *c):
     DecodedInstruction(c, true),
     KH(get_k_22(opcode)) {}
 
-int avr_op_CALL::operator()() 
-{
-    word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
-    int k = (KH << 16) + K_lsb;
-    int clkadd = core->flagXMega ? 1 : 2;
-    
-    core->stack->m_ThreadList.OnCall();
-    core->stack->PushAddr(core->PC + 2);
-    core->DebugOnJump();
-    core->PC = k - 1;
-
-    return core->PC_size + clkadd;
+int avr_op_CALL::operator()() {
+    return exec_CALL(core, KH);
 }
 
 avr_op_CBI::avr_op_CBI(word opcode, AvrDevice *c):
@@ -363,11 +241,7 @@ avr_op_CBI::avr_op_CBI(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_CBI::operator()() {
-    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
-  
-    core->ClearIORegBit(ioreg, Kbit);
-    
-    return clks;
+    return exec_CBI(core, ioreg, Kbit);
 }
 
 avr_op_COM::avr_op_COM(word opcode, AvrDevice *c):
@@ -376,18 +250,7 @@ avr_op_COM::avr_op_COM(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_COM::operator()() {
-    byte rd  = core->GetCoreReg(R1);
-    byte res = 0xff - rd;
-
-    status->N = (res >> 7) & 0x1;
-    status->C = 1;
-    status->V = 0;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_COM(core, R1);
 }
 
 avr_op_CP::avr_op_CP(word opcode, AvrDevice *c):
@@ -397,18 +260,7 @@ avr_op_CP::avr_op_CP(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_CP::operator()() {
-    byte rd  = core->GetCoreReg(R1);
-    byte rr  = core->GetCoreReg(R2);
-    byte res = rd - rr;
-
-    status->H = get_compare_carry(res, rd, rr, 3);
-    status->V = get_compare_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_compare_carry(res, rd, rr, 7);
-
-    return 1;
+    return exec_CP(core, R1, R2);
 }
 
 avr_op_CPC::avr_op_CPC(word opcode, AvrDevice *c):
@@ -418,22 +270,7 @@ avr_op_CPC::avr_op_CPC(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_CPC::operator()() {
-    byte rd  = core->GetCoreReg(R1);
-    byte rr  = core->GetCoreReg(R2);
-    byte res = rd - rr - status->C;
-
-    status->H = get_compare_carry(res, rd, rr, 3);
-    status->V = get_compare_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->C = get_compare_carry(res, rd, rr, 7);
-
-    /* Previous value remains unchanged when result is 0; cleared otherwise */
-    bool Z = (res & 0xff) == 0;
-    bool prev_Z = status->Z;
-    status->Z = Z && prev_Z;
-
-    return 1;
+    return exec_CPC(core, R1, R2);
 }
 
 
@@ -444,17 +281,7 @@ avr_op_CPI::avr_op_CPI(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_CPI::operator()() {
-    byte rd  = core->GetCoreReg(R1);
-    byte res = rd - K;
-
-    status->H = get_compare_carry(res, rd, K, 3);
-    status->V = get_compare_overflow(res, rd, K);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_compare_carry(res, rd, K, 7);
-
-    return 1;
+    return exec_CPI(core, R1, K);
 }
 
 avr_op_CPSE::avr_op_CPSE(word opcode, AvrDevice *c):
@@ -464,24 +291,9 @@ avr_op_CPSE::avr_op_CPSE(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_CPSE::operator()() {
-    int skip;
-    byte rd = core->GetCoreReg(R1);
-    byte rr = core->GetCoreReg(R2);
-    int clks;
-
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
-        skip = 3;
-    else
-        skip = 2;
+    int skip = core->Flash->GetDecoded(core->PC + 1)->IsInstruction2Words() ? 3 : 2;
 
-    if(rd == rr) {
-        core->DebugOnJump();
-        core->PC += skip - 1;
-        clks = skip;
-    } else
-        clks = 1;
-
-    return clks;
+    return exec_CPSE(core, R1, R2, skip);
 }
 
 avr_op_DEC::avr_op_DEC(word opcode, AvrDevice *c):
@@ -490,16 +302,7 @@ avr_op_DEC::avr_op_DEC(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_DEC::operator()() {
-    byte res = core->GetCoreReg(R1) - 1;
-
-    status->N = (res >> 7) & 0x1;
-    status->V = res == 0x7f;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_DEC(core, R1);
 }
 
 avr_op_EICALL::avr_op_EICALL(word opcode, AvrDevice *c):
@@ -590,18 +393,7 @@ avr_op_EOR::avr_op_EOR(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_EOR::operator()() {
-    byte rd = core->GetCoreReg(R1); 
-    byte rr = core->GetCoreReg(R2);
-    byte res = rd ^ rr;
-
-    status->V = 0;
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_EOR(core, R1, R2);
 }
 
 avr_op_ESPM::avr_op_ESPM(word opcode, AvrDevice *c):
@@ -700,29 +492,14 @@ avr_op_ICALL::avr_op_ICALL(word opcode, AvrDevice *c):
     DecodedInstruction(c) {}
 
 int avr_op_ICALL::operator()() {
-    unsigned int pc = core->PC;
-    /* Z is R31:R30 */
-    unsigned int new_pc = core->GetRegZ();
-
-    core->stack->m_ThreadList.OnCall();
-    core->stack->PushAddr(pc + 1);
-
-    core->DebugOnJump();
-    core->PC = new_pc - 1;
-
-    return core->PC_size + (core->flagXMega ? 0 : 1);
+    return exec_ICALL(core);
 }
 
 avr_op_IJMP::avr_op_IJMP(word opcode, AvrDevice *c):
     DecodedInstruction(c) {}
 
 int avr_op_IJMP::operator()() {
-    int new_pc = core->GetRegZ();
-    
-    core->DebugOnJump();
-    core->PC = new_pc - 1;
-
-    return 2;
+    return exec_IJMP(core);
 }
 
 avr_op_IN::avr_op_IN(word opcode, AvrDevice *c):
@@ -731,10 +508,7 @@ avr_op_IN::avr_op_IN(word opcode, AvrDevice *c):
     ioreg(get_A_6(opcode)) {}
 
 int avr_op_IN::operator()() {
-    unsigned char val= core->GetIOReg(ioreg);
-    core->SetCoreReg(R1, val );
-
-    return 1;
+    return exec_IN(core, R1, ioreg);
 }
 
 avr_op_INC::avr_op_INC(word opcode, AvrDevice *c):
@@ -743,17 +517,7 @@ avr_op_INC::avr_op_INC(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_INC::operator()() {
-    byte rd  = core->GetCoreReg(R1);
-    byte res = rd + 1;
-
-    status->N = (res >> 7) & 0x1;
-    status->V = rd == 0x7f;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_INC(core, R1);
 }
 
 avr_op_JMP::avr_op_JMP(word opcode, AvrDevice *c):
@@ -761,10 +525,7 @@ avr_op_JMP::avr_op_JMP(word opcode, AvrDevice *c):
     K(get_k_22(opcode)) {}
 
 int avr_op_JMP::operator()() {
-    word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
-    core->DebugOnJump();
-    core->PC = (K << 16) + K_lsb - 1;
-    return 3;
+    return exec_JMP(core, K);
 }
 
 avr_op_LDD_Y::avr_op_LDD_Y(word opcode, AvrDevice *c):
@@ -773,12 +534,7 @@ avr_op_LDD_Y::avr_op_LDD_Y(word opcode, AvrDevice *c):
     K(get_q(opcode)) {}
 
 int avr_op_LDD_Y::operator()() {
-    /* Y is R29:R28 */
-    word Y = core->GetRegY();
-
-    core->SetCoreReg(Rd, core->GetRWMem(Y + K));
-    
-    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+    return exec_LDD_Y(core, Rd, K);
 }
 
 avr_op_LDD_Z::avr_op_LDD_Z(word opcode, AvrDevice *c):
@@ -787,12 +543,7 @@ avr_op_LDD_Z::avr_op_LDD_Z(word opcode, AvrDevice *c):
     K(get_q(opcode)) {}
 
 int avr_op_LDD_Z::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-
-    core->SetCoreReg(Rd, core->GetRWMem(Z + K));
-
-    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+    return exec_LDD_Z(core, Rd, K);
 }
 
 avr_op_LDI::avr_op_LDI(word opcode, AvrDevice *c):
@@ -803,10 +554,8 @@ avr_op_LDI::avr_op_LDI(word opcode, AvrDevice *c):
 unsigned char avr_op_LDI::GetModifiedR() const {
     return R1;
 }
-int avr_op_LDI::operator()() { 
-    core->SetCoreReg(R1, K);
-
-    return 1;
+int avr_op_LDI::operator()() {
+    return exec_LDI(core, R1, K);
 }
 
 avr_op_LDS::avr_op_LDS(word opcode, AvrDevice *c):
@@ -814,13 +563,7 @@ avr_op_LDS::avr_op_LDS(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_LDS::operator()() {
-    /* Get data at k in current data segment and put into Rd */
-    word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);
-    
-    core->SetCoreReg(R1, core->GetRWMem(offset));
-    core->PC++;
-    
-    return 2;
+    return exec_LDS(core, R1);
 }
 
 avr_op_LD_X::avr_op_LD_X(word opcode, AvrDevice *c):
@@ -828,12 +571,7 @@ avr_op_LD_X::avr_op_LD_X(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_X::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-
-    core->SetCoreReg(Rd, core->GetRWMem(X));
-    
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return exec_LD_X(core, Rd);
 }
 
 avr_op_LD_X_decr::avr_op_LD_X_decr(word opcode, AvrDevice *c):
@@ -841,18 +579,7 @@ avr_op_LD_X_decr::avr_op_LD_X_decr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_X_decr::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-    if (Rd == 26 || Rd == 27)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform pre-decrement */
-    X--;
-    core->SetCoreReg(Rd, core->GetRWMem(X));
-    core->SetCoreReg(26, X & 0xff);
-    core->SetCoreReg(27, (X >> 8) & 0xff);
-
-    return core->flagTiny10 ? 3 : 2;
+    return exec_LD_decr(core, Rd, 26);
 }
 
 avr_op_LD_X_incr::avr_op_LD_X_incr(word opcode, AvrDevice *c):
@@ -860,18 +587,7 @@ avr_op_LD_X_incr::avr_op_LD_X_incr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_X_incr::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-    if (Rd == 26 || Rd == 27)
-       avr_error( "Result of operation is undefined" );
-
-    /* Perform post-increment */
-    core->SetCoreReg(Rd, core->GetRWMem(X));
-    X++;
-    core->SetCoreReg(26, X & 0xff);
-    core->SetCoreReg(27, (X >> 8) & 0xff);
-
-    return core->flagXMega ? 1 : 2;
+    return exec_LD_incr(core, Rd, 26);
 }
 
 avr_op_LD_Y_decr::avr_op_LD_Y_decr(word opcode, AvrDevice *c):
@@ -879,18 +595,7 @@ avr_op_LD_Y_decr::avr_op_LD_Y_decr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_Y_decr::operator()() {
-    /* Y is R29:R28 */
-    word Y = core->GetRegY();
-    if (Rd == 28 || Rd == 29)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform pre-decrement */
-    Y--;
-    core->SetCoreReg(Rd, core->GetRWMem(Y));
-    core->SetCoreReg(28, Y & 0xff);
-    core->SetCoreReg(29, (Y >> 8) & 0xff);
-
-    return core->flagTiny10 ? 3 : 2;
+    return exec_LD_decr(core, Rd, 28);
 }
 
 avr_op_LD_Y_incr::avr_op_LD_Y_incr(word opcode, AvrDevice *c):
@@ -898,18 +603,7 @@ avr_op_LD_Y_incr::avr_op_LD_Y_incr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_Y_incr::operator()() {
-    /* Y is R29:R28 */
-    word Y = core->GetRegY();
-    if (Rd == 28 || Rd == 29)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform post-increment */
-    core->SetCoreReg(Rd, core->GetRWMem(Y));
-    Y++;
-    core->SetCoreReg(28, Y & 0xff);
-    core->SetCoreReg(29, (Y >> 8) & 0xff);
-
-    return core->flagXMega ? 1 : 2;
+    return exec_LD_incr(core, Rd, 28);
 }
 
 avr_op_LD_Z_incr::avr_op_LD_Z_incr(word opcode, AvrDevice *c):
@@ -917,18 +611,7 @@ avr_op_LD_Z_incr::avr_op_LD_Z_incr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_Z_incr::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-    if (Rd == 30 || Rd == 31)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform post-increment */
-    core->SetCoreReg(Rd, core->GetRWMem(Z));
-    Z++;
-    core->SetCoreReg(30, Z & 0xff);
-    core->SetCoreReg(31, (Z >> 8) & 0xff);
-
-    return core->flagXMega ? 1 : 2;
+    return exec_LD_incr(core, Rd, 30);
 }
 
 avr_op_LD_Z_decr::avr_op_LD_Z_decr(word opcode, AvrDevice *c):
@@ -936,18 +619,7 @@ avr_op_LD_Z_decr::avr_op_LD_Z_decr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LD_Z_decr::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-    if (Rd == 30 || Rd == 31)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform pre-decrement */
-    Z--;
-    core->SetCoreReg(Rd, core->GetRWMem(Z));
-    core->SetCoreReg(30, Z & 0xff);
-    core->SetCoreReg(31, (Z >> 8) & 0xff);
-
-    return core->flagTiny10 ? 3 : 2;
+    return exec_LD_decr(core, Rd, 30);
 }
 
 avr_op_LPM_Z::avr_op_LPM_Z(word opcode, AvrDevice *c):
@@ -955,13 +627,7 @@ avr_op_LPM_Z::avr_op_LPM_Z(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int  avr_op_LPM_Z::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-
-    Z ^= 0x0001;
-    core->SetCoreReg(Rd , core->Flash->ReadMem(Z));
-
-    return 3;
+    return exec_LPM_Z(core, Rd);
 }
 
 avr_op_LPM::avr_op_LPM(word opcode, AvrDevice *c):
@@ -982,16 +648,7 @@ avr_op_LPM_Z_incr::avr_op_LPM_Z_incr(word opcode, AvrDevice *c):
     Rd(get_rd_5(opcode)) {}
 
 int avr_op_LPM_Z_incr::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-
-    core->SetCoreReg(Rd , core->Flash->ReadMem(Z ^ 0x0001));
-
-    Z++;
-    core->SetCoreReg(30, Z & 0xff);
-    core->SetCoreReg(31, (Z >> 8) & 0xff);
-
-    return 3;
+    return exec_LPM_Z_incr(core, Rd);
 }
 
 avr_op_LSR::avr_op_LSR(word opcode, AvrDevice *c):
@@ -1000,19 +657,7 @@ avr_op_LSR::avr_op_LSR(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_LSR::operator()() {
-    byte rd = core->GetCoreReg(Rd); 
-
-    byte res = (rd >> 1) & 0x7f;
-
-    status->C = rd & 0x1;
-    status->N = 0;
-    status->V = status->N ^ status->C;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-
-    core->SetCoreReg(Rd, res);
-
-    return 1;
+    return exec_LSR(core, Rd);
 }
 
 avr_op_MOV::avr_op_MOV(word opcode, AvrDevice *c):
@@ -1021,8 +666,7 @@ avr_op_MOV::avr_op_MOV(word opcode, AvrDevice *c):
     R2(get_rr_5(opcode)) {}
 
 int avr_op_MOV::operator()() {
-    core->SetCoreReg(R1, core->GetCoreReg(R2));
-    return 1;
+    return exec_MOV(core, R1, R2);
 }
 
 avr_op_MOVW::avr_op_MOVW(word opcode, AvrDevice *c):
@@ -1031,10 +675,7 @@ avr_op_MOVW::avr_op_MOVW(word opcode, AvrDevice *c):
     Rs((get_rr_4(opcode) - 16) << 1) {}
 
 int avr_op_MOVW::operator()() {
-    core->SetCoreReg(Rd, core->GetCoreReg(Rs));
-    core->SetCoreReg(Rd + 1, core->GetCoreReg(Rs + 1));
-
-    return 1;
+    return exec_MOVW(core, Rd, Rs);
 }
 
 avr_op_MUL::avr_op_MUL(word opcode, AvrDevice *c):
@@ -1044,19 +685,7 @@ avr_op_MUL::avr_op_MUL(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_MUL::operator()() {
-    byte rd = core->GetCoreReg(Rd);
-    byte rr = core->GetCoreReg(Rr);
-
-    word res = rd * rr;
-
-    status->Z = (res & 0xffff) == 0;
-    status->C = (res >> 15) & 0x1;
-
-    /* result goes in R1:R0 */
-    core->SetCoreReg(0, res & 0xff);
-    core->SetCoreReg(1, (res >> 8) & 0xff);
-
-    return 2;
+    return exec_MUL(core, Rd, Rr);
 }
 
 avr_op_MULS::avr_op_MULS(word opcode, AvrDevice *c):
@@ -1110,26 +739,14 @@ avr_op_NEG::avr_op_NEG(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_NEG::operator()() {
-    byte rd  = core->GetCoreReg(Rd);
-    byte res = (0x0 - rd) & 0xff;
-
-    status->H = ((res >> 3) | (rd >> 3)) & 0x1;
-    status->V = res == 0x80;
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = res == 0x0;
-    status->C = res != 0x0;
-
-    core->SetCoreReg(Rd, res);
-
-    return 1;
+    return exec_NEG(core, Rd);
 }
 
 avr_op_NOP::avr_op_NOP(word opcode, AvrDevice *c):
     DecodedInstruction(c) {}
 
 int avr_op_NOP::operator()() {
-    return 1;
+    return exec_NOP(core);
 }
 
 avr_op_OR::avr_op_OR(word opcode, AvrDevice *c):
@@ -1139,16 +756,7 @@ avr_op_OR::avr_op_OR(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_OR::operator()() {
-    byte res = core->GetCoreReg(Rd) | core->GetCoreReg(Rr);
-
-    status->V = 0;
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = res == 0x0;
-
-    core->SetCoreReg(Rd, res);
-
-    return 1;
+    return exec_OR(core, Rd, Rr);
 }
 
 avr_op_ORI::avr_op_ORI(word opcode, AvrDevice *c):
@@ -1158,16 +766,7 @@ avr_op_ORI::avr_op_ORI(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_ORI::operator()() {
-    byte res = core->GetCoreReg(R1) | K;
-
-    status->V = 0;
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = res == 0x0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_ORI(core, R1, K);
 }
 
 avr_op_OUT::avr_op_OUT(word opcode, AvrDevice *c):
@@ -1176,9 +775,7 @@ avr_op_OUT::avr_op_OUT(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_OUT::operator()() {
-    core->SetIOReg(ioreg, core->GetCoreReg(R1));
-
-    return 1;
+    return exec_OUT(core, R1, ioreg);
 }
 
 avr_op_POP::avr_op_POP(word opcode, AvrDevice *c):
@@ -1186,9 +783,7 @@ avr_op_POP::avr_op_POP(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_POP::operator()() {
-    core->SetCoreReg(R1, core->stack->Pop());
-
-    return 2;
+    return exec_POP(core, R1);
 }
 
 avr_op_PUSH::avr_op_PUSH(word opcode, AvrDevice *c):
@@ -1196,9 +791,7 @@ avr_op_PUSH::avr_op_PUSH(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_PUSH::operator()() {
-    core->stack->Push(core->GetCoreReg(R1));
-
-    return core->flagXMega ? 1 : 2;
+    return exec_PUSH(core, R1);
 }
 
 avr_op_RCALL::avr_op_RCALL(word opcode, AvrDevice *c):
@@ -1206,25 +799,14 @@ avr_op_RCALL::avr_op_RCALL(word opcode, AvrDevice *c):
     K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)) {}
 
 int avr_op_RCALL::operator()() {
-    core->stack->PushAddr(core->PC + 1);
-    core->stack->m_ThreadList.OnCall();
-    core->DebugOnJump();
-    core->PC += K;
-    core->PC &= (core->Flash->GetSize() - 1) >> 1;
-
-    if(core->flagTiny10)
-        return 4;
-    return core->PC_size + (core->flagXMega ? 0 : 1);
-    
+    return exec_RCALL(core, K);
 }
 
 avr_op_RET::avr_op_RET(word opcode, AvrDevice *c):
     DecodedInstruction(c) {}
 
 int avr_op_RET::operator()() {
-    core->PC = core->stack->PopAddr() - 1;
-
-    return core->PC_size + 2;
+    return exec_RET(core);
 }
 
 avr_op_RETI::avr_op_RETI(word opcode, AvrDevice *c):
@@ -1232,10 +814,7 @@ avr_op_RETI::avr_op_RETI(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_RETI::operator()() {
-    core->PC = core->stack->PopAddr() - 1;
-    status->I = 1;
-
-    return core->PC_size + 2;
+    return exec_RETI(core);
 }
 
 avr_op_RJMP::avr_op_RJMP(word opcode, AvrDevice *c):
@@ -1243,11 +822,7 @@ avr_op_RJMP::avr_op_RJMP(word opcode, AvrDevice *c):
     K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)) {}
 
 int avr_op_RJMP::operator()() {
-    core->DebugOnJump();
-    core->PC += K;
-    core->PC &= (core->Flash->GetSize() - 1) >> 1;
-
-    return 2;
+    return exec_RJMP(core, K);
 }
 
 avr_op_ROR::avr_op_ROR(word opcode, AvrDevice *c):
@@ -1256,19 +831,7 @@ avr_op_ROR::avr_op_ROR(word opcode, AvrDevice *c):
     status(c->status) {}
 
 int avr_op_ROR::operator()() {
-    byte rd = core->GetCoreReg(R1);
-
-    byte res = (rd >> 1) | ((status->C << 7) & 0x80);
-
-    status->C = rd & 0x1;
-    status->N = (res >> 7) & 0x1;
-    status->V = status->N ^ status->C;
-    status->S = status->N ^ status->V;
-    status->Z = res == 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_ROR(core, R1);
 }
 
 
@@ -1282,23 +845,7 @@ unsigned char avr_op_SBC::GetModifiedR() const {
     return R1;
 }
 int avr_op_SBC::operator()() {
-    byte rd = core->GetCoreReg(R1);
-    byte rr = core->GetCoreReg(R2);
-
-    byte res = rd - rr - status->C;
-
-    status->H = get_sub_carry(res, rd, rr, 3);
-    status->V = get_sub_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->C = get_sub_carry(res, rd, rr, 7);
-
-    if((res & 0xff) != 0)
-        status->Z = 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_SBC(core, R1, R2);
 }
 
 avr_op_SBCI::avr_op_SBCI(word opcode, AvrDevice *c):
@@ -1311,22 +858,7 @@ unsigned char avr_op_SBCI::GetModifiedR() const {
     return R1;
 }
 int avr_op_SBCI::operator()() {
-    byte rd = core->GetCoreReg(R1);
-
-    byte res = rd - K - status->C;
-
-    status->H = get_sub_carry(res, rd, K, 3);
-    status->V = get_sub_overflow(res, rd, K);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->C = get_sub_carry(res, rd, K, 7);
-
-    if((res & 0xff) != 0)
-        status->Z = 0;
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_SBCI(core, R1, K);
 }
 
 avr_op_SBI::avr_op_SBI(word opcode, AvrDevice *c):
@@ -1335,11 +867,7 @@ avr_op_SBI::avr_op_SBI(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_SBI::operator()() {
-    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
-    
-    core->SetIORegBit(ioreg, Kbit);
-    
-    return clks;
+    return exec_SBI(core, ioreg, Kbit);
 }
 
 avr_op_SBIC::avr_op_SBIC(word opcode, AvrDevice *c):
@@ -1348,24 +876,9 @@ avr_op_SBIC::avr_op_SBIC(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_SBIC::operator()() {
-    int skip, clks;
-
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
-        skip = 3;
-    else
-        skip = 2;
-
-    if((core->GetIOReg(ioreg) & (1 << Kbit)) == 0) {
-        core->DebugOnJump();
-        core->PC += skip - 1;
-        clks = skip;
-    } else
-        clks = 1;
-
-    if(core->flagXMega)
-        clks++;
-    
-    return clks;
+    int skip = core->Flash->GetDecoded(core->PC + 1)->IsInstruction2Words() ? 3 : 2;
+
+    return exec_SBIC(core, ioreg, Kbit, skip);
 }
 
 avr_op_SBIS::avr_op_SBIS(word opcode, AvrDevice *c):
@@ -1374,24 +887,9 @@ avr_op_SBIS::avr_op_SBIS(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_SBIS::operator()() {
-    int skip, clks;
-
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
-        skip = 3;
-    else
-        skip = 2;
-
-    if((core->GetIOReg(ioreg) & (1 << Kbit)) != 0) {
-        core->DebugOnJump();
-        core->PC += skip - 1;
-        clks = skip;
-    } else
-        clks = 1;
-
-    if(core->flagXMega)
-        clks++;
-    
-    return clks;
+    int skip = core->Flash->GetDecoded(core->PC + 1)->IsInstruction2Words() ? 3 : 2;
+
+    return exec_SBIS(core, ioreg, Kbit, skip);
 }
 
 
@@ -1408,22 +906,7 @@ unsigned char avr_op_SBIW::GetModifiedRHi() const {
     return R1 + 1;
 }
 int avr_op_SBIW::operator()() {
-    byte rdl = core->GetCoreReg(R1);
-    byte rdh = core->GetCoreReg(R1 + 1);
-
-    word rd = (rdh << 8) + rdl;
-    word res = rd - K;
-
-    status->V = (rdh >> 7 & 0x1) & ~(res >> 15 & 0x1);
-    status->N = (res >> 15) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xffff) == 0;
-    status->C = (res >> 15 & 0x1) & ~(rdh >> 7 & 0x1);
-
-    core->SetCoreReg(R1, res & 0xff);
-    core->SetCoreReg(R1 + 1, (res >> 8) & 0xff);
-
-    return 2;
+    return exec_SBIW(core, R1, K);
 }
 
 avr_op_SBRC::avr_op_SBRC(word opcode, AvrDevice *c):
@@ -1432,21 +915,9 @@ avr_op_SBRC::avr_op_SBRC(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_SBRC::operator()() {
-    int skip, clks;
-
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
-        skip = 3;
-    else
-        skip = 2;
-
-    if((core->GetCoreReg(R1) & (1 << Kbit)) == 0) {
-        core->DebugOnJump();
-        core->PC += skip - 1;
-        clks = skip;
-    } else
-        clks = 1;
+    int skip = core->Flash->GetDecoded(core->PC + 1)->IsInstruction2Words() ? 3 : 2;
 
-    return clks;
+    return exec_SBRC(core, R1, 1 << Kbit, skip);
 }
 
 avr_op_SBRS::avr_op_SBRS(word opcode, AvrDevice *c):
@@ -1455,21 +926,9 @@ avr_op_SBRS::avr_op_SBRS(word opcode, AvrDevice *c):
     Kbit(get_reg_bit(opcode)) {}
 
 int avr_op_SBRS::operator()() {
-    int skip, clks;
-
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
-        skip = 3;
-    else
-        skip = 2;
-
-    if((core->GetCoreReg(R1) & (1 << Kbit)) != 0) {
-        core->DebugOnJump();
-        core->PC += skip - 1;
-        clks = skip;
-    } else
-        clks = 1;
+    int skip = core->Flash->GetDecoded(core->PC + 1)->IsInstruction2Words() ? 3 : 2;
 
-    return clks;
+    return exec_SBRS(core, R1, 1 << Kbit, skip);
 }
 
 avr_op_SLEEP::avr_op_SLEEP(word opcode, AvrDevice *c):
@@ -1522,12 +981,7 @@ avr_op_STD_Y::avr_op_STD_Y(word opcode, AvrDevice *c):
     K(get_q(opcode)) {}
 
 int avr_op_STD_Y::operator()() {
-    /* Y is R29:R28 */
-    unsigned int Y = core->GetRegY();
-
-    core->SetRWMem(Y + K, core->GetCoreReg(R1));
-
-    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+    return exec_STD_Y(core, R1, K);
 }
 
 avr_op_STD_Z::avr_op_STD_Z(word opcode, AvrDevice *c):
@@ -1536,12 +990,7 @@ avr_op_STD_Z::avr_op_STD_Z(word opcode, AvrDevice *c):
     K(get_q(opcode)) {}
 
 int avr_op_STD_Z::operator()() {
-    /* Z is R31:R30 */
-    int Z = core->GetRegZ();
-
-    core->SetRWMem(Z + K, core->GetCoreReg(R1));
-
-    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+    return exec_STD_Z(core, R1, K);
 }
 
 avr_op_STS::avr_op_STS(word opcode, AvrDevice *c):
@@ -1549,13 +998,7 @@ avr_op_STS::avr_op_STS(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_STS::operator()() {
-    /* Get data at k in current data segment and put into Rd */
-    word k = core->Flash->ReadMemWord((core->PC + 1) * 2);
-
-    core->SetRWMem(k, core->GetCoreReg(R1));
-    core->PC++;
-
-    return 2;
+    return exec_STS(core, R1);
 }
 
 avr_op_ST_X::avr_op_ST_X(word opcode, AvrDevice *c):
@@ -1563,12 +1006,7 @@ avr_op_ST_X::avr_op_ST_X(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_X::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-    
-    core->SetRWMem(X, core->GetCoreReg(R1));
-
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return exec_ST_X(core, R1);
 }
 
 avr_op_ST_X_decr::avr_op_ST_X_decr(word opcode, AvrDevice *c):
@@ -1576,18 +1014,7 @@ avr_op_ST_X_decr::avr_op_ST_X_decr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_X_decr::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-    if (R1 == 26 || R1 == 27)
-        avr_error( "Result of operation is undefined" );
-
-    /* Perform pre-decrement */
-    X--;
-    core->SetCoreReg(26, X & 0xff);
-    core->SetCoreReg(27, (X >> 8) & 0xff);
-    core->SetRWMem(X, core->GetCoreReg(R1));
-
-    return 2;
+    return exec_ST_decr(core, R1, 26);
 }
 
 avr_op_ST_X_incr::avr_op_ST_X_incr(word opcode, AvrDevice *c):
@@ -1595,19 +1022,7 @@ avr_op_ST_X_incr::avr_op_ST_X_incr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_X_incr::operator()() {
-    /* X is R27:R26 */
-    word X = core->GetRegX();
-    if (R1 == 26 || R1 == 27)
-        avr_error( "Result of operation is undefined" );
-
-    core->SetRWMem(X, core->GetCoreReg(R1));
-
-    /* Perform post-increment */
-    X++;
-    core->SetCoreReg(26, X & 0xff);
-    core->SetCoreReg(27, (X >> 8) & 0xff);
-
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return exec_ST_incr(core, R1, 26);
 }
 
 avr_op_ST_Y_decr::avr_op_ST_Y_decr(word opcode, AvrDevice *c):
@@ -1615,18 +1030,7 @@ avr_op_ST_Y_decr::avr_op_ST_Y_decr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_Y_decr::operator()() {
-    /* Y is R29:R28 */
-    word Y = core->GetRegY();
-    if (R1 == 28 || R1 == 29)
-        avr_error( "Result of operation is undefined" );
- 
-    /* Perform pre-decrement */
-    Y--;
-    core->SetCoreReg(28, Y & 0xff);
-    core->SetCoreReg(29, (Y >> 8) & 0xff);
-    core->SetRWMem(Y, core->GetCoreReg(R1));
-
-    return 2;
+    return exec_ST_decr(core, R1, 28);
 }
 
 avr_op_ST_Y_incr::avr_op_ST_Y_incr(word opcode, AvrDevice *c):
@@ -1634,19 +1038,7 @@ avr_op_ST_Y_incr::avr_op_ST_Y_incr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_Y_incr::operator()() {
-    /* Y is R29:R28 */
-    word Y = core->GetRegY();
-    if (R1 == 28 || R1 == 29)
-        avr_error( "Result of operation is undefined" );
-
-    core->SetRWMem(Y, core->GetCoreReg(R1));
-
-    /* Perform post-increment */
-    Y++;
-    core->SetCoreReg(28, Y & 0xff);
-    core->SetCoreReg(29, (Y >> 8) & 0xff);
-
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return exec_ST_incr(core, R1, 28);
 }
 
 avr_op_ST_Z_decr::avr_op_ST_Z_decr(word opcode, AvrDevice *c):
@@ -1654,18 +1046,7 @@ avr_op_ST_Z_decr::avr_op_ST_Z_decr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_Z_decr::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-    if (R1 == 30 || R1 == 31)
-        avr_error( "Result of operation is undefined" );
- 
-    /* Perform pre-decrement */
-    Z--;
-    core->SetCoreReg(30, Z & 0xff);
-    core->SetCoreReg(31, (Z >> 8) & 0xff);
-    core->SetRWMem(Z, core->GetCoreReg(R1));
-
-    return 2;
+    return exec_ST_decr(core, R1, 30);
 }
 
 avr_op_ST_Z_incr::avr_op_ST_Z_incr(word opcode, AvrDevice *c):
@@ -1673,19 +1054,7 @@ avr_op_ST_Z_incr::avr_op_ST_Z_incr(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_ST_Z_incr::operator()() {
-    /* Z is R31:R30 */
-    word Z = core->GetRegZ();
-    if (R1 == 30 || R1 == 31)
-        avr_error( "Result of operation is undefined" );
-
-    core->SetRWMem(Z, core->GetCoreReg(R1));
-
-    /* Perform post-increment */
-    Z++;
-    core->SetCoreReg(30, Z & 0xff);
-    core->SetCoreReg(31, (Z >> 8) & 0xff);
-
-    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+    return exec_ST_incr(core, R1, 30);
 }
 
 avr_op_SUB::avr_op_SUB(word opcode, AvrDevice *c):
@@ -1698,21 +1067,7 @@ unsigned char avr_op_SUB::GetModifiedR() const {
     return R1;
 }
 int avr_op_SUB::operator()() {
-    byte rd = core->GetCoreReg(R1);
-    byte rr = core->GetCoreReg(R2);
-
-    byte res = rd - rr;
-
-    status->H = get_sub_carry(res, rd, rr, 3);
-    status->V = get_sub_overflow(res, rd, rr);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_sub_carry(res, rd, rr, 7);
-    
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_SUB(core, R1, R2);
 }
 
 avr_op_SUBI::avr_op_SUBI(word opcode, AvrDevice *c):
@@ -1725,19 +1080,7 @@ unsigned char avr_op_SUBI::GetModifiedR() const {
     return R1;
 }
 int avr_op_SUBI::operator()() {
-    byte rd = core->GetCoreReg(R1);
-    byte res = rd - K;
-
-    status->H = get_sub_carry(res, rd, K, 3);
-    status->V = get_sub_overflow(res, rd, K);
-    status->N = (res >> 7) & 0x1;
-    status->S = status->N ^ status->V;
-    status->Z = (res & 0xff) == 0;
-    status->C = get_sub_carry(res, rd, K, 7);
-
-    core->SetCoreReg(R1, res);
-
-    return 1;
+    return exec_SUBI(core, R1, K);
 }
 
 avr_op_SWAP::avr_op_SWAP(word opcode, AvrDevice *c):
@@ -1745,12 +1088,7 @@ avr_op_SWAP::avr_op_SWAP(word opcode, AvrDevice *c):
     R1(get_rd_5(opcode)) {}
 
 int avr_op_SWAP::operator()() {
-    byte rd = core->GetCoreReg(R1);
-    byte res = ((rd << 4) & 0xf0) | ((rd >> 4) & 0x0f);
-
-    core->SetCoreReg(R1, res);
-    
-    return 1;
+    return exec_SWAP(core, R1);
 }
 
 avr_op_WDR::avr_op_WDR(word opcode, AvrDevice *c):
@@ -1779,55 +1117,6 @@ int avr_op_ILLEGAL::operator()() {
     return 0;
 }
 
-static int get_add_carry( byte res, byte rd, byte rr, int b )
-{
-    byte resb = res >> b & 0x1;
-    byte rdb  = rd  >> b & 0x1;
-    byte rrb  = rr  >> b & 0x1;
-    return (rdb & rrb) | (rrb & ~resb) | (~resb & rdb);
-}
-
-static int get_add_overflow( byte res, byte rd, byte rr )
-{
-    byte res7 = res >> 7 & 0x1;
-    byte rd7  = rd  >> 7 & 0x1;
-    byte rr7  = rr  >> 7 & 0x1;
-    return (rd7 & rr7 & ~res7) | (~rd7 & ~rr7 & res7);
-}
-
-static int get_sub_carry( byte res, byte rd, byte rr, int b )
-{
-    byte resb = res >> b & 0x1;
-    byte rdb  = rd  >> b & 0x1;
-    byte rrb  = rr  >> b & 0x1;
-    return (~rdb & rrb) | (rrb & resb) | (resb & ~rdb);
-}
-
-static int get_sub_overflow( byte res, byte rd, byte rr )
-{
-    byte res7 = res >> 7 & 0x1;
-    byte rd7  = rd  >> 7 & 0x1;
-    byte rr7  = rr  >> 7 & 0x1;
-    return (rd7 & ~rr7 & ~res7) | (~rd7 & rr7 & res7);
-}
-
-static int get_compare_carry( byte res, byte rd, byte rr, int b )
-{
-    byte resb = res >> b & 0x1;
-    byte rdb  = rd  >> b & 0x1;
-    byte rrb  = rr  >> b & 0x1;
-    return (~rdb & rrb) | (rrb & resb) | (resb & ~rdb);
-}
-
-static int get_compare_overflow( byte res, byte rd, byte rr )
-{
-    byte res7 = res >> 7 & 0x1;
-    byte rd7  = rd  >> 7 & 0x1;
-    byte rr7  = rr  >> 7 & 0x1;
-    /* The atmel data sheet says the second term is ~rd7 for CP
-     * but that doesn't make any sense. You be the judge. */
-    return (rd7 & ~rr7 & ~res7) | (~rd7 & rr7 & res7);
-}
 static int n_bit_unsigned_to_signed( unsigned int val, int n ) 
 {
     /* Convert n-bit unsigned value to a signed value. */
@@ -27,12 +27,55 @@
 #define DECODER
 
 #include <iostream>
+#include <atomic>
 
 #include "rwmem.h"
 #include "types.h"
 #include "avrdevice.h"
 
 class AvrFlash;
+class DecodedInstruction;
+
+//! Compact record of a decoded instruction for threaded dispatch
+/*! AvrFlash holds one record per flash word in a flat array. The operands are
+  copied from the DecodedInstruction at decode time, so executing a record is
+  one indirect call through handler, without a virtual call and without
+  touching the DecodedInstruction object. Instructions without an own handler
+  get a handler, which simply calls the DecodedInstruction.
+
+  Records of a shared FlashImage are executed by devices on other threads,
+  while one of them decodes a record. So the operands are written first and
+  the record is published by a release store of handler, the core reads it by
+  GetHandler with acquire. */
+struct ThreadedInstruction {
+    //! Performs instruction, returns used clocks like DecodedInstruction::operator()
+    typedef int (*Handler)(AvrDevice *core, const ThreadedInstruction *ti);
+
+    std::atomic<Handler> handler; //!< function, which executes this instruction
+    unsigned char R1; //!< destination register or register pair
+    unsigned char R2; //!< source register, pointer register, bit number or bit mask
+    bool size2Word; //!< Flag: true, if instruction has 2 words
+    bool endsBlock; //!< Flag: true, if instruction can change program flow, ends a BasicBlock
+    int K; //!< constant, IO address, address displacement, bit mask or jump offset
+
+    ThreadedInstruction(): handler(nullptr), R1(0), R2(0), size2Word(false), endsBlock(false), K(0) {}
+    //! Copies a record, which isn't executed by other threads at the same time
+    ThreadedInstruction(const ThreadedInstruction &ti) { *this = ti; }
+    ThreadedInstruction &operator=(const ThreadedInstruction &ti) {
+        handler.store(ti.handler.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        R1 = ti.R1;
+        R2 = ti.R2;
+        size2Word = ti.size2Word;
+        endsBlock = ti.endsBlock;
+        K = ti.K;
+        return *this;
+    }
+
+    //! Returns handler, operands written before it was published are visible
+    Handler GetHandler(void) const { return handler.load(std::memory_order_acquire); }
+    //! Publishes handler after the operands
+    void SetHandler(Handler h) { handler.store(h, std::memory_order_release); }
+};
 
 //! Base class of core instruction
 /*! All instruction are derived from this class */
@@ -53,6 +96,9 @@ class DecodedInstruction {
         virtual int operator()() = 0;
         //! Performs instruction and write out instruction mnemonic for trace
         virtual int Trace() = 0;
+        //! Fills handler and operands of a threaded code record for this instruction
+        /*! The default handler calls operator() of this instance. */
+        virtual void Precompile(ThreadedInstruction *ti) const;
 		//! If this instruction modifies a R0-R31 register then return its number, otherwise -1.
 		virtual unsigned char GetModifiedR() const {return -1;}
 		//! If this instruction modifies a pair of R0-R31 registers then ...
@@ -88,6 +134,7 @@ class avr_op_ADC: public DecodedInstruction {
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override; 
+        void Precompile(ThreadedInstruction *ti) const override;
 }; //end of class 
 
 class avr_op_ADD: public DecodedInstruction {
@@ -110,6 +157,7 @@ class avr_op_ADD: public DecodedInstruction {
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override; 
+        void Precompile(ThreadedInstruction *ti) const override;
 }; //end of class 
 
 
@@ -139,6 +187,7 @@ class avr_op_ADIW: public DecodedInstruction
         unsigned char GetModifiedRHi() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_AND: public DecodedInstruction
@@ -162,6 +211,7 @@ class avr_op_AND: public DecodedInstruction
         avr_op_AND(word opcode, AvrDevice *c); 
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ANDI: public DecodedInstruction
@@ -185,6 +235,7 @@ class avr_op_ANDI: public DecodedInstruction
         avr_op_ANDI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ASR:public DecodedInstruction
@@ -207,6 +258,7 @@ class avr_op_ASR:public DecodedInstruction
         avr_op_ASR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_BCLR: public DecodedInstruction
@@ -229,6 +281,7 @@ class avr_op_BCLR: public DecodedInstruction
         avr_op_BCLR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 
@@ -252,6 +305,7 @@ class avr_op_BLD: public DecodedInstruction
         avr_op_BLD(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_BRBC: public DecodedInstruction
@@ -280,6 +334,7 @@ class avr_op_BRBC: public DecodedInstruction
         avr_op_BRBC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_BRBS: public DecodedInstruction
@@ -308,6 +363,7 @@ class avr_op_BRBS: public DecodedInstruction
         avr_op_BRBS(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_BSET: public DecodedInstruction
@@ -330,6 +386,7 @@ class avr_op_BSET: public DecodedInstruction
         avr_op_BSET(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_BST: public DecodedInstruction
@@ -353,6 +410,7 @@ class avr_op_BST: public DecodedInstruction
         avr_op_BST(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 
 };
 
@@ -375,6 +433,7 @@ class avr_op_CALL: public DecodedInstruction
         avr_op_CALL(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_CBI: public DecodedInstruction
@@ -398,6 +457,7 @@ class avr_op_CBI: public DecodedInstruction
         avr_op_CBI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_COM: public DecodedInstruction
@@ -420,6 +480,7 @@ class avr_op_COM: public DecodedInstruction
         avr_op_COM(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_CP: public DecodedInstruction
@@ -443,6 +504,7 @@ class avr_op_CP: public DecodedInstruction
         avr_op_CP(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_CPC: public DecodedInstruction
@@ -466,6 +528,7 @@ class avr_op_CPC: public DecodedInstruction
         avr_op_CPC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_CPI: public DecodedInstruction
@@ -489,6 +552,7 @@ class avr_op_CPI: public DecodedInstruction
         avr_op_CPI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 
 };
 
@@ -513,6 +577,7 @@ class avr_op_CPSE: public DecodedInstruction
         avr_op_CPSE(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_DEC: public DecodedInstruction
@@ -535,6 +600,7 @@ class avr_op_DEC: public DecodedInstruction
         avr_op_DEC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_EICALL: public DecodedInstruction
@@ -655,6 +721,7 @@ class avr_op_EOR: public DecodedInstruction
         avr_op_EOR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ESPM: public DecodedInstruction
@@ -761,6 +828,7 @@ class avr_op_ICALL: public DecodedInstruction
         avr_op_ICALL(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_IJMP: public DecodedInstruction
@@ -779,6 +847,7 @@ class avr_op_IJMP: public DecodedInstruction
         avr_op_IJMP (word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_IN: public DecodedInstruction
@@ -801,6 +870,7 @@ class avr_op_IN: public DecodedInstruction
         avr_op_IN(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_INC: public DecodedInstruction
@@ -823,6 +893,7 @@ class avr_op_INC: public DecodedInstruction
         avr_op_INC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_JMP: public DecodedInstruction
@@ -844,6 +915,7 @@ class avr_op_JMP: public DecodedInstruction
         avr_op_JMP (word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LDD_Y: public DecodedInstruction
@@ -866,6 +938,7 @@ class avr_op_LDD_Y: public DecodedInstruction
         avr_op_LDD_Y(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LDD_Z: public DecodedInstruction
@@ -888,6 +961,7 @@ class avr_op_LDD_Z: public DecodedInstruction
         avr_op_LDD_Z(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LDI: public DecodedInstruction
@@ -911,6 +985,7 @@ class avr_op_LDI: public DecodedInstruction
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LDS: public DecodedInstruction
@@ -932,6 +1007,7 @@ class avr_op_LDS: public DecodedInstruction
         avr_op_LDS(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_X: public DecodedInstruction
@@ -953,6 +1029,7 @@ class avr_op_LD_X: public DecodedInstruction
         avr_op_LD_X(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_X_decr: public DecodedInstruction
@@ -974,6 +1051,7 @@ class avr_op_LD_X_decr: public DecodedInstruction
         avr_op_LD_X_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_X_incr: public DecodedInstruction
@@ -995,6 +1073,7 @@ class avr_op_LD_X_incr: public DecodedInstruction
         avr_op_LD_X_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_Y_decr: public DecodedInstruction
@@ -1017,6 +1096,7 @@ class avr_op_LD_Y_decr: public DecodedInstruction
         avr_op_LD_Y_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_Y_incr: public DecodedInstruction
@@ -1038,6 +1118,7 @@ class avr_op_LD_Y_incr: public DecodedInstruction
         avr_op_LD_Y_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_Z_incr: public DecodedInstruction
@@ -1059,6 +1140,7 @@ class avr_op_LD_Z_incr: public DecodedInstruction
         avr_op_LD_Z_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LD_Z_decr: public DecodedInstruction
@@ -1080,6 +1162,7 @@ class avr_op_LD_Z_decr: public DecodedInstruction
         avr_op_LD_Z_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LPM_Z: public DecodedInstruction
@@ -1101,6 +1184,7 @@ class avr_op_LPM_Z: public DecodedInstruction
         avr_op_LPM_Z(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LPM: public DecodedInstruction
@@ -1142,6 +1226,7 @@ class avr_op_LPM_Z_incr: public DecodedInstruction
         avr_op_LPM_Z_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_LSR: public DecodedInstruction
@@ -1164,6 +1249,7 @@ class avr_op_LSR: public DecodedInstruction
         avr_op_LSR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_MOV: public DecodedInstruction
@@ -1185,6 +1271,7 @@ class avr_op_MOV: public DecodedInstruction
         avr_op_MOV(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_MOVW: public DecodedInstruction
@@ -1207,6 +1294,7 @@ class avr_op_MOVW: public DecodedInstruction
         avr_op_MOVW(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_MUL: public DecodedInstruction
@@ -1230,6 +1318,7 @@ class avr_op_MUL: public DecodedInstruction
         avr_op_MUL(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_MULS: public DecodedInstruction
@@ -1301,6 +1390,7 @@ class avr_op_NEG: public DecodedInstruction
         avr_op_NEG(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_NOP: public DecodedInstruction
@@ -1320,6 +1410,7 @@ class avr_op_NOP: public DecodedInstruction
         avr_op_NOP(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_OR:public DecodedInstruction
@@ -1343,6 +1434,7 @@ class avr_op_OR:public DecodedInstruction
         avr_op_OR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ORI: public DecodedInstruction
@@ -1366,6 +1458,7 @@ class avr_op_ORI: public DecodedInstruction
         avr_op_ORI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_OUT: public DecodedInstruction
@@ -1388,6 +1481,7 @@ class avr_op_OUT: public DecodedInstruction
         avr_op_OUT(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 
     friend class AvrFlash;  // AvrFlash::LooksLikeContextSwitch() needs to read ioreg
 };
@@ -1411,6 +1505,7 @@ class avr_op_POP: public DecodedInstruction
         avr_op_POP(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_PUSH: public DecodedInstruction
@@ -1432,6 +1527,7 @@ class avr_op_PUSH: public DecodedInstruction
         avr_op_PUSH(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_RCALL: public DecodedInstruction
@@ -1453,6 +1549,7 @@ class avr_op_RCALL: public DecodedInstruction
         avr_op_RCALL(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_RET: public DecodedInstruction
@@ -1471,6 +1568,7 @@ class avr_op_RET: public DecodedInstruction
         avr_op_RET(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_RETI: public DecodedInstruction
@@ -1492,6 +1590,7 @@ class avr_op_RETI: public DecodedInstruction
         avr_op_RETI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_RJMP: public DecodedInstruction
@@ -1513,6 +1612,7 @@ class avr_op_RJMP: public DecodedInstruction
         avr_op_RJMP(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ROR: public DecodedInstruction
@@ -1535,6 +1635,7 @@ class avr_op_ROR: public DecodedInstruction
         avr_op_ROR(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBC: public DecodedInstruction
@@ -1559,6 +1660,7 @@ class avr_op_SBC: public DecodedInstruction
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBCI: public DecodedInstruction
@@ -1583,6 +1685,7 @@ class avr_op_SBCI: public DecodedInstruction
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBI: public DecodedInstruction
@@ -1605,6 +1708,7 @@ class avr_op_SBI: public DecodedInstruction
         avr_op_SBI(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBIC: public DecodedInstruction
@@ -1627,6 +1731,7 @@ class avr_op_SBIC: public DecodedInstruction
         avr_op_SBIC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBIS: public DecodedInstruction
@@ -1649,6 +1754,7 @@ class avr_op_SBIS: public DecodedInstruction
         avr_op_SBIS(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBIW: public DecodedInstruction
@@ -1674,6 +1780,7 @@ class avr_op_SBIW: public DecodedInstruction
         unsigned char GetModifiedRHi() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBRC: public DecodedInstruction
@@ -1696,6 +1803,7 @@ class avr_op_SBRC: public DecodedInstruction
         avr_op_SBRC(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SBRS: public DecodedInstruction
@@ -1718,6 +1826,7 @@ class avr_op_SBRS: public DecodedInstruction
         avr_op_SBRS(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 /*! \todo SLEEP instruction not implemented */
@@ -1780,6 +1889,7 @@ class avr_op_STD_Y: public DecodedInstruction
         avr_op_STD_Y(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_STD_Z: public DecodedInstruction
@@ -1802,6 +1912,7 @@ class avr_op_STD_Z: public DecodedInstruction
         avr_op_STD_Z(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_STS: public DecodedInstruction
@@ -1823,6 +1934,7 @@ class avr_op_STS: public DecodedInstruction
         avr_op_STS(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_X: public DecodedInstruction
@@ -1844,6 +1956,7 @@ class avr_op_ST_X: public DecodedInstruction
         avr_op_ST_X(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_X_decr: public DecodedInstruction
@@ -1865,6 +1978,7 @@ class avr_op_ST_X_decr: public DecodedInstruction
         avr_op_ST_X_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_X_incr: public DecodedInstruction
@@ -1886,6 +2000,7 @@ class avr_op_ST_X_incr: public DecodedInstruction
         avr_op_ST_X_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_Y_decr: public DecodedInstruction
@@ -1907,6 +2022,7 @@ class avr_op_ST_Y_decr: public DecodedInstruction
         avr_op_ST_Y_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_Y_incr: public DecodedInstruction
@@ -1928,6 +2044,7 @@ class avr_op_ST_Y_incr: public DecodedInstruction
         avr_op_ST_Y_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_Z_decr: public DecodedInstruction
@@ -1949,6 +2066,7 @@ class avr_op_ST_Z_decr: public DecodedInstruction
         avr_op_ST_Z_decr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_ST_Z_incr: public DecodedInstruction
@@ -1970,6 +2088,7 @@ class avr_op_ST_Z_incr: public DecodedInstruction
         avr_op_ST_Z_incr(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SUB: public DecodedInstruction
@@ -1994,6 +2113,7 @@ class avr_op_SUB: public DecodedInstruction
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SUBI: public DecodedInstruction
@@ -2018,6 +2138,7 @@ class avr_op_SUBI: public DecodedInstruction
         unsigned char GetModifiedR() const override;
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_SWAP: public DecodedInstruction
@@ -2039,6 +2160,7 @@ class avr_op_SWAP: public DecodedInstruction
         avr_op_SWAP(word opcode, AvrDevice *c);
         int operator()() override;
         int Trace() override;
+        void Precompile(ThreadedInstruction *ti) const override;
 };
 
 class avr_op_WDR: public DecodedInstruction
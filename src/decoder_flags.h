@@ -0,0 +1,85 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Theodore A. Roth, Klaus Rudolph
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef DECODER_FLAGS
+#define DECODER_FLAGS
+
+#include "types.h"
+
+/* Helpers to calculate carry and overflow flags for ALU instructions, shared
+   by the instruction classes in decoder.cpp and the threaded code handlers in
+   decoder_threaded.cpp */
+
+static inline int get_add_carry( byte res, byte rd, byte rr, int b )
+{
+    byte resb = res >> b & 0x1;
+    byte rdb  = rd  >> b & 0x1;
+    byte rrb  = rr  >> b & 0x1;
+    return (rdb & rrb) | (rrb & ~resb) | (~resb & rdb);
+}
+
+static inline int get_add_overflow( byte res, byte rd, byte rr )
+{
+    byte res7 = res >> 7 & 0x1;
+    byte rd7  = rd  >> 7 & 0x1;
+    byte rr7  = rr  >> 7 & 0x1;
+    return (rd7 & rr7 & ~res7) | (~rd7 & ~rr7 & res7);
+}
+
+static inline int get_sub_carry( byte res, byte rd, byte rr, int b )
+{
+    byte resb = res >> b & 0x1;
+    byte rdb  = rd  >> b & 0x1;
+    byte rrb  = rr  >> b & 0x1;
+    return (~rdb & rrb) | (rrb & resb) | (resb & ~rdb);
+}
+
+static inline int get_sub_overflow( byte res, byte rd, byte rr )
+{
+    byte res7 = res >> 7 & 0x1;
+    byte rd7  = rd  >> 7 & 0x1;
+    byte rr7  = rr  >> 7 & 0x1;
+    return (rd7 & ~rr7 & ~res7) | (~rd7 & rr7 & res7);
+}
+
+static inline int get_compare_carry( byte res, byte rd, byte rr, int b )
+{
+    byte resb = res >> b & 0x1;
+    byte rdb  = rd  >> b & 0x1;
+    byte rrb  = rr  >> b & 0x1;
+    return (~rdb & rrb) | (rrb & resb) | (resb & ~rdb);
+}
+
+static inline int get_compare_overflow( byte res, byte rd, byte rr )
+{
+    byte res7 = res >> 7 & 0x1;
+    byte rd7  = rd  >> 7 & 0x1;
+    byte rr7  = rr  >> 7 & 0x1;
+    /* The atmel data sheet says the second term is ~rd7 for CP
+     * but that doesn't make any sense. You be the judge. */
+    return (rd7 & ~rr7 & ~res7) | (~rd7 & rr7 & res7);
+}
+
+#endif
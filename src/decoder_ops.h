@@ -0,0 +1,833 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef DECODER_OPS
+#define DECODER_OPS
+
+#include "avrdevice.h"
+#include "decoder_flags.h"
+#include "hwstack.h"
+#include "flash.h"
+#include "hwsreg.h"
+#include "avrerror.h"
+
+/* Execution of the instructions, which have a handler for the threaded
+   dispatch engine. operator() of the instruction class in decoder.cpp and the
+   handler in decoder_threaded.cpp both call the function here, each one with
+   the operands from its own storage. So the behaviour of an instruction is
+   defined only once.
+
+   Skip instructions get the size of the skip (2 or 3 words, if the next
+   instruction has 2 words) from the caller. */
+
+static inline int exec_ADC(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    unsigned char rd = core->GetCoreReg(Rd);
+    unsigned char rr = core->GetCoreReg(Rr);
+    unsigned char res = rd + rr + status->C;
+
+    status->H = get_add_carry(res, rd, rr, 3);
+    status->V = get_add_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_add_carry(res, rd, rr, 7);
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ADD(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    unsigned char rd = core->GetCoreReg(Rd);
+    unsigned char rr = core->GetCoreReg(Rr);
+    unsigned char res = rd + rr;
+
+    status->H = get_add_carry(res, rd, rr, 3);
+    status->V = get_add_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_add_carry(res, rd, rr, 7);
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ADIW(AvrDevice *core, unsigned char Rl, int K) {
+    HWSreg *status = core->status;
+    unsigned char rdh = core->GetCoreReg(Rl + 1);
+    word rd = (rdh << 8) + core->GetCoreReg(Rl);
+    word res = rd + K;
+
+    status->V = ~(rdh >> 7 & 0x1) & (res >> 15 & 0x1);
+    status->N = (res >> 15) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xffff) == 0;
+    status->C = ~(res >> 15 & 0x1) & (rdh >> 7 & 0x1);
+
+    core->SetCoreReg(Rl, res & 0xff);
+    core->SetCoreReg(Rl + 1, res >> 8);
+
+    return 2;
+}
+
+static inline int exec_AND(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    unsigned char res = core->GetCoreReg(Rd) & core->GetCoreReg(Rr);
+
+    status->V = 0;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ANDI(AvrDevice *core, unsigned char Rd, int K) {
+    HWSreg *status = core->status;
+    unsigned char res = core->GetCoreReg(Rd) & K;
+
+    status->V = 0;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ASR(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    unsigned char rd = core->GetCoreReg(Rd);
+    unsigned char res = (rd >> 1) + (rd & 0x80);
+
+    status->N = (res >> 7) & 0x1;
+    status->C = rd & 0x1;
+    status->V = status->N ^ status->C;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_BCLR(AvrDevice *core, int mask) {
+    *(core->status) = *(core->status) & ~mask;
+
+    return 1;
+}
+
+static inline int exec_BLD(AvrDevice *core, unsigned char Rd, int mask) {
+    unsigned char rd = core->GetCoreReg(Rd);
+    unsigned char res;
+
+    if(core->status->T == 0)
+        res = rd & ~mask;
+    else
+        res = rd | mask;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_BRBC(AvrDevice *core, unsigned char bitmask, int offset) {
+    if((bitmask & *(core->status)) == 0) {
+        core->DebugOnJump();
+        core->PC += offset;
+        return 2;
+    }
+    return 1;
+}
+
+static inline int exec_BRBS(AvrDevice *core, unsigned char bitmask, int offset) {
+    if((bitmask & *(core->status)) != 0) {
+        core->DebugOnJump();
+        core->PC += offset;
+        return 2;
+    }
+    return 1;
+}
+
+static inline int exec_BSET(AvrDevice *core, int mask) {
+    *(core->status) = *(core->status) | mask;
+
+    return 1;
+}
+
+static inline int exec_BST(AvrDevice *core, unsigned char Rd, int mask) {
+    core->status->T = ((core->GetCoreReg(Rd) & mask) != 0);
+
+    return 1;
+}
+
+static inline int exec_CALL(AvrDevice *core, int KH) {
+    word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
+    int k = (KH << 16) + K_lsb;
+    int clkadd = core->flagXMega ? 1 : 2;
+
+    core->stack->m_ThreadList.OnCall();
+    core->stack->PushAddr(core->PC + 2);
+    core->DebugOnJump();
+    core->PC = k - 1;
+
+    return core->PC_size + clkadd;
+}
+
+static inline int exec_CBI(AvrDevice *core, int ioreg, unsigned char Kbit) {
+    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
+
+    core->ClearIORegBit(ioreg, Kbit);
+
+    return clks;
+}
+
+static inline int exec_COM(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte res = 0xff - core->GetCoreReg(Rd);
+
+    status->N = (res >> 7) & 0x1;
+    status->C = 1;
+    status->V = 0;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_CP(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte rd  = core->GetCoreReg(Rd);
+    byte rr  = core->GetCoreReg(Rr);
+    byte res = rd - rr;
+
+    status->H = get_compare_carry(res, rd, rr, 3);
+    status->V = get_compare_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_compare_carry(res, rd, rr, 7);
+
+    return 1;
+}
+
+static inline int exec_CPC(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte rd  = core->GetCoreReg(Rd);
+    byte rr  = core->GetCoreReg(Rr);
+    byte res = rd - rr - status->C;
+
+    status->H = get_compare_carry(res, rd, rr, 3);
+    status->V = get_compare_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->C = get_compare_carry(res, rd, rr, 7);
+
+    /* Previous value remains unchanged when result is 0; cleared otherwise */
+    status->Z = ((res & 0xff) == 0) && status->Z;
+
+    return 1;
+}
+
+static inline int exec_CPI(AvrDevice *core, unsigned char Rd, byte K) {
+    HWSreg *status = core->status;
+    byte rd  = core->GetCoreReg(Rd);
+    byte res = rd - K;
+
+    status->H = get_compare_carry(res, rd, K, 3);
+    status->V = get_compare_overflow(res, rd, K);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_compare_carry(res, rd, K, 7);
+
+    return 1;
+}
+
+static inline int exec_CPSE(AvrDevice *core, unsigned char Rd, unsigned char Rr, int skip) {
+    if(core->GetCoreReg(Rd) == core->GetCoreReg(Rr)) {
+        core->DebugOnJump();
+        core->PC += skip - 1;
+        return skip;
+    }
+    return 1;
+}
+
+static inline int exec_DEC(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte res = core->GetCoreReg(Rd) - 1;
+
+    status->N = (res >> 7) & 0x1;
+    status->V = res == 0x7f;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_EOR(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte res = core->GetCoreReg(Rd) ^ core->GetCoreReg(Rr);
+
+    status->V = 0;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ICALL(AvrDevice *core) {
+    unsigned int pc = core->PC;
+    unsigned int new_pc = core->GetRegZ();
+
+    core->stack->m_ThreadList.OnCall();
+    core->stack->PushAddr(pc + 1);
+
+    core->DebugOnJump();
+    core->PC = new_pc - 1;
+
+    return core->PC_size + (core->flagXMega ? 0 : 1);
+}
+
+static inline int exec_IJMP(AvrDevice *core) {
+    int new_pc = core->GetRegZ();
+
+    core->DebugOnJump();
+    core->PC = new_pc - 1;
+
+    return 2;
+}
+
+static inline int exec_IN(AvrDevice *core, unsigned char Rd, int ioreg) {
+    unsigned char val = core->GetIOReg(ioreg);
+    core->SetCoreReg(Rd, val);
+
+    return 1;
+}
+
+static inline int exec_INC(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte rd  = core->GetCoreReg(Rd);
+    byte res = rd + 1;
+
+    status->N = (res >> 7) & 0x1;
+    status->V = rd == 0x7f;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_JMP(AvrDevice *core, int KH) {
+    word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
+    core->DebugOnJump();
+    core->PC = (KH << 16) + K_lsb - 1;
+    return 3;
+}
+
+static inline int exec_LDD_Y(AvrDevice *core, unsigned char Rd, int K) {
+    word Y = core->GetRegY();
+
+    core->SetCoreReg(Rd, core->GetRWMem(Y + K));
+
+    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+}
+
+static inline int exec_LDD_Z(AvrDevice *core, unsigned char Rd, int K) {
+    word Z = core->GetRegZ();
+
+    core->SetCoreReg(Rd, core->GetRWMem(Z + K));
+
+    return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
+}
+
+static inline int exec_LDI(AvrDevice *core, unsigned char Rd, int K) {
+    core->SetCoreReg(Rd, K);
+
+    return 1;
+}
+
+static inline int exec_LDS(AvrDevice *core, unsigned char Rd) {
+    word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);
+
+    core->SetCoreReg(Rd, core->GetRWMem(offset));
+    core->PC++;
+
+    return 2;
+}
+
+static inline int exec_LD_X(AvrDevice *core, unsigned char Rd) {
+    word X = core->GetRegX();
+
+    core->SetCoreReg(Rd, core->GetRWMem(X));
+
+    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+}
+
+/* Pre decrement and post increment loads and stores through X, Y or Z. Rp
+ * is the low register of the pointer (26, 28 or 30). */
+
+static inline int exec_LD_decr(AvrDevice *core, unsigned char Rd, unsigned char Rp) {
+    word P = (core->GetCoreReg(Rp + 1) << 8) + core->GetCoreReg(Rp);
+    if (Rd == Rp || Rd == Rp + 1)
+        avr_error( "Result of operation is undefined" );
+
+    P--;
+    core->SetCoreReg(Rd, core->GetRWMem(P));
+    core->SetCoreReg(Rp, P & 0xff);
+    core->SetCoreReg(Rp + 1, (P >> 8) & 0xff);
+
+    return core->flagTiny10 ? 3 : 2;
+}
+
+static inline int exec_LD_incr(AvrDevice *core, unsigned char Rd, unsigned char Rp) {
+    word P = (core->GetCoreReg(Rp + 1) << 8) + core->GetCoreReg(Rp);
+    if (Rd == Rp || Rd == Rp + 1)
+        avr_error( "Result of operation is undefined" );
+
+    core->SetCoreReg(Rd, core->GetRWMem(P));
+    P++;
+    core->SetCoreReg(Rp, P & 0xff);
+    core->SetCoreReg(Rp + 1, (P >> 8) & 0xff);
+
+    return core->flagXMega ? 1 : 2;
+}
+
+static inline int exec_LPM_Z(AvrDevice *core, unsigned char Rd) {
+    word Z = core->GetRegZ();
+
+    core->SetCoreReg(Rd, core->Flash->ReadMem(Z ^ 0x0001));
+
+    return 3;
+}
+
+static inline int exec_LPM_Z_incr(AvrDevice *core, unsigned char Rd) {
+    word Z = core->GetRegZ();
+
+    core->SetCoreReg(Rd, core->Flash->ReadMem(Z ^ 0x0001));
+
+    Z++;
+    core->SetCoreReg(30, Z & 0xff);
+    core->SetCoreReg(31, (Z >> 8) & 0xff);
+
+    return 3;
+}
+
+static inline int exec_LSR(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte res = (rd >> 1) & 0x7f;
+
+    status->C = rd & 0x1;
+    status->N = 0;
+    status->V = status->N ^ status->C;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_MOV(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    core->SetCoreReg(Rd, core->GetCoreReg(Rr));
+    return 1;
+}
+
+static inline int exec_MOVW(AvrDevice *core, unsigned char Rd, unsigned char Rs) {
+    core->SetCoreReg(Rd, core->GetCoreReg(Rs));
+    core->SetCoreReg(Rd + 1, core->GetCoreReg(Rs + 1));
+
+    return 1;
+}
+
+static inline int exec_MUL(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte rr = core->GetCoreReg(Rr);
+
+    word res = rd * rr;
+
+    status->Z = (res & 0xffff) == 0;
+    status->C = (res >> 15) & 0x1;
+
+    /* result goes in R1:R0 */
+    core->SetCoreReg(0, res & 0xff);
+    core->SetCoreReg(1, (res >> 8) & 0xff);
+
+    return 2;
+}
+
+static inline int exec_NEG(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte rd  = core->GetCoreReg(Rd);
+    byte res = (0x0 - rd) & 0xff;
+
+    status->H = ((res >> 3) | (rd >> 3)) & 0x1;
+    status->V = res == 0x80;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = res == 0x0;
+    status->C = res != 0x0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_NOP(AvrDevice *core) {
+    return 1;
+}
+
+static inline int exec_OR(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte res = core->GetCoreReg(Rd) | core->GetCoreReg(Rr);
+
+    status->V = 0;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = res == 0x0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_ORI(AvrDevice *core, unsigned char Rd, int K) {
+    HWSreg *status = core->status;
+    byte res = core->GetCoreReg(Rd) | K;
+
+    status->V = 0;
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = res == 0x0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_OUT(AvrDevice *core, unsigned char Rd, int ioreg) {
+    core->SetIOReg(ioreg, core->GetCoreReg(Rd));
+
+    return 1;
+}
+
+static inline int exec_POP(AvrDevice *core, unsigned char Rd) {
+    core->SetCoreReg(Rd, core->stack->Pop());
+
+    return 2;
+}
+
+static inline int exec_PUSH(AvrDevice *core, unsigned char Rd) {
+    core->stack->Push(core->GetCoreReg(Rd));
+
+    return core->flagXMega ? 1 : 2;
+}
+
+static inline int exec_RCALL(AvrDevice *core, int offset) {
+    core->stack->PushAddr(core->PC + 1);
+    core->stack->m_ThreadList.OnCall();
+    core->DebugOnJump();
+    core->PC += offset;
+    core->PC &= (core->Flash->GetSize() - 1) >> 1;
+
+    if(core->flagTiny10)
+        return 4;
+    return core->PC_size + (core->flagXMega ? 0 : 1);
+}
+
+static inline int exec_RET(AvrDevice *core) {
+    core->PC = core->stack->PopAddr() - 1;
+
+    return core->PC_size + 2;
+}
+
+static inline int exec_RETI(AvrDevice *core) {
+    core->PC = core->stack->PopAddr() - 1;
+    core->status->I = 1;
+
+    return core->PC_size + 2;
+}
+
+static inline int exec_RJMP(AvrDevice *core, int offset) {
+    core->DebugOnJump();
+    core->PC += offset;
+    core->PC &= (core->Flash->GetSize() - 1) >> 1;
+
+    return 2;
+}
+
+static inline int exec_ROR(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte res = (rd >> 1) | ((status->C << 7) & 0x80);
+
+    status->C = rd & 0x1;
+    status->N = (res >> 7) & 0x1;
+    status->V = status->N ^ status->C;
+    status->S = status->N ^ status->V;
+    status->Z = res == 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_SBC(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte rr = core->GetCoreReg(Rr);
+    byte res = rd - rr - status->C;
+
+    status->H = get_sub_carry(res, rd, rr, 3);
+    status->V = get_sub_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->C = get_sub_carry(res, rd, rr, 7);
+
+    if((res & 0xff) != 0)
+        status->Z = 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_SBCI(AvrDevice *core, unsigned char Rd, byte K) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte res = rd - K - status->C;
+
+    status->H = get_sub_carry(res, rd, K, 3);
+    status->V = get_sub_overflow(res, rd, K);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->C = get_sub_carry(res, rd, K, 7);
+
+    if((res & 0xff) != 0)
+        status->Z = 0;
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_SBI(AvrDevice *core, int ioreg, unsigned char Kbit) {
+    int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
+
+    core->SetIORegBit(ioreg, Kbit);
+
+    return clks;
+}
+
+static inline int exec_SBIC(AvrDevice *core, int ioreg, unsigned char Kbit, int skip) {
+    int clks = 1;
+
+    if((core->GetIOReg(ioreg) & (1 << Kbit)) == 0) {
+        clks = skip;
+        core->DebugOnJump();
+        core->PC += clks - 1;
+    }
+
+    if(core->flagXMega)
+        clks++;
+
+    return clks;
+}
+
+static inline int exec_SBIS(AvrDevice *core, int ioreg, unsigned char Kbit, int skip) {
+    int clks = 1;
+
+    if((core->GetIOReg(ioreg) & (1 << Kbit)) != 0) {
+        clks = skip;
+        core->DebugOnJump();
+        core->PC += clks - 1;
+    }
+
+    if(core->flagXMega)
+        clks++;
+
+    return clks;
+}
+
+static inline int exec_SBIW(AvrDevice *core, unsigned char Rl, int K) {
+    HWSreg *status = core->status;
+    byte rdl = core->GetCoreReg(Rl);
+    byte rdh = core->GetCoreReg(Rl + 1);
+    word rd = (rdh << 8) + rdl;
+    word res = rd - K;
+
+    status->V = (rdh >> 7 & 0x1) & ~(res >> 15 & 0x1);
+    status->N = (res >> 15) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xffff) == 0;
+    status->C = (res >> 15 & 0x1) & ~(rdh >> 7 & 0x1);
+
+    core->SetCoreReg(Rl, res & 0xff);
+    core->SetCoreReg(Rl + 1, (res >> 8) & 0xff);
+
+    return 2;
+}
+
+static inline int exec_SBRC(AvrDevice *core, unsigned char Rd, int mask, int skip) {
+    if((core->GetCoreReg(Rd) & mask) == 0) {
+        core->DebugOnJump();
+        core->PC += skip - 1;
+        return skip;
+    }
+    return 1;
+}
+
+static inline int exec_SBRS(AvrDevice *core, unsigned char Rd, int mask, int skip) {
+    if((core->GetCoreReg(Rd) & mask) != 0) {
+        core->DebugOnJump();
+        core->PC += skip - 1;
+        return skip;
+    }
+    return 1;
+}
+
+static inline int exec_STD_Y(AvrDevice *core, unsigned char Rd, int K) {
+    unsigned int Y = core->GetRegY();
+
+    core->SetRWMem(Y + K, core->GetCoreReg(Rd));
+
+    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+}
+
+static inline int exec_STD_Z(AvrDevice *core, unsigned char Rd, int K) {
+    int Z = core->GetRegZ();
+
+    core->SetRWMem(Z + K, core->GetCoreReg(Rd));
+
+    return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
+}
+
+static inline int exec_STS(AvrDevice *core, unsigned char Rd) {
+    word k = core->Flash->ReadMemWord((core->PC + 1) * 2);
+
+    core->SetRWMem(k, core->GetCoreReg(Rd));
+    core->PC++;
+
+    return 2;
+}
+
+static inline int exec_ST_X(AvrDevice *core, unsigned char Rd) {
+    word X = core->GetRegX();
+
+    core->SetRWMem(X, core->GetCoreReg(Rd));
+
+    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+}
+
+static inline int exec_ST_decr(AvrDevice *core, unsigned char Rd, unsigned char Rp) {
+    word P = (core->GetCoreReg(Rp + 1) << 8) + core->GetCoreReg(Rp);
+    if (Rd == Rp || Rd == Rp + 1)
+        avr_error( "Result of operation is undefined" );
+
+    P--;
+    core->SetCoreReg(Rp, P & 0xff);
+    core->SetCoreReg(Rp + 1, (P >> 8) & 0xff);
+    core->SetRWMem(P, core->GetCoreReg(Rd));
+
+    return 2;
+}
+
+static inline int exec_ST_incr(AvrDevice *core, unsigned char Rd, unsigned char Rp) {
+    word P = (core->GetCoreReg(Rp + 1) << 8) + core->GetCoreReg(Rp);
+    if (Rd == Rp || Rd == Rp + 1)
+        avr_error( "Result of operation is undefined" );
+
+    core->SetRWMem(P, core->GetCoreReg(Rd));
+
+    P++;
+    core->SetCoreReg(Rp, P & 0xff);
+    core->SetCoreReg(Rp + 1, (P >> 8) & 0xff);
+
+    return (core->flagXMega || core->flagTiny10) ? 1 : 2;
+}
+
+static inline int exec_SUB(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte rr = core->GetCoreReg(Rr);
+    byte res = rd - rr;
+
+    status->H = get_sub_carry(res, rd, rr, 3);
+    status->V = get_sub_overflow(res, rd, rr);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_sub_carry(res, rd, rr, 7);
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_SUBI(AvrDevice *core, unsigned char Rd, byte K) {
+    HWSreg *status = core->status;
+    byte rd = core->GetCoreReg(Rd);
+    byte res = rd - K;
+
+    status->H = get_sub_carry(res, rd, K, 3);
+    status->V = get_sub_overflow(res, rd, K);
+    status->N = (res >> 7) & 0x1;
+    status->S = status->N ^ status->V;
+    status->Z = (res & 0xff) == 0;
+    status->C = get_sub_carry(res, rd, K, 7);
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+static inline int exec_SWAP(AvrDevice *core, unsigned char Rd) {
+    byte rd = core->GetCoreReg(Rd);
+    byte res = ((rd << 4) & 0xf0) | ((rd >> 4) & 0x0f);
+
+    core->SetCoreReg(Rd, res);
+
+    return 1;
+}
+
+#endif
@@ -0,0 +1,764 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+/* Handlers for the threaded dispatch engine. A handler takes the operands from
+ * the ThreadedInstruction record and calls the same execution function in
+ * decoder_ops.h as operator() of the related class in decoder.cpp. */
+
+#include "decoder.h"
+#include "decoder_ops.h"
+#include "flash.h"
+
+static int threaded_decoded(AvrDevice *core, const ThreadedInstruction *ti) {
+    // records can be shared by devices, so take the instruction object of this core
+    return (*(core->Flash->GetDecoded(core->PC)))();
+}
+
+void DecodedInstruction::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_decoded;
+    ti->endsBlock = true;
+}
+
+/* Skip instructions have to know, if the next instruction has 2 words. The
+ * records are in a flat array, so the next one is just behind. */
+static inline int skip_size(const ThreadedInstruction *ti) {
+    return ti[1].size2Word ? 3 : 2;
+}
+
+static int threaded_ADC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ADC(core, ti->R1, ti->R2);
+}
+
+void avr_op_ADC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_ADC;
+}
+
+static int threaded_ADD(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ADD(core, ti->R1, ti->R2);
+}
+
+void avr_op_ADD::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_ADD;
+}
+
+static int threaded_ADIW(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ADIW(core, ti->R1, ti->K);
+}
+
+void avr_op_ADIW::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rl;
+    ti->K = K;
+    ti->handler = threaded_ADIW;
+}
+
+static int threaded_AND(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_AND(core, ti->R1, ti->R2);
+}
+
+void avr_op_AND::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_AND;
+}
+
+static int threaded_ANDI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ANDI(core, ti->R1, ti->K);
+}
+
+void avr_op_ANDI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_ANDI;
+}
+
+static int threaded_ASR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ASR(core, ti->R1);
+}
+
+void avr_op_ASR::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_ASR;
+}
+
+static int threaded_BCLR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BCLR(core, ti->K);
+}
+
+void avr_op_BCLR::Precompile(ThreadedInstruction *ti) const {
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_BCLR;
+}
+
+static int threaded_BLD(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BLD(core, ti->R1, ti->K);
+}
+
+void avr_op_BLD::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_BLD;
+}
+
+static int threaded_BRBC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BRBC(core, ti->R2, ti->K);
+}
+
+void avr_op_BRBC::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = bitmask;
+    ti->K = offset;
+    ti->handler = threaded_BRBC;
+    ti->endsBlock = true;
+}
+
+static int threaded_BRBS(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BRBS(core, ti->R2, ti->K);
+}
+
+void avr_op_BRBS::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = bitmask;
+    ti->K = offset;
+    ti->handler = threaded_BRBS;
+    ti->endsBlock = true;
+}
+
+static int threaded_BSET(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BSET(core, ti->K);
+}
+
+void avr_op_BSET::Precompile(ThreadedInstruction *ti) const {
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_BSET;
+}
+
+static int threaded_BST(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_BST(core, ti->R1, ti->K);
+}
+
+void avr_op_BST::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_BST;
+}
+
+static int threaded_CALL(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CALL(core, ti->K);
+}
+
+void avr_op_CALL::Precompile(ThreadedInstruction *ti) const {
+    ti->K = KH;
+    ti->handler = threaded_CALL;
+    ti->endsBlock = true;
+}
+
+static int threaded_CBI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CBI(core, ti->K, ti->R2);
+}
+
+void avr_op_CBI::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = Kbit;
+    ti->K = ioreg;
+    ti->handler = threaded_CBI;
+}
+
+static int threaded_COM(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_COM(core, ti->R1);
+}
+
+void avr_op_COM::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_COM;
+}
+
+static int threaded_CP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CP(core, ti->R1, ti->R2);
+}
+
+void avr_op_CP::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_CP;
+}
+
+static int threaded_CPC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CPC(core, ti->R1, ti->R2);
+}
+
+void avr_op_CPC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_CPC;
+}
+
+static int threaded_CPI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CPI(core, ti->R1, ti->K);
+}
+
+void avr_op_CPI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_CPI;
+}
+
+static int threaded_CPSE(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_CPSE(core, ti->R1, ti->R2, skip_size(ti));
+}
+
+void avr_op_CPSE::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_CPSE;
+    ti->endsBlock = true;
+}
+
+static int threaded_DEC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_DEC(core, ti->R1);
+}
+
+void avr_op_DEC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_DEC;
+}
+
+static int threaded_EOR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_EOR(core, ti->R1, ti->R2);
+}
+
+void avr_op_EOR::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_EOR;
+}
+
+static int threaded_ICALL(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ICALL(core);
+}
+
+void avr_op_ICALL::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_ICALL;
+    ti->endsBlock = true;
+}
+
+static int threaded_IJMP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_IJMP(core);
+}
+
+void avr_op_IJMP::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_IJMP;
+    ti->endsBlock = true;
+}
+
+static int threaded_IN(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_IN(core, ti->R1, ti->K);
+}
+
+void avr_op_IN::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = ioreg;
+    ti->handler = threaded_IN;
+}
+
+static int threaded_INC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_INC(core, ti->R1);
+}
+
+void avr_op_INC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_INC;
+}
+
+static int threaded_JMP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_JMP(core, ti->K);
+}
+
+void avr_op_JMP::Precompile(ThreadedInstruction *ti) const {
+    ti->K = K;
+    ti->handler = threaded_JMP;
+    ti->endsBlock = true;
+}
+
+static int threaded_LDD_Y(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LDD_Y(core, ti->R1, ti->K);
+}
+
+void avr_op_LDD_Y::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->K = K;
+    ti->handler = threaded_LDD_Y;
+}
+
+static int threaded_LDD_Z(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LDD_Z(core, ti->R1, ti->K);
+}
+
+void avr_op_LDD_Z::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->K = K;
+    ti->handler = threaded_LDD_Z;
+}
+
+static int threaded_LDI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LDI(core, ti->R1, ti->K);
+}
+
+void avr_op_LDI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_LDI;
+}
+
+static int threaded_LDS(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LDS(core, ti->R1);
+}
+
+void avr_op_LDS::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_LDS;
+}
+
+static int threaded_LD_X(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LD_X(core, ti->R1);
+}
+
+void avr_op_LD_X::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->handler = threaded_LD_X;
+}
+
+/* Pre decrement and post increment loads and stores through X, Y or Z. R2
+ * holds the low register of the pointer. */
+
+static int threaded_LD_decr(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LD_decr(core, ti->R1, ti->R2);
+}
+
+static int threaded_LD_incr(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LD_incr(core, ti->R1, ti->R2);
+}
+
+void avr_op_LD_X_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 26;
+    ti->handler = threaded_LD_decr;
+}
+
+void avr_op_LD_X_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 26;
+    ti->handler = threaded_LD_incr;
+}
+
+void avr_op_LD_Y_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 28;
+    ti->handler = threaded_LD_decr;
+}
+
+void avr_op_LD_Y_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 28;
+    ti->handler = threaded_LD_incr;
+}
+
+void avr_op_LD_Z_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 30;
+    ti->handler = threaded_LD_decr;
+}
+
+void avr_op_LD_Z_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = 30;
+    ti->handler = threaded_LD_incr;
+}
+
+static int threaded_LPM_Z(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LPM_Z(core, ti->R1);
+}
+
+void avr_op_LPM_Z::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->handler = threaded_LPM_Z;
+}
+
+static int threaded_LPM_Z_incr(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LPM_Z_incr(core, ti->R1);
+}
+
+void avr_op_LPM_Z_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->handler = threaded_LPM_Z_incr;
+}
+
+static int threaded_LSR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_LSR(core, ti->R1);
+}
+
+void avr_op_LSR::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->handler = threaded_LSR;
+}
+
+static int threaded_MOV(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_MOV(core, ti->R1, ti->R2);
+}
+
+void avr_op_MOV::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_MOV;
+}
+
+static int threaded_MOVW(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_MOVW(core, ti->R1, ti->R2);
+}
+
+void avr_op_MOVW::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = Rs;
+    ti->handler = threaded_MOVW;
+}
+
+static int threaded_MUL(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_MUL(core, ti->R1, ti->R2);
+}
+
+void avr_op_MUL::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = Rr;
+    ti->handler = threaded_MUL;
+}
+
+static int threaded_NEG(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_NEG(core, ti->R1);
+}
+
+void avr_op_NEG::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->handler = threaded_NEG;
+}
+
+static int threaded_NOP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_NOP(core);
+}
+
+void avr_op_NOP::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_NOP;
+}
+
+static int threaded_OR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_OR(core, ti->R1, ti->R2);
+}
+
+void avr_op_OR::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = Rd;
+    ti->R2 = Rr;
+    ti->handler = threaded_OR;
+}
+
+static int threaded_ORI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ORI(core, ti->R1, ti->K);
+}
+
+void avr_op_ORI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_ORI;
+}
+
+static int threaded_OUT(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_OUT(core, ti->R1, ti->K);
+}
+
+void avr_op_OUT::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = ioreg;
+    ti->handler = threaded_OUT;
+}
+
+static int threaded_POP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_POP(core, ti->R1);
+}
+
+void avr_op_POP::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_POP;
+}
+
+static int threaded_PUSH(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_PUSH(core, ti->R1);
+}
+
+void avr_op_PUSH::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_PUSH;
+}
+
+static int threaded_RCALL(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_RCALL(core, ti->K);
+}
+
+void avr_op_RCALL::Precompile(ThreadedInstruction *ti) const {
+    ti->K = K;
+    ti->handler = threaded_RCALL;
+    ti->endsBlock = true;
+}
+
+static int threaded_RET(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_RET(core);
+}
+
+void avr_op_RET::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_RET;
+    ti->endsBlock = true;
+}
+
+static int threaded_RETI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_RETI(core);
+}
+
+void avr_op_RETI::Precompile(ThreadedInstruction *ti) const {
+    ti->handler = threaded_RETI;
+    ti->endsBlock = true;
+}
+
+static int threaded_RJMP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_RJMP(core, ti->K);
+}
+
+void avr_op_RJMP::Precompile(ThreadedInstruction *ti) const {
+    ti->K = K;
+    ti->handler = threaded_RJMP;
+    ti->endsBlock = true;
+}
+
+static int threaded_ROR(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ROR(core, ti->R1);
+}
+
+void avr_op_ROR::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_ROR;
+}
+
+static int threaded_SBC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBC(core, ti->R1, ti->R2);
+}
+
+void avr_op_SBC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_SBC;
+}
+
+static int threaded_SBCI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBCI(core, ti->R1, ti->K);
+}
+
+void avr_op_SBCI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_SBCI;
+}
+
+static int threaded_SBI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBI(core, ti->K, ti->R2);
+}
+
+void avr_op_SBI::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = Kbit;
+    ti->K = ioreg;
+    ti->handler = threaded_SBI;
+}
+
+static int threaded_SBIC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBIC(core, ti->K, ti->R2, skip_size(ti));
+}
+
+void avr_op_SBIC::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = Kbit;
+    ti->K = ioreg;
+    ti->handler = threaded_SBIC;
+    ti->endsBlock = true;
+}
+
+static int threaded_SBIS(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBIS(core, ti->K, ti->R2, skip_size(ti));
+}
+
+void avr_op_SBIS::Precompile(ThreadedInstruction *ti) const {
+    ti->R2 = Kbit;
+    ti->K = ioreg;
+    ti->handler = threaded_SBIS;
+    ti->endsBlock = true;
+}
+
+static int threaded_SBIW(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBIW(core, ti->R1, ti->K);
+}
+
+void avr_op_SBIW::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_SBIW;
+}
+
+static int threaded_SBRC(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBRC(core, ti->R1, ti->K, skip_size(ti));
+}
+
+void avr_op_SBRC::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_SBRC;
+    ti->endsBlock = true;
+}
+
+static int threaded_SBRS(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SBRS(core, ti->R1, ti->K, skip_size(ti));
+}
+
+void avr_op_SBRS::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = 1 << Kbit;
+    ti->handler = threaded_SBRS;
+    ti->endsBlock = true;
+}
+
+static int threaded_STD_Y(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_STD_Y(core, ti->R1, ti->K);
+}
+
+void avr_op_STD_Y::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_STD_Y;
+}
+
+static int threaded_STD_Z(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_STD_Z(core, ti->R1, ti->K);
+}
+
+void avr_op_STD_Z::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_STD_Z;
+}
+
+static int threaded_STS(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_STS(core, ti->R1);
+}
+
+void avr_op_STS::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_STS;
+}
+
+static int threaded_ST_X(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ST_X(core, ti->R1);
+}
+
+void avr_op_ST_X::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_ST_X;
+}
+
+static int threaded_ST_decr(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ST_decr(core, ti->R1, ti->R2);
+}
+
+static int threaded_ST_incr(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_ST_incr(core, ti->R1, ti->R2);
+}
+
+void avr_op_ST_X_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 26;
+    ti->handler = threaded_ST_decr;
+}
+
+void avr_op_ST_X_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 26;
+    ti->handler = threaded_ST_incr;
+}
+
+void avr_op_ST_Y_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 28;
+    ti->handler = threaded_ST_decr;
+}
+
+void avr_op_ST_Y_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 28;
+    ti->handler = threaded_ST_incr;
+}
+
+void avr_op_ST_Z_decr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 30;
+    ti->handler = threaded_ST_decr;
+}
+
+void avr_op_ST_Z_incr::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = 30;
+    ti->handler = threaded_ST_incr;
+}
+
+static int threaded_SUB(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SUB(core, ti->R1, ti->R2);
+}
+
+void avr_op_SUB::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->R2 = R2;
+    ti->handler = threaded_SUB;
+}
+
+static int threaded_SUBI(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SUBI(core, ti->R1, ti->K);
+}
+
+void avr_op_SUBI::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->K = K;
+    ti->handler = threaded_SUBI;
+}
+
+static int threaded_SWAP(AvrDevice *core, const ThreadedInstruction *ti) {
+    return exec_SWAP(core, ti->R1);
+}
+
+void avr_op_SWAP::Precompile(ThreadedInstruction *ti) const {
+    ti->R1 = R1;
+    ti->handler = threaded_SWAP;
+}
+
+// EOF
@@ -136,11 +136,11 @@ int avr_op_BRBC::Trace() {
     word addr = ( core->PC+1+offset ) << 1;
     traceOut << branch_opcodes_clear[INDEX_FROM_BITMASK(bitmask)]
              << " ->" << HexShort( addr ) << " ";
-    std::string sym(core->Flash->GetSymbolAtAddress(addr));
     int ret = this->operator()();
-    
-    traceOut << sym << " ";
-    for(int len = sym.length(); len < 30; len++)
+
+    size_t len = core->Flash->WriteSymbolAtAddress(traceOut, addr);
+    traceOut << " ";
+    for(; len < 30; len++)
         traceOut << " ";
 
     return ret;
@@ -161,11 +161,11 @@ int avr_op_BRBS::Trace() {
     word addr = ( core->PC+1+offset ) << 1;
     traceOut << branch_opcodes_set[INDEX_FROM_BITMASK(bitmask)]
              << " ->" << " " << HexShort( addr ) << " ";
-    std::string sym(core->Flash->GetSymbolAtAddress(addr));
     int ret=this->operator()();
 
-    traceOut << sym << " ";
-    for(int len = sym.length(); len < 30; len++)
+    size_t len = core->Flash->WriteSymbolAtAddress(traceOut, addr);
+    traceOut << " ";
+    for(; len < 30; len++)
         traceOut << " ";
 
     return ret;
@@ -369,9 +369,9 @@ int avr_op_JMP::Trace() {
     int ret = this->operator()();
     traceOut << HexShort( offset << 1 ) << " ";
 
-    std::string sym(core->Flash->GetSymbolAtAddress(offset));
-    traceOut << sym << " ";
-    for(int len = sym.length(); len < 30; len++)
+    size_t len = core->Flash->WriteSymbolAtAddress(traceOut, offset);
+    traceOut << " ";
+    for(; len < 30; len++)
         traceOut << " " ;
 
     return ret;
@@ -450,8 +450,9 @@ int avr_op_LPM_Z::Trace() {
 
     /* Z is R31:R30 */
     unsigned int Z = core->GetRegZ();
-    std::string sym(core->Flash->GetSymbolAtAddress(Z));
-    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << "," << sym << "] ";
+    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << ",";
+    core->Flash->WriteSymbolAtAddress(traceOut, Z);
+    traceOut << "] ";
 
     return ret;
 }
@@ -462,8 +463,9 @@ int avr_op_LPM::Trace() {
 
     /* Z is R31:R30 */
     unsigned int Z = core->GetRegZ();
-    std::string sym(core->Flash->GetSymbolAtAddress(Z));
-    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << "," << sym << "] ";
+    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << ",";
+    core->Flash->WriteSymbolAtAddress(traceOut, Z);
+    traceOut << "] ";
 
     return ret;
 }
@@ -474,8 +476,9 @@ int avr_op_LPM_Z_incr::Trace() {
     unsigned int Z = core->GetRegZ();
     int ret = this->operator()();
     
-    std::string sym(core->Flash->GetSymbolAtAddress(Z));
-    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << "," << sym << "] ";
+    traceOut << "FLASH[0x" <<std::hex << Z <<std::dec << ",";
+    core->Flash->WriteSymbolAtAddress(traceOut, Z);
+    traceOut << "] ";
     return ret;
 }
 
@@ -25,6 +25,7 @@
 
 #include "externalirq.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 ExternalIRQHandler::ExternalIRQHandler(AvrDevice* c,
                                        HWIrqSystem* irqsys,
@@ -107,6 +108,14 @@ void ExternalIRQHandler::Reset(void) {
         extirqs[idx]->ResetMode();
 }
 
+void ExternalIRQHandler::Checkpoint(Snapshot &snap) {
+    snap.Section("extirq");
+    snap.Value(irq_mask);
+    snap.Value(irq_flag);
+    for(unsigned int idx = 0; idx < extirqs.size(); idx++)
+        extirqs[idx]->Checkpoint(snap);
+}
+
 unsigned char ExternalIRQHandler::set_from_reg(const IOSpecialReg* reg, unsigned char nv) {
     if(reg == mask_reg) {
         // mask register: trigger interrupt, if mask bit is new set and flag is true or fireAgain()
@@ -152,6 +161,10 @@ unsigned char ExternalIRQ::set_from_reg(const IOSpecialReg* reg, unsigned char n
     return nv;
 }
 
+void ExternalIRQ::Checkpoint(Snapshot &snap) {
+    snap.Value(mode);
+}
+
 unsigned char ExternalIRQ::get_from_client(const IOSpecialReg* reg, unsigned char v) {
     return (v & ~mask) | (mode << bitshift);
 }
@@ -209,6 +222,11 @@ void ExternalIRQSingle::ChangeMode(unsigned char m) {
         avr_warning("External irq mode ISCx1:ISCx0 = 0:1 isn't supported here");
 }
 
+void ExternalIRQSingle::Checkpoint(Snapshot &snap) {
+    ExternalIRQ::Checkpoint(snap);
+    snap.Value(state);
+}
+
 bool ExternalIRQSingle::fireAgain(void) {
     return (mode == MODE_LEVEL_LOW) && (state == false);
 }
@@ -253,6 +271,11 @@ ExternalIRQPort::ExternalIRQPort(IOSpecialReg *ctrl, Pin* pinList[8]):
     ResetMode();
 }
 
+void ExternalIRQPort::Checkpoint(Snapshot &snap) {
+    ExternalIRQ::Checkpoint(snap);
+    snap.Value(state);
+}
+
 void ExternalIRQPort::PinStateHasChanged(Pin *pin) {
     // new state
     bool s = (bool)*pin;
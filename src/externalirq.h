@@ -64,6 +64,7 @@ class ExternalIRQHandler: public Hardware, public IOSpecialRegClient {
         // from Hardware
         void ClearIrqFlag(unsigned int vector) override;
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         bool IsLevelInterrupt(unsigned int vector) override;
         bool LevelInterruptPending(unsigned int vector) override;
         
@@ -95,6 +96,8 @@ class ExternalIRQ: public IOSpecialRegClient {
         virtual bool fireAgain(void) { return false; }
         //! does fire interrupt set the interrupt flag? (level interrupt does this not!)
         virtual bool mustSetFlagOnFire(void) { return true; }
+        //! Save or restore mode and saved pin states, see Hardware::Checkpoint
+        virtual void Checkpoint(Snapshot &snap);
         
         friend class ExternalIRQHandler;
         
@@ -128,6 +131,7 @@ class ExternalIRQSingle: public ExternalIRQ, public HasPinNotifyFunction {
         void ChangeMode(unsigned char m) override;
         bool fireAgain(void) override;
         bool mustSetFlagOnFire() override;
+        void Checkpoint(Snapshot &snap) override;
         
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin) override;
@@ -145,6 +149,9 @@ class ExternalIRQPort: public ExternalIRQ, public HasPinNotifyFunction {
         ExternalIRQPort(IOSpecialReg *ctrl, HWPort *port);
         ExternalIRQPort(IOSpecialReg *ctrl, Pin* pinList[8]);
         
+        // from ExternalIRQ
+        void Checkpoint(Snapshot &snap) override;
+        
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin) override;
 };
@@ -27,13 +27,53 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-
-
+#include <mutex>
+#include <atomic>
+#include <algorithm>
 
 #include "flash.h"
 #include "helper.h"
 #include "memory.h"
 #include "avrerror.h"
+#include "snapshot.h"
+
+namespace {
+    //! Image, which is registered for use by other devices
+    struct SharedImage {
+        std::string type; //!< device type, which decoded image
+        std::weak_ptr<FlashImage> image;
+    };
+
+    std::mutex sharedImagesMutex;
+    std::vector<SharedImage> sharedImages;
+}
+
+FlashImage::FlashImage(unsigned int size):
+    memory(size, 0xff),  // Safeguard, will be decoded as avr_op_ILLEGAL
+    slots(size / 2, 0),
+    opcodes(1, 0xffff),
+    records(size / 2 + 1),
+    shared(false) {
+    slotOfOpcode[0xffff] = 0;
+}
+
+FlashImage::FlashImage(const FlashImage &img):
+    memory(img.memory),
+    slots(img.slots),
+    opcodes(img.opcodes),
+    slotOfOpcode(img.slotOfOpcode),
+    records(img.records),
+    shared(false) {}
+
+void FlashImage::SetSlot(unsigned int index) {
+    word opcode = (memory[index * 2] << 8) + memory[index * 2 + 1];
+    std::unordered_map<word, unsigned short>::iterator ii = slotOfOpcode.find(opcode);
+    if(ii == slotOfOpcode.end()) {
+        ii = slotOfOpcode.insert(std::make_pair(opcode, (unsigned short)opcodes.size())).first;
+        opcodes.push_back(opcode);
+    }
+    slots[index] = ii->second;
+}
 
 void AvrFlash::Decode(){
     for(unsigned int addr = 0; addr < size ; addr += 2)
@@ -43,23 +83,74 @@ void AvrFlash::Decode(){
 AvrFlash::AvrFlash(AvrDevice *c, int _size):
     Memory(_size),
     core(c),
-    DecodedMem(_size),
-    flashLoaded(false) {
-    for(unsigned int tt = 0; tt < size; tt++)
-        myMemory[tt] = 0xff;  // Safeguard, will be decoded as avr_op_ILLEGAL
+    flashLoaded(false),
+    blockCache(this, _size / 2) {
+    // flash content is held by image
+    avr_free(myMemory);
+    std::shared_ptr<FlashImage> img = std::make_shared<FlashImage>(size);
+    // instructions are decoded on first fetch, the sentinel record stays empty
+    for(unsigned int i = 0; i < size / 2; i++)
+        img->records[i].SetHandler(DecodeOnFetch);
+    SetImage(img);
     rww_lock = 0;
-    // initialize DecodedMem
-    Decode();
 }
 
 AvrFlash::~AvrFlash() {
-    for(unsigned int i = 0; i < size; i++) {
-       if(DecodedMem[i] != NULL)
-          delete DecodedMem[i]; // delete Instruction
+    for(unsigned int i = 0; i < instructions.size(); i++)
+        delete instructions[i];
+    myMemory = NULL; // owned by image
+}
+
+void AvrFlash::SetImage(const std::shared_ptr<FlashImage> &img) {
+    image = img;
+    myMemory = image->memory.data();
+    slots = image->slots.data();
+    ThreadedMem = image->records.data();
+    instructions.resize(image->opcodes.size(), NULL);
+}
+
+void AvrFlash::Unshare(void) {
+    if(!image->shared)
+        return;
+    std::shared_ptr<FlashImage> img;
+    {
+        // other devices may decode records of the image at the same time
+        std::lock_guard<std::mutex> lock(image->decodeMutex);
+        img = std::make_shared<FlashImage>(*image);
     }
+    SetImage(img);
+}
+
+void AvrFlash::ShareImage(const std::string &type) {
+    std::lock_guard<std::mutex> lock(sharedImagesMutex);
+
+    for(std::vector<SharedImage>::iterator ii = sharedImages.begin(); ii != sharedImages.end(); ) {
+        std::shared_ptr<FlashImage> img = ii->image.lock();
+        if(!img) {
+            ii = sharedImages.erase(ii);
+            continue;
+        }
+        if(img == image)
+            return;
+        if(ii->type == type && img->memory == image->memory) {
+            // slots are different in the other image, instructions will be created again
+            for(unsigned int i = 0; i < instructions.size(); i++)
+                delete instructions[i];
+            instructions.clear();
+            SetImage(img);
+            blockCache.Clear();
+            return;
+        }
+        ii++;
+    }
+
+    // records are decoded on first fetch, also if the image is shared later
+    image->shared = true;
+    sharedImages.push_back(SharedImage{type, image});
 }
 
 void AvrFlash::WriteMem(const unsigned char *src, unsigned int offset, unsigned int secSize) {
+    Unshare();
     for(unsigned tt = 0; tt < secSize; tt += 2) { 
         if(tt + offset < size) {
             assert(tt+offset+1<size);
@@ -73,14 +164,34 @@ void AvrFlash::WriteMem(const unsigned char *src, unsigned int offset, unsigned
 
 void AvrFlash::WriteMemByte(unsigned char val, unsigned int offset) {
     assert(offset < size);  // in bytes
+    Unshare();
     *(myMemory + offset) = val;
     flashLoaded = true;
 }
 
+void AvrFlash::Checkpoint(Snapshot &snap) {
+    snap.Section("flash");
+    snap.Value(rww_lock);
+    snap.Value(flashLoaded);
+    std::vector<unsigned char> content(myMemory, myMemory + size);
+    snap.Bytes(content.data(), size);
+    if(snap.IsRestoring() && content != image->memory) {
+        Unshare();
+        std::copy(content.begin(), content.end(), myMemory);
+        Decode();
+    }
+}
+
 DecodedInstruction* AvrFlash::GetInstruction(unsigned int pc) {
     if(IsRWWLock(pc * 2))
         avr_error("flash is locked (RWW lock)");
-    return DecodedMem[pc];
+    return GetDecoded(pc);
+}
+
+const ThreadedInstruction* AvrFlash::GetThreadedInstruction(unsigned int pc) {
+    if(IsRWWLock(pc * 2))
+        avr_error("flash is locked (RWW lock)");
+    return &ThreadedMem[pc];
 }
 
 unsigned char AvrFlash::ReadMem(unsigned int offset) {
@@ -109,11 +220,75 @@ void AvrFlash::Decode(unsigned int offset, int secSize) {
 void AvrFlash::Decode(unsigned int addr) {
     assert((unsigned)addr < size);
     assert((addr % 2) == 0);
-    word opcode = (myMemory[addr] << 8) + myMemory[addr + 1];
+    Unshare();
     unsigned int index = addr / 2;
-    if(DecodedMem[index] != NULL)
-        delete DecodedMem[index];                     //delete old Instruction here 
-    DecodedMem[index] = lookup_opcode(opcode, core);  //and set new one
+    image->SetSlot(index);
+    instructions.resize(image->opcodes.size(), NULL);
+    ThreadedMem[index] = ThreadedInstruction();
+    ThreadedMem[index].SetHandler(DecodeOnFetch);
+
+    // a skip instruction before has to see the size of the new instruction
+    if(index > 0)
+        ThreadedMem[index - 1].SetHandler(DecodeOnFetch);
+
+    // drop translated blocks, which contain this instruction
+    blockCache.Invalidate(index);
+}
+
+DecodedInstruction *AvrFlash::DecodeWord(unsigned int index) {
+    assert(index < size / 2);
+    // instructions have no state for their address, so one object per opcode is enough
+    unsigned short slot = slots[index];
+    DecodedInstruction *&de = instructions[slot];
+    if(de == NULL)
+        de = lookup_opcode(image->opcodes[slot], core);
+    return de;
+}
+
+// the flag is read by a skip instruction before, which may run on a other thread
+static inline void SetSize2Word(ThreadedInstruction &ti, bool size2Word) {
+    if(ti.size2Word != size2Word)
+        ti.size2Word = size2Word;
+}
+
+void AvrFlash::PrecompileWord(unsigned int index, bool arm) {
+    // other devices may execute records of a shared image at the same time, so
+    // a record of it is decoded once and armed, its operands are written,
+    // while its handler is DecodeOnFetch, and published by the handler
+    std::unique_lock<std::mutex> lock(image->decodeMutex, std::defer_lock);
+    if(image->shared) {
+        lock.lock();
+        if(ThreadedMem[index].GetHandler() != DecodeOnFetch)
+            return; // decoded by another device
+        arm = true;
+    }
+
+    DecodedInstruction *de = GetDecoded(index);
+    ThreadedInstruction ti;
+    ti.size2Word = de->IsInstruction2Words();
+    de->Precompile(&ti);
+
+    // skip instructions read the size of the next instruction from its record,
+    // a armed skip may read it at any time, so it's only written, if it changes
+    if(arm && index + 1 < size / 2 && ThreadedMem[index + 1].GetHandler() == DecodeOnFetch)
+        SetSize2Word(ThreadedMem[index + 1], GetDecoded(index + 1)->IsInstruction2Words());
+
+    ThreadedInstruction &record = ThreadedMem[index];
+    record.R1 = ti.R1;
+    record.R2 = ti.R2;
+    record.endsBlock = ti.endsBlock;
+    record.K = ti.K;
+    SetSize2Word(record, ti.size2Word);
+    record.SetHandler(arm ? ti.handler.load(std::memory_order_relaxed) : DecodeOnFetch);
+}
+
+int AvrFlash::DecodeOnFetch(AvrDevice *core, const ThreadedInstruction *ti) {
+    AvrFlash *flash = core->Flash;
+    unsigned int index = ti - flash->ThreadedMem;
+
+    flash->PrecompileWord(index, true);
+    const ThreadedInstruction *t = &flash->ThreadedMem[index];
+    return t->GetHandler()(core, t);
 }
 
 /** Returns true if insn at address index*2 looks like switching thread stacks (heuristics).
@@ -128,11 +303,11 @@ void AvrFlash::Decode(unsigned int addr) {
 * We analyze few preceding instructions in hope to rule out these cases.
 * (GDB's weak prologue analysis is doctored elsewhere.)
 */
-bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
+bool AvrFlash::LooksLikeContextSwitch(unsigned int addr)
 {
     assert(addr < size);
     word index = addr/2;
-    DecodedInstruction * instr = DecodedMem[index];
+    DecodedInstruction * instr = GetDecoded(index);
     avr_op_OUT * out_instr = dynamic_cast<avr_op_OUT*>(instr);
     if(out_instr == NULL)
         return false;
@@ -144,7 +319,7 @@ bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
     unsigned char out_R = out_instr->R1;  // We have "OUT SP, R"
 
     for(int i = 1; i < 8 && i <= index; i++) {
-        instr = DecodedMem[index - i];
+        instr = GetDecoded(index - i);
         byte Rlo = instr->GetModifiedR();  // "sbiw r28:r29, 42" returns 28
         byte Rhi = instr->GetModifiedRHi();  // "sbiw r28:r29, 42" returns 29
         if(out_R == Rlo || (is_SPH && out_R == Rhi)) {
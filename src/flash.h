@@ -27,39 +27,84 @@
 #define FLASH_H_INCLUDED
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "decoder.h"
 #include "memory.h"
+#include "basicblock.h"
 
 class DecodedInstruction;
+class Snapshot;
+
+//! Flash content and threaded code records, which can be shared by devices
+/*! Devices of the same type, which load the same program, use one image.
+  The content of a shared image isn't changed any more, a device, which
+  writes flash, gets a own copy before. The threaded code records of a shared
+  image are decoded on first fetch like the ones of a own image, but under
+  decodeMutex, because other devices may run on other threads. */
+class FlashImage {
+
+    public:
+        FlashImage(unsigned int size);
+        //! Copies content and records, the copy isn't shared
+        FlashImage(const FlashImage &img);
+
+        std::vector <unsigned char> memory; //!< flash content
+        std::vector <unsigned short> slots; //!< index in opcodes for each flash word
+        std::vector <word> opcodes; //!< opcodes in flash, each one only once
+        std::unordered_map <word, unsigned short> slotOfOpcode; //!< reverse map of opcodes
+        std::vector <ThreadedInstruction> records; //!< threaded code records, one per flash word + 1 sentinel
+        bool shared; //!< Flag: image is registered for use by other devices and fixed
+        std::mutex decodeMutex; //!< guards decoding of records of a shared image
+
+        /*! Sets slot for flash word at index from memory content */
+        void SetSlot(unsigned int index);
+};
 
 //! Holds AVR flash content and symbol informations.
 class AvrFlash: public Memory {
   
     protected:
         AvrDevice *core;
-        std::vector <DecodedInstruction*> DecodedMem;
+        std::shared_ptr <FlashImage> image; //!< flash content, maybe shared with other devices
+        unsigned short *slots; //!< slots of image
+        ThreadedInstruction *ThreadedMem; //!< records of image
+        std::vector <DecodedInstruction*> instructions; //!< instruction per slot of image, NULL till first fetch, owned here
         unsigned int rww_lock; //!< When Flash write is in progress then addresses below this are inaccesible, otherwise 0.
         bool flashLoaded; //!< Flag, true if there was a write to Flash after constructor call (program load)
+        BasicBlockCache blockCache; //!< translated basic blocks, dropped on decode
+        
+        friend class BasicBlockCache;
         
-        friend int avr_op_CPSE::operator()();
-        friend int avr_op_SBIC::operator()();
-        friend int avr_op_SBIS::operator()();
-        friend int avr_op_SBRC::operator()();
-        friend int avr_op_SBRS::operator()();
+        /*! Creates instruction for flash word at index, instruction object is shared with all other words with same opcode */
+        DecodedInstruction *DecodeWord(unsigned int index);
+
+        /*! Fills threaded code record at index, if arm is false, it's executed by DecodeOnFetch */
+        void PrecompileWord(unsigned int index, bool arm);
+
+        /*! Handler of threaded code records, which wasn't executed since decode */
+        static int DecodeOnFetch(AvrDevice *core, const ThreadedInstruction *ti);
+
+        /*! Uses img as flash image */
+        void SetImage(const std::shared_ptr <FlashImage> &img);
+
+        /*! Gets a own copy of image, if it's shared, before flash is written */
+        void Unshare(void);
 
     public:
       
         AvrFlash(AvrDevice *c, int size);
         ~AvrFlash();
         
-        void Decode(); /*!< Decode/create all instructions */
+        void Decode(); /*!< Decode all instructions again on next fetch */
         
-        /*! Decode/create instruction at address 'addr'. */
+        /*! Decode instruction at address 'addr' again on next fetch. */
         void Decode(unsigned int addr);
         
-        /*! Decode memory block with offset and size
+        /*! Decode instructions in memory block with offset and size again on next fetch
           @param offset data offset in memory block, beginning from start of THIS memory block!
           @param secSize count of available data (bytes) in src */
         void Decode(unsigned int addr, int secSize);
@@ -85,6 +130,25 @@ class AvrFlash: public Memory {
         /*! Returns instruction at pointer PC. Aborts if Flash write is in progress. */
         DecodedInstruction* GetInstruction(unsigned int pc);
         
+        /*! Returns instruction at pointer PC, decodes it on first access. Works even during flash writing. */
+        DecodedInstruction* GetDecoded(unsigned int pc) {
+            DecodedInstruction *de = instructions[slots[pc]];
+            return (de != NULL) ? de : DecodeWord(pc);
+        }
+        
+        /*! Shares flash content with devices of same type, which loaded the same program
+          @param type device type, devices of one type decode instructions in the same way */
+        void ShareImage(const std::string &type);
+        
+        /*! True if flash content is shared with other devices */
+        bool IsImageShared(void) { return image.use_count() > 1; }
+        
+        /*! Returns threaded code record at pointer PC. Aborts if Flash write is in progress. */
+        const ThreadedInstruction* GetThreadedInstruction(unsigned int pc);
+        
+        /*! Returns cache of basic blocks for this flash */
+        BasicBlockCache *GetBlockCache(void) { return &blockCache; }
+        
         /*! Returns byte at flash address. Works even during flash writing. */
         unsigned char ReadMemRaw(unsigned int addr) { return myMemory[addr]; }
         
@@ -97,7 +161,11 @@ class AvrFlash: public Memory {
         /*! Returns 16bits at flash address. Aborts if Flash write is in progress. */
         unsigned int ReadMemWord(unsigned int addr);
 
-        bool LooksLikeContextSwitch(unsigned int addr) const;
+        bool LooksLikeContextSwitch(unsigned int addr);
+
+        /*! Save or restore flash content and RWW lock, content is only written
+          back and decoded again, if it differs from the current content */
+        void Checkpoint(Snapshot &snap);
 };
 
 #endif
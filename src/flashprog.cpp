@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "snapshot.h"
 
 
 void FlashProgramming::ClearOperationBits(void) {
@@ -101,6 +102,13 @@ unsigned int FlashProgramming::CpuCycle() {
     return 0;
 }
 
+unsigned int FlashProgramming::GetIdleCycles() {
+    // idle, if no operation is enabled and cpu isn't locked
+    if(opr_enable_count > 0 || action == SPM_ACTION_LOCKCPU)
+        return 0;
+    return idleForever;
+}
+
 void FlashProgramming::Reset() {
     spmcr_val = 0;
     opr_enable_count = 0;
@@ -109,6 +117,16 @@ void FlashProgramming::Reset() {
     timeout = 0;
 }
 
+void FlashProgramming::Checkpoint(Snapshot &snap) {
+    snap.Section("spm");
+    snap.Value(spmcr_val);
+    snap.Value(opr_enable_count);
+    snap.Value(action);
+    snap.Value(spm_opr);
+    snap.Value(timeout);
+    snap.Bytes(tempBuffer, pageSize * 2);
+}
+
 unsigned char FlashProgramming::LPM_action(unsigned int xaddr, unsigned int addr) {
     return 0;
 }
@@ -154,6 +172,7 @@ int FlashProgramming::SPM_action(unsigned int data, unsigned int xaddr, unsigned
             timeout = SystemClock::Instance().GetCurrentTime() + FlashProgramming::SPM_TIMEOUT;
             // lock cpu while writing flash
             action = SPM_ACTION_LOCKCPU;
+            core->RescheduleHardware(this);
             // lock RWW, if necessary
             SetRWWLock(addr);
             //cout << "write buffer: [0x" << hex << addr << "]" << endl;
@@ -170,6 +189,7 @@ int FlashProgramming::SPM_action(unsigned int data, unsigned int xaddr, unsigned
             timeout = SystemClock::Instance().GetCurrentTime() + FlashProgramming::SPM_TIMEOUT;
             // lock cpu while erasing flash
             action = SPM_ACTION_LOCKCPU;
+            core->RescheduleHardware(this);
             // lock RWW, if necessary
             SetRWWLock(addr);
             //cout << "erase page: [0x" << hex << addr << "]" << endl;
@@ -182,6 +202,7 @@ int FlashProgramming::SPM_action(unsigned int data, unsigned int xaddr, unsigned
 }
 
 void FlashProgramming::SetSpmcr(unsigned char v) {
+    core->RescheduleHardware(this);
     spmcr_val = (spmcr_val & ~spmcr_valid_bits) + (v & spmcr_valid_bits);
     
     // calculate operation
@@ -331,4 +352,8 @@ void AvrLockBits::SetLockBits(unsigned char bits) {
     lockBits = (lockBits & bits) | ~((1 << lockBitsSize) - 1);
 }
 
+void AvrLockBits::Checkpoint(Snapshot &snap) {
+    snap.Value(lockBits);
+}
+
 // EOF
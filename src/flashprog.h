@@ -85,7 +85,9 @@ class FlashProgramming: public Hardware {
         ~FlashProgramming();
         
         unsigned int CpuCycle() override;
+        unsigned int GetIdleCycles() override;
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         
         unsigned char LPM_action(unsigned int xaddr, unsigned int addr);
         int SPM_action(unsigned int data, unsigned int xaddr, unsigned int addr);
@@ -151,6 +153,8 @@ class AvrLockBits {
         unsigned char GetLockByte(void) { return lockBits; }
         //! Set lock bits (from a SPM instruction)
         void SetLockBits(unsigned char bits);
+        //! Save or restore lock bits, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
 
 };
 
@@ -0,0 +1,143 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "flightrecorder.h"
+#include "avrdevice.h"
+#include "flash.h"
+#include "avrerror.h"
+
+#include <set>
+#include <iostream>
+#include <stdio.h>
+
+//! All existing recorders, for DumpAll
+static std::set<FlightRecorder *> &Recorders(void) {
+    static std::set<FlightRecorder *> recorders;
+    return recorders;
+}
+
+FlightRecorder::FlightRecorder(AvrDevice *_core, unsigned int size):
+    core(_core),
+    regs(_core->dataMem),
+    status(_core->status),
+    entries(size > 0 ? size : 1),
+    pos(0),
+    count(0),
+    dumping(false)
+{
+    memcpy(shadow, regs, sizeof(shadow));
+    Recorders().insert(this);
+}
+
+FlightRecorder::~FlightRecorder() {
+    Recorders().erase(this);
+}
+
+void FlightRecorder::RegistersChanged(Entry &e) {
+    for(unsigned int r = 0; r < sizeof(shadow); r++) {
+        if(regs[r] != shadow[r]) {
+            e.changed |= 1U << r;
+            shadow[r] = regs[r];
+        }
+    }
+    // a entry could be finished twice, if it is dumped while running
+    unsigned int n = 0;
+    for(unsigned int r = 0; r < sizeof(shadow) && n < maxValues; r++)
+        if(e.changed & (1U << r))
+            e.value[n++] = regs[r];
+}
+
+void FlightRecorder::SetFile(const std::string &filename) {
+    file.open(filename.c_str(), std::ios::out | std::ios::trunc);
+    if(!file)
+        avr_error("flight recorder: can't create file '%s'", filename.c_str());
+}
+
+void FlightRecorder::Write(std::ostream &os, unsigned int max) {
+    if(count == 0)
+        return;
+    // take over the state of the running instruction
+    Finish();
+
+    unsigned int n = (count < entries.size()) ? (unsigned int)count : (unsigned int)entries.size();
+    if(n > max)
+        n = max;
+    unsigned int idx = (pos + entries.size() - (n - 1)) % entries.size();
+    for(; n > 0; n--) {
+        const Entry &e = entries[idx];
+        char buf[64];
+        if(e.flags & FLAG_INTERRUPT) {
+            snprintf(buf, sizeof(buf), "%llu IRQ DETECTED: Vector %u", e.cycle, e.pc);
+            os << buf << std::endl;
+        } else {
+            snprintf(buf, sizeof(buf), "%llu 0x%04x: ", e.cycle, e.pc << 1);
+            os << buf;
+            size_t len = core->Flash->WriteSymbolAtAddress(os, e.pc << 1);
+            os << " ";
+            for(; len < 30; len++)
+                os << " ";
+            HWSreg sreg;
+            sreg = e.sreg;
+            os << (std::string)sreg;
+            unsigned int v = 0;
+            for(unsigned int r = 0; r < 32; r++) {
+                if(!(e.changed & (1U << r)))
+                    continue;
+                if(v < maxValues)
+                    snprintf(buf, sizeof(buf), "R%u=0x%02x ", r, e.value[v]);
+                else
+                    snprintf(buf, sizeof(buf), "R%u ", r);
+                os << buf;
+                v++;
+            }
+            os << std::endl;
+        }
+        if(++idx == entries.size())
+            idx = 0;
+    }
+}
+
+void FlightRecorder::Dump(const char *reason) {
+    if(dumping)
+        return;
+    dumping = true;
+    std::ostream &os = file.is_open() ? (std::ostream &)file : std::cerr;
+    unsigned int n = (count < entries.size()) ? (unsigned int)count : (unsigned int)entries.size();
+    os << "flight recorder " << core->GetDeviceName() << ": " << reason << std::endl
+       << "last " << n << " of " << count << " recorded instructions and interrupts, first column is cpu cycle" << std::endl;
+    Write(os, n);
+    os << std::endl;
+    os.flush();
+    dumping = false;
+}
+
+void FlightRecorder::DumpAll(const char *reason, bool fault) {
+    std::set<FlightRecorder *> &recorders = Recorders();
+    for(std::set<FlightRecorder *>::iterator i = recorders.begin(); i != recorders.end(); i++)
+        if(fault || (*i)->HasFile())
+            (*i)->Dump(reason);
+}
+
+// EOF
@@ -0,0 +1,146 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef FLIGHTRECORDER
+#define FLIGHTRECORDER
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <fstream>
+#include <string.h>
+
+#include "hwsreg.h"
+#include "instructionobserver.h"
+
+class AvrDevice;
+
+//! Ring buffer of the last executed instructions for post mortem analysis
+/*! The recorder is added as InstructionObserver to the core. A entry holds
+  cycle and PC of the instruction and,
+  filled in on the start of the next instruction, SREG after the instruction
+  and the core registers, which were changed by it. Changes are found by
+  comparing the register file with a copy, so recording costs only a few
+  compares per instruction and the recorder can be always enabled.
+
+  The buffer is dumped by Dump, by DumpAll for all recorders on a fatal
+  error, an abort or exit of the application and by the stack on a
+  overflow. A stack growing into static data is a warning only, then the
+  buffer is dumped, if dumps are written to a file. */
+class FlightRecorder: public InstructionObserver {
+
+    private:
+        //! One recorded instruction or interrupt
+        struct Entry {
+            unsigned long long cycle; //!< cycle, in which instruction was started
+            unsigned int pc; //!< flash word of instruction or vector number for a interrupt
+            unsigned int changed; //!< bit n is set, if instruction has changed register Rn
+            unsigned char sreg; //!< SREG after instruction
+            unsigned char flags; //!< FLAG_xxx
+            unsigned char value[6]; //!< new values of the changed registers, lowest register first
+        };
+
+        enum {
+            FLAG_INTERRUPT = 1 //!< entry is a interrupt, not a instruction
+        };
+
+        static const unsigned int maxValues = sizeof(((Entry *)0)->value); //!< register values per entry
+
+        AvrDevice *core; //!< the recorded core
+        const unsigned char *regs; //!< register file R0-R31 of core
+        HWSreg *status; //!< status register of core
+        std::vector<Entry> entries; //!< ring buffer
+        unsigned int pos; //!< index of the newest entry
+        unsigned long long count; //!< count of all recorded entries
+        unsigned char shadow[32]; //!< register file after the last recorded instruction
+        std::ofstream file; //!< dump file, if set
+        bool dumping; //!< a dump is in progress, avoids recursion by errors while dumping
+
+        //! Stores SREG and changed registers of the newest entry
+        void Finish(void) {
+            Entry &e = entries[pos];
+            e.sreg = (status->I << 7) | (status->T << 6) | (status->H << 5) | (status->S << 4) |
+                     (status->V << 3) | (status->N << 2) | (status->Z << 1) | status->C;
+            if(memcmp(regs, shadow, sizeof(shadow)) != 0)
+                RegistersChanged(e);
+        }
+        //! Records changed registers in e and takes them over into shadow
+        void RegistersChanged(Entry &e);
+        //! Appends a entry
+        void Add(unsigned int pc, unsigned long long cycle, unsigned char flags) {
+            if(++pos == entries.size())
+                pos = 0;
+            Entry &e = entries[pos];
+            e.cycle = cycle;
+            e.pc = pc;
+            e.changed = 0;
+            e.flags = flags;
+            count++;
+        }
+
+    public:
+        static const unsigned int defaultSize = 65536; //!< default number of entries
+
+        //! Creates a recorder for the last size instructions of core
+        FlightRecorder(AvrDevice *core, unsigned int size = defaultSize);
+        ~FlightRecorder();
+
+        void Instruction(unsigned int pc, unsigned long long cycle) override {
+            if(count != 0)
+                Finish();
+            Add(pc, cycle, 0);
+        }
+
+        void Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) override {
+            if(count != 0)
+                Finish();
+            Add(vector, cycle, FLAG_INTERRUPT);
+        }
+
+        //! Clears the buffer
+        void Clear(void) { count = 0; }
+
+        //! Returns the number of entries in the buffer
+        unsigned int GetSize(void) const { return (unsigned int)entries.size(); }
+
+        //! Writes all following dumps to file instead of stderr
+        void SetFile(const std::string &filename);
+        //! True, if dumps are written to a file
+        bool HasFile(void) const { return file.is_open(); }
+
+        //! Writes the last max recorded entries as text, oldest first
+        void Write(std::ostream &os, unsigned int max);
+
+        //! Writes all recorded entries with reason to the dump file or to stderr
+        void Dump(const char *reason);
+
+        //! Dumps all recorders
+        /*! @param reason text, why the recorders are dumped
+          @param fault true on a error, then all recorders are dumped, otherwise
+          only recorders with a dump file */
+        static void DumpAll(const char *reason, bool fault);
+};
+
+#endif
@@ -26,6 +26,10 @@
 #include "hardware.h"
 #include "avrdevice.h"
 
-Hardware::Hardware(AvrDevice *core) { core->AddToResetList(this); }
+Hardware::Hardware(AvrDevice *core):
+    cycleLast(AvrDevice::cycleNever),
+    cycleDue(AvrDevice::cycleNever) {
+    core->AddToResetList(this);
+}
 
 // EOF
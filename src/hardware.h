@@ -27,6 +27,7 @@
 #define HARDWARE
 
 class AvrDevice;
+class Snapshot;
 
 /*! Hardware objects are the subsystems of an AVR device. They have a clock and
   reset input and in addition will define various memory registers through
@@ -45,6 +46,21 @@ class Hardware {
           not be executed (e.g. a Flash write is in progress). */
         virtual unsigned int CpuCycle(void) { return 0; }
 
+        /*! Returns the count of cycles after the current one, in which CpuCycle
+          would do nothing else than counting. The core doesn't call CpuCycle
+          for these cycles, it calls SkipCpuCycles instead, before CpuCycle is
+          called again or if AvrDevice::SyncHardware is called. If a register
+          access changes, when the hardware needs the next CpuCycle call, it has
+          to call AvrDevice::RescheduleHardware. The default is 0, so CpuCycle
+          is called on every cycle. Return idleForever, if nothing will happen
+          till the next reschedule. */
+        virtual unsigned int GetIdleCycles(void) { return 0; }
+
+        /*! Called with the count of cycles, for which CpuCycle wasn't called
+          because of GetIdleCycles. The hardware has to catch up its counters
+          here. The default is no action. */
+        virtual void SkipCpuCycles(unsigned int cycles) {}
+
         /*! Implement the hardware's reset functionality here. The default
           is no action on reset. */
         virtual void Reset(void) {};
@@ -58,6 +74,20 @@ class Hardware {
         
         /*! Check a level interrupt on the time, where interrupt routine will be called */
         virtual bool LevelInterruptPending(unsigned int vector) { return false; }
+
+        /*! Saves or restores the internal state of the hardware, see Snapshot.
+          On restore, the state has to be set without side effects like pin
+          changes or interrupts, all units are restored one after another. The
+          default is no state. */
+        virtual void Checkpoint(Snapshot &snap) {}
+
+        //! Return value of GetIdleCycles, if hardware will be idle till next reschedule
+        static const unsigned int idleForever = 0xffffffff;
+
+    private:
+        friend class AvrDevice;
+        unsigned long long cycleLast; //!< last cycle, which was processed by CpuCycle or SkipCpuCycles
+        unsigned long long cycleDue; //!< next cycle, in which CpuCycle has to be called
         
 };
 
@@ -28,6 +28,7 @@
 #include "irqsystem.h"
 #include "hwad.h"
 #include "hwtimer.h"
+#include "snapshot.h"
 
 HWAcomp::HWAcomp(AvrDevice *core,
                  HWIrqSystem *irqsys,
@@ -90,6 +91,13 @@ void HWAcomp::Reset() {
         acsr |= ACO;
 }
 
+void HWAcomp::Checkpoint(Snapshot &snap) {
+    snap.Section("acomp");
+    snap.Value(acme_sfior);
+    snap.Value(enabled);
+    snap.Value(acsr);
+}
+
 void HWAcomp::SetAcsr(unsigned char val) {
     unsigned char old = acsr & (ACO|ACI);
     bool old_acic = (acsr & ACIC) == ACIC;
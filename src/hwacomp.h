@@ -100,6 +100,8 @@ class HWAcomp: public Hardware,
         void SetAcsr(unsigned char val);
         //! Reset the unit
         void Reset() override;
+        //! Save or restore state of the unit
+        void Checkpoint(Snapshot &snap) override;
         //! Reflect irq processing, reset interrupt source
         void ClearIrqFlag(unsigned int vec) override;
         //! Get informed about input pin change
@@ -26,6 +26,7 @@
 #include "hwad.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 HWARefPin::HWARefPin(AvrDevice *_core):
     HWARef(_core),
@@ -101,6 +102,10 @@ void HWAdmux::SetMuxSelect(int select) {
         notifyClient->NotifySignalChanged();
 }
 
+void HWAdmux::Checkpoint(Snapshot &snap) {
+    snap.Value(muxSelect);
+}
+
 void HWAdmux::PinStateHasChanged(Pin* p) {
     Pin *selected = ad[muxSelect];
     if((notifyClient != NULL) && (selected == p))
@@ -436,6 +441,24 @@ void HWAd::Reset(void) {
     adchLocked = false;
 }
 
+void HWAd::Checkpoint(Snapshot &snap) {
+    snap.Section("adc");
+    snap.Value(adch);
+    snap.Value(adcl);
+    snap.Value(adcsra);
+    snap.Value(adcsrb);
+    snap.Value(admux);
+    snap.Value(adchLocked);
+    snap.Value(adSample);
+    snap.Value(adMuxConfig);
+    snap.Value(prescaler);
+    snap.Value(prescalerSelect);
+    snap.Value(conversionState);
+    snap.Value(firstConversion);
+    snap.Value(state);
+    mux->Checkpoint(snap);
+}
+
 void HWAd::NotifySignalChanged(void) {
     if((notifyClient != NULL) && !IsADEnabled())
         notifyClient->NotifySignalChanged();
@@ -452,6 +475,7 @@ unsigned char HWAd::GetAdcl(void) {
 }
 
 void HWAd::SetAdcsrA(unsigned char val) {
+    core->RescheduleHardware(this);
     bool enabled = (adcsra & ADEN) == ADEN;
     // clear IRQ Flag if set in val, otherwise do not overwrite ADIF
     if((val & ADIF) == ADIF)
@@ -702,6 +726,13 @@ unsigned int HWAd::CpuCycle() {
     return 0;
 }
 
+unsigned int HWAd::GetIdleCycles() {
+    // disabled ADC holds prescaler in reset and can't start a conversion
+    if((adcsra & ADEN) == 0)
+        return idleForever;
+    return 0;
+}
+
 HWAd_SFIOR::HWAd_SFIOR(AvrDevice *c, int _typ, HWIrqSystem *i, unsigned int iv, HWAdmux *a, HWARef *r, IOSpecialReg *s):
     HWAd(c, _typ, i, iv, a, r),
     sfior_reg(s) {
@@ -709,6 +740,11 @@ HWAd_SFIOR::HWAd_SFIOR(AvrDevice *c, int _typ, HWIrqSystem *i, unsigned int iv,
     sfior_reg->connectSRegClient(this);
 }
 
+void HWAd_SFIOR::Checkpoint(Snapshot &snap) {
+    HWAd::Checkpoint(snap);
+    snap.Value(adts);
+}
+
 unsigned char HWAd_SFIOR::set_from_reg(const IOSpecialReg* reg, unsigned char nv) {
     adts = (nv >> 5) & 0x7;
     return nv;
@@ -113,6 +113,8 @@ class HWAdmux: public HasPinNotifyFunction {
         void PinStateHasChanged(Pin*) override;
         void RegisterNotifyClient(AnalogSignalChange *client) { notifyClient = client; }
         void UnregisterNotifyClient(void) { notifyClient = 0; }
+        //! Saves or restores the selected channel, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
 };
 
 class HWAdmux6: public HWAdmux {
@@ -276,6 +278,8 @@ class HWAd: public Hardware, public TraceValueRegister, public AnalogSignalChang
         virtual ~HWAd() { mux->UnregisterNotifyClient(); }
 
         unsigned int CpuCycle() override;
+        //! ADC is idle, if it is disabled
+        unsigned int GetIdleCycles() override;
 
         unsigned char GetAdch(void);
         unsigned char GetAdcl(void);
@@ -286,6 +290,7 @@ class HWAd: public Hardware, public TraceValueRegister, public AnalogSignalChang
         void SetAdcsrB(unsigned char);
         void SetAdmux(unsigned char val);
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         void ClearIrqFlag(unsigned int vec) override;
 
         // interface for notify signal change in multiplexer
@@ -315,6 +320,7 @@ class HWAd_SFIOR: public HWAd, public IOSpecialRegClient {
         HWAd_SFIOR(AvrDevice *c, int _typ, HWIrqSystem *i, unsigned int iv, HWAdmux *a, HWARef *r, IOSpecialReg *s);
 
         void Reset() override { HWAd::Reset(); adts = 0; }
+        void Checkpoint(Snapshot &snap) override;
 
         unsigned char set_from_reg(const IOSpecialReg* reg, unsigned char nv) override;
         unsigned char get_from_client(const IOSpecialReg* reg, unsigned char v) override { return v; }
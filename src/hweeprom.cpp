@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 #include <assert.h>
 
 
@@ -102,6 +103,20 @@ void HWEeprom::Reset() {
     cpuHoldCycles = 0;
 }
 
+void HWEeprom::Checkpoint(Snapshot &snap) {
+    snap.Section("eeprom");
+    snap.Value(eear);
+    snap.Value(eecr);
+    snap.Value(eedr);
+    snap.Value(opEnableCycles);
+    snap.Value(cpuHoldCycles);
+    snap.Value(opState);
+    snap.Value(opMode);
+    snap.Value(opAddr);
+    snap.Value(writeDoneTime);
+    snap.Bytes(myMemory, size);
+}
+
 
 HWEeprom::~HWEeprom() {
     avr_free(myMemory);
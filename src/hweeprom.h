@@ -81,6 +81,7 @@ class HWEeprom: public Hardware, public Memory, public TraceValueRegister {
 
         unsigned int CpuCycle() override;
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         void ClearIrqFlag(unsigned int vector) override;
 
         void WriteMem(const unsigned char *, unsigned int offset, unsigned int size) override;
@@ -2,6 +2,7 @@
 #include <iostream>
 #include "hwpinchange.h"
 #include "irqsystem.h"
+#include "snapshot.h"
 
 
 HWPcir::HWPcir(	AvrDevice*		core,
@@ -158,6 +159,11 @@ void HWPcir::Reset(){
 	_pcifr	= 0;
 	}
 
+void HWPcir::Checkpoint(Snapshot &snap){
+	snap.Value(_pcicr);
+	snap.Value(_pcifr);
+	}
+
 void HWPcir::ClearIrqFlag(unsigned int vector){
 	if(vector == _vector0){
 		_pcifr	&= ~(1<<0);
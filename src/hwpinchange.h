@@ -99,6 +99,7 @@ class HWPcir : public HWPcifrApi , public HWPcirMaskApi , public Hardware {
         
 	private:	// Hardware
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         void ClearIrqFlag(unsigned int vector) override;
 
 	
@@ -28,6 +28,8 @@
 #include "hwport.h"
 #include "avrdevice.h"
 #include "avrerror.h"
+#include "snapshot.h"
+#include "net.h"
 #include <assert.h>
 
 HWPort::HWPort(AvrDevice *core, const std::string &name, bool portToggle, int size):
@@ -48,6 +50,8 @@ HWPort::HWPort(AvrDevice *core, const std::string &name, bool portToggle, int si
 {
     assert((portSize >= 1) && (portSize <= sizeof(p)/sizeof(p[0])));
     portMask = (unsigned char)((1 << portSize) - 1);
+    calcPort = 0;
+    calcDdr = 0;
 
     for(unsigned int tt = 0; tt < portSize; tt++) {
         // register pin to give access to pin by name
@@ -81,7 +85,28 @@ void HWPort::Reset(void) {
 
     for(int tt = portSize - 1; tt >= 0; tt--)
         p[tt].ResetOverride();
-    CalcOutputs();
+    CalcOutputs(portMask);
+}
+
+void HWPort::Checkpoint(Snapshot &snap) {
+    snap.Section("port");
+    snap.Value(port);
+    snap.Value(pin);
+    snap.Value(ddr);
+    for(unsigned int tt = 0; tt < portSize; tt++)
+        p[tt].Checkpoint(snap);
+
+    if(snap.IsRestoring()) {
+        // input values are taken over with pin register, so there is no update of nets
+        for(unsigned int tt = 0; tt < portSize; tt++) {
+            pintrace[tt]->change(p[tt].outState);
+            if(p[tt].isConnected())
+                p[tt].GetNet()->Invalidate();
+        }
+        calcPort = port;
+        calcDdr = ddr;
+        pin_reg.hardwareChange(pin);
+    }
 }
 
 Pin& HWPort::GetPin(unsigned char pinNo) {
@@ -89,20 +114,41 @@ Pin& HWPort::GetPin(unsigned char pinNo) {
     return p[pinNo];
 }
 
-void HWPort::CalcOutputs(void) { // Calculate the new output value to be transmitted to the environment
-    unsigned char tmpPin = 0;
+void HWPort::CalcOutputs(unsigned char forced) { // Calculate the new output value to be transmitted to the environment
+    unsigned char changed = forced | (port ^ calcPort) | (ddr ^ calcDdr);
+    unsigned char connected = 0;
 
     for(unsigned int actualBitNo = 0; actualBitNo < portSize; actualBitNo++) {
         unsigned char actualBit = 1 << actualBitNo;
         bool regPort = (bool)(port & actualBit);
         bool regDDR = (bool)(ddr & actualBit);
-
-        if(p[actualBitNo].CalcPinOverride(regDDR, regPort, false))
-            tmpPin |= actualBit;
-        pintrace[actualBitNo]->change(p[actualBitNo].outState);
+        PortPin &pp = p[actualBitNo];
+
+        Pin::T_Pinstate old = pp.outState;
+        pp.CalcOutState(regDDR, regPort, false);
+        if(pp.outState != old || (changed & actualBit)) {
+            changed |= actualBit;
+            pintrace[actualBitNo]->change(pp.outState);
+            if(pp.isConnected())
+                connected |= actualBit;
+            else if((bool)pp) // no net, the output is the input of the pin
+                pin |= actualBit;
+            else
+                pin &= ~actualBit;
+        }
     }
-//    pin = tmpPin; //BUGFIX: OpenDrain reads wrong value from PIN register
+    calcPort = port;
+    calcDdr = ddr;
     pin_reg.hardwareChange(pin);
+
+    // all unconnected pins have their input now, inform listeners and update nets
+    for(unsigned int actualBitNo = 0; actualBitNo < portSize; actualBitNo++) {
+        unsigned char actualBit = 1 << actualBitNo;
+        if(connected & actualBit)
+            p[actualBitNo].CalcPin();
+        else if(changed & actualBit)
+            p[actualBitNo].NotifyListeners();
+    }
 }
 
 std::string HWPort::GetPortString() {
@@ -153,6 +199,7 @@ void HWPort::SetPinBit(bool val, unsigned int bitaddr) {
             pin=tmpPin;
         }
         pintrace[bitaddr]->change(p[bitaddr].outState);
+        calcPort = (calcPort & ~actualBit) | (port & actualBit);
 
         port_reg.hardwareChange(port);
     } else {
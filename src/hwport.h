@@ -54,14 +54,20 @@ class HWPort: public Hardware, public TraceValueRegister {
         unsigned int portSize; //!< how much bits does this port have [1..8]
         unsigned char portMask; //!< mask out unused bits, if necessary
         bool portToggleFeature; //!< controls functionality of SetPin method (write to PIN toggles port register)
+        unsigned char calcPort; //!< port register at last CalcOutputs, to find changed pins
+        unsigned char calcDdr; //!< data direction register at last CalcOutputs, to find changed pins
         
     public:
         HWPort(AvrDevice *core, const std::string &name, bool portToggle = false, int size = 8);
         ~HWPort();
         
-        void CalcOutputs(void);  //!< Calculate the new output value to be transmitted to the environment
+        //! Calculate the new output value to be transmitted to the environment
+        /*! Only pins, for which the output state or the port or ddr bit is changed
+          or which are given in forced, are updated. */
+        void CalcOutputs(unsigned char forced = 0);
         std::string GetPortString(); //!< returns a string representation of output states
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         std::string GetName() { return myName; } //!< returns the port name as given in constructor
         Pin& GetPin(unsigned char pinNo); //!< returns a pin reference of pin with pin number
         int GetPortSize() { return portSize; } //!< returns, how much bits this port controls
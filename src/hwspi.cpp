@@ -32,6 +32,7 @@
 #include "traceval.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 //configuration
 #define SPIE 0x80
@@ -60,6 +61,7 @@ void HWSpi::spdr_access() {
     //data register
     spsr&=~(SPIF|WCOL);
     spsr_read=false;
+    SampleDirectValues();
     }
 }
 
@@ -89,6 +91,7 @@ void HWSpi::SetSPDR(unsigned char val) {
             clkcnt=0;
         }
     }
+    SampleDirectValues();
 }
 
 void HWSpi::updatePrescaler() {
@@ -107,6 +110,7 @@ void HWSpi::SetSPSR(unsigned char val) {
         spsr&=~SPI2X;
         spsr|=val&SPI2X;
         updatePrescaler();
+        SampleDirectValues();
     } else {
         ((core->trace_on) ?
             (traceOut) : (std::cerr))
@@ -159,6 +163,7 @@ void HWSpi::SetSPCR(unsigned char val) {
         SS.SetUseAlternateDdr(0);
     }
     updatePrescaler();
+    SampleDirectValues();
 }
 
 
@@ -194,12 +199,31 @@ void HWSpi::Reset() {
     SetSPCR(0);
     spsr=0;
     data_write=data_read=shift_in=0;
+    SampleDirectValues();
+}
+
+void HWSpi::Checkpoint(Snapshot &snap) {
+    snap.Section("spi");
+    snap.Value(shift_in);
+    snap.Value(data_read);
+    snap.Value(data_write);
+    snap.Value(spsr);
+    snap.Value(spcr);
+    snap.Value(clkdiv);
+    snap.Value(spsr_read);
+    snap.Value(oldsck);
+    snap.Value(bitcnt);
+    snap.Value(clkcnt);
+    snap.Value(spi_cycles);
+    snap.Value(finished);
+    SampleDirectValues();
 }
 
 void HWSpi::ClearIrqFlag(unsigned int vector) {
     if (vector==irq_vector) {
         spsr&=~SPIF;
         irq->ClearIrqFlag(irq_vector);
+        SampleDirectValues();
     } else {
         std::cerr << "WARNING: There is HWSPI called to get a irq vector which is not assigned for!?!?!?!?";
     }
@@ -345,6 +369,7 @@ unsigned int HWSpi::CpuCycle() {
         }
     }
     clkcnt++;
+    SampleDirectValues();
     return 0;
 }
 
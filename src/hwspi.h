@@ -110,6 +110,7 @@ class HWSpi: public Hardware, public TraceValueRegister {
         
         unsigned int CpuCycle() override;
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
     
         void SetSPDR(unsigned char val);
         void SetSPSR(unsigned char val); // it is read only! but we need it for rwmem-> only tell that we have an error 
@@ -27,35 +27,88 @@
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "snapshot.h"
+#include "flightrecorder.h"
 #include <assert.h>
 #include <cstdio>  // NULL
 
 
 HWStack::HWStack(AvrDevice *c):
     core(c),
+    stackLimit(0),
+    stackInData(false),
+    returnPointCount(0),
+    lowestReturnPoint(0),
     m_ThreadList(*c)
 {
     Reset();
 }
 
 void HWStack::Reset(void) {
-    returnPointList.clear();
+    ClearReturnPoints();
+    overflowReported = false;
+    stackInData = false;
     stackPointer = 0;
     lowestStackPointer = 0;
 }
 
-void HWStack::CheckReturnPoints() {
-    using I = std::multimap<unsigned long, std::function< void( uint32_t)> >::iterator;
-    std::pair<I,I> l = returnPointList.equal_range(stackPointer);
-    
-    for(I i = l.first; i != l.second; i++) {
-        (i->second)(stackPointer); //execute Funktor
+void HWStack::Checkpoint(Snapshot &snap) {
+    snap.Section("stack");
+    snap.Value(stackPointer);
+    snap.Value(lowestStackPointer);
+    // listeners belong to the stack frames before restore
+    if(snap.IsRestoring()) {
+        ClearReturnPoints();
+        StackPointerSet();
     }
-    returnPointList.erase(l.first, l.second);
 }
 
-void HWStack::SetReturnPoint(unsigned long stackPointer, std::function< void( uint32_t)> f) {
-    returnPointList.insert(std::make_pair(stackPointer, f));
+void HWStack::RunReturnPoints() {
+    // remove reached entries first, so a listener may set new return points
+    ReturnPoint reached[maxReturnPoints];
+    unsigned int reachedCount = 0, kept = 0;
+    lowestReturnPoint = UINT32_MAX;
+    for(unsigned int i = 0; i < returnPointCount; i++) {
+        if(returnPoints[i].stackPointer == stackPointer)
+            reached[reachedCount++] = returnPoints[i];
+        else {
+            if(returnPoints[i].stackPointer < lowestReturnPoint)
+                lowestReturnPoint = returnPoints[i].stackPointer;
+            returnPoints[kept++] = returnPoints[i];
+        }
+    }
+    returnPointCount = kept;
+
+    for(unsigned int i = 0; i < reachedCount; i++)
+        reached[i].listener->ReturnPointReached(stackPointer, reached[i].id);
+}
+
+void HWStack::StackOverflow() {
+    overflowReported = true;
+    avr_warning("stack overflow into data: SP=0x%x, static data ends at 0x%x",
+                (unsigned int)stackPointer, (unsigned int)stackLimit);
+    // the dump is long, only on request by a dump file
+    if(core->flightRecorder != NULL && core->flightRecorder->HasFile())
+        core->flightRecorder->Dump("stack overflow into data");
+}
+
+void HWStack::SetReturnPoint(unsigned long sp, ReturnPointListener *listener, unsigned int id) {
+    if(returnPointCount == maxReturnPoints) {
+        // handler, which never returned (e.g. task switch), drop the oldest
+        for(unsigned int i = 1; i < returnPointCount; i++)
+            returnPoints[i - 1] = returnPoints[i];
+        returnPointCount--;
+        lowestReturnPoint = UINT32_MAX;
+        for(unsigned int i = 0; i < returnPointCount; i++)
+            if(returnPoints[i].stackPointer < lowestReturnPoint)
+                lowestReturnPoint = returnPoints[i].stackPointer;
+    }
+    if(returnPointCount == 0 || sp < lowestReturnPoint)
+        lowestReturnPoint = sp;
+    ReturnPoint &rp = returnPoints[returnPointCount++];
+    rp.stackPointer = sp;
+    rp.listener = listener;
+    rp.id = id;
 }
 
 HWStackSram::HWStackSram(AvrDevice *core, int bs, bool initRE):
@@ -72,7 +125,9 @@ HWStackSram::HWStackSram(AvrDevice *core, int bs, bool initRE):
 }
 
 void HWStackSram::Reset() {
-    returnPointList.clear();
+    ClearReturnPoints();
+    overflowReported = false;
+    stackInData = false;
     if(initRAMEND)
         stackPointer = core->GetMemIRamSize() +
                        core->GetMemIOSize() +
@@ -98,6 +153,7 @@ void HWStackSram::Push(unsigned char val) {
     // measure stack usage, calculate lowest stack pointer
     if(lowestStackPointer > stackPointer)
         lowestStackPointer = stackPointer;
+    CheckStackLimit();
 }
 
 unsigned char HWStackSram::Pop() {
@@ -150,6 +206,7 @@ void HWStackSram::SetSpl(unsigned char val) {
     if(oldSP != stackPointer)
         m_ThreadList.OnSPWrite(stackPointer);
     CheckReturnPoints();
+    StackPointerSet();
 }
 
 void HWStackSram::SetSph(unsigned char val) {
@@ -167,6 +224,7 @@ void HWStackSram::SetSph(unsigned char val) {
     if(oldSP != stackPointer)
         m_ThreadList.OnSPWrite(stackPointer);
     CheckReturnPoints();
+    StackPointerSet();
 }
 
 unsigned char HWStackSram::GetSph() {
@@ -195,9 +253,17 @@ ThreeLevelStack::~ThreeLevelStack() {
 }
 
 void ThreeLevelStack::Reset(void) {
-    returnPointList.clear();
+    ClearReturnPoints();
     stackPointer = 3;
     lowestStackPointer = stackPointer;
+    SampleDirectValues();
+}
+
+void ThreeLevelStack::Checkpoint(Snapshot &snap) {
+    HWStack::Checkpoint(snap);
+    for(int i = 0; i < 3; i++)
+        snap.Value(stackArea[i]);
+    SampleDirectValues();
 }
 
 void ThreeLevelStack::Push(unsigned char val) {
@@ -215,10 +281,14 @@ void ThreeLevelStack::PushAddr(unsigned long addr) {
     stackArea[0] = addr;
     if(stackPointer > 0)
         stackPointer--;
+    SampleDirectValues();
     if(lowestStackPointer > stackPointer)
         lowestStackPointer = stackPointer;
-    if(stackPointer == 0)
+    if(stackPointer == 0) {
         avr_warning("stack overflow");
+        if(core->flightRecorder != NULL)
+            core->flightRecorder->Dump("stack overflow");
+    }
 }
 
 unsigned long ThreeLevelStack::PopAddr() {
@@ -230,6 +300,7 @@ unsigned long ThreeLevelStack::PopAddr() {
         stackPointer = 3;
         avr_warning("stack underflow");
     }
+    SampleDirectValues();
     return val;
 }
 
@@ -31,8 +31,7 @@
 #include "avrdevice.h"
 #include "traceval.h"
 
-#include <map>
-#include <functional>
+#include <stdint.h>
 
 /** A thread automatically detected in simulated program.
 * We keep track of them in core->stack.m_ThreadList.m_threads[] and
@@ -86,6 +85,14 @@ public:
     unsigned int GetCount() const;
 };
 
+//! Listener, which is informed, if the stack pointer comes back to a return point
+class ReturnPointListener {
+    public:
+        virtual ~ReturnPointListener() {}
+        //! Called once, if stack pointer reaches the registered value again
+        virtual void ReturnPointReached(uint32_t stackPointer, unsigned int id) = 0;
+};
+
 //! Implements a stack register with stack logic
 /*! This is the base class for all 2 different stack types. It holds the interface
     for pushing and poping bytes and addresses from stack by core and for interrupt */
@@ -95,10 +102,37 @@ class HWStack {
         AvrDevice *core; //!< Link to device
         uint32_t stackPointer; //!< current value of stack pointer
         uint32_t lowestStackPointer; //!< marker: lowest stackpointer used by program
-        std::multimap<unsigned long, std::function<void(uint32_t /*stack ptr*/ )> > returnPointList; //!< Maps adresses to listeners for return addresses
-
-        /// Run functions registered for current stack address and delete them
-        void CheckReturnPoints();
+        uint32_t stackLimit; //!< lowest address, which may be used by stack, 0 if there is no limit
+        bool overflowReported; //!< stack overflow below stackLimit is already reported
+        bool stackInData; //!< SP was set below stackLimit by program, e.g. stack of a RTOS task in .bss
+        //! A registered return point, see SetReturnPoint
+        struct ReturnPoint {
+            uint32_t stackPointer;
+            ReturnPointListener *listener;
+            unsigned int id;
+        };
+        //! Maximum number of return points, if more are set, the oldest is dropped
+        static const unsigned int maxReturnPoints = 32;
+        ReturnPoint returnPoints[maxReturnPoints]; //!< return points in order of registration
+        unsigned int returnPointCount; //!< number of used entries in returnPoints
+        uint32_t lowestReturnPoint; //!< lowest stack pointer in returnPoints, if returnPointCount > 0
+
+        /// Run listeners registered for current stack address and delete them
+        void CheckReturnPoints() {
+            // a ordinary push or pop below all return points needs no lookup
+            if(returnPointCount != 0 && stackPointer >= lowestReturnPoint)
+                RunReturnPoints();
+        }
+        void RunReturnPoints();
+        void ClearReturnPoints() { returnPointCount = 0; }
+        /// Check on push, that stack doesn't grow from above stackLimit into static data
+        void CheckStackLimit() {
+            if(stackPointer + 1 < stackLimit && !stackInData && !overflowReported)
+                StackOverflow();
+        }
+        /// Selects the stack region after SP was set, a stack in static data isn't checked
+        void StackPointerSet() { stackInData = stackPointer + 1 < stackLimit; }
+        void StackOverflow();
         
     public:
         ThreadList m_ThreadList;  ///< List of known threads created within target.
@@ -112,15 +146,25 @@ class HWStack {
         virtual unsigned long PopAddr()=0; //!< Pops a address from stack
 
         virtual void Reset(); //!< Resets stack pointer and listener table
+        //! Saves or restores stack pointer, clears listener table on restore
+        virtual void Checkpoint(Snapshot &snap);
 
         //! Returns current stack pointer value
         unsigned long GetStackPointer() const { return stackPointer; }
         //! Sets current stack pointer value (used by GDB interface)
-        void SetStackPointer(unsigned long val) { stackPointer = val; }
+        void SetStackPointer(unsigned long val) { stackPointer = val; StackPointerSet(); }
 
         //! Subscribes a Listener for a return address
-        void SetReturnPoint(unsigned long stackPointer, std::function< void( uint32_t)> f);
+        /*! The listener is called with id, if the stack pointer becomes stackPointer again. */
+        void SetReturnPoint(unsigned long stackPointer, ReturnPointListener *listener, unsigned int id);
         
+        //! Sets lowest address, which may be used by stack (end of static data), 0 for no limit
+        /*! If a push lets the stack grow below, a warning is given and the
+          flight recorder of the core is dumped, if it writes dumps to a file.
+          A stack, which the program has placed in static data by setting SP,
+          isn't checked, till SP is set above the limit again. */
+        void SetStackLimit(unsigned long limit) { stackLimit = limit; overflowReported = false; StackPointerSet(); }
+
         //! Sets lowest stack marker back to current stackpointer
         void ResetLowestStackpointer(void) { lowestStackPointer = stackPointer; }
         //! Gets back the lowest stack pointer (for measuring stack usage)
@@ -171,6 +215,7 @@ class ThreeLevelStack: public HWStack, public TraceValueRegister {
         unsigned long PopAddr() override;
 
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "hwtimer.h"
 #include "../helper.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 #include <cstdlib>
 #include <time.h>
@@ -197,6 +198,7 @@ void BasicTimerUnit::SetClockMode(int mode) {
     cs = mode;
     if(cs != 0) {
         core->AddToCycleList(this);
+        core->RescheduleHardware(this);
     } else {
         core->RemoveFromCycleList(this);
     }
@@ -566,6 +568,35 @@ void BasicTimerUnit::Reset() {
     icapNoiseCanceler = false;
 }
 
+void BasicTimerUnit::Checkpoint(Snapshot &snap) {
+    snap.Section("timer");
+    snap.Value(cs);
+    snap.Value(captureInputState);
+    snap.Value(icapNCcounter);
+    snap.Value(icapNCstate);
+    snap.Value(vtcnt);
+    snap.Value(vlast_tcnt);
+    snap.Value(updown_counting);
+    snap.Value(count_down);
+    snap.Value(limit_bottom);
+    snap.Value(limit_top);
+    snap.Value(limit_max);
+    snap.Value(icapRegister);
+    snap.Value(icapRisingEdge);
+    snap.Value(icapNoiseCanceler);
+    snap.Value(wgm);
+    snap.Value(compare);
+    snap.Value(compare_dbl);
+    snap.Value(compareEnable);
+    snap.Value(com);
+    snap.Value(compare_output_state);
+    premx->Checkpoint(snap);
+    if(icapSource != NULL)
+        icapSource->Checkpoint(snap);
+    if(snap.IsRestoring())
+        counterTrace->change(vtcnt);
+}
+
 unsigned int BasicTimerUnit::CpuCycle() {
     if(premx->isClock(cs))
         CountTimer();
@@ -573,6 +604,13 @@ unsigned int BasicTimerUnit::CpuCycle() {
     return 0;
 }
 
+unsigned int BasicTimerUnit::GetIdleCycles() {
+    // input capture source has to be polled on every cycle
+    if(icapSource != NULL)
+        return 0;
+    return premx->GetIdleCycles(cs);
+}
+
 void BasicTimerUnit::RegisterACompForICapture(HWAcomp *acomp) {
     if(icapSource != NULL)
         icapSource->RegisterAComp(acomp);
@@ -770,6 +808,11 @@ void HWTimer16::Reset(void) {
     accessTempRegister = 0;
 }
 
+void HWTimer16::Checkpoint(Snapshot &snap) {
+    BasicTimerUnit::Checkpoint(snap);
+    snap.Value(accessTempRegister);
+}
+
 void HWTimer16::SetCompareRegister(int idx, bool high, unsigned char val) {
     unsigned long temp;
     if(high) {
@@ -936,6 +979,11 @@ void HWTimer8_0C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_0C::Checkpoint(Snapshot &snap) {
+    HWTimer8::Checkpoint(snap);
+    snap.Value(tccr_val);
+}
+
 HWTimer8_1C::HWTimer8_1C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -971,6 +1019,11 @@ void HWTimer8_1C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_1C::Checkpoint(Snapshot &snap) {
+    HWTimer8::Checkpoint(snap);
+    snap.Value(tccr_val);
+}
+
 HWTimer8_2C::HWTimer8_2C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -1041,6 +1094,13 @@ void HWTimer8_2C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer8_2C::Checkpoint(Snapshot &snap) {
+    HWTimer8::Checkpoint(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_1C::HWTimer16_1C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1104,6 +1164,13 @@ void HWTimer16_1C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_1C::Checkpoint(Snapshot &snap) {
+    HWTimer16::Checkpoint(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_2C2::HWTimer16_2C2(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1185,6 +1252,13 @@ void HWTimer16_2C2::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_2C2::Checkpoint(Snapshot &snap) {
+    HWTimer16::Checkpoint(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_2C3::HWTimer16_2C3(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1245,6 +1319,12 @@ void HWTimer16_2C3::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_2C3::Checkpoint(Snapshot &snap) {
+    HWTimer16::Checkpoint(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+}
+
 HWTimer16_3C::HWTimer16_3C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1311,6 +1391,12 @@ void HWTimer16_3C::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_3C::Checkpoint(Snapshot &snap) {
+    HWTimer16::Checkpoint(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+}
+
 //! Step time in ns for async clock by pll
 /*! Because system clock steps are counted in ns, we have to calculate so many steps to get
  * over all steps a time in ns without fraction. For 64MHz, e.g. 15,625 ns period, this step
@@ -1416,6 +1502,48 @@ void HWTimerTinyX5::Reset() {
     SetPrescalerClock(false); // reset prescaler to sync. clock mode, if necessary!
 }
 
+void HWTimerTinyX5::Checkpoint(Snapshot &snap) {
+    snap.Section("timertinyx5");
+    snap.Value(counter);
+    snap.Value(prescaler);
+    snap.Value(dtprescaler);
+    tccr_inout_val.Checkpoint(snap);
+    ocra_inout_val.Checkpoint(snap);
+    ocrb_inout_val.Checkpoint(snap);
+    ocrc_inout_val.Checkpoint(snap);
+    gtccr_in_val.Checkpoint(snap);
+    snap.Value(dtps1_inout_val);
+    dt1a_inout_val.Checkpoint(snap);
+    dt1b_inout_val.Checkpoint(snap);
+    snap.Value(tcnt_out_val);
+    snap.Value(tcnt_out_async_tmp);
+    snap.Value(tcnt_in_val);
+    snap.Value(tcnt_set_flag);
+    snap.Value(tov_internal_flag);
+    snap.Value(tocra_internal_flag);
+    snap.Value(tocrb_internal_flag);
+    snap.Value(ocra_internal_val);
+    snap.Value(ocra_compare);
+    ocra_unit.Checkpoint(snap);
+    snap.Value(ocrb_internal_val);
+    snap.Value(ocrb_compare);
+    ocrb_unit.Checkpoint(snap);
+    snap.Value(cfg_prescaler);
+    snap.Value(cfg_dtprescaler);
+    snap.Value(cfg_mode);
+    snap.Value(cfg_ctc);
+    snap.Value(cfg_com_a);
+    snap.Value(cfg_com_b);
+    snap.Value(asyncClock_step);
+    snap.Value(asyncClock_async);
+    snap.Value(asyncClock_lsm);
+    snap.Value(asyncClock_pll);
+    snap.Value(asyncClock_plllock);
+    snap.Value(asyncClock_locktime);
+    // in async mode the timer is stepped by the system clock
+    SystemClock::Instance().CheckpointMember(snap, this);
+}
+
 int HWTimerTinyX5::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
     if(asyncClock_async) {
         *nextStepIn_ns = HWTimerTinyX5_nextdelay[asyncClock_step];
@@ -1766,6 +1894,20 @@ void TimerTinyX5_OCR::Reset() {
     dtCounter = 0;
 }
 
+void TimerTinyX5_OCR::Checkpoint(Snapshot &snap) {
+    snap.Value(ocrComMode);
+    snap.Value(ocrPWM);
+    snap.Value(ocrOut);
+    snap.Value(dtHigh);
+    snap.Value(dtLow);
+    snap.Value(dtCounter);
+}
+
+void HWTimerTinyX5_SyncReg::Checkpoint(Snapshot &snap) {
+    snap.Value(inValue);
+    snap.Value(regValue);
+}
+
 void TimerTinyX5_OCR::DTClockCycle() {
     if(dtCounter > 0) {
         dtCounter--;
@@ -77,9 +77,13 @@ class BasicTimerUnit: public Hardware, public TraceValueRegister {
         ~BasicTimerUnit();
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
         
         //! Process timer/counter unit operations by CPU cycle
         unsigned int CpuCycle() override;
+        //! Timer is idle till next prescaler clock, if input capture isn't used
+        unsigned int GetIdleCycles() override;
 
         //! register analog comparator unit for input capture source
         void RegisterACompForICapture(HWAcomp *acomp);
@@ -332,6 +336,8 @@ class HWTimer16: public BasicTimerUnit {
                   ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 8Bit counter and no output compare unit
@@ -363,6 +369,8 @@ class HWTimer8_0C: public HWTimer8 {
                     IRQLine* tov);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 8Bit counter and one output compare unit
@@ -395,6 +403,8 @@ class HWTimer8_1C: public HWTimer8 {
                     PinAtPort* outA);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 8Bit counter and 2 output compare unit
@@ -449,6 +459,8 @@ class HWTimer8_2C: public HWTimer8 {
                     PinAtPort* outB);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 16Bit counter and one output compare unit
@@ -503,6 +515,8 @@ class HWTimer16_1C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units and 2 config registers
@@ -565,6 +579,8 @@ class HWTimer16_2C2: public HWTimer16 {
                       bool is_at8515);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units, but 3 config registers
@@ -628,6 +644,8 @@ class HWTimer16_2C3: public HWTimer16 {
                       ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Timer unit with 16Bit counter and 3 output compare units
@@ -693,6 +711,8 @@ class HWTimer16_3C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! PWM output unit for timer 1 on ATtiny25/45/85
@@ -722,6 +742,8 @@ class TimerTinyX5_OCR {
 
         //! Reset internal states on device reset
         void Reset();
+        //! Save or restore internal states, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
 
         //! Run one clock cycle from dead time prescaler
         void DTClockCycle();
@@ -768,6 +790,8 @@ class HWTimerTinyX5_SyncReg {
 
         //! Mask out a value inside sync area and do not force a change event
         void MaskOutSync(unsigned char mask) { inValue &= ~mask; regValue = inValue; }
+        //! Save or restore both register values, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
 };
 
 //! timer unit for timer 1 on ATtiny25/45/85
@@ -935,6 +959,8 @@ class HWTimerTinyX5: public Hardware,
         int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) override;
         //! Perform a reset of this unit
         void Reset() override;
+        //! Save or restore state of this unit
+        void Checkpoint(Snapshot &snap) override;
         //! Process timer/counter unit operations by CPU cycle
         unsigned int CpuCycle() override;
 };
@@ -25,6 +25,7 @@
 
 #include "icapturesrc.h"
 #include "hwacomp.h"
+#include "snapshot.h"
 
 ICaptureSource::ICaptureSource(PinAtPort cp):
     capturePin(cp),
@@ -38,3 +39,7 @@ bool ICaptureSource::GetSourceState(void) {
         return (bool)capturePin;
 }
         
+
+void ICaptureSource::Checkpoint(Snapshot &snap) {
+    snap.Value(acic);
+}
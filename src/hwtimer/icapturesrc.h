@@ -29,6 +29,7 @@
 #include "../pinatport.h"
 
 class HWAcomp;
+class Snapshot;
 
 //! Class, which provides input capture source for 16bit timers
 class ICaptureSource {
@@ -50,6 +51,9 @@ class ICaptureSource {
 
         //! Reflect ACIC flag state
         void SetACIC(bool _acic) { acic = _acic; }
+
+        //! Save or restore ACIC flag, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
 };
 
 #endif
@@ -25,6 +25,7 @@
 
 #include "prescalermux.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 PrescalerMultiplexer::PrescalerMultiplexer(HWPrescaler *ps):
     prescaler(ps) {}
@@ -62,6 +63,16 @@ bool PrescalerMultiplexer::isClock(unsigned int cs) {
     }
 }
 
+unsigned int PrescalerMultiplexer::GetIdleCycles(unsigned int cs) {
+    static const unsigned int divider[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+    if(cs == 0)
+        return Hardware::idleForever;
+    if(cs > 7)
+        return 0; // let isClock report the error
+    return prescaler->GetIdleCyclesForDivider(divider[cs]);
+}
+
 PrescalerMultiplexerExt::PrescalerMultiplexerExt(HWPrescaler *ps, PinAtPort pi):
     PrescalerMultiplexer(ps),
     clkpin(pi) {
@@ -105,6 +116,20 @@ bool PrescalerMultiplexerExt::isClock(unsigned int cs) {
     }
 }
 
+unsigned int PrescalerMultiplexerExt::GetIdleCycles(unsigned int cs) {
+    static const unsigned int divider[6] = { 0, 1, 8, 64, 256, 1024 };
+
+    if(cs == 0)
+        return Hardware::idleForever;
+    if(cs > 5)
+        return 0; // poll count pin or let isClock report the error
+    return prescaler->GetIdleCyclesForDivider(divider[cs]);
+}
+
+void PrescalerMultiplexerExt::Checkpoint(Snapshot &snap) {
+    snap.Value(clkpin_old);
+}
+
 PrescalerMultiplexerT15::PrescalerMultiplexerT15(HWPrescaler *ps):
     PrescalerMultiplexer(ps) {}
 
@@ -44,6 +44,11 @@ class PrescalerMultiplexer {
         //! @param cs multiplexer select value
         //! @return true, if a clock event occured
         virtual bool isClock(unsigned int cs);
+        //! Returns count of following cycles without clock event, see Hardware::GetIdleCycles
+        //! @param cs multiplexer select value
+        virtual unsigned int GetIdleCycles(unsigned int cs);
+        //! Saves or restores state of multiplexer, see Hardware::Checkpoint
+        virtual void Checkpoint(Snapshot &snap) {}
     
 };
 
@@ -61,6 +66,8 @@ class PrescalerMultiplexerExt: public PrescalerMultiplexer {
         //! Creates a multiplexer instance with a count input pin, connected with prescaler
         PrescalerMultiplexerExt(HWPrescaler *ps, PinAtPort pi);
         bool isClock(unsigned int cs) override;
+        unsigned int GetIdleCycles(unsigned int cs) override;
+        void Checkpoint(Snapshot &snap) override;
     
 };
 
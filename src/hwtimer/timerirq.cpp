@@ -26,6 +26,7 @@
 #include "timerirq.h"
 #include "helper.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 IRQLine::IRQLine(const std::string& n, int irqvec):
     irqvector(irqvec),
@@ -115,6 +116,12 @@ void TimerIRQRegister::Reset(void) {
     tifr_reg.Reset();
 }
 
+void TimerIRQRegister::Checkpoint(Snapshot &snap) {
+    snap.Section("timerirq");
+    snap.Value(irqmask);
+    snap.Value(irqflags);
+}
+
 unsigned char TimerIRQRegister::set_from_reg(const IOSpecialReg* reg, unsigned char nv) {
     if(reg == &timsk_reg) {
         // mask register: trigger interrupt, if mask bit is new set and flag is true
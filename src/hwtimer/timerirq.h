@@ -79,6 +79,7 @@ class TimerIRQRegister: public Hardware, public IOSpecialRegClient, public Trace
         
         void ClearIrqFlag(unsigned int vector) override;
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
         
         unsigned char set_from_reg(const IOSpecialReg* reg, unsigned char nv) override;
         unsigned char get_from_client(const IOSpecialReg* reg, unsigned char v) override;
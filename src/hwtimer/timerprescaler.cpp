@@ -25,15 +25,17 @@
 
 #include "timerprescaler.h"
 #include "traceval.h"
+#include "snapshot.h"
 
 HWPrescaler::HWPrescaler(AvrDevice *core, const std::string &tracename):
     Hardware(core),
     _resetBit(-1),
     _resetSyncBit(-1),
+    core(core),
     countEnable(true)
 {
     core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    preScaleTrace = trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
     resetRegister = NULL;
 }
 
@@ -44,10 +46,11 @@ HWPrescaler::HWPrescaler(AvrDevice *core,
     Hardware(core),
     _resetBit(resetBit),
     _resetSyncBit(-1),
+    core(core),
     countEnable(true)
 {
     core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    preScaleTrace = trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
     resetRegister = ioreg;
     ioreg->connectSRegClient(this);
 }
@@ -60,14 +63,49 @@ HWPrescaler::HWPrescaler(AvrDevice *core,
     Hardware(core),
     _resetBit(resetBit),
     _resetSyncBit(resetSyncBit),
+    core(core),
     countEnable(true)
 {
     core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    preScaleTrace = trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
     resetRegister = ioreg;
     ioreg->connectSRegClient(this);
 }
 
+unsigned int HWPrescaler::GetIdleCycles() {
+    // trace has to see every counter change
+    if(preScaleTrace->enabled())
+        return 0;
+    return idleForever;
+}
+
+void HWPrescaler::SkipCpuCycles(unsigned int cycles) {
+    if(countEnable)
+        preScaleValue = (preScaleValue + cycles) % 1024;
+    preScaleTrace->sample();
+}
+
+unsigned int HWPrescaler::GetIdleCyclesForDivider(unsigned int divider) {
+    if(!countEnable)
+        return 0;
+    // value is counted up on next cycle before it is checked
+    return divider - 1 - (GetValue() % divider);
+}
+
+void HWPrescaler::Reset() {
+    // timers, which wait for a prescaler clock, have to check again
+    core->RescheduleAllHardware();
+    preScaleValue = 0;
+    preScaleTrace->sample();
+}
+
+void HWPrescaler::Checkpoint(Snapshot &snap) {
+    snap.Section("prescaler");
+    snap.Value(preScaleValue);
+    snap.Value(countEnable);
+    preScaleTrace->sample();
+}
+
 unsigned char HWPrescaler::set_from_reg(const IOSpecialReg *reg, unsigned char nv) {
     // check, if this is the right register
     if(reg != resetRegister) return nv;
@@ -79,7 +117,7 @@ unsigned char HWPrescaler::set_from_reg(const IOSpecialReg *reg, unsigned char n
         sync = (1 << _resetSyncBit) & nv;
     
     if(reset) {
-        Reset();  // reset requested
+        Reset();  // reset requested, reschedules also countEnable change
         if(sync)
             countEnable = false; // sync asserted, stop counting
         else {
@@ -135,13 +173,38 @@ unsigned int HWPrescalerAsync::CpuCycle() {
     if(e && countEnable) {
       preScaleValue++;
       if(preScaleValue > 1023) preScaleValue = 0;
+      preScaleTrace->sample();
     }
     return 0;
 }
 
+unsigned int HWPrescalerAsync::GetIdleCycles() {
+    if(clockselect)
+        return 0; // poll oscillator pin
+    return HWPrescaler::GetIdleCycles();
+}
+
+void HWPrescalerAsync::SkipCpuCycles(unsigned int cycles) {
+    if(!clockselect)
+        HWPrescaler::SkipCpuCycles(cycles);
+}
+
+unsigned int HWPrescalerAsync::GetIdleCyclesForDivider(unsigned int divider) {
+    if(clockselect)
+        return 0;
+    return HWPrescaler::GetIdleCyclesForDivider(divider);
+}
+
+void HWPrescalerAsync::Checkpoint(Snapshot &snap) {
+    HWPrescaler::Checkpoint(snap);
+    snap.Value(pinstate);
+    snap.Value(clockselect);
+}
+
 unsigned char HWPrescalerAsync::set_from_reg(const IOSpecialReg *reg, unsigned char nv) {
     unsigned char v = HWPrescaler::set_from_reg(reg, nv);
     if(reg != asyncRegister) return v;
+    core->RescheduleAllHardware();
     if((1 << clockSelectBit) & v) {
         clockselect = true;
         //tosc_pin.SetAlternatePort(true);
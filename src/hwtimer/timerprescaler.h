@@ -41,8 +41,10 @@ class HWPrescaler: public Hardware, public IOSpecialRegClient {
         int _resetSyncBit; //!< holds sync bit position for prescaler reset synchronisation
         
     protected:
+        AvrDevice *core; //!< pointer to device core
         IOSpecialReg* resetRegister; //!< instance of IO register with reset bits
         unsigned short preScaleValue; //!< prescaler counter value
+        TraceValue *preScaleTrace; //!< trace value for preScaleValue
         bool countEnable;  //!< enables counting of prescaler (for reset sync)
         //! IO register interface set method, see IOSpecialRegClient
         unsigned char set_from_reg(const IOSpecialReg *reg, unsigned char nv) override;
@@ -69,13 +71,24 @@ class HWPrescaler: public Hardware, public IOSpecialRegClient {
             if(countEnable) {
               preScaleValue++;
               if(preScaleValue > 1023) preScaleValue = 0;
+              preScaleTrace->sample();
             }
             return 0;
         }
+        //! Prescaler counts lazy, if counter value isn't traced
+        unsigned int GetIdleCycles() override;
+        //! Catch up counter value for skipped cycles
+        void SkipCpuCycles(unsigned int cycles) override;
         //! Get method for current prescaler counter value
-        unsigned short GetValue() { return preScaleValue; }
+        unsigned short GetValue() { core->SyncHardware(this); return preScaleValue; }
+        //! Returns count of following cycles, till counter value is a multiple of divider, minus one
+        /*! Returns 0, if this isn't predictable, for example, if prescaler is
+          stopped or counts a external clock. */
+        virtual unsigned int GetIdleCyclesForDivider(unsigned int divider);
         //! Reset method, sets prescaler counter to 0
-        void Reset() override { preScaleValue = 0; }
+        void Reset() override;
+        //! Save or restore prescaler counter
+        void Checkpoint(Snapshot &snap) override;
 };
 
 //! Extends HWPrescaler with a external clock oszillator pin
@@ -103,6 +116,10 @@ class HWPrescalerAsync: public HWPrescaler {
                          int resetSyncBit);
         //! Count functionality for prescaler
         unsigned int CpuCycle() override;
+        unsigned int GetIdleCycles() override;
+        void SkipCpuCycles(unsigned int cycles) override;
+        unsigned int GetIdleCyclesForDivider(unsigned int divider) override;
+        void Checkpoint(Snapshot &snap) override;
         
     protected:
         //! IO register interface set method, see IOSpecialRegClient
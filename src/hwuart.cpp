@@ -25,6 +25,8 @@
 
 #include "hwuart.h"
 #include "helper.h"
+#include "avrdevice.h"
+#include "snapshot.h"
 
 //usr & ucsra
 #define RXC 0x80
@@ -67,7 +69,7 @@ void HWUart::SetUdr(unsigned char val) {
             irqSystem->ClearIrqFlag(vectorUdre);
         }
     }
-
+    SampleDirectValues();
 } 
 
 void HWUart::SetUsr(unsigned char val) { 
@@ -87,14 +89,19 @@ void HWUart::SetUsr(unsigned char val) {
 
     CheckForNewSetIrq(setnew);
     CheckForNewClearIrq(clearnew);
+    SampleDirectValues();
 } 
 
 void HWUart::SetUbrr(unsigned char val) {
+    core->RescheduleHardware(this);
     ubrr = (ubrr & 0xff00) | val;
+    SampleDirectValues();
 }
 
 void HWUart::SetUbrrhi(unsigned char val) {
+    core->RescheduleHardware(this);
     ubrr = (ubrr & 0xff) | ((val & 0xf) << 8);
+    SampleDirectValues();
 }
 
 void HWUart::SetFrameLengthFromRegister() {
@@ -124,6 +131,7 @@ void HWUart::SetFrameLengthFromRegister() {
 }
 
 void HWUart::SetUcr(unsigned char val) { 
+    core->RescheduleHardware(this);
     unsigned char ucrold=ucr;
     ucr=val;
     SetFrameLengthFromRegister();
@@ -165,6 +173,7 @@ void HWUart::SetUcr(unsigned char val) {
 
     CheckForNewSetIrq(setnew);
     CheckForNewClearIrq(clearnew);
+    SampleDirectValues();
 }
 
 unsigned int HWUart::CpuCycle() {
@@ -173,6 +182,7 @@ unsigned int HWUart::CpuCycle() {
         baudCnt = 0;
         CpuCycleRx();
         CpuCycleTx();
+        SampleDirectValues();
     }
 
     // controling read sequence down counter
@@ -182,6 +192,38 @@ unsigned int HWUart::CpuCycle() {
     return 0;
 }
 
+unsigned int HWUart::GetIdleCycles() {
+    if(regSeq > 0)
+        return 0;
+
+    // count of baud clocks till the next one, which has to be processed
+    unsigned int clocks;
+    if(ucr & RXEN)
+        clocks = 1; // receiver samples on every baud clock
+    else if(ucr & TXEN)
+        clocks = 16 - baudCnt16; // transmitter works on every 16th baud clock
+    else
+        return idleForever; // baud clocks do nothing but counting
+
+    if(baudCnt >= ubrr)
+        return (clocks - 1) * (ubrr + 1);
+    return (ubrr - baudCnt) + (clocks - 1) * (ubrr + 1);
+}
+
+void HWUart::SkipCpuCycles(unsigned int cycles) {
+    unsigned long long cnt = (unsigned long long)baudCnt + cycles;
+    unsigned long long clocks = 0;
+    if(baudCnt > ubrr) {
+        // ubrr was decreased below baudCnt, next cycle is a baud clock
+        cnt = cycles - 1;
+        clocks = 1;
+    }
+    clocks += cnt / (ubrr + 1);
+    baudCnt = cnt % (ubrr + 1);
+    baudCnt16 = (baudCnt16 + clocks) % 16;
+    regSeq = (regSeq > cycles) ? regSeq - cycles : 0;
+}
+
 unsigned int HWUart::CpuCycleRx() {
     // receiver part
     //
@@ -532,6 +574,7 @@ HWUart::HWUart(AvrDevice *core,
                int instance_id):
     Hardware(core),
     TraceValueRegister(core, "UART" + int2str(instance_id)),
+    core(core),
     irqSystem(s),
     pinTx(tx),
     pinRx(rx),
@@ -574,6 +617,7 @@ unsigned char HWUart::GetUdr() {
         if (ucr & RXC) {
             irqSystem->ClearIrqFlag(vectorRx); // and clear interrupt flag
         }    
+        SampleDirectValues();
     }
     return udrRead;
 }
@@ -588,6 +632,7 @@ void HWUart::ClearIrqFlag(unsigned int vector){
     if (vector == vectorTx) {
         usr&=0xff-TXC;
         irqSystem->ClearIrqFlag( vectorTx);
+        SampleDirectValues();
     }
 }
 
@@ -619,6 +664,33 @@ void HWUart::Reset() {
     txState = TX_FIRST_RUN;
 
     SetFrameLengthFromRegister(); 
+    SampleDirectValues();
+}
+
+void HWUart::Checkpoint(Snapshot &snap) {
+    snap.Section("uart");
+    snap.Value(udrWrite);
+    snap.Value(udrRead);
+    snap.Value(usr);
+    snap.Value(ucr);
+    snap.Value(ucsrc);
+    snap.Value(ubrr);
+    snap.Value(readParity);
+    snap.Value(writeParity);
+    snap.Value(frameLength);
+    snap.Value(regSeq);
+    snap.Value(baudCnt);
+    snap.Value(rxState);
+    snap.Value(txState);
+    snap.Value(cntRxSamples);
+    snap.Value(rxLowCnt);
+    snap.Value(rxHighCnt);
+    snap.Value(rxDataTmp);
+    snap.Value(rxBitCnt);
+    snap.Value(baudCnt16);
+    snap.Value(txDataTmp);
+    snap.Value(txBitCnt);
+    SampleDirectValues();
 }
 
 // implementation of HWUsart
@@ -640,6 +712,8 @@ unsigned char HWUsart::GetUcsrc() { return ucsrc; }
 
 unsigned char HWUsart::GetUcsrcUbrrh() {
     if(regSeq == 0) {
+        // start read sequence down counter
+        core->RescheduleHardware(this);
         regSeq = 2;
         return GetUbrrhi();
     } else {
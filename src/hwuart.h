@@ -50,6 +50,7 @@ class HWUart: public Hardware, public TraceValueRegister {
 
         int frameLength;        //!< Hold length of UART frame
 
+        AvrDevice *core;        //!< Connection to device core
         HWIrqSystem *irqSystem; //!< Connection to interrupt system
 
         PinAtPort pinTx;        //!< TX pin
@@ -113,8 +114,13 @@ class HWUart: public Hardware, public TraceValueRegister {
                unsigned int tx_interrupt,
                int instance_id = 0);
         unsigned int CpuCycle() override;
+        //! UART is idle till next baud clock, which has something to do
+        unsigned int GetIdleCycles() override;
+        //! Catch up baud counters for skipped cycles
+        void SkipCpuCycles(unsigned int cycles) override;
 
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
 
         void SetUdr(unsigned char val);  
         void SetUsr(unsigned char val);  
@@ -28,10 +28,12 @@
 #include "avrerror.h"
 #include "hwtimer.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 void HWUSI::SetUSIDR(unsigned char val) {
     shift_data = val;
     setDout();
+    SampleDirectValues();
 }
 
 unsigned char HWUSI::GetUSISR(void) {
@@ -62,6 +64,7 @@ void HWUSI::SetUSISR(unsigned char val) {
     /* reset stop flag */
     if((val & 0x20) == 0x20) /* reset USIPF */
         flag_stop = false;
+    SampleDirectValues();
 }
 
 void HWUSI::SetUSICR(unsigned char val) {
@@ -138,12 +141,14 @@ void HWUSI::doCount(void) {
                 irq->SetIrqFlag(this, irq_ovr);
             }
         }
+        SampleDirectValues();
     }
 }
 
 void HWUSI::doShift(void) {
     unsigned char di = (bool)DI ? 1 : 0;
     shift_data = ((shift_data << 1) | di) & 0xff;
+    SampleDirectValues();
 }
 
 void HWUSI::setDout(void) {
@@ -252,6 +257,33 @@ void HWUSI::Reset() {
     /* reset port pin states */
     controlDO(false);
     controlTWI(false);
+    SampleDirectValues();
+}
+
+void HWUSI::Checkpoint(Snapshot &snap) {
+    snap.Section("usi");
+    snap.Value(shift_data);
+    snap.Value(control_data);
+    snap.Value(sck_state);
+    snap.Value(sck_port);
+    snap.Value(sck_ddr);
+    snap.Value(di_state);
+    snap.Value(di_port);
+    snap.Value(di_ddr);
+    snap.Value(scl_hold);
+    snap.Value(irqen_start);
+    snap.Value(irqactive_start);
+    snap.Value(irqen_ovr);
+    snap.Value(irqactive_ovr);
+    snap.Value(flag_stop);
+    snap.Value(flag_dcol);
+    snap.Value(wire_mode);
+    snap.Value(clock_mode);
+    snap.Value(counter_data);
+    snap.Value(is_DI_change);
+    // a pending pin change is done by Step
+    SystemClock::Instance().CheckpointMember(snap, this);
+    SampleDirectValues();
 }
 
 int HWUSI::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
@@ -382,6 +414,11 @@ void HWUSI_BR::Reset() {
     HWUSI::Reset();
 }
 
+void HWUSI_BR::Checkpoint(Snapshot &snap) {
+    HWUSI::Checkpoint(snap);
+    snap.Value(buffer_data);
+}
+
 void HWUSI_BR::setDataBuffer(unsigned char data) {
     buffer_data = data;
 }
@@ -151,6 +151,7 @@ class HWUSI: public Hardware, public SimulationMember, public TraceValueRegister
 
         /* Interface from Hardware */
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
 
         /* Interface from TimerEventListener */
         void fireEvent(int event) override;
@@ -194,6 +195,7 @@ class HWUSI_BR: public HWUSI {
 
         /* Interface from Hardware */
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
 
         /* Set and get functions for IO registers */
         void SetUSIBR(unsigned char val); // produce warning: read only
@@ -26,12 +26,14 @@
 #include "hwwado.h"
 #include "avrdevice.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 #define WDTOE 0x10
 #define WDE 0x08
 
 
 void HWWado::SetWdtcr(unsigned char val) {
+	core->RescheduleHardware(this);
 	unsigned char oldWDTOE= wdtcr & WDTOE;
 	unsigned char newWDE= val   & WDE;
 
@@ -65,6 +67,18 @@ unsigned int HWWado::CpuCycle() {
 	return 0;
 }
 
+unsigned int HWWado::GetIdleCycles() {
+	if (cntWde > 0) return 0;
+	if ((wdtcr & WDE) == 0) return idleForever;
+
+	// wado reset, if timeOutAt is exceeded
+	SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+	SystemClockOffset period = core->GetClockFreq();
+	if (timeOutAt < now || period <= 0) return 0;
+	SystemClockOffset idle = (timeOutAt - now) / period;
+	return (idle < idleForever) ? (unsigned int)idle : idleForever;
+}
+
 HWWado::HWWado(AvrDevice *core_):
     Hardware(core_),
     TraceValueRegister(core_, "WADO"),
@@ -80,8 +94,16 @@ void HWWado::Reset() {
 	wdtcr=0;
 }
 
+void HWWado::Checkpoint(Snapshot &snap) {
+	snap.Section("wado");
+	snap.Value(wdtcr);
+	snap.Value(cntWde);
+	snap.Value(timeOutAt);
+}
+
 
 void HWWado::Wdr() {
+	core->RescheduleHardware(this);
 	SystemClockOffset currentTime= SystemClock::Instance().GetCurrentTime(); 
 	switch ( wdtcr& 0x7) {
 		case 0:
@@ -45,11 +45,13 @@ class HWWado: public Hardware, public TraceValueRegister {
 	public:
 		HWWado(AvrDevice *); // { irqSystem= s;}
 		unsigned int CpuCycle() override;
+		unsigned int GetIdleCycles() override; //!< idle till WDTOE timeout or wado timeout
 
 		void SetWdtcr(unsigned char val);  
 		unsigned char GetWdtcr() { return wdtcr; }
 		void Wdr(); //reset the wado counter
 		void Reset() override;
+		void Checkpoint(Snapshot &snap) override;
 
         IOReg<HWWado> wdtcr_reg;
 };
@@ -0,0 +1,51 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef INSTRUCTIONOBSERVER
+#define INSTRUCTIONOBSERVER
+
+//! Gets the instructions and interrupts, which a core executes
+/*! Observers are added by AvrDevice::AddInstructionObserver, the core calls
+  them in the order, in which they were added. Idle loops skipped by the core
+  are reported only once, the cycles of the loop are counted for the
+  instruction before the next report. */
+class InstructionObserver {
+
+    public:
+        virtual ~InstructionObserver() {}
+
+        //! Called by core before instruction on flash word pc starts in cycle
+        virtual void Instruction(unsigned int pc, unsigned long long cycle) = 0;
+        //! Called by core, if it enters a interrupt, before return address is pushed
+        /*! @param vector number of interrupt vector
+          @param returnPC flash word, on which program continues after reti
+          @param vectorPC flash word of interrupt vector
+          @param cycle cycle, in which the interrupt is entered */
+        virtual void Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) = 0;
+        //! Called on reset of core
+        virtual void Reset(void) {}
+};
+
+#endif
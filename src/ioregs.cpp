@@ -24,6 +24,7 @@
  */
 
 #include "ioregs.h"
+#include "snapshot.h"
 
 AddressExtensionRegister::AddressExtensionRegister(AvrDevice *core,
                                                    const std::string &regname,
@@ -37,4 +38,8 @@ AddressExtensionRegister::AddressExtensionRegister(AvrDevice *core,
     Reset();
 }
 
+void AddressExtensionRegister::Checkpoint(Snapshot &snap) {
+    snap.Value(reg_val);
+}
+
 // EOF
@@ -24,310 +24,107 @@
  */
 
 #include "irqsystem.h"
+#include "irqstatistic.h"
 #include "avrdevice.h"
-#include "funktor.h"
 #include "systemclock.h"
-#include "helper.h"
 #include "avrerror.h"
 
 #include "application.h"
 
 #include <iostream>
-#include <assert.h>
-#include <typeinfo>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cmath>
 
 
 // global switch to enable irq statistic (default is disabled)
 bool enableIRQStatistic = false;
 
-void IrqStatisticEntry::CalcDiffs() {
-    // only calc if we have valid entries in both parms for diff
-    if ( ( flagCleared     != INVALID ) && ( flagSet        != INVALID ) ) { setClear          = flagCleared -     flagSet; }
-    if ( ( handlerStarted  != INVALID ) && ( flagSet        != INVALID ) ) { setStarted        = handlerStarted -  flagSet; }
-    if ( ( handlerFinished != INVALID ) && ( flagSet        != INVALID ) ) { setFinished       = handlerFinished - flagSet; }
-    if ( ( handlerFinished != INVALID ) && ( handlerStarted != INVALID ) ) { startedFinished   = handlerFinished - handlerStarted; }
+void IrqLatencyHistogram::Reset() {
+    count = 0;
+    sum = 0;
+    min = 0;
+    max = 0;
+    for(unsigned int i = 0; i < bucketCount; i++)
+        buckets[i] = 0;
 }
 
-bool IrqStatisticEntry::CheckComplete() {
-    if (
-        (flagSet!=INVALID) &&
-        (flagCleared!=INVALID) &&
-        (handlerStarted!=INVALID) &&
-        (handlerFinished!=INVALID)
-       ) 
-    {
-        return true;
-    }
-
-    return false;
-}
-
-
-IrqStatisticPerVector::IrqStatisticPerVector():
-    dummyInitObject{ std::make_shared<IrqStatisticEntry>() },
-    long_SetClear{ dummyInitObject },
-    short_SetClear{ dummyInitObject },
-    long_SetStarted{ dummyInitObject },
-    short_SetStarted{ dummyInitObject },
-    long_SetFinished{ dummyInitObject },
-    short_SetFinished{ dummyInitObject },
-    long_StartedFinished{ dummyInitObject },
-    short_StartedFinished{ dummyInitObject },
-    last{ dummyInitObject }
-{
-    dummyInitObject.reset(); // we do not need it any longer
+unsigned int IrqLatencyHistogram::BucketIndex(uint64_t value) {
+    if(value < linearBuckets)
+        return value;
+    unsigned int exponent = 0;
+    for(uint64_t v = value; v > 1; v >>= 1)
+        exponent++;
+    if(exponent > maxExponent)
+        return bucketCount - 1;
+    // exponent >= 4, take the 3 bits below the highest bit as sub bucket
+    return linearBuckets + (exponent - 4) * subBuckets + ((value >> (exponent - 3)) & (subBuckets - 1));
 }
 
-void IrqStatisticPerVector::CalculateStatistic() {
-    std::vector< decltype( unfinishedEntries.begin() ) > toRemove;
-
-    for ( auto it= unfinishedEntries.begin(); it != unfinishedEntries.end(); it++)
-    {
-        auto& el=*it;
-
-        if ( 
-            ( el->setClear != INVALID ) &&
-            (
-                ( el->setClear< short_SetClear->setClear ) ||
-                ( short_SetClear->setClear == INVALID )
-            )
-           )
-        {
-            short_SetClear=el;
-        }
-
-        if (
-            ( el->setClear != INVALID ) &&
-            (
-                ( el->setClear> long_SetClear->setClear ) ||
-                ( long_SetClear->setClear == INVALID )
-            )
-           )
-        {
-            long_SetClear=el;
-        }
-
-        if (
-            ( el->setStarted != INVALID ) &&
-            (
-                ( el->setStarted< short_SetStarted->setStarted ) ||
-                ( short_SetStarted->setStarted == INVALID )
-            )
-           )
-        {
-            short_SetStarted=el;
-        }
-
-        if ( 
-            ( el->setStarted != INVALID ) &&
-            (
-                ( el->setStarted> long_SetStarted->setStarted ) ||
-                ( long_SetStarted->setStarted == INVALID )
-            )
-           )
-        {
-            long_SetStarted=el;
-        }
-
-        if (
-            ( el->setFinished != INVALID ) &&
-            (
-                ( el->setFinished< short_SetFinished->setFinished ) ||
-                ( short_SetFinished->setFinished == INVALID )
-            )
-           ) 
-        {
-            short_SetFinished= el;
-        }
-
-        if ( 
-            ( el->setFinished != INVALID ) &&
-            (
-                ( el->setFinished > long_SetFinished->setFinished ) ||
-                ( long_SetFinished->setFinished == INVALID )
-            )
-           )
-        {
-            long_SetFinished= el;
-        }
-
-        if (
-            ( el->startedFinished != INVALID ) &&
-            (
-                ( el->startedFinished < short_StartedFinished->startedFinished ) ||
-                ( short_StartedFinished->startedFinished != INVALID )
-            )
-           )
-        {
-            short_StartedFinished= el;
-        }
-
-        if (
-            ( el->startedFinished != INVALID ) &&
-            (
-                ( el->startedFinished > long_StartedFinished->startedFinished ) ||
-                ( long_StartedFinished->startedFinished == INVALID )
-            )
-           )
-        {
-            long_StartedFinished= el;
-        }
-
-        // if one of the entries has all elements set, we can remove it from the all entries list
-        // to print it ones, we leave the entry in the "last" element
-        if ( el->CheckComplete() )
-        {
-            last = el;
-            toRemove.push_back( it );
-        }
-    }
-
-    // now we remove all "completed" entries as they are already part of the statistic summerize table
-    for ( auto& rem: toRemove )
-    {
-        unfinishedEntries.erase( rem );
-    }
-
-
+uint64_t IrqLatencyHistogram::BucketLow(unsigned int index) {
+    if(index < linearBuckets)
+        return index;
+    unsigned int exponent = (index - linearBuckets) / subBuckets + 4;
+    uint64_t sub = (index - linearBuckets) % subBuckets;
+    return (subBuckets + sub) << (exponent - 3);
 }
 
-std::ostream& operator<<(std::ostream &os, const IrqStatisticEntry& ise) {
-    std::string invalid_string= "               *";
-    invalid_string += '\t';
-
-    os << std::dec<<"\t";
-
-    if ( ise.flagSet         != INVALID ) { os << FormattedTime( ise.flagSet ) << "\t"; } else { os << invalid_string ; }
-    if ( ise.flagCleared     != INVALID ) { os << FormattedTime( ise.flagCleared ) << "\t";     } else { os << invalid_string ; }
-    if ( ise.handlerStarted  != INVALID ) { os << FormattedTime( ise.handlerStarted )<< "\t";   } else { os << invalid_string ; }
-    if ( ise.handlerFinished != INVALID ) { os << FormattedTime( ise.handlerFinished ) << "\t"; } else { os << invalid_string ; }
-
-    if ( ise.setClear        != INVALID ) { os << FormattedTime( ise.setClear ) << "\t";    } else { os << invalid_string ; }
-    if ( ise.setStarted      != INVALID ) { os << FormattedTime( ise.setStarted ) << "\t";  } else { os << invalid_string ; }
-    if ( ise.setFinished     != INVALID ) { os << FormattedTime( ise.setFinished ) << "\t";     } else { os << invalid_string ; }
-    if ( ise.startedFinished != INVALID ) { os << FormattedTime( ise.startedFinished )<< "\t";  } else { os << invalid_string ; }
-
-    return os;
+uint64_t IrqLatencyHistogram::BucketHigh(unsigned int index) {
+    if(index + 1 >= bucketCount)
+        return UINT64_MAX;
+    return BucketLow(index + 1) - 1;
 }
 
-std::string Cycles( const std::shared_ptr<IrqStatisticEntry>& ise, AvrDevice* core ) {
-    // Get time for a single step of cpu core
-
-    std::string invalid_string= "               *";
-    invalid_string += '\t';
-
-    std::ostringstream os;
-    os << std::dec<<"\t";
-    SystemClockOffset ns = core->GetClockFreq();
-
-    if ( ise->flagSet         != INVALID ) { os << FormattedTime( ise->flagSet ) << "\t"; } else { os << invalid_string ; }
-    if ( ise->flagCleared     != INVALID ) { os << FormattedTime( ise->flagCleared ) << "\t";     } else { os << invalid_string ; }
-    if ( ise->handlerStarted  != INVALID ) { os << FormattedTime( ise->handlerStarted )<< "\t";   } else { os << invalid_string ; }
-    if ( ise->handlerFinished != INVALID ) { os << FormattedTime( ise->handlerFinished ) << "\t"; } else { os << invalid_string ; }
-
-    if ( ise->setClear        != INVALID ) { os << std::setw(16) << ( ise->setClear/ns  ) << "\t"; } else { os << invalid_string ; }
-    if ( ise->setStarted      != INVALID ) { os << std::setw(16) << ( ise->setStarted/ns ) << "\t"; }else { os << invalid_string ; }
-    if ( ise->setFinished     != INVALID ) { os << std::setw(16) << ( ise->setFinished/ns ) << "\t"; }else { os << invalid_string ; }
-    if ( ise->startedFinished != INVALID ) { os << std::setw(16) << ( ise->startedFinished/ns )<< "\t"; }  else { os << invalid_string ; }
-
-    return os.str();
+void IrqLatencyHistogram::Add(uint64_t value) {
+    if(count == 0 || value < min)
+        min = value;
+    if(count == 0 || value > max)
+        max = value;
+    count++;
+    sum += value;
+    buckets[BucketIndex(value)]++;
 }
 
-std::string Print( const IrqStatisticPerVector &ispv, AvrDevice* core ) {
-    std::string headline;
-    headline += "Entry type              ";
-
-    headline += "          t Flag Set";
-    headline += "      t Flag Cleared";
-    headline += "   t Handler Started";
-    headline += "  t Handler Finished";
-    headline += "       dt Set->Clear";
-    headline += "       dt Set->Start";
-    headline += "      dt Set->Finish";
-    headline += "    dt Start->Finish";
-
-    std::string headline2;
-    headline2 += "Entry type              ";
-
-    headline2 += "          t Flag Set";
-    headline2 += "      t Flag Cleared";
-    headline2 += "   t Handler Started";
-    headline2 += "  t Handler Finished";
-    headline2 += "      clk Set->Clear";
-    headline2 += "      clk Set->Start";
-    headline2 += "     clk Set->Finish";
-    headline2 += "   clk Start->Finish";
-
-    std::ostringstream os;
-
-    if ( ispv.unfinishedEntries.size() )
-    {
-        os << headline << std::endl;
-
-        for ( auto& v: ispv.unfinishedEntries )
-        {
-            os << "all active handlers:     " << *v << std::endl;
-        }
-        os << std::endl;
-    }
-
-
-    os << headline << std::endl;
-    os << "last                     " << *ispv.last << std::endl;
-    os << "Set->Clear >             " << *ispv.long_SetClear << std::endl; 
-    os << "Set->Clear <             " << *ispv.short_SetClear << std::endl;
-    os << "Set->HandlerStarted >    " << *ispv.long_SetStarted << std::endl; 
-    os << "Set->HandlerStarted <    " << *ispv.short_SetStarted << std::endl;
-
-    os << "Set->HandlerFinished >   " << *ispv.long_SetFinished << std::endl; 
-    os << "Set->HandlerFinished <   " << *ispv.short_SetFinished << std::endl;
-    os << "Handler Start->Finished >" << *ispv.long_StartedFinished << std::endl; 
-    os << "Handler Start->Finished <" << *ispv.short_StartedFinished << std::endl;
-    os << std::endl;
-
-    if ( ispv.unfinishedEntries.size() )
-    {
-        os << headline << std::endl;
-
-        for ( auto& v: ispv.unfinishedEntries )
-        {
-            os << "all active handlers:     " << Cycles( v, core ) << std::endl;
+uint64_t IrqLatencyHistogram::Percentile(double fraction) const {
+    if(count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)std::ceil(fraction * count);
+    if(rank < 1)
+        rank = 1;
+    if(rank > count)
+        rank = count;
+    uint64_t seen = 0;
+    for(unsigned int i = 0; i < bucketCount; i++) {
+        seen += buckets[i];
+        if(seen >= rank) {
+            uint64_t high = BucketHigh(i);
+            if(high > max)
+                high = max;
+            if(high < min)
+                high = min;
+            return high;
         }
-        os << std::endl;
     }
-
-    os << headline << std::endl;
-    os << "last                     " << Cycles( ispv.last, core ) << std::endl;
-    os << "Set->Clear >             " << Cycles( ispv.long_SetClear, core ) << std::endl; 
-    os << "Set->Clear <             " << Cycles( ispv.short_SetClear, core ) << std::endl;
-    os << "Set->HandlerStarted >    " << Cycles( ispv.long_SetStarted, core ) << std::endl; 
-    os << "Set->HandlerStarted <    " << Cycles( ispv.short_SetStarted, core ) << std::endl;
-
-    os << "Set->HandlerFinished >   " << Cycles( ispv.long_SetFinished, core ) << std::endl; 
-    os << "Set->HandlerFinished <   " << Cycles( ispv.short_SetFinished, core ) << std::endl;
-    os << "Handler Start->Finished >" << Cycles( ispv.long_StartedFinished, core ) << std::endl; 
-    os << "Handler Start->Finished <" << Cycles( ispv.short_StartedFinished, core ) << std::endl;
-
-    return os.str();
+    return max;
 }
 
-
-std::ostream& operator<<(std::ostream &os, const IrqStatistic& is) {
-    std::map<unsigned int, IrqStatisticPerVector>::const_iterator ii;
-
-    os << "IRQ STATISTIC" << std::endl;
-    for (ii=is.entries.begin(); ii!= is.entries.end(); ii++) {
-        os << "####################################################################################################################################################################################" << std::endl;
-        os << "Core: "  << is.core->GetFname() << std::endl;
-        os << "Statistic for vector: " << ii->first << " " << is.core->GetInterruptVectorName( ii->first ) << std::endl;
-
-        os << Print( ii->second, is.core);
-    }
-
-    return os;
+void IrqStatisticPerVector::Reset() {
+    flagSet = INVALID;
+    flagCleared = INVALID;
+    clearedFlagSet = INVALID;
+    activeCount = 0;
+    lostHandlers = 0;
+    setClear.Reset();
+    setStarted.Reset();
+    setFinished.Reset();
+    startedFinished.Reset();
 }
 
-IrqStatistic::IrqStatistic (AvrDevice *c):Printable(std::cout), core(c) {
+IrqStatistic::IrqStatistic(AvrDevice *c, unsigned int vectors):
+    Printable(std::cout),
+    core(c),
+    entries(vectors) {
     Application::GetInstance()->RegisterPrintable(this);
 }
 
@@ -337,86 +134,220 @@ void IrqStatistic::operator()() {
         out << *this;
 }
 
+IrqStatisticPerVector &IrqStatistic::Entry(unsigned int vector) {
+    // allocated once on first event of the vector, later events don't allocate
+    std::unique_ptr<IrqStatisticPerVector> &e = entries[vector];
+    if(!e)
+        e.reset(new IrqStatisticPerVector);
+    return *e;
+}
+
+uint64_t IrqStatistic::Cycles(SystemClockOffset from, SystemClockOffset to) const {
+    SystemClockOffset clk = core->GetClockFreq();
+    if(clk <= 0)
+        clk = 1;
+    return (to - from) / clk;
+}
+
 void IrqStatistic::SetIrqFlag( unsigned int vector, SystemClockOffset time )
 {
-    // on getting a new irq flag set, we always start with a new statistic entry
-    entries[vector].unfinishedEntries.push_back(std::make_shared<IrqStatisticEntry>());
-    entries[vector].unfinishedEntries.back()->flagSet = time;
-    if ( core->trace_on ) { traceOut << (*this) << std::endl; }
+    // a flag, which is set again while pending, keeps the time of the first set
+    IrqStatisticPerVector &e = Entry(vector);
+    if(e.flagSet == INVALID)
+        e.flagSet = time;
 }
 
 void IrqStatistic::ClearIrqFlag( unsigned int vector, SystemClockOffset time )
 {
-    auto& el = entries[vector].unfinishedEntries.back();
-    if ( el->flagCleared!=INVALID )
-    {
-        if ( core->trace_on )
-        {
-            traceOut << "UUUUBS flagCleared was already set######################   E  R  R  O  R  ###############################" << std::endl;
-        }
-    }
-
-    el->flagCleared = time;
-    el->CalcDiffs();
-    entries[vector].CalculateStatistic();
-    if ( core->trace_on ) { traceOut << (*this) << std::endl; }
+    IrqStatisticPerVector &e = Entry(vector);
+    if(e.flagSet != INVALID)
+        e.setClear.Add(Cycles(e.flagSet, time));
+    // the flag is cleared just before the handler is started, so remember set time for it
+    e.flagCleared = time;
+    e.clearedFlagSet = e.flagSet;
+    e.flagSet = INVALID;
 }
 
 void IrqStatistic::IrqHandlerStarted( unsigned int vector, SystemClockOffset time, unsigned int stackPointer )
 {
-    auto& el = entries[vector].unfinishedEntries.back();
-    if ( el->handlerStarted!=INVALID )
-    {
-        if ( core->trace_on )
-        {
-            traceOut << "UUUUBS handlerStarted was already set######################   E  R  R  O  R  ###############################" << std::endl;
-        }
+    IrqStatisticPerVector &e = Entry(vector);
+    SystemClockOffset set = (e.flagCleared == time) ? e.clearedFlagSet : e.flagSet;
+    e.clearedFlagSet = INVALID;
+    if(set != INVALID)
+        e.setStarted.Add(Cycles(set, time));
+
+    if(e.activeCount == IrqStatisticPerVector::maxNesting) {
+        e.lostHandlers++;
+        return;
     }
-
-    el->handlerStarted = time;
-    el->stackPointer = stackPointer;
-    el->CalcDiffs();
-    entries[vector].CalculateStatistic();
-    if ( core->trace_on ) { traceOut << (*this) << std::endl; }
+    IrqStatisticPerVector::ActiveHandler &a = e.active[e.activeCount++];
+    a.flagSet = set;
+    a.handlerStarted = time;
+    a.stackPointer = stackPointer;
 }
 
 void IrqStatistic::IrqHandlerFinished( unsigned int vector, SystemClockOffset time, unsigned int stackPointer )
 {
     // we finish the handler which is on the given stack position as we can have nested irqs for the same
     // vector. This can happen if the handler set sei() and a new irq for the same vector occures and the 
-    // same handler is started again.
+    // same handler is started again. Handlers started later on the same vector have left without return.
+    IrqStatisticPerVector &e = Entry(vector);
+    for(unsigned int i = e.activeCount; i > 0; i--) {
+        IrqStatisticPerVector::ActiveHandler &a = e.active[i - 1];
+        if(a.stackPointer == stackPointer) {
+            if(a.flagSet != INVALID)
+                e.setFinished.Add(Cycles(a.flagSet, time));
+            e.startedFinished.Add(Cycles(a.handlerStarted, time));
+            e.activeCount = i - 1;
+            break;
+        }
+    }
+}
 
-    auto& vec = entries[vector].unfinishedEntries;
+void IrqStatistic::Reset() {
+    for(auto &e: entries) {
+        if(e) {
+            e->setClear.Reset();
+            e->setStarted.Reset();
+            e->setFinished.Reset();
+            e->startedFinished.Reset();
+            e->lostHandlers = 0;
+        }
+    }
+}
+
+static const char *latencyNames[] = { "set_clear", "set_started", "set_finished", "started_finished" };
+
+static const IrqLatencyHistogram *Latency(const IrqStatisticPerVector &e, unsigned int i) {
+    const IrqLatencyHistogram *h[] = { &e.setClear, &e.setStarted, &e.setFinished, &e.startedFinished };
+    return h[i];
+}
+
+static const unsigned int latencyCount = sizeof(latencyNames) / sizeof(latencyNames[0]);
 
-    // search vector from back and find same stackPointer
-    for ( auto it = vec.rbegin(); it != vec.rend(); ++it )
-    {
-        auto& el = *it;
-        if ( core->trace_on )
-        {
-            traceOut << "run over all entries in reverse order: " << std::endl;
-            traceOut << el << std::endl;
+static double Mean(const IrqLatencyHistogram &h) {
+    return h.count ? (double)h.sum / h.count : 0.0;
+}
 
+void IrqStatistic::WriteText(std::ostream &os) const {
+    os << "IRQ STATISTIC" << std::endl;
+    for(unsigned int v = 0; v < entries.size(); v++) {
+        if(!entries[v])
+            continue;
+        const IrqStatisticPerVector &e = *entries[v];
+        os << "Core: " << core->GetFname() << std::endl;
+        os << "Statistic for vector: " << v << " " << core->GetInterruptVectorName(v) << std::endl;
+        os << "Latency in clk          count         min        mean         max         p50         p99       p99.9" << std::endl;
+        const char *labels[] = { "Set->Clear      ", "Set->Started    ", "Set->Finished   ", "Started->Finished" };
+        for(unsigned int i = 0; i < latencyCount; i++) {
+            const IrqLatencyHistogram &h = *Latency(e, i);
+            os << std::left << std::setw(17) << labels[i] << std::right
+               << std::setw(12) << h.count
+               << std::setw(12) << h.min
+               << std::setw(12) << std::fixed << std::setprecision(1) << Mean(h)
+               << std::setw(12) << h.max
+               << std::setw(12) << h.Percentile(0.5)
+               << std::setw(12) << h.Percentile(0.99)
+               << std::setw(12) << h.Percentile(0.999) << std::endl;
         }
+        if(e.activeCount || e.lostHandlers)
+            os << "active handlers: " << e.activeCount << ", not tracked handlers: " << e.lostHandlers << std::endl;
+        os << std::endl;
+    }
+}
 
-        if ( el->stackPointer == stackPointer )
-        {
-            if ( el->handlerFinished!=INVALID )
-            {
-                if ( core->trace_on )
-                {
-                    traceOut << "UUUUBS handlerFinished was already set######################   E  R  R  O  R  ###############################" << std::endl;
-                }
+void IrqStatistic::WriteJSON(std::ostream &os) const {
+    os << "{\"device\": \"" << core->GetFname() << "\", \"time_ns\": " << SystemClock::Instance().GetCurrentTime()
+       << ", \"clk_ns\": " << core->GetClockFreq() << ", \"vectors\": [";
+    bool firstVector = true;
+    for(unsigned int v = 0; v < entries.size(); v++) {
+        if(!entries[v])
+            continue;
+        const IrqStatisticPerVector &e = *entries[v];
+        std::string name = core->GetInterruptVectorName(v);
+        if(name.empty())
+            name = "\"\"";
+        os << (firstVector ? "\n" : ",\n") << "  {\"vector\": " << v << ", \"name\": " << name
+           << ", \"pending\": " << (e.flagSet != INVALID ? "true" : "false")
+           << ", \"active\": " << e.activeCount << ", \"lost\": " << e.lostHandlers;
+        firstVector = false;
+        for(unsigned int i = 0; i < latencyCount; i++) {
+            const IrqLatencyHistogram &h = *Latency(e, i);
+            os << ",\n   \"" << latencyNames[i] << "\": {\"count\": " << h.count
+               << ", \"min\": " << h.min << ", \"max\": " << h.max
+               << ", \"mean\": " << std::fixed << std::setprecision(1) << Mean(h)
+               << ", \"p50\": " << h.Percentile(0.5) << ", \"p99\": " << h.Percentile(0.99)
+               << ", \"p99.9\": " << h.Percentile(0.999) << ", \"buckets\": [";
+            bool firstBucket = true;
+            for(unsigned int b = 0; b < IrqLatencyHistogram::bucketCount; b++) {
+                if(h.buckets[b] == 0)
+                    continue;
+                os << (firstBucket ? "" : ", ") << "[" << IrqLatencyHistogram::BucketLow(b) << ", "
+                   << IrqLatencyHistogram::BucketHigh(b) << ", " << h.buckets[b] << "]";
+                firstBucket = false;
             }
-            el->handlerFinished = time;
-            el->CalcDiffs();
-            entries[vector].CalculateStatistic();
-            break;
+            os << "]}";
         }
+        os << "}";
     }
+    os << "\n]}" << std::endl;
+}
+
+void IrqStatistic::WriteCSV(std::ostream &os) const {
+    os << "device,vector,name,latency,count,min,max,mean,p50,p99,p99.9" << std::endl;
+    for(unsigned int v = 0; v < entries.size(); v++) {
+        if(!entries[v])
+            continue;
+        const IrqStatisticPerVector &e = *entries[v];
+        for(unsigned int i = 0; i < latencyCount; i++) {
+            const IrqLatencyHistogram &h = *Latency(e, i);
+            os << core->GetFname() << "," << v << "," << core->GetInterruptVectorName(v) << ","
+               << latencyNames[i] << "," << h.count << "," << h.min << "," << h.max << ","
+               << std::fixed << std::setprecision(1) << Mean(h) << ","
+               << h.Percentile(0.5) << "," << h.Percentile(0.99) << "," << h.Percentile(0.999) << std::endl;
+        }
+    }
+}
 
-    if ( core->trace_on ) { traceOut << (*this) << std::endl; }
+bool IrqStatistic::Write(std::ostream &os, const std::string &format) const {
+    if(format == "text")
+        WriteText(os);
+    else if(format == "json")
+        WriteJSON(os);
+    else if(format == "csv")
+        WriteCSV(os);
+    else
+        return false;
+    return true;
+}
 
+std::ostream& operator<<(std::ostream &os, const IrqStatistic& is) {
+    is.WriteText(os);
+    return os;
+}
+
+IrqStatisticWriter::IrqStatisticWriter(HWIrqSystem *irq, const std::string &name, SystemClockOffset intervalNs):
+    irqSystem(irq),
+    fileName(name),
+    interval(intervalNs),
+    started(false) {}
+
+int IrqStatisticWriter::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
+    if(started)
+        WriteFile();
+    started = true;
+    if(timeToNextStepIn_ns != NULL)
+        *timeToNextStepIn_ns = (interval > 0) ? interval : -1;
+    return 0;
+}
 
+void IrqStatisticWriter::WriteFile(void) {
+    size_t len = fileName.size();
+    bool csv = len >= 4 && fileName.compare(len - 4, 4, ".csv") == 0;
+    std::ofstream f(fileName.c_str(), std::ios::out | std::ios::trunc);
+    if(!f)
+        avr_error("irq statistic: can't create file '%s'", fileName.c_str());
+    f << irqSystem->GetIrqStatistic(csv ? "csv" : "json");
 }
 
+// EOF
@@ -27,103 +27,136 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <stdint.h>
 
 #include "hardware.h"
 #include "funktor.h"
 #include "printable.h"
 #include "avrdevice.h"
 #include "traceval.h"
+#include "simulationmember.h"
+
+class HWIrqSystem;
 
 //! global switch to enable irq statistic (default is disabled)
 extern bool enableIRQStatistic;
 
 #ifndef SWIG
 
-class IrqStatisticEntry {
-        
+//! Latency histogram with logarithmic buckets and constant memory
+/*! Values below 16 have a bucket each, above every power of 2 is split into
+  8 buckets, so a bucket covers at most 12.5% of its value. Values above
+  2^48 are counted in the last bucket. Adding a value doesn't allocate. */
+class IrqLatencyHistogram {
+
     public:
-        SystemClockOffset flagSet;
-        SystemClockOffset flagCleared;
-        SystemClockOffset handlerStarted;
-        SystemClockOffset handlerFinished;
-
-        SystemClockOffset setClear;
-        SystemClockOffset setStarted;   
-        SystemClockOffset setFinished;  
-        SystemClockOffset startedFinished;
-
-        uint32_t stackPointer;
-
-
-        IrqStatisticEntry():
-            flagSet(INVALID),
-            flagCleared(INVALID),
-            handlerStarted(INVALID),
-            handlerFinished(INVALID),
-            setClear(INVALID),
-            setStarted(INVALID),
-            setFinished(INVALID),
-            startedFinished(INVALID),
-            stackPointer(0)
-    {}
-        void CalcDiffs();
-        bool CheckComplete();
+        static const unsigned int linearBuckets = 16; //!< buckets with one value each
+        static const unsigned int subBuckets = 8; //!< buckets per power of 2
+        static const unsigned int maxExponent = 47; //!< highest power of 2 with own buckets
+        static const unsigned int bucketCount = linearBuckets + (maxExponent - 3) * subBuckets;
+
+        uint64_t count; //!< number of values
+        uint64_t sum; //!< sum of all values, for mean value
+        uint64_t min; //!< smallest value, only valid if count > 0
+        uint64_t max; //!< largest value, only valid if count > 0
+        uint64_t buckets[bucketCount]; //!< number of values per bucket
+
+        IrqLatencyHistogram() { Reset(); }
+        void Reset();
+        void Add(uint64_t value);
+        //! Returns upper bound of bucket, where the given fraction of values is reached
+        uint64_t Percentile(double fraction) const;
+
+        static unsigned int BucketIndex(uint64_t value);
+        //! Smallest value in bucket
+        static uint64_t BucketLow(unsigned int index);
+        //! Largest value in bucket
+        static uint64_t BucketHigh(unsigned int index);
 };
 
+//! Statistic and state of one interrupt vector
 class IrqStatisticPerVector {
-    std::shared_ptr<IrqStatisticEntry> dummyInitObject;
-    
-    protected:
-        std::shared_ptr<IrqStatisticEntry> long_SetClear;
-        std::shared_ptr<IrqStatisticEntry> short_SetClear;
-
-        std::shared_ptr<IrqStatisticEntry> long_SetStarted;
-        std::shared_ptr<IrqStatisticEntry> short_SetStarted;
-
-        std::shared_ptr<IrqStatisticEntry> long_SetFinished;
-        std::shared_ptr<IrqStatisticEntry> short_SetFinished;
-
-        std::shared_ptr<IrqStatisticEntry> long_StartedFinished;
-        std::shared_ptr<IrqStatisticEntry> short_StartedFinished;
-
-        std::shared_ptr<IrqStatisticEntry> last;
-
-        friend std::string Print( const IrqStatisticPerVector &ispv, AvrDevice* core );
 
     public:
-        std::vector< std::shared_ptr<IrqStatisticEntry> > unfinishedEntries;
-        std::vector< std::shared_ptr<IrqStatisticEntry> > usedInSummarize;
-
-
-        void CalculateStatistic();
-
-        IrqStatisticPerVector();
+        //! Depth of nested handlers for the same vector, which are tracked
+        static const unsigned int maxNesting = 8;
+
+        //! A started interrupt handler, which hasn't finished yet
+        struct ActiveHandler {
+            SystemClockOffset flagSet;
+            SystemClockOffset handlerStarted;
+            uint32_t stackPointer;
+        };
+
+        SystemClockOffset flagSet; //!< time, when pending flag was set, INVALID if not pending
+        SystemClockOffset flagCleared; //!< time, when flag was cleared last
+        SystemClockOffset clearedFlagSet; //!< set time of the flag cleared at flagCleared
+        ActiveHandler active[maxNesting]; //!< started handlers, innermost last
+        unsigned int activeCount; //!< number of entries in active
+        uint64_t lostHandlers; //!< handlers not tracked, because nesting was too deep
+
+        IrqLatencyHistogram setClear; //!< flag set to flag cleared, in cpu cycles
+        IrqLatencyHistogram setStarted; //!< flag set to handler started, in cpu cycles
+        IrqLatencyHistogram setFinished; //!< flag set to handler finished, in cpu cycles
+        IrqLatencyHistogram startedFinished; //!< handler started to finished, in cpu cycles
+
+        IrqStatisticPerVector() { Reset(); }
+        void Reset();
 };
 
-std::ostream& operator<<(std::ostream &, const IrqStatisticEntry&);
-std::ostream& operator<<(std::ostream &, const IrqStatisticPerVector&);
-
+//! Interrupt latency statistic of a device
+/*! Memory is bounded: each vector gets a IrqStatisticPerVector on its first
+  event, all later events only update counters. Latencies are measured in cpu
+  cycles. */
 class IrqStatistic: public Printable {
     
     private:
         AvrDevice *core; // used to get the (file) name and clk speed of the core device
-        std::map<unsigned int, IrqStatisticPerVector> entries;
+        std::vector<std::unique_ptr<IrqStatisticPerVector> > entries; //!< indexed by vector, NULL if unused
         void operator()() override;
 
-        friend std::ostream& operator<<(std::ostream &, const IrqStatistic&);
+        IrqStatisticPerVector &Entry(unsigned int vector);
+        uint64_t Cycles(SystemClockOffset from, SystemClockOffset to) const;
 
     public:
-        IrqStatistic(AvrDevice *);
+        IrqStatistic(AvrDevice *, unsigned int vectors);
         virtual ~IrqStatistic() {}
         void SetIrqFlag( unsigned int vector, SystemClockOffset );
         void ClearIrqFlag( unsigned int vector, SystemClockOffset );
         void IrqHandlerStarted( unsigned int vector, SystemClockOffset, unsigned int stackPointer );
         void IrqHandlerFinished( unsigned int vector, SystemClockOffset, unsigned int stackPointer );
+
+        //! Drops all collected values, pending flags and active handlers are kept
+        void Reset();
+        //! Writes summary as readable table
+        void WriteText(std::ostream &os) const;
+        //! Writes summary and non empty histogram buckets as JSON object
+        void WriteJSON(std::ostream &os) const;
+        //! Writes summary as CSV, one line per vector and latency
+        void WriteCSV(std::ostream &os) const;
+        //! Writes in format "text", "json" or "csv", returns false for other formats
+        bool Write(std::ostream &os, const std::string &format) const;
 };
 
 std::ostream& operator<<(std::ostream &, const IrqStatistic&);
 
-#endif // ifndef SWIG
+//! Writes the interrupt statistic of a device periodically to a file
+/*! The format is CSV, if the file name ends with ".csv", JSON otherwise. The
+  file is rewritten every interval with the statistic collected so far. */
+class IrqStatisticWriter: public SimulationMember {
 
+    private:
+        HWIrqSystem *irqSystem;
+        std::string fileName;
+        SystemClockOffset interval; //!< time between writes in ns, 0 writes only on WriteFile
+        bool started; //!< false till first step, which isn't a write
 
+    public:
+        IrqStatisticWriter(HWIrqSystem *irq, const std::string &name, SystemClockOffset intervalNs);
+        int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) override;
+        //! Writes the statistic now
+        void WriteFile(void);
+};
 
+#endif // ifndef SWIG
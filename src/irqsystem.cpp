@@ -29,12 +29,15 @@
 #include "systemclock.h"
 #include "helper.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 #include "application.h"
 
 #include <iostream>
+#include <sstream>
 #include <assert.h>
 #include <typeinfo>
+#include <algorithm>
 
 
 HWIrqSystem::HWIrqSystem(AvrDevice* _core, int bytes, int tblsize):
@@ -42,10 +45,16 @@ HWIrqSystem::HWIrqSystem(AvrDevice* _core, int bytes, int tblsize):
     bytesPerVector(bytes),
     vectorTableSize(tblsize),
     irqTrace(tblsize),
+    irqSource(tblsize, (Hardware*)NULL),
     core(_core),
-    irqStatistic(_core),
+    activeHandlers(tblsize, 0),
+    irqStatistic(_core, tblsize),
     debugInterruptTable(tblsize, (Hardware*)NULL)
 {
+    if(vectorTableSize > maskWords * 64)
+        avr_error("IRQ system: %u vectors aren't supported, maximum is %u", vectorTableSize, maskWords * 64);
+    for(unsigned int w = 0; w < maskWords; w++)
+        pendingMask[w] = 0;
     for(unsigned int i = 0; i < vectorTableSize; i++) {
         TraceValue* tv = new TraceValue(1, GetTraceValuePrefix() + "VECTOR" + int2str(i));
         tv->set_written(0);
@@ -54,77 +63,144 @@ HWIrqSystem::HWIrqSystem(AvrDevice* _core, int bytes, int tblsize):
     }
 }
 
-bool HWIrqSystem::IsIrqPending()
-{
-    return ( irqPartnerList.size() != 0); // if any interrupt is in the list, return true
+//! Returns index of lowest set bit, value must not be 0
+static inline unsigned int LowestBit(uint64_t value) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(value);
+#else
+    unsigned int idx = 0;
+    while((value & 1) == 0) {
+        value >>= 1;
+        idx++;
+    }
+    return idx;
+#endif
 }
 
 unsigned int HWIrqSystem::GetNewPc(unsigned int &actualVector) {
-    unsigned int newPC = 0xffffffff;
-
-    static std::map<unsigned int, Hardware *>::iterator ii;
-    static std::map<unsigned int, Hardware *>::iterator end;
-    end = irqPartnerList.end();
-
-    //a map is always sorted, so the priority of the irq vector is known and handled correctly
-    for(ii = irqPartnerList.begin(); ii != end; ii++) {
-        Hardware* second = ii->second;
-        unsigned int index = ii->first;
-        assert(index < vectorTableSize);
-
-        if(second->IsLevelInterrupt(index)) {
-            if(second->LevelInterruptPending(index)) {
-                actualVector = index;
-                newPC = index * (bytesPerVector / 2);
-                break;
-            }
-        } else {
+    // the lowest pending vector has the highest priority, level interrupts
+    // are only taken, if the level is still active, the source decides about
+    // the kind of interrupt on dispatch, firmware could have changed it
+    for(unsigned int w = 0; w < maskWords; w++) {
+        uint64_t candidates = pendingMask[w];
+        while(candidates != 0) {
+            unsigned int bit = LowestBit(candidates);
+            uint64_t vmask = (uint64_t)1 << bit;
+            candidates &= ~vmask;
+            unsigned int index = w * 64 + bit;
+            Hardware *source = irqSource[index];
+            if(source->IsLevelInterrupt(index) && !source->LevelInterruptPending(index))
+                continue;
             actualVector = index;
-            newPC = index * (bytesPerVector / 2);
-            break;
+            return index * (bytesPerVector / 2);
         }
     }
 
-    return newPC;
+    return 0xffffffff;
 }
 
 
 void HWIrqSystem::SetIrqFlag(Hardware *hwp, unsigned int vector) {
     assert(vector < vectorTableSize);
-    irqPartnerList[vector]=hwp;
+    uint64_t vmask = (uint64_t)1 << (vector % 64);
+    pendingMask[vector / 64] |= vmask;
+    irqSource[vector] = hwp;
     if (core->trace_on) {
         traceOut << core->GetFname() << " IRQ: " << vector << " " << core->GetInterruptVectorName( vector ) << " is pending" << std::endl;
     }
 
-    
-    irqStatistic.SetIrqFlag( vector, SystemClock::Now() );
+    if(enableIRQStatistic)
+        irqStatistic.SetIrqFlag( vector, SystemClock::Now() );
 }
 
 void HWIrqSystem::ClearIrqFlag(unsigned int vector) {
-    irqPartnerList.erase(vector);
+    assert(vector < vectorTableSize);
+    uint64_t vmask = (uint64_t)1 << (vector % 64);
+    pendingMask[vector / 64] &= ~vmask;
     if (core->trace_on) {
         traceOut << core->GetFname() << " IRQ: " << vector << " " << core->GetInterruptVectorName( vector ) << " flag cleared" << std::endl;
     }
 
-    irqStatistic.ClearIrqFlag( vector, SystemClock::Now() );
+    if(enableIRQStatistic)
+        irqStatistic.ClearIrqFlag( vector, SystemClock::Now() );
 } 
 
+void HWIrqSystem::Checkpoint(Snapshot &snap) {
+    snap.Section("irq");
+    unsigned int count = 0;
+    for(unsigned int w = 0; w < maskWords; w++)
+        for(uint64_t m = pendingMask[w]; m != 0; m &= m - 1)
+            count++;
+    snap.Value(count);
+
+    // hardware is stored as index in reset list of device
+    uint64_t pending[maskWords] = { 0 };
+    std::vector<Hardware *> source(irqSource.size(), (Hardware *)NULL);
+    unsigned int vector = 0;
+    for(unsigned int i = 0; i < count; i++) {
+        unsigned int index = 0;
+        if(!snap.IsRestoring()) {
+            while(!(pendingMask[vector / 64] & ((uint64_t)1 << (vector % 64))))
+                vector++;
+            index = std::find(core->hwResetList.begin(), core->hwResetList.end(), irqSource[vector]) - core->hwResetList.begin();
+        }
+        snap.Value(vector);
+        snap.Value(index);
+        if(snap.IsRestoring()) {
+            if(vector >= vectorTableSize || index >= core->hwResetList.size())
+                avr_error("snapshot: invalid pending interrupt %u", vector);
+            uint64_t vmask = (uint64_t)1 << (vector % 64);
+            pending[vector / 64] |= vmask;
+            source[vector] = core->hwResetList[index];
+        } else
+            vector++;
+    }
+
+    if(snap.IsRestoring()) {
+        for(unsigned int w = 0; w < maskWords; w++)
+            pendingMask[w] = pending[w];
+        irqSource.swap(source);
+        // running handlers are tracked by the stack, which is restored separately
+        ClearActiveHandlers();
+    }
+}
+
 void HWIrqSystem::IrqHandlerStarted(uint32_t stackPointer, unsigned int vector) {
     irqTrace[vector]->change(1);
+    activeHandlers[vector]++;
     if (core->trace_on) {
         traceOut << core->GetFname() << " IRQ: " << vector << " " << core->GetInterruptVectorName( vector ) << " handler started" << std::endl;
     }
 
-    irqStatistic.IrqHandlerStarted( vector, SystemClock::Now(), stackPointer );
+    if(enableIRQStatistic)
+        irqStatistic.IrqHandlerStarted( vector, SystemClock::Now(), stackPointer );
 }
 
 void HWIrqSystem::IrqHandlerFinished(unsigned int stackPointer, unsigned int vector) {
     irqTrace[vector]->change(0);
+    if(activeHandlers[vector] > 0)
+        activeHandlers[vector]--;
     if (core->trace_on) {
         traceOut << core->GetFname() << " IRQ: " << vector << " " << core->GetInterruptVectorName( vector ) << " handler finished" << std::endl;
     }
 
-    irqStatistic.IrqHandlerFinished(  vector, SystemClock::Now(), stackPointer );
+    if(enableIRQStatistic)
+        irqStatistic.IrqHandlerFinished(  vector, SystemClock::Now(), stackPointer );
+}
+
+void HWIrqSystem::ClearActiveHandlers(void) {
+    std::fill(activeHandlers.begin(), activeHandlers.end(), 0);
+}
+
+std::string HWIrqSystem::GetIrqStatistic(const std::string &format) {
+    std::ostringstream os;
+    if(!irqStatistic.Write(os, format))
+        avr_error("IRQ statistic: unknown format '%s', use text, json or csv", format.c_str());
+    return os.str();
+}
+
+void HWIrqSystem::ResetIrqStatistic(void) {
+    irqStatistic.Reset();
 }
 
 void HWIrqSystem::DebugVerifyInterruptVector(unsigned int vector, const Hardware* source) {
@@ -27,14 +27,21 @@
 #define HWIRQSYSTEM
 
 #include <vector>
+#include <string>
+#include <stdint.h>
 
 #include "hardware.h"
 #include "funktor.h"
 #include "avrdevice.h"
 #include "traceval.h"
 #include "irqstatistic.h"
+#include "hwstack.h"
 
-class HWIrqSystem: public TraceValueRegister {
+class HWIrqSystem: public TraceValueRegister
+#ifndef SWIG
+    , public ReturnPointListener
+#endif
+{
     
     protected:
         int bytesPerVector;
@@ -42,25 +49,55 @@ class HWIrqSystem: public TraceValueRegister {
         HWSreg *status;
         std::vector<TraceValue*> irqTrace;
         
-        /// priority queue of pending interrupts (i.e. waiting to be processed)
-        std::map<unsigned int, Hardware *> irqPartnerList;
+        /// number of 64 bit words in the interrupt masks, enough for 128 vectors
+        static const unsigned int maskWords = 2;
+        /// pending interrupts (i.e. waiting to be processed), one bit per vector, lowest vector has highest priority
+        uint64_t pendingMask[maskWords];
+        /// hardware, which has raised the pending interrupt, indexed by vector
+        std::vector<Hardware *> irqSource;
         AvrDevice *core;
+        std::vector<unsigned int> activeHandlers; ///< nesting depth of running handlers, indexed by vector
         IrqStatistic irqStatistic;
         std::vector<const Hardware*> debugInterruptTable;
 
     public:
         HWIrqSystem (AvrDevice* _core, int bytes_per_vector, int number_of_vectors);
 
-        bool IsIrqPending();
+        bool IsIrqPending() {
+            uint64_t pending = 0;
+            for(unsigned int w = 0; w < maskWords; w++)
+                pending |= pendingMask[w];
+            return pending != 0;
+        }
         /// returns a new PC pointer if interrupt occurred, -1 otherwise.
         unsigned int GetNewPc(unsigned int &vector_index);
         void SetIrqFlag(Hardware *, unsigned int vector_index);
         void ClearIrqFlag(unsigned int vector_index);
         void IrqHandlerStarted(uint32_t stackPointer, unsigned int vector_index);
         void IrqHandlerFinished(uint32_t stackPointer, unsigned int vector_index);
+        /// True, if the handler of vector is entered and hasn't returned yet
+        bool IsHandlerActive(unsigned int vector_index) const {
+            return vector_index < activeHandlers.size() && activeHandlers[vector_index] != 0;
+        }
+        /// Returns the number of interrupt vectors of the device
+        unsigned int GetVectorTableSize(void) const { return vectorTableSize; }
+        /// Forgets all running handlers, e.g. on reset
+        void ClearActiveHandlers(void);
+#ifndef SWIG
+        //! Return from handler of vector id, see HWStack::SetReturnPoint
+        void ReturnPointReached(uint32_t stackPointer, unsigned int id) override { IrqHandlerFinished(stackPointer, id); }
+#endif
+        //! Saves or restores the pending interrupts, see Hardware::Checkpoint
+        /*! The interrupt statistic isn't part of the snapshot. */
+        void Checkpoint(Snapshot &snap);
         /// In datasheets RESET vector is index 1 but we use 0! And not a byte address.
         void DebugVerifyInterruptVector(unsigned int vector_index, const Hardware* source);
         void DebugDumpTable();
+        //! Returns the interrupt statistic as "text", "json" or "csv"
+        /*! The statistic is only collected, if it is enabled by enableIRQStatistic. */
+        std::string GetIrqStatistic(const std::string &format);
+        //! Drops all collected interrupt latencies, e.g. after the boot phase
+        void ResetIrqStatistic(void);
 };
 
 
@@ -24,8 +24,7 @@
  */
 
 #include <string.h> //strcpy()
-#include <sstream>
-#include <iostream>
+#include <stdio.h>
 
 #include "memory.h"
 #include "avrerror.h"
@@ -62,68 +61,113 @@ unsigned int Memory::GetAddressAtSymbol(const std::string &s) {
     return 0; // to avoid warnings, avr_error aborts the program
 }
 
+bool Memory::GetSymbolRange(const std::string &s, unsigned int &start, unsigned int &end) {
+    std::multimap<unsigned int, std::string>::iterator ii;
+    for(ii = sym.begin(); ii != sym.end(); ii++)
+        if(ii->second == s)
+            break;
+    if(ii == sym.end())
+        return false;
+
+    start = ii->first;
+    ii = sym.upper_bound(start);
+    end = (ii != sym.end()) ? ii->first : size;
+    return true;
+}
 
-std::string Memory::GetSymbolAtAddress( unsigned int add )
-{
-    std::ostringstream os;
-
-    if ( sym.size() )
-    {
-        // get value behind our address
-        auto it = sym.upper_bound( add );
 
-        // take the symbol where the address is equal or lower than the searched one
-        it--;   
+void Memory::BuildSymbolIndex(void) {
+    symIndex.clear();
+    lastSymEntry = 0;
 
+    auto it = sym.begin();
+    while(it != sym.end()) {
         // get all symbols from that address
-        auto p = sym.equal_range( it->first ); 
-
-        // get the offset the the address we search for
-        unsigned int offset = add- p.first->first;
-
-        // if there is a offset...
-        if ( offset ) { os << "("; }
+        auto p = sym.equal_range(it->first);
 
         // try to suppress symbols beginning with '_', but only if others are present
-        unsigned int found = 100;
-        auto tmp = p.first;
-        for ( ; tmp != p.second; tmp++ )
-        {
-            unsigned int comp = tmp->second.find_first_not_of("_");
-            if ( found > comp ) { found = comp; }
+        size_t found = std::string::npos;
+        for(auto tmp = p.first; tmp != p.second; tmp++) {
+            size_t comp = tmp->second.find_first_not_of("_");
+            if(found > comp)
+                found = comp;
         }
 
-        // run over all symbols for the address
-        bool isFirst = true;
-        for ( ; p.first != p.second; p.first++ )
-        {
-            if ( found >= p.first->second.find_first_not_of("_") )
-            {
-                if ( isFirst )
-                {
-                    isFirst = false;
-                }
-                else
-                { 
-                    os << ",";
-                }
-                os << p.first->second;
+        SymbolEntry e;
+        e.address = it->first;
+        for(auto tmp = p.first; tmp != p.second; tmp++) {
+            if(found >= tmp->second.find_first_not_of("_")) {
+                if(!e.label.empty())
+                    e.label += ",";
+                e.label += tmp->second;
             }
-
         }
+        symIndex.push_back(e);
+        it = p.second;
+    }
 
-        // print the offset if there is one
-        if( offset ) 
-        {
-            os << ")+0x"<< std::hex<< offset;
+    symIndexValid = true;
+}
+
+std::string_view Memory::FindSymbol(unsigned int add, unsigned int &offset) {
+    if(!symIndexValid)
+        BuildSymbolIndex();
+
+    offset = 0;
+    size_t cnt = symIndex.size();
+    if(cnt == 0 || add < symIndex[0].address)
+        return std::string_view();
+
+    // most lookups are in the same function as the last one
+    size_t i = lastSymEntry;
+    if(!(symIndex[i].address <= add && (i + 1 == cnt || add < symIndex[i + 1].address))) {
+        // search last entry with address <= add
+        size_t lo = 0, hi = cnt;
+        while(hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if(symIndex[mid].address <= add)
+                lo = mid;
+            else
+                hi = mid;
         }
+        i = lo;
+        lastSymEntry = i;
+    }
 
+    offset = add - symIndex[i].address;
+    return symIndex[i].label;
+}
+
+size_t Memory::WriteSymbolAtAddress(std::ostream &os, unsigned int add) {
+    unsigned int offset;
+    std::string_view label = FindSymbol(add, offset);
+    if(offset == 0) {
+        os << label;
+        return label.size();
     }
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), ")+0x%x", offset);
+    os << '(' << label << buf;
+    return label.size() + 1 + len;
+}
 
-    return os.str();
+std::string Memory::GetSymbolAtAddress(unsigned int add) {
+    unsigned int offset;
+    std::string_view label = FindSymbol(add, offset);
+    if(offset == 0)
+        return std::string(label);
+    char buf[16];
+    snprintf(buf, sizeof(buf), ")+0x%x", offset);
+    std::string res("(");
+    res.append(label);
+    res.append(buf);
+    return res;
 }
 
-Memory::Memory(int _size): size(_size) {
+Memory::Memory(int _size):
+    size(_size),
+    symIndexValid(true),
+    lastSymEntry(0) {
     myMemory = avr_new(unsigned char, size);
 }
 
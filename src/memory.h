@@ -27,7 +27,10 @@
 #define MEMORY
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
+#include <ostream>
 
 #include "decoder.h"
 #include "avrmalloc.h"
@@ -39,6 +42,19 @@ class Memory {
     protected:
       
         unsigned int size; /*!< allocated size (in bytes) of myMemory */
+
+        //! One address with symbols in the symbol index
+        struct SymbolEntry {
+            unsigned int address; //!< address of symbol(s)
+            std::string label; //!< symbol names for address, concatenated by ','
+        };
+
+        std::vector<SymbolEntry> symIndex; //!< sorted by address, built from sym on first lookup
+        bool symIndexValid; //!< false, if sym was changed after building symIndex
+        size_t lastSymEntry; //!< entry found by last lookup, checked first on next lookup
+
+        //! Builds symIndex from sym
+        void BuildSymbolIndex(void);
         
     public:
         unsigned char *myMemory; /*!< THE memory block content itself */
@@ -63,6 +79,23 @@ class Memory {
           @param add the given address
           @return a string with all found symbols, concatenated by ',' */
         std::string GetSymbolAtAddress(unsigned int add);
+
+        /*! Find the symbol(s) for a address without allocating memory
+
+          The index is built once after symbols are added, a lookup is a binary
+          search or a hit on the last found entry.
+          @param add the given address
+          @param offset returns the offset from symbol address to add
+          @return symbol names concatenated by ',' or a empty view, if there is
+          no symbol at or before add. The view is valid until next AddSymbol. */
+        std::string_view FindSymbol(unsigned int add, unsigned int &offset);
+
+        /*! Write the same text as GetSymbolAtAddress to a stream
+
+          @param os the output stream
+          @param add the given address
+          @return number of written characters */
+        size_t WriteSymbolAtAddress(std::ostream &os, unsigned int add);
         
         /*! Returns the address for a symbol
         
@@ -75,10 +108,20 @@ class Memory {
           should raise a exeption to handle this on the caller side? */
         unsigned int GetAddressAtSymbol(const std::string &s);
         
+        /*! Returns the address range of a symbol without aborting
+
+          The range ends on the next symbol with a higher address or on the end
+          of memory.
+          @param s the symbol string
+          @param start returns the address of the symbol
+          @param end returns the first address after the symbol
+          @return false, if the symbol isn't found */
+        bool GetSymbolRange(const std::string &s, unsigned int &start, unsigned int &end);
+        
         /*! Add the (address, symbol) pair
         
           @param p a std::pair with address and symbol string */
-        void AddSymbol(std::pair<unsigned int, std::string> p) { sym.insert(p); }
+        void AddSymbol(std::pair<unsigned int, std::string> p) { sym.insert(p); symIndexValid = false; }
         
         /*! Returns the size in bytes of memory block */
         unsigned int GetSize() { return size; }
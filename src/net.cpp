@@ -23,21 +23,35 @@
  *  $Id$
  */
 
+#include <algorithm>
+
 #include "net.h"
 #include "pin.h"
+#include "systemclock.h"
+
+Net::Net(): delay(0), changesDone(0), delivery(this), deferred(false) {
+    for(unsigned int i = 0; i <= Pin::ANALOG_SHORTED; i++)
+        driverCount[i] = 0;
+}
 
 void Net::Add(Pin *p) {
     push_back(p);
     p->RegisterNet(this);
+    p->netIndex = size() - 1;
     CalcNet();
 }
 
 // Remove a Pin from a net but do NOT "delete" it
 void Net::Delete(Pin *p) {
-    iterator ii;
-    for(ii = begin(); ii != end(); ii++) {
-        if((*ii) == p) {
-            erase(ii);
+    for(unsigned int i = 0; i < size(); i++) {
+        if((*this)[i] == p) {
+            erase(begin() + i);
+            if(i < driverState.size()) {
+                driverCount[driverState[i]]--;
+                driverState.erase(driverState.begin() + i);
+            }
+            for(unsigned int j = i; j < size(); j++)
+                (*this)[j]->netIndex = j;
             break;
         }
     }
@@ -48,18 +62,202 @@ Net::~Net() {
     {
         pin->UnRegisterNet(this);
     }
+    if(delivery.scheduled)
+        delivery.clock->Remove(&delivery);
+}
+
+void Net::Invalidate(void) {
+    driverState.clear();
+    // changes on the way are from before the restore
+    Trim(changesDone + changes.size());
+}
+
+void Net::CountDrivers(void) {
+    for(unsigned int i = 0; i <= Pin::ANALOG_SHORTED; i++)
+        driverCount[i] = 0;
+    driverState.resize(size());
+    for(unsigned int i = 0; i < size(); i++) {
+        Pin::T_Pinstate st = (*this)[i]->GetPin().outState; //get state of pin (TRISTATE, HIGH, LOW ....)
+        driverState[i] = st;
+        driverCount[st]++;
+    }
+    if(delay > 0) {
+        driverPin.clear();
+        for(unsigned int i = 0; i < size(); i++)
+            driverPin.push_back((*this)[i]->GetPin());
+    }
+}
+
+Pin Net::Resolve(void) {
+    const unsigned int *c = driverCount;
+    if(c[Pin::ANALOG_SHORTED] > 0)
+        return Pin(Pin::ANALOG_SHORTED);
+    if(c[Pin::ANALOG] > 0) {
+        // a analog pin can only drive the net alone
+        if(size() - c[Pin::TRISTATE] > 1)
+            return Pin(Pin::ANALOG_SHORTED);
+        for(unsigned int i = 0; i < size(); i++) {
+            if(driverState[i] == Pin::ANALOG)
+                return (delay > 0) ? driverPin[i] : (*this)[i]->GetPin();
+        }
+    }
+    if(c[Pin::SHORTED] > 0 || (c[Pin::HIGH] > 0 && c[Pin::LOW] > 0))
+        return Pin(Pin::SHORTED);
+    if(c[Pin::HIGH] > 0)
+        return Pin(Pin::HIGH);
+    if(c[Pin::LOW] > 0)
+        return Pin(Pin::LOW);
+    // more pull resistors in parallel are stronger, same count is floating
+    if(c[Pin::PULLUP] > c[Pin::PULLDOWN])
+        return Pin(Pin::PULLUP);
+    if(c[Pin::PULLDOWN] > c[Pin::PULLUP])
+        return Pin(Pin::PULLDOWN);
+    return Pin(Pin::TRISTATE);
+}
+
+bool Net::SameInput(const Pin &a, const Pin &b) {
+    return a.outState == b.outState &&
+           a.analogVal.getD() == b.analogVal.getD() &&
+           a.analogVal.getRaw() == b.analogVal.getRaw();
 }
 
 bool Net::CalcNet() {
-    Pin result(Pin::TRISTATE);
-    iterator ii;
-    for(ii = begin(); ii != end(); ii++)
-        result += ((*ii)->GetPin()); //get state of pin (TRISTATE, HIGH, LOW ....)
+    CountDrivers();
+    result = Resolve();
 
     //new result is now found, so set all pins in the Net to new state
-    for(ii = begin(); ii != end(); ii++)
-        (*ii)->SetInState( result); //In-State that means the state of register PIN not the complete pin here
+    for(unsigned int i = 0; i < size(); i++)
+        (*this)[i]->SetInState(result); //In-State that means the state of register PIN not the complete pin here
+    delivery.input = result;
 
     return (bool)result;
 }
 
+bool Net::PinChanged(Pin *p) {
+    unsigned int i = p->netIndex;
+    if(delay > 0) {
+        SystemClock &clock = SystemClock::Instance();
+        if(i >= size() || (*this)[i] != p)
+            i = size(); // e.g. pin behind a OpenDrain, which is in the net
+        if(deferred) {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending.push_back(PendingChange{ clock.GetCurrentTime(), i, p->GetPin() });
+        } else {
+            ResolveDelayed(clock.GetCurrentTime(), i, p->GetPin());
+            delivery.Schedule(clock);
+        }
+        return (bool)result;
+    }
+
+    if(i >= size() || (*this)[i] != p || driverState.size() != size())
+        return CalcNet(); // e.g. pin behind a OpenDrain, which is in the net
+
+    Pin::T_Pinstate st = p->GetPin().outState;
+    driverCount[driverState[i]]--;
+    driverCount[st]++;
+    driverState[i] = st;
+
+    Pin r = Resolve();
+    if(SameInput(r, result)) {
+        // other pins see the same input as before, only the changed pin gets its input
+        p->SetInState(result);
+    } else {
+        result = r;
+        for(unsigned int j = 0; j < size(); j++)
+            (*this)[j]->SetInState(result);
+    }
+
+    return (bool)result;
+}
+
+void Net::ResolveDelayed(SystemClockOffset time, unsigned int index, const Pin &state) {
+    if(index >= size() || driverState.size() != size() || driverPin.size() != size()) {
+        CountDrivers();
+    } else {
+        driverCount[driverState[index]]--;
+        driverCount[state.outState]++;
+        driverState[index] = state.outState;
+        driverPin[index] = state;
+    }
+
+    Pin r = Resolve();
+    if(SameInput(r, result))
+        return;
+    result = r;
+
+    // only the last change at the same time is set on the pins
+    time += delay;
+    if(!changes.empty() && changes.back().first == time)
+        changes.back().second = r;
+    else
+        changes.push_back(std::make_pair(time, r));
+}
+
+void Net::Flush(void) {
+    std::sort(pending.begin(), pending.end());
+    for(auto &c: pending)
+        ResolveDelayed(c.time, c.index, c.state);
+    pending.clear();
+}
+
+void Net::Trim(unsigned long long done) {
+    while(changesDone < done && !changes.empty()) {
+        changes.pop_front();
+        changesDone++;
+    }
+}
+
+NetDelivery::NetDelivery(Net *n): net(n), next(0), clock(nullptr), scheduled(false) {}
+
+NetDelivery::NetDelivery(const NetDelivery &d, const std::vector<Pin *> &p):
+    SimulationMember(d),
+    net(d.net),
+    pins(p),
+    next(d.next),
+    input(d.input),
+    clock(nullptr),
+    scheduled(false) {}
+
+bool NetDelivery::IsPending(void) const {
+    return std::max(next, net->changesDone) < net->changesDone + net->changes.size();
+}
+
+void NetDelivery::Schedule(SystemClock &c) {
+    if(scheduled || !IsPending())
+        return;
+    next = std::max(next, net->changesDone);
+    SystemClockOffset time = net->changes[next - net->changesDone].first;
+    c.Reschedule(this, std::max(time, c.GetCurrentTime()) - c.GetCurrentTime() - 1);
+    clock = &c;
+    scheduled = true;
+}
+
+int NetDelivery::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
+    SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+    next = std::max(next, net->changesDone);
+    *timeToNextStepIn_ns = -1;
+    while(next < net->changesDone + net->changes.size()) {
+        const std::pair<SystemClockOffset, Pin> &c = net->changes[next - net->changesDone];
+        if(c.first > now) {
+            *timeToNextStepIn_ns = c.first - now;
+            break;
+        }
+        next++;
+        if(Net::SameInput(c.second, input))
+            continue;
+        input = c.second;
+        if(pins.empty()) {
+            for(unsigned int i = 0; i < net->size(); i++)
+                (*net)[i]->SetInState(input);
+        } else {
+            for(unsigned int i = 0; i < pins.size(); i++)
+                pins[i]->SetInState(input);
+        }
+    }
+
+    // the delivery for all pins is the only one in a serial run
+    if(pins.empty())
+        net->Trim(next);
+    scheduled = *timeToNextStepIn_ns > 0;
+    return 0;
+}
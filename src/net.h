@@ -28,29 +28,115 @@
 
 #include <vector>
 #include <string>
+#ifndef SWIG
+#include <deque>
+#include <mutex>
+#endif
 
 #include "pin.h"
+#include "systemclocktypes.h"
+#include "simulationmember.h"
+
+class Net;
+class SystemClock;
+
+#ifndef SWIG
+//! Sets the inputs of the pins of a Net with propagation delay, when a change is due
+/*! The net has one instance for all pins, which is used in a serial run. A
+  parallel run gives every partition a copy for the pins of its devices, see
+  SystemClock::SetParallel. A copy has the same member number, so it's stepped
+  in the same order to other members as the original. */
+class NetDelivery: public SimulationMember {
+    public:
+        NetDelivery(Net *n); //!< Delivery for all pins of net n
+        NetDelivery(const NetDelivery &d, const std::vector<Pin *> &p); //!< Copy of d for pins p
+        int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns = 0) override;
+        //! Schedules this member on clock at the next change, if it isn't scheduled
+        void Schedule(SystemClock &c);
+        //! Returns true, if there are changes, which aren't set on the pins
+        bool IsPending(void) const;
+
+        Net *net; //!< the net, which changes are set
+        std::vector<Pin *> pins; //!< the pins, which get the changes, all pins of the net, if empty
+        unsigned long long next; //!< number of the next change of the net to set
+        Pin input; //!< the last input, which was set on the pins
+        SystemClock *clock; //!< the clock, on which this member is scheduled
+        bool scheduled; //!< true, if this member is in the time table of clock
+};
+#endif
 
 //! Connect Pins to each other and transfers a output change from a pin to input values for all pins
+/*! The net counts the output states of all pins, so a output change of one pin
+  is resolved in constant time. Inputs of pins are only updated, if the resolved
+  state of the net changes, the changed pin itself gets always its input. */
 class Net
 #ifndef SWIG
     : public std::vector <Pin *>
 #endif
 {
     public:
-        //Net() {} //!< Common Constructor, initially it'a a "empty net" and useless!
+        Net(); //!< Common Constructor, initially it'a a "empty net" and useless!
         virtual ~Net(); //!< Destructor, disconnects save all pins, which are connected
         void Add(Pin *p); //!< Add a pin to net, e.g. connect a pin to others
         virtual void Delete(Pin *p); //!< Remove a pin from net
          //! Calculate a "electrical potential" on the net and set all pin inputs with this value
         virtual bool CalcNet();
+        //! Update the net after a output change of connected pin p
+        bool PinChanged(Pin *p);
+        //! Forget counted output states, the next change recalculates the whole net
+        /*! Used, if output states are set without update of the net, e.g. on snapshot restore. */
+        void Invalidate(void);
+        //! Set a propagation delay in [ns] for all pin changes on this net
+        /*! With a delay > 0, all pins of the net get a new resolved state
+          after this time. Devices on such a net can then run in different
+          partitions of a parallel run, see SystemClock::SetParallel. Set it,
+          before the simulation starts. Changes, which are on the way, aren't
+          part of a Snapshot. */
+        void SetDelay(SystemClockOffset d) { delay = (d > 0) ? d : 0; }
+        SystemClockOffset GetDelay(void) const { return delay; }
 
         void SetName( const std::string& n) { name = n; }
         std::string GetName() const { return name; }
         
     private:
         friend void Pin::RegisterNet(Net*);
+        friend class NetDelivery;
+        friend class SystemClock;
         std::string name;
+
+        std::vector<Pin::T_Pinstate> driverState; //!< output state of every pin, as counted in driverCount
+        unsigned int driverCount[Pin::ANALOG_SHORTED + 1]; //!< number of pins for every output state
+        Pin result; //!< resolved state, which is given to all pin inputs
+
+        void CountDrivers(void); //!< count output states of all pins again
+        Pin Resolve(void); //!< resolved state from driverCount
+        static bool SameInput(const Pin &a, const Pin &b); //!< true, if pins would get the same input
+
+        SystemClockOffset delay; //!< propagation delay, see SetDelay
+#ifndef SWIG
+        //! A output change of a pin, which isn't resolved yet
+        struct PendingChange {
+            SystemClockOffset time; //!< time of the change
+            unsigned int index; //!< index of the pin in the net
+            Pin state; //!< output of the pin
+            bool operator<(const PendingChange &c) const { return time < c.time || (time == c.time && index < c.index); }
+        };
+
+        std::vector<Pin> driverPin; //!< with delay: output of every pin, as counted in driverCount
+        std::deque<std::pair<SystemClockOffset, Pin> > changes; //!< with delay: resolved states and the time, when pins get them
+        unsigned long long changesDone; //!< number of changes, which were removed from the front of changes
+        NetDelivery delivery; //!< sets the changes on all pins in a serial run
+        bool deferred; //!< set in a parallel run: changes are collected in pending and resolved by Flush
+        std::vector<PendingChange> pending; //!< output changes of a parallel run, which aren't resolved yet
+        std::mutex pendingMutex; //!< lock for pending
+
+        //! Resolves the output change of pin index to state at time, with delay
+        void ResolveDelayed(SystemClockOffset time, unsigned int index, const Pin &state);
+        //! Resolves all pending changes in order of time and pin index
+        void Flush(void);
+        //! Removes all changes before number done from changes
+        void Trim(unsigned long long done);
+#endif
 };
 
 #endif
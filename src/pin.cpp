@@ -29,12 +29,13 @@
 #include <iostream>
 #include "avrerror.h"
 
-#define traceOut sysConHandler.traceOutStream()
+#define traceOut GetSystemConsoleHandler().traceOutStream()
 
 
 #include "pin.h"
 #include "net.h"
 #include "rwmem.h"
+#include "snapshot.h"
 
 float AnalogValue::getA(float vcc) {
     switch(dState) {
@@ -80,6 +81,10 @@ void Pin::SetInState(const Pin &p) {
             pinRegOfPort->hardwareChange(*pinOfPort);
     }
 
+    NotifyListeners();
+}
+
+void Pin::NotifyListeners(void) {
     std::vector<HasPinNotifyFunction*>::iterator ii;
     std::vector<HasPinNotifyFunction*>::iterator ee = notifyList.end();
 
@@ -94,7 +99,7 @@ bool Pin::CalcPin(void) {
         SetInState(*this);
         return (bool)*this;
     } else {
-        return connectedTo->CalcNet();
+        return connectedTo->PinChanged(this);
     }
 }
 
@@ -102,6 +107,7 @@ Pin::Pin(T_Pinstate ps) {
     pinOfPort = nullptr;
     pinRegOfPort = nullptr;
     connectedTo = nullptr;
+    netIndex = 0;
     mask = 0;
     
     outState = ps;
@@ -132,6 +138,7 @@ Pin::Pin() {
     pinOfPort = nullptr; 
     pinRegOfPort = nullptr;
     connectedTo = nullptr;
+    netIndex = 0;
     mask = 0;
     
     outState = TRISTATE;
@@ -142,11 +149,26 @@ Pin::~Pin() {
     UnRegisterNet(connectedTo);
 }
 
+void Pin::Checkpoint(Snapshot &snap) {
+    int dState = analogVal.getD();
+    float aValue = analogVal.getRaw();
+    snap.Value(outState);
+    snap.Value(dState);
+    snap.Value(aValue);
+    if(snap.IsRestoring()) {
+        if(dState == AnalogValue::ST_ANALOG)
+            analogVal.setA(aValue);
+        else
+            analogVal.setD(dState);
+    }
+}
+
 Pin::Pin(unsigned char *parentPin, unsigned char _mask) { 
     pinOfPort = parentPin;
     pinRegOfPort = nullptr;
     mask = _mask;
     connectedTo = nullptr;
+    netIndex = 0;
     
     outState = TRISTATE;
 }
@@ -155,6 +177,7 @@ Pin::Pin(const Pin& p) {
     pinOfPort = nullptr; // don't take over HWPort connection!
     pinRegOfPort = nullptr;
     connectedTo = nullptr; // don't take over Net instance!
+    netIndex = 0;
     mask = 0;
     
     outState = p.outState;
@@ -166,6 +189,7 @@ Pin::Pin(float analog) {
     pinOfPort = nullptr;
     pinRegOfPort = nullptr;
     connectedTo = nullptr;
+    netIndex = 0;
     analogVal.setA(analog);
 
     outState = ANALOG;
@@ -415,7 +439,8 @@ PortPin::PortPin() {
 
 PortPin::~PortPin() {
     // unregister myself on Net instance
-    connectedTo->Delete(this);
+    if(connectedTo != nullptr)
+        connectedTo->Delete(this);
 }
 
 void PortPin::ResetOverride(void) {
@@ -424,6 +449,17 @@ void PortPin::ResetOverride(void) {
     PUOE = PUOV = 0;
 }
 
+void PortPin::Checkpoint(Snapshot &snap) {
+    Pin::Checkpoint(snap);
+    snap.Value(DDOE);
+    snap.Value(DDOV);
+    snap.Value(PVOE);
+    snap.Value(PVOV);
+    snap.Value(PVOEwDDR);
+    snap.Value(PUOE);
+    snap.Value(PUOV);
+}
+
 int PortPin::RegisterAlternateUse(void) {
     assert(regCount < (sizeof(DDOV) * 8)); // bit count is used!
     return regCount++;
@@ -478,7 +514,7 @@ void PortPin::SetPUOE(bool val, int index) {
         PUOE &= ~(1 << index);
 }
 
-bool PortPin::CalcPinOverride(bool ddr, bool port, bool pud) {
+void PortPin::CalcOutState(bool ddr, bool port, bool pud) {
     unsigned char ddov = DDOE & DDOV; // masking values
     unsigned char pvov = PVOE & PVOV;
     unsigned char pvovwddr = PVOEwDDR & PVOV;
@@ -499,6 +535,10 @@ bool PortPin::CalcPinOverride(bool ddr, bool port, bool pud) {
             outState = Pin::TRISTATE;
     }
 
+}
+
+bool PortPin::CalcPinOverride(bool ddr, bool port, bool pud) {
+    CalcOutState(ddr, port, pud);
     return CalcPin();
 }
 
@@ -29,12 +29,13 @@
 #include <vector>
 #include "avrerror.h"
 
-#define traceOut sysConHandler.traceOutStream()
+#define traceOut GetSystemConsoleHandler().traceOutStream()
 
 #include "pinnotify.h"
 
 class Net;
 class OpenDrain;
+class Snapshot;
 class HWPort;
 template<typename T> class IOReg;
 
@@ -109,6 +110,9 @@ class Pin {
         AnalogValue analogVal; //!< "real" analog voltage value
 
         Net *connectedTo; //!< the connection to other pins (nullptr, if not connected)
+        unsigned int netIndex; //!< position in connected net, maintained by Net
+
+        void NotifyListeners(void); //!< calls all listeners for change of input value
 
     public:
 
@@ -160,13 +164,15 @@ class Pin {
         Pin& SetAnalogValue(float value);  //!< Sets the pin to an real analog value
         void SetRawAnalog(float value) { analogVal.setA(value); }
         void RegisterCallback(HasPinNotifyFunction *); //!< register a listener for input value change
+        virtual void Checkpoint(Snapshot &snap); //!< save or restore output stage and analog value, without update of net
         //! Update input values from output values
         /*! If there is no connection to other pins, then it will reflect the own
-        output value to own input value. Otherwise it calls Net::CalcNet method */
+        output value to own input value. Otherwise it calls Net::PinChanged method */
         bool CalcPin(void);
 
         bool isPortPin(void) { return pinOfPort != nullptr; } //!< True, if it's a port pin
         bool isConnected(void) { return connectedTo != nullptr; } //!< True, if it's connected to other pins
+        Net *GetNet(void) { return connectedTo; } //!< The net, this pin is connected to (nullptr, if not connected)
         bool hasListener(void) { return notifyList.size() != 0; } //!< True, if there change listeners
 
         friend class HWPort;
@@ -193,6 +199,7 @@ class PortPin: public Pin {
         PortPin(void); //!< common constructor, initial output state is tristate
         virtual ~PortPin(); //!< pin destructor, breaks save connection to other pins, if necessary
         void ResetOverride(void); //!< reset override states
+        void Checkpoint(Snapshot &snap) override; //!< save or restore also override states
 
         // override interface, index is the registered index for multiple alternate pin functions
         void SetDDOV(bool val, int index = 0); //!< set data direction override value
@@ -207,6 +214,7 @@ class PortPin: public Pin {
         int RegisterAlternateUse(void); //!< register an alternate function to pin
 
         // calculate outState with override
+        void CalcOutState(bool ddr, bool port, bool pud); //!< calculate pin outState with override functionality, without update of input
         bool CalcPinOverride(bool ddr, bool port, bool pud); //!< calculate pin outState with override functionality
 
         friend class HWPort;
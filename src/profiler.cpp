@@ -0,0 +1,200 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "profiler.h"
+#include "avrdevice.h"
+#include "flash.h"
+#include "hwstack.h"
+#include "avrerror.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+
+// opcodes, which are followed by the shadow call stack
+static inline bool IsCallOpcode(unsigned int op) {
+    return (op & 0xfe0e) == 0x940e || // CALL
+           (op & 0xf000) == 0xd000 || // RCALL
+           op == 0x9509 ||            // ICALL
+           op == 0x9519;              // EICALL
+}
+
+static inline bool IsReturnOpcode(unsigned int op) {
+    return op == 0x9508 || op == 0x9518; // RET, RETI
+}
+
+Profiler::Profiler(AvrDevice *_core):
+    core(_core),
+    cycles(_core->Flash->GetSize() >> 1, 0),
+    executed(_core->Flash->GetSize() >> 1, 0),
+    lastPC(0),
+    lastExecuted(false),
+    interruptPending(false),
+    interruptReturn(0),
+    lastCycle(0),
+    interruptCycle(0),
+    instructions(0) {}
+
+void Profiler::Retire(unsigned long long cycle) {
+    // cycle counter could go back by restoring a snapshot
+    if(cycle > lastCycle && lastPC < cycles.size())
+        cycles[lastPC] += cycle - lastCycle;
+    lastCycle = cycle;
+
+    if(!lastExecuted)
+        return;
+    lastExecuted = false;
+
+    unsigned int op = core->Flash->ReadMemRawWord(lastPC << 1);
+    if(IsCallOpcode(op))
+        PushFrame(lastPC, core->PC, cycle, false);
+    else if(IsReturnOpcode(op))
+        Return(cycle);
+}
+
+void Profiler::PushFrame(unsigned int callSite, unsigned int target, unsigned long long cycle, bool isInterrupt) {
+    if(frames.size() >= maxDepth)
+        frames.erase(frames.begin());
+    Frame f;
+    f.callSite = callSite;
+    f.target = target;
+    f.stackPointer = core->stack->GetStackPointer();
+    f.startCycle = cycle;
+    f.startInstructions = instructions;
+    f.isInterrupt = isInterrupt;
+    frames.push_back(f);
+}
+
+void Profiler::Return(unsigned long long cycle) {
+    // all frames below the stack pointer are left, on a hardware stack the
+    // stack pointer doesn't change, then the last frame is left
+    unsigned long sp = core->stack->GetStackPointer();
+    bool popped = false;
+    while(!frames.empty() && (frames.back().stackPointer < sp ||
+                              (!popped && frames.back().stackPointer == sp))) {
+        const Frame &f = frames.back();
+        if(!f.isInterrupt) {
+            CallCost &c = calls[((unsigned long long)f.callSite << 32) | f.target];
+            c.calls++;
+            if(cycle > f.startCycle)
+                c.cycles += cycle - f.startCycle;
+            c.instructions += instructions - f.startInstructions;
+        }
+        frames.pop_back();
+        popped = true;
+    }
+}
+
+void Profiler::Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) {
+    Retire(cycle);
+    // the cycles to enter the interrupt are counted for the vector
+    lastPC = vectorPC;
+    interruptPending = true;
+    interruptReturn = returnPC;
+    interruptCycle = cycle;
+}
+
+void Profiler::Reset(void) {
+    frames.clear();
+    lastExecuted = false;
+    interruptPending = false;
+}
+
+std::string Profiler::FunctionName(unsigned int word, unsigned int &start) {
+    unsigned int offset;
+    std::string_view label = core->Flash->FindSymbol(word << 1, offset);
+    start = (word << 1) - offset;
+    if(!label.empty())
+        return std::string(label);
+    char buf[16];
+    snprintf(buf, sizeof(buf), "0x%x", start);
+    return buf;
+}
+
+void Profiler::WriteCallgrind(std::ostream &os, const std::string &cmd) {
+    // call sites in order of flash words
+    std::vector<std::pair<unsigned long long, CallCost> > sites(calls.begin(), calls.end());
+    std::sort(sites.begin(), sites.end(),
+              [](const std::pair<unsigned long long, CallCost> &a,
+                 const std::pair<unsigned long long, CallCost> &b) { return a.first < b.first; });
+
+    unsigned long long totalCycles = 0, totalInstructions = 0;
+    for(size_t i = 0; i < cycles.size(); i++) {
+        totalCycles += cycles[i];
+        totalInstructions += executed[i];
+    }
+
+    os << "# callgrind format" << std::endl
+       << "version: 1" << std::endl
+       << "creator: simulavr" << std::endl
+       << "cmd: " << cmd << std::endl
+       << "positions: instr" << std::endl
+       << "events: Cycles Instructions" << std::endl
+       << "summary: " << totalCycles << " " << totalInstructions << std::endl
+       << std::endl
+       << "ob=" << cmd << std::endl;
+
+    bool inFunction = false;
+    unsigned int function = 0;
+    size_t site = 0;
+    for(unsigned int word = 0; word < cycles.size(); word++) {
+        bool hasSite = site < sites.size() && (sites[site].first >> 32) == word;
+        if(cycles[word] == 0 && executed[word] == 0 && !hasSite)
+            continue;
+
+        unsigned int start;
+        std::string name = FunctionName(word, start);
+        if(!inFunction || start != function) {
+            os << "fn=" << name << std::endl;
+            inFunction = true;
+            function = start;
+        }
+        if(cycles[word] != 0 || executed[word] != 0)
+            os << "0x" << std::hex << (word << 1) << std::dec << " "
+               << cycles[word] << " " << executed[word] << std::endl;
+
+        for(; site < sites.size() && (sites[site].first >> 32) == word; site++) {
+            unsigned int target = sites[site].first & 0xffffffff;
+            const CallCost &c = sites[site].second;
+            unsigned int targetStart;
+            os << "cfn=" << FunctionName(target, targetStart) << std::endl
+               << "calls=" << c.calls << " 0x" << std::hex << (target << 1) << std::endl
+               << "0x" << (word << 1) << std::dec << " " << c.cycles << " " << c.instructions << std::endl;
+        }
+    }
+
+    os << std::endl << "totals: " << totalCycles << " " << totalInstructions << std::endl;
+}
+
+void Profiler::WriteFile(const std::string &filename, const std::string &cmd) {
+    std::ofstream f(filename.c_str(), std::ios::out | std::ios::trunc);
+    if(!f)
+        avr_error("profile: can't create file '%s'", filename.c_str());
+    WriteCallgrind(f, cmd);
+    if(!f)
+        avr_error("profile: can't write file '%s'", filename.c_str());
+}
+
+// EOF
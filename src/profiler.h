@@ -0,0 +1,123 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef PROFILER
+#define PROFILER
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+
+#include "instructionobserver.h"
+
+class AvrDevice;
+
+//! Cycle accurate function profiler for the program in flash
+/*! The profiler is added as InstructionObserver to the core. All cycles
+  between two instruction starts are
+  counted for the first instruction, so wait states, hold cycles of hardware
+  and skipped idle loops are included. Calls are detected by the opcode of
+  the last instruction (CALL, RCALL, ICALL, EICALL), returns by RET and RETI
+  and the stack pointer, so the shadow call stack follows also returns over
+  more than one frame. The result is written in callgrind format, the cost
+  of a function is the sum of its instructions, the inclusive cost of a call
+  is counted from the first instruction of the callee till the return. */
+class Profiler: public InstructionObserver {
+
+    private:
+        //! A entry on the shadow call stack
+        struct Frame {
+            unsigned int callSite; //!< flash word of call instruction or return address for a interrupt
+            unsigned int target; //!< flash word of called function
+            unsigned long stackPointer; //!< stack pointer after the return address was pushed
+            unsigned long long startCycle; //!< cycle, in which the call was entered
+            unsigned long long startInstructions; //!< instruction counter, when the call was entered
+            bool isInterrupt; //!< true, if frame was created by a interrupt
+        };
+
+        //! Counters for one call site and target
+        struct CallCost {
+            unsigned long long calls; //!< number of calls
+            unsigned long long cycles; //!< inclusive cycles
+            unsigned long long instructions; //!< inclusive instructions
+        };
+
+        static const unsigned int maxDepth = 1024; //!< frames of shadow call stack, oldest is dropped, if full
+
+        AvrDevice *core; //!< the profiled core
+        std::vector<unsigned long long> cycles; //!< cycles per flash word
+        std::vector<unsigned long long> executed; //!< executed instructions per flash word
+        std::unordered_map<unsigned long long, CallCost> calls; //!< call costs by call site << 32 | target
+        std::vector<Frame> frames; //!< shadow call stack
+        unsigned int lastPC; //!< flash word of last started instruction
+        bool lastExecuted; //!< false, if lastPC was set by Interrupt and isn't executed yet
+        bool interruptPending; //!< interrupt entered, frame is created on next instruction
+        unsigned int interruptReturn; //!< return address of pending interrupt
+        unsigned long long lastCycle; //!< cycle, in which lastPC was started
+        unsigned long long interruptCycle; //!< cycle, in which the pending interrupt was entered
+        unsigned long long instructions; //!< count of all executed instructions
+
+        //! Counts cycles of last instruction and follows calls and returns
+        void Retire(unsigned long long cycle);
+        //! Removes frames, which are left by a return
+        void Return(unsigned long long cycle);
+        //! Pushes a frame to shadow call stack
+        void PushFrame(unsigned int callSite, unsigned int target, unsigned long long cycle, bool isInterrupt);
+        //! Returns function name and start address (in bytes) for a flash word
+        std::string FunctionName(unsigned int word, unsigned int &start);
+
+    public:
+        //! Creates a profiler for core, core has to be loaded with the program
+        Profiler(AvrDevice *core);
+
+        void Instruction(unsigned int pc, unsigned long long cycle) override {
+            Retire(cycle);
+            lastPC = pc;
+            lastExecuted = true;
+            instructions++;
+            if(pc < executed.size())
+                executed[pc]++;
+            if(interruptPending) {
+                interruptPending = false;
+                PushFrame(interruptReturn, pc, interruptCycle, true);
+            }
+        }
+
+        void Interrupt(unsigned int vector, unsigned int returnPC, unsigned int vectorPC, unsigned long long cycle) override;
+
+        //! Clears shadow call stack on reset of core, but not the collected costs
+        void Reset(void) override;
+
+        //! Writes collected costs in callgrind format
+        /*! @param os output stream
+          @param cmd name of the program, written as "cmd:" */
+        void WriteCallgrind(std::ostream &os, const std::string &cmd);
+
+        //! Writes collected costs in callgrind format to file
+        void WriteFile(const std::string &filename, const std::string &cmd);
+};
+
+#endif
@@ -21,6 +21,7 @@
   #include "flash.h"
   #include "hweeprom.h"
   #include "avrerror.h"
+  #include "simulationcontext.h"
   #include "pysimulationmember.h"
   #include "hwport.h"
   #include "hwstack.h"
@@ -87,7 +88,9 @@ namespace std {
 %feature("director") HasPinNotifyFunction;
 %include "pinnotify.h"
 %include "traceval.h"
+%include "irqstatistic.h"
 %include "irqsystem.h"
+%include "tracescope.h"
 %include "avrdevice.h"
 
 %extend DumpManager {
@@ -177,20 +180,19 @@ namespace std {
 %include "flash.h"
 %include "hweeprom.h"
 
-%extend Breakpoints {
-  void RemoveBreakpoint(unsigned bp) {
-    Breakpoints::iterator ii;
-    if ((ii = find($self->begin(), $self->end(), bp)) != $self->end()) $self->erase(ii);
-  }
-  void AddBreakpoint(unsigned bp) {
-    $self->push_back(bp);
-  }
-}
-
 %include "avrsignature.h"
 
 %include "avrerror.h"
 
+// scripts run in the default simulation context, they access its console
+// handler as variable sysConHandler
+%{
+  static SystemConsoleHandler &sysConHandler = SimulationContext::Default().GetConsoleHandler();
+%}
+%immutable;
+SystemConsoleHandler sysConHandler;
+%mutable;
+
 %include "cmd/dumpargs.h"
 %include "cmd/gdb.h"
 
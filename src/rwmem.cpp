@@ -38,6 +38,7 @@
 #include "rwmem.h"
 #include "avrdevice.h"
 #include "memory.h"
+#include "snapshot.h"
 
 
 RWMemoryMember::RWMemoryMember(TraceValueRegister *_reg,
@@ -92,6 +93,10 @@ RWMemoryMember::~RWMemoryMember() {
         delete tv;
 }
 
+void GPIORegister::Checkpoint(Snapshot &snap) {
+    snap.Value(value);
+}
+
 CLKPRRegister::CLKPRRegister(AvrDevice *core,
                              TraceValueRegister *registry):
         RWMemoryMember(registry, "CLKPR"),
@@ -115,6 +120,11 @@ void CLKPRRegister::Reset(void) {
     activate = 0;
 }
 
+void CLKPRRegister::Checkpoint(Snapshot &snap) {
+    snap.Value(value);
+    snap.Value(activate);
+}
+
 unsigned int CLKPRRegister::CpuCycle(void) {
     // control clock set activation
     if(activate > 0) {
@@ -124,7 +134,13 @@ unsigned int CLKPRRegister::CpuCycle(void) {
     return 0;
 }
 
+unsigned int CLKPRRegister::GetIdleCycles(void) {
+    // only activation period has to be counted down
+    return (activate > 0) ? 0 : idleForever;
+}
+
 void CLKPRRegister::set(unsigned char v) {
+    _core->RescheduleHardware(this);
     if(v == 0x80) {
         // set activation period
         if(activate == 0) activate = 4;
@@ -149,6 +165,10 @@ XDIVRegister::XDIVRegister(AvrDevice *core,
     Reset();
 }
 
+void XDIVRegister::Checkpoint(Snapshot &snap) {
+    snap.Value(value);
+}
+
 void XDIVRegister::set(unsigned char v) {
     bool old_enbl = (value & 0x80) == 0x80, new_enbl = (v & 0x80) == 0x80;
     if(new_enbl) {
@@ -185,6 +205,10 @@ void OSCCALRegister::Reset(void) {
         value = 42;
 }
 
+void OSCCALRegister::Checkpoint(Snapshot &snap) {
+    snap.Value(value);
+}
+
 void OSCCALRegister::set(unsigned char v) {
     if(cal_type == OSCCAL_V4)
         v &= 0x7f;
@@ -198,7 +222,7 @@ RAM::RAM(AvrDevice* core_, size_t myAddress_, TraceValueCoreRegister *_reg, cons
     myAddress{ myAddress_ }
 {
     corereg = _reg;
-    value = 0xaa;
+    core->dataMem[myAddress] = 0xaa;
     if(name.size()) {
         tv = new TraceValue(8, corereg->GetTraceValuePrefix() + name, number);
         if(!corereg) {
@@ -210,15 +234,23 @@ RAM::RAM(AvrDevice* core_, size_t myAddress_, TraceValueCoreRegister *_reg, cons
     }
 }
 
+void RAM::SyncTraceValue(void) {
+    if(tv)
+        tv->set_written(core->dataMem[myAddress]);
+}
+
 unsigned char RAM::get() const 
 {
+    unsigned char value = core->dataMem[myAddress];
     if (core->trace_on==1) 
     {
         // fix me: it makes no sense to compare here if we already know during construction that we are register or io or i/e ram
 
         if ( myAddress > 0x20 )
         {
-            traceOut << "IRAM["<<HexShort(myAddress) <<","<< core->data->GetSymbolAtAddress(myAddress)<<"]-->"<<HexChar(value)<<std::dec<<"--> ";
+            traceOut << "IRAM["<<HexShort(myAddress) <<",";
+            core->data->WriteSymbolAtAddress(traceOut, myAddress);
+            traceOut <<"]-->"<<HexChar(value)<<std::dec<<"--> ";
         }
     }
     return value; 
@@ -226,13 +258,15 @@ unsigned char RAM::get() const
 
 void RAM::set(unsigned char v) 
 {
-    value=v; 
+    core->dataMem[myAddress] = v;
     if (core->trace_on==1) 
     {
         // fix me: it makes no sense to compare here if we already know during construction that we are register or io or i/e ram
         if ( myAddress > 0x20 )
         {
-            traceOut << "IRAM["<<HexShort(myAddress) <<","<< core->data->GetSymbolAtAddress(myAddress)<<"]="<<HexChar(v)<<std::dec<<" ";
+            traceOut << "IRAM["<<HexShort(myAddress) <<",";
+            core->data->WriteSymbolAtAddress(traceOut, myAddress);
+            traceOut <<"]="<<HexChar(v)<<std::dec<<" ";
         }
         else  // register
         {
@@ -279,6 +313,50 @@ void InvalidMem::set(unsigned char c) {
     avr_warning("%s", s.c_str());
 }
 
+WatchpointMember::WatchpointMember(AvrDevice* _c, unsigned int _a, RWMemoryMember *_cell):
+    RWMemoryMember(_c),
+    core(_c),
+    addr(_a),
+    cell(_cell) {
+    for(int i = 0; i < 4; i++)
+        counts[i] = 0;
+}
+
+bool WatchpointMember::Remove(int type) {
+    if(counts[type] == 0)
+        return false;
+    counts[type]--;
+    return true;
+}
+
+void WatchpointMember::Hit(int type) const {
+    if(counts[type] > 0)
+        core->WatchpointHit(addr, (AvrDevice::WatchpointType)type);
+    else if(counts[AvrDevice::WATCH_ACCESS] > 0)
+        core->WatchpointHit(addr, AvrDevice::WATCH_ACCESS);
+}
+
+unsigned char WatchpointMember::get() const {
+    unsigned char val = *cell;
+    Hit(AvrDevice::WATCH_READ);
+    return val;
+}
+
+void WatchpointMember::set(unsigned char val) {
+    *cell = val;
+    Hit(AvrDevice::WATCH_WRITE);
+}
+
+void WatchpointMember::set_bit(unsigned int bitaddr) {
+    cell->set_bit(bitaddr);
+    Hit(AvrDevice::WATCH_WRITE);
+}
+
+void WatchpointMember::clear_bit(unsigned int bitaddr) {
+    cell->clear_bit(bitaddr);
+    Hit(AvrDevice::WATCH_WRITE);
+}
+
 NotSimulatedRegister::NotSimulatedRegister(const char * message_on_access_)
     : message_on_access(message_on_access_)  {}
 
@@ -313,6 +391,12 @@ unsigned char IOSpecialReg::get() const {
     return val;
 }
 
+void IOSpecialReg::Checkpoint(Snapshot &snap) {
+    snap.Value(value);
+    if(snap.IsRestoring())
+        hardwareChange(value);
+}
+
 void IOSpecialReg::set(unsigned char val) {
     for(size_t i = 0; i < clients.size(); i++)
     {
@@ -125,6 +125,7 @@ class GPIORegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset() override { value = 0; }
+        void Checkpoint(Snapshot &snap) override;
 
     protected:
         unsigned char get() const override { return value; }
@@ -143,7 +144,9 @@ class CLKPRRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset() override ;
+        void Checkpoint(Snapshot &snap) override;
         unsigned int CpuCycle() override;
+        unsigned int GetIdleCycles() override;
 
     protected:
         unsigned char get() const override { return value; }
@@ -164,6 +167,7 @@ class XDIVRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset() override { value = 0; }
+        void Checkpoint(Snapshot &snap) override;
 
     protected:
         unsigned char get() const override { return value; }
@@ -190,6 +194,7 @@ class OSCCALRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset() override;
+        void Checkpoint(Snapshot &snap) override;
 
     protected:
         unsigned char get() const override { return value; }
@@ -201,7 +206,9 @@ class OSCCALRegister: public RWMemoryMember, public Hardware {
 };
 
 //! One byte in any AVR RAM
-/*! Allows clean read and write accesses and simply has one stored byte. */
+/*! Allows clean read and write accesses and simply has one stored byte. The
+  byte itself is stored in AvrDevice::dataMem, so the core can access it without
+  this object, as long as there is no tracing on this cell. */
 class RAM : public RWMemoryMember {
 
     public:
@@ -212,6 +219,15 @@ class RAM : public RWMemoryMember {
             const size_t number,
             const size_t maxsize);
 
+        //! Get data address of this cell
+        size_t GetAddress(void) const { return myAddress; }
+        //! Returns true, if the trace value of this cell is enabled for a dumper
+        bool IsTraced(void) const { return tv && tv->enabled(); }
+        //! Returns true, if the trace value of this cell was written
+        bool IsWritten(void) const { return tv && tv->written(); }
+        //! Takes over value into trace value, after cell was written without RWMemoryMember
+        void SyncTraceValue(void);
+
     protected:
         unsigned char get() const override;
         void set(unsigned char) override;
@@ -219,7 +235,6 @@ class RAM : public RWMemoryMember {
     private:
         AvrDevice* core;
         size_t myAddress;
-        unsigned char value;
         TraceValueCoreRegister *corereg;
 };
 
@@ -238,6 +253,40 @@ class InvalidMem : public RWMemoryMember {
         void set(unsigned char) override;
 };
 
+//! Memory cell, which is put in front of a watched cell for data watchpoints
+/*! Only watched addresses get such a cell, so other memory is accessed
+  without overhead. All accesses are passed to the original cell, a access,
+  which matches a watchpoint, is reported to the device. */
+class WatchpointMember : public RWMemoryMember {
+    private:
+        AvrDevice* core;
+        unsigned int addr; //!< data address of this cell
+        RWMemoryMember *cell; //!< original memory cell
+        unsigned int counts[4]; //!< count of watchpoints per AvrDevice::WatchpointType
+
+        //! Reports a access to device, if a watchpoint matches
+        void Hit(int type) const;
+
+    public:
+        WatchpointMember(AvrDevice *core, unsigned int addr, RWMemoryMember *cell);
+
+        //! Returns the original memory cell
+        RWMemoryMember *GetCell(void) { return cell; }
+        //! Adds a watchpoint of AvrDevice::WatchpointType
+        void Add(int type) { counts[type]++; }
+        //! Removes a watchpoint of AvrDevice::WatchpointType, returns false, if there is none
+        bool Remove(int type);
+        //! True, if there is a watchpoint left on this cell
+        bool IsUsed(void) const { return counts[1] + counts[2] + counts[3] > 0; }
+
+        unsigned char get() const override;
+        void set_bit(unsigned int bitaddr) override;
+        void clear_bit(unsigned int bitaddr) override;
+
+    protected:
+        void set(unsigned char) override;
+};
+
 //! An IO register which is not simulated because programmers are lazy.
 /*! Reads and writes are ignored and produce warning. */
 class NotSimulatedRegister : public RWMemoryMember {
@@ -438,6 +487,9 @@ class IOSpecialReg: public RWMemoryMember {
           @param mask the bitmask for val */
         void hardwareChangeMask(unsigned char val, unsigned char mask) { if(tv) tv->change(val, mask); }
 
+        //! Saves or restores the register value without informing clients, see Hardware::Checkpoint
+        void Checkpoint(Snapshot &snap);
+
     protected:
         std::vector<IOSpecialRegClient*> clients; //!< clients-list with registered clients
 
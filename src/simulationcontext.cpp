@@ -0,0 +1,75 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <algorithm>
+
+#include "simulationcontext.h"
+#include "avrdevice.h"
+#include "traceval.h"
+
+thread_local SimulationContext *SimulationContext::current = nullptr;
+
+SimulationContext::SimulationContext():
+    dumpManager(nullptr) {}
+
+SimulationContext::~SimulationContext() {
+    // devices unregister from dump manager and from this context
+    while(!devices.empty())
+        delete devices.back();
+    ResetDumpManager();
+    if(current == this)
+        current = nullptr;
+}
+
+SimulationContext &SimulationContext::Default(void) {
+    static SimulationContext context;
+    return context;
+}
+
+void SimulationContext::RemoveDevice(AvrDevice *dev) {
+    std::vector<AvrDevice *>::iterator ii = std::find(devices.begin(), devices.end(), dev);
+    if(ii != devices.end())
+        devices.erase(ii);
+}
+
+DumpManager *SimulationContext::GetDumpManager(void) {
+    if(dumpManager == nullptr)
+        dumpManager = new DumpManager();
+    return dumpManager;
+}
+
+void SimulationContext::ResetDumpManager(void) {
+    if(dumpManager != nullptr) {
+        dumpManager->detachAvrDevices();
+        delete dumpManager;
+    }
+    dumpManager = nullptr;
+}
+
+SystemConsoleHandler &GetSystemConsoleHandler(void) {
+    return SimulationContext::Current().GetConsoleHandler();
+}
+
+// EOF
@@ -0,0 +1,96 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SIMULATIONCONTEXT_H_INCLUDED
+#define SIMULATIONCONTEXT_H_INCLUDED
+
+#include "avrerror.h"
+#include "application.h"
+#include "systemclock.h"
+
+class DumpManager;
+class AvrDevice;
+
+//! Holds all parts of a simulation, which are shared by its devices
+/*! A simulation context owns the system clock, the dump manager, the console
+  handler, the application instance for printable results and the devices,
+  which were created in it. Devices, which aren't deleted before, are deleted
+  with the context. Devices and
+  other simulation members use the context, which is current for the thread,
+  on which they are created: SystemClock::Instance(), DumpManager::Instance(),
+  Application::GetInstance() and GetSystemConsoleHandler() return the parts of
+  this context.
+
+  Without activating a context, all threads use the default context. So a
+  single simulation doesn't need to care about it. To run several independent
+  simulations concurrently, every thread creates and activates its own context,
+  before it creates devices for its simulation. */
+class SimulationContext {
+
+    public:
+        SimulationContext();
+        ~SimulationContext();
+
+        //! Makes this context the current context for the calling thread
+        void Activate(void) { current = this; }
+        //! Makes the default context current again for the calling thread
+        static void Deactivate(void) { current = nullptr; }
+
+        //! Returns the context, which is current for the calling thread
+        static SimulationContext &Current(void) { return (current != nullptr) ? *current : Default(); }
+        //! Returns the default context, used by threads without an activated context
+        static SimulationContext &Default(void);
+
+        //! Returns the system clock of this context
+        SystemClock &GetSystemClock(void) { return clock; }
+        //! Returns the dump manager of this context, it's created on first use
+        DumpManager *GetDumpManager(void);
+        //! Deletes the dump manager of this context, see DumpManager::Reset
+        void ResetDumpManager(void);
+        //! Returns the console handler of this context
+        SystemConsoleHandler &GetConsoleHandler(void) { return conHandler; }
+        //! Returns the application instance of this context
+        Application *GetApplication(void) { return &application; }
+
+        //! Takes over a device, called by the constructor of AvrDevice
+        void AddDevice(AvrDevice *dev) { devices.push_back(dev); }
+        //! Gives up a device, called by the destructor of AvrDevice
+        void RemoveDevice(AvrDevice *dev);
+        //! Returns the devices of this context
+        const std::vector<AvrDevice *> &GetDevices(void) const { return devices; }
+
+    private:
+        SimulationContext(const SimulationContext &); //!< contexts can't be copied
+
+        SystemConsoleHandler conHandler; //!< messages, trace output and exit handling
+        Application application; //!< printable results
+        SystemClock clock; //!< time table for simulation members
+        DumpManager *dumpManager; //!< trace value dumpers, created on first use
+        std::vector<AvrDevice *> devices; //!< devices created in this context
+
+        static thread_local SimulationContext *current; //!< activated context of a thread
+};
+
+#endif
@@ -33,11 +33,19 @@
 * will be called later. People, please avoid polling. */
 class SimulationMember {
     public:
-        SimulationMember(): trace_on{ false }{}
+        SimulationMember(): trace_on{ false }, memberNumber{ NewMemberNumber() }{}
         virtual ~SimulationMember() { }
         /// Return nonzero if a breakpoint was hit.
         virtual int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns=0)=0;
         int trace_on;
+
+        /*! Returns a number, which grows in creation order of members. SystemClock
+          steps members, which are due at the same time, in order of this number. */
+        unsigned long long GetMemberNumber(void) const { return memberNumber; }
+
+    private:
+        unsigned long long memberNumber; //!< see GetMemberNumber
+        static unsigned long long NewMemberNumber(void); //!< next number in creation order
 };
 
 #endif 
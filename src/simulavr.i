@@ -31,6 +31,7 @@
 #include "specialmem.h"
 #include "ui/scope.h"
 #include "avrerror.h"
+#include "simulationcontext.h"
 
 #if defined(_MSC_VER) && defined(_DEBUG)
 #   pragma message ("If link fails because of missing pythonXY_d.lib then")
@@ -56,6 +57,7 @@ namespace std {
 %include "ui/mysocket.h"
 %include "pinnotify.h"
 %include "traceval.h"
+%include "tracescope.h"
 %include "avrdevice.h"
 %include "avrfactory.h"
 %include "at8515.h"
@@ -89,4 +91,13 @@ namespace std {
 %include "ui/scope.h"
 %include "avrerror.h"
 
+// scripts run in the default simulation context, they access its console
+// handler as variable sysConHandler
+%{
+  static SystemConsoleHandler &sysConHandler = SimulationContext::Default().GetConsoleHandler();
+%}
+%immutable;
+SystemConsoleHandler sysConHandler;
+%mutable;
+
 SystemClock &GetSystemClock();
@@ -0,0 +1,128 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "snapshot.h"
+#include "avrerror.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static const char snapshotMagic[8] = { 'S', 'A', 'V', 'R', 'S', 'N', 'A', 'P' };
+
+Snapshot::Snapshot(void):
+    readPos(0),
+    restoring(false) {
+    Write(snapshotMagic, sizeof(snapshotMagic));
+    unsigned int v = version;
+    Value(v);
+}
+
+void Snapshot::Write(const void *src, size_t len) {
+    data.append((const char *)src, len);
+}
+
+void Snapshot::Read(void *dst, size_t len) {
+    if(readPos + len > data.size())
+        avr_error("snapshot: unexpected end of data");
+    memcpy(dst, data.data() + readPos, len);
+    readPos += len;
+}
+
+void Snapshot::Integer(unsigned long long &val, size_t len) {
+    unsigned char buf[sizeof(unsigned long long)];
+    if(restoring) {
+        Read(buf, len);
+        val = 0;
+        for(size_t i = len; i > 0; i--)
+            val = (val << 8) | buf[i - 1];
+    } else {
+        for(size_t i = 0; i < len; i++)
+            buf[i] = (val >> (i * 8)) & 0xff;
+        Write(buf, len);
+    }
+}
+
+void Snapshot::Value(std::string &val) {
+    unsigned int len = val.size();
+    Value(len);
+    if(restoring) {
+        val.resize(len);
+        if(len > 0)
+            Read(&val[0], len);
+    } else
+        Write(val.data(), len);
+}
+
+void Snapshot::Bytes(void *buf, size_t len) {
+    if(restoring)
+        Read(buf, len);
+    else
+        Write(buf, len);
+}
+
+void Snapshot::Section(const char *name) {
+    std::string tag(name);
+    Value(tag);
+    if(restoring && tag != name)
+        avr_error("snapshot: expected section '%s', found '%s'", name, tag.c_str());
+}
+
+void Snapshot::SetData(const std::string &content) {
+    data = content;
+    readPos = 0;
+    restoring = true;
+
+    char magic[sizeof(snapshotMagic)];
+    if(data.size() < sizeof(snapshotMagic))
+        avr_error("snapshot: no snapshot data");
+    Read(magic, sizeof(magic));
+    if(memcmp(magic, snapshotMagic, sizeof(magic)) != 0)
+        avr_error("snapshot: no snapshot data");
+    unsigned int v = 0;
+    Value(v);
+    if(v != version)
+        avr_error("snapshot: format version %u isn't supported (expected %u)", v, version);
+}
+
+void Snapshot::WriteFile(const std::string &filename) const {
+    std::ofstream f(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!f)
+        avr_error("snapshot: can't create file '%s'", filename.c_str());
+    f.write(data.data(), data.size());
+    if(!f)
+        avr_error("snapshot: can't write file '%s'", filename.c_str());
+}
+
+void Snapshot::ReadFile(const std::string &filename) {
+    std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary);
+    if(!f)
+        avr_error("snapshot: can't open file '%s'", filename.c_str());
+    std::ostringstream content;
+    content << f.rdbuf();
+    SetData(content.str());
+}
+
+// EOF
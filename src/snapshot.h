@@ -0,0 +1,103 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SNAPSHOT
+#define SNAPSHOT
+
+#include <string>
+#include <cstddef>
+#include <type_traits>
+
+//! Binary archive to save and restore the state of a simulation
+/*! The same Checkpoint method of a class saves and restores its state: while
+  saving, Value, Bytes and Section append data to the snapshot, while restoring,
+  they read the data back into the given variables. Integer values are stored
+  with their size in little endian byte order, a section tag ensures, that
+  data is read back by the class, which has written it. */
+class Snapshot {
+
+    private:
+        std::string data; //!< binary content, starts with magic and version
+        size_t readPos; //!< next byte to read, if restoring
+        bool restoring; //!< Flag, true if snapshot is read back
+
+        void Write(const void *src, size_t len);
+        void Read(void *dst, size_t len);
+        void Integer(unsigned long long &val, size_t len);
+
+    public:
+        static const unsigned int version = 1; //!< version of binary format
+
+        //! Creates a empty snapshot for saving
+        Snapshot(void);
+
+        //! True, if snapshot is restored, false, if it is saved
+        bool IsRestoring(void) const { return restoring; }
+
+        //! Saves or restores a integer, enum, bool or floating point value
+        template<typename T>
+        void Value(T &val) {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                          "Snapshot::Value needs a scalar type");
+            if constexpr(std::is_floating_point<T>::value) {
+                Bytes(&val, sizeof(T));
+            } else {
+                unsigned long long v = (unsigned long long)val;
+                Integer(v, sizeof(T));
+                val = (T)v;
+            }
+        }
+
+        //! Saves or restores all elements of a array
+        template<typename T, size_t N>
+        void Value(T (&val)[N]) {
+            for(size_t i = 0; i < N; i++)
+                Value(val[i]);
+        }
+
+        //! Saves or restores a string
+        void Value(std::string &val);
+
+        //! Saves or restores a raw memory block
+        void Bytes(void *buf, size_t len);
+
+        //! Saves a section tag or checks it on restore
+        /*! Aborts the simulation, if the tag doesn't match on restore. */
+        void Section(const char *name);
+
+        //! Returns the binary content
+        const std::string &GetData(void) const { return data; }
+
+        //! Takes over binary content and starts restoring from it
+        void SetData(const std::string &content);
+
+        //! Writes binary content to file
+        void WriteFile(const std::string &filename) const;
+
+        //! Reads binary content from file and starts restoring from it
+        void ReadFile(const std::string &filename);
+};
+
+#endif
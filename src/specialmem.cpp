@@ -78,13 +78,13 @@ RWExit::RWExit(TraceValueRegister *registry,
 void RWExit::set(unsigned char c) {
     avr_message("Exiting at simulated program request (write)");
     DumpManager::Instance()->stopApplication();
-    sysConHandler.ExitApplication(c); 
+    GetSystemConsoleHandler().ExitApplication(c); 
 }
 
 unsigned char RWExit::get() const {
     avr_message("Exiting at simulated program request (read)");
     DumpManager::Instance()->stopApplication();
-    sysConHandler.ExitApplication(0); 
+    GetSystemConsoleHandler().ExitApplication(0); 
     return 0;
 }
 
@@ -95,13 +95,13 @@ RWAbort::RWAbort(TraceValueRegister *registry,
 void RWAbort::set(unsigned char c) {
     avr_warning("Aborting at simulated program request (write)");
     DumpManager::Instance()->stopApplication();
-    sysConHandler.AbortApplication(c);
+    GetSystemConsoleHandler().AbortApplication(c);
 }
 
 unsigned char RWAbort::get() const {
     avr_warning("Aborting at simulated program request (read)");
     DumpManager::Instance()->stopApplication();
-    sysConHandler.AbortApplication(0);
+    GetSystemConsoleHandler().AbortApplication(0);
     return 0;
 }
 
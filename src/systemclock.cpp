@@ -30,9 +30,20 @@
 #include "application.h"
 #include "avrdevice.h"
 #include "avrerror.h"
+#include "simulationcontext.h"
+#include "traceval.h"
+#include "pin.h"
+#include "net.h"
+#include "snapshot.h"
 
 #include "signal.h"
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 
     template<typename Key, typename Value>
@@ -68,7 +79,7 @@ void MinHeap<Key, Value>::InsertInternal(Key k, Value v, unsigned pos)
 {
     for(unsigned i = pos;;) {
         unsigned parent = i/2;
-        if(parent == 0 || (*this)[parent-1].first <= k) {
+        if(parent == 0 || !Less(k, v, (*this)[parent-1])) {
             (*this)[i-1].first = k;
             (*this)[i-1].second = v;
             return;
@@ -90,9 +101,10 @@ void MinHeap<Key, Value>::RemoveAtPositionAndInsertInternal(Key k, Value v, unsi
         unsigned left = 2*i;
         unsigned right = 2*i + 1;
         unsigned smallest = i;
-        if(left-1 < this->size() && (*this)[left-1].first < k)
+        if(left-1 < this->size() && Less((*this)[left-1], k, v))
             smallest = left;
-        if(right-1 < this->size() && (*this)[right-1].first < k && (*this)[right-1].first < (*this)[left-1].first)
+        if(right-1 < this->size() && Less((*this)[right-1], k, v) &&
+           Less((*this)[right-1], (*this)[left-1].first, (*this)[left-1].second))
             smallest = right;
         if(smallest == i) {
             (*this)[smallest-1].first = k;
@@ -107,12 +119,30 @@ void MinHeap<Key, Value>::RemoveAtPositionAndInsertInternal(Key k, Value v, unsi
     }
 }
 
+unsigned long long SimulationMember::NewMemberNumber(void) {
+    static std::atomic<unsigned long long> count(0);
+    return count++;
+}
+
+// counted by signal handler, stops the runs of all system clocks, which have
+// started before the signal
+static std::atomic<unsigned int> breakSignals(0);
+
 SystemClock::SystemClock() { 
-    static int no = 0;
     currentTime = 0; 
-    no++;
-    if(no > 1)
-        avr_error("Crazy problem: Second instance of SystemClock created!");
+    currentMember = nullptr;
+    slotLimit = 0;
+    slotSteps = 0;
+    stopRequested = false;
+    breakSeen = breakSignals;
+    windowEnd = INVALID;
+    parallelThreads = 1;
+    parallelWindow = 100000;
+}
+
+SystemClock::~SystemClock() {
+    for(SimulationContext *pc: partitions)
+        delete pc;
 }
 
 void SystemClock::SetTraceModeForAllMembers(int trace_on) {
@@ -133,16 +163,14 @@ void SystemClock::AddAsyncMember(SimulationMember *dev) {
     asyncMembers.push_back(dev);
 }
 
-volatile bool breakMessage = false;
-
 int SystemClock::Step(bool &untilCoreStepFinished) {
     // 0-> return also if cpu in waitstate 
     // 1-> return if cpu is really finished
     int res = 0; // returns the state from a core step. Needed by gdb-server to
     // watch for breakpoints
 
-    static std::vector<SimulationMember*>::iterator ami;
-    static std::vector<SimulationMember*>::iterator amiEnd;
+    std::vector<SimulationMember*>::iterator ami;
+    std::vector<SimulationMember*>::iterator amiEnd;
 
     //    std::cout << "Step" << std::endl;
 
@@ -154,13 +182,15 @@ int SystemClock::Step(bool &untilCoreStepFinished) {
 
         syncMembers.RemoveMinimum();
 
-        if ( sysConHandler.GetTraceState() && core->trace_on )
+        if ( core->trace_on && GetSystemConsoleHandler().GetTraceState() )
         {
             traceOut << std::dec << FormattedTime( currentTime ) << " ";
         }
 
         // do a step on simulation member
+        currentMember = core;
         int rc = core->Step(untilCoreStepFinished, &nextStepIn_ns);
+        currentMember = nullptr;
         if (rc)
             res = rc;
 
@@ -179,7 +209,7 @@ int SystemClock::Step(bool &untilCoreStepFinished) {
         for(ami = asyncMembers.begin(); ami != amiEnd; ami++) {
             bool untilCoreStepFinished = false;
 
-            if ( sysConHandler.GetTraceState() && (*ami)->trace_on )
+            if ( (*ami)->trace_on && GetSystemConsoleHandler().GetTraceState() )
             {
                 traceOut << std::dec <<  FormattedTime( currentTime ) << " ";
             }
@@ -189,12 +219,57 @@ int SystemClock::Step(bool &untilCoreStepFinished) {
     }
 
     // honour the stop command
-    if (breakMessage)
+    if (BreakRequested())
         return 1;
 
     return res;
 }
 
+bool SystemClock::ContinueSlot(SimulationMember *sm, SystemClockOffset period) {
+    if(sm != currentMember || BreakRequested() || !asyncMembers.empty())
+        return false;
+    // Run, Endless or RunTimeRange would stop before the next step
+    if(currentTime >= slotLimit)
+        return false;
+    // other members, which are due at the same time, are stepped first
+    SystemClockOffset nextTime = currentTime + period;
+    if(!syncMembers.IsEmpty() && syncMembers.GetMinimumKey() <= nextTime)
+        return false;
+    // a parallel run synchronizes partitions at windowEnd
+    if(nextTime >= windowEnd)
+        return false;
+    currentTime = nextTime;
+    slotSteps++;
+    return true;
+}
+
+unsigned long long SystemClock::ContinueSlot(SimulationMember *sm, SystemClockOffset period, unsigned long long maxSteps, unsigned int stepGroup) {
+    unsigned long long steps = SlotSteps(sm, period, maxSteps);
+    steps -= steps % stepGroup;
+    AdvanceSlot(period, steps);
+    return steps;
+}
+
+unsigned long long SystemClock::SlotSteps(SimulationMember *sm, SystemClockOffset period, unsigned long long maxSteps) const {
+    if(sm != currentMember || BreakRequested() || !asyncMembers.empty() || period <= 0)
+        return 0;
+    // keep room for the time of the step after the granted steps
+    SystemClockOffset limit = std::min(slotLimit, INVALID - 2 * period);
+    if(currentTime >= limit)
+        return 0;
+    // steps, before Run, Endless or RunTimeRange would stop
+    unsigned long long steps = (limit - currentTime - 1) / period + 1;
+    // steps before windowEnd of a parallel run
+    steps = std::min(steps, (unsigned long long)((windowEnd - currentTime - 1) / period));
+    // steps, before other members are due, they are stepped first at the same time
+    if(!syncMembers.IsEmpty()) {
+        SystemClockOffset nextTime = syncMembers.GetMinimumKey();
+        unsigned long long before = (nextTime > currentTime) ? (nextTime - currentTime - 1) / period : 0;
+        steps = std::min(steps, before);
+    }
+    return std::min(steps, maxSteps);
+}
+
 void SystemClock::Reschedule(SimulationMember *sm, SystemClockOffset newTime) {
 
     for(unsigned i = 0; i < syncMembers.size(); i++) {
@@ -207,18 +282,53 @@ void SystemClock::Reschedule(SimulationMember *sm, SystemClockOffset newTime) {
     syncMembers.Insert(newTime+currentTime+1, sm);
 }
 
+void SystemClock::CheckpointMember(Snapshot &snap, SimulationMember *sm) {
+    bool scheduled = false;
+    SystemClockOffset time = 0;
+    for(unsigned i = 0; i < syncMembers.size(); i++) {
+        if(syncMembers[i].second == sm) {
+            scheduled = true;
+            time = syncMembers[i].first;
+            break;
+        }
+    }
+    snap.Value(scheduled);
+    snap.Value(time);
+
+    if(snap.IsRestoring()) {
+        Remove(sm);
+        if(scheduled)
+            syncMembers.Insert(time, sm);
+    }
+}
+
+void SystemClock::Remove(SimulationMember *sm) {
+    // build the time table again without sm, the heap has no removal
+    MinHeap<SystemClockOffset, SimulationMember*> members;
+    for(unsigned i = 0; i < syncMembers.size(); i++) {
+        if(syncMembers[i].second != sm)
+            members.Insert(syncMembers[i].first, syncMembers[i].second);
+    }
+    syncMembers.swap(members);
+}
+
 void OnBreak(int s) {
     signal(SIGINT, SIG_DFL);
     signal(SIGTERM, SIG_DFL);
-    breakMessage = true;
+    breakSignals++;
+}
+
+bool SystemClock::BreakRequested(void) const {
+    return breakSignals.load(std::memory_order_relaxed) != breakSeen || stopRequested;
 }
 
 void SystemClock::Stop() {
-    breakMessage = true;
+    stopRequested = true;
 }
 
 void SystemClock::ResetClock(void) {
-    breakMessage = false;
+    breakSeen = breakSignals;
+    stopRequested = false;
     asyncMembers.clear();
     syncMembers.clear();
     currentTime = 0;
@@ -227,62 +337,383 @@ void SystemClock::ResetClock(void) {
 long SystemClock::Endless() {
     long steps = 0;
 
-    breakMessage = false;        // if we run a second loop, clear break before entering loop
+    breakSeen = breakSignals;    // if we run a second loop, ignore breaks before entering loop
+    stopRequested = false;
 
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
 
-    while(breakMessage == false) {
+    bool stopped = false;
+    if(RunParallel(INVALID, false, steps, stopped) && stopped)
+        return steps;
+
+    slotLimit = INVALID;
+    slotSteps = 0;
+    while(!BreakRequested()) {
         steps++;
         bool untilCoreStepFinished = false;
         Step(untilCoreStepFinished);
     }
+    slotLimit = 0;
 
-    return steps;
+    return steps + slotSteps;
 }
 
 long SystemClock::Run(SystemClockOffset maxRunTime) {
     long steps = 0;
 
-    breakMessage = false;        // if we run a second loop, clear break before entering loop
+    breakSeen = breakSignals;    // if we run a second loop, ignore breaks before entering loop
+    stopRequested = false;
 
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
 
-    while((breakMessage== false) &&
-          (SystemClock::Instance().GetCurrentTime() < maxRunTime)) {
+    // run all steps before maxRunTime in parallel, if possible, the last step is done serial
+    bool stopped = false;
+    if(RunParallel(maxRunTime, true, steps, stopped) && stopped)
+        return steps;
+
+    slotLimit = maxRunTime;
+    slotSteps = 0;
+    while(!BreakRequested() && (currentTime < maxRunTime)) {
         steps++;
         bool untilCoreStepFinished = false;
         if (Step(untilCoreStepFinished))
             break;
     }
+    slotLimit = 0;
 
-    return steps;
+    return steps + slotSteps;
 }
 
 long SystemClock::RunTimeRange(SystemClockOffset timeRange) {
     long steps = 0;
     bool untilCoreStepFinished;
 
-    breakMessage = false;        // if we run a second loop, clear break before entering loop
+    breakSeen = breakSignals;    // if we run a second loop, ignore breaks before entering loop
+    stopRequested = false;
 
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
 
-    timeRange += SystemClock::Instance().GetCurrentTime();
-    while((breakMessage == false) && (SystemClock::Instance().GetCurrentTime() < timeRange)) {
+    timeRange += currentTime;
+
+    bool stopped = false;
+    if(RunParallel(timeRange, true, steps, stopped) && stopped)
+        return steps;
+
+    slotLimit = timeRange;
+    slotSteps = 0;
+    while(!BreakRequested() && (currentTime < timeRange)) {
         untilCoreStepFinished = false;
         if (Step(untilCoreStepFinished))
             break;
         steps++;
     }
+    slotLimit = 0;
 
-    return steps;
+    return steps + slotSteps;
+}
+
+void SystemClock::SetParallel(unsigned int threads, SystemClockOffset window) {
+    parallelThreads = (threads > 0) ? threads : 1;
+    parallelWindow = (window > 0) ? window : 1;
+}
+
+bool SystemClock::Partition(std::vector<std::vector<std::pair<SystemClockOffset, SimulationMember *> > > &groups, std::vector<Net *> &delayed) {
+    if(!asyncMembers.empty() || GetSystemConsoleHandler().GetTraceState())
+        return false;
+
+    // only devices can be partitioned, their pins show, which members are connected
+    std::vector<AvrDevice *> devices;
+    std::vector<std::pair<SystemClockOffset, SimulationMember *> > members;
+    std::vector<NetDelivery *> deliveries;
+    std::map<Pin *, unsigned int> pinOwner;
+    for(unsigned int i = 0; i < syncMembers.size(); i++) {
+        // changes of a net with delay are set by a delivery of every partition
+        NetDelivery *delivery = dynamic_cast<NetDelivery *>(syncMembers[i].second);
+        if(delivery != nullptr) {
+            deliveries.push_back(delivery);
+            continue;
+        }
+        AvrDevice *core = dynamic_cast<AvrDevice *>(syncMembers[i].second);
+        if(core == nullptr || core->trace_on)
+            return false;
+        if(core->dumpManager != nullptr && core->dumpManager->HasDumpers())
+            return false;
+        for(auto &pin: core->allPins)
+            pinOwner[pin.second] = devices.size();
+        devices.push_back(core);
+        members.push_back(syncMembers[i]);
+    }
+
+    // union find over all nets without delay, a net with a pin of a other
+    // object can't be partitioned
+    std::vector<unsigned int> root(devices.size());
+    for(unsigned int i = 0; i < root.size(); i++)
+        root[i] = i;
+    auto find = [&root](unsigned int i) {
+        while(root[i] != i)
+            i = root[i] = root[root[i]];
+        return i;
+    };
+    for(unsigned int i = 0; i < devices.size(); i++) {
+        for(auto &pin: devices[i]->allPins) {
+            Net *net = pin.second->GetNet();
+            if(net == nullptr)
+                continue;
+            for(Pin *other: *net) {
+                std::map<Pin *, unsigned int>::iterator o = pinOwner.find(other);
+                if(o == pinOwner.end())
+                    return false;
+                if(net->GetDelay() == 0)
+                    root[find(o->second)] = find(i);
+            }
+            if(net->GetDelay() > 0 && std::find(delayed.begin(), delayed.end(), net) == delayed.end())
+                delayed.push_back(net);
+        }
+    }
+    // a net with delay without pins of devices
+    for(NetDelivery *delivery: deliveries) {
+        if(std::find(delayed.begin(), delayed.end(), delivery->net) == delayed.end())
+            return false;
+    }
+
+    std::map<unsigned int, unsigned int> groupIndex;
+    groups.clear();
+    for(unsigned int i = 0; i < devices.size(); i++) {
+        unsigned int r = find(i);
+        if(groupIndex.find(r) == groupIndex.end()) {
+            groupIndex[r] = groups.size();
+            groups.resize(groups.size() + 1);
+        }
+        groups[groupIndex[r]].push_back(members[i]);
+    }
+    return groups.size() > 1;
+}
+
+long SystemClock::StepWindow(SystemClockOffset end, SystemClock &parent, bool stopOnBreak, bool &stopped) {
+    long steps = 0;
+
+    windowEnd = end;
+    slotLimit = end;
+    slotSteps = 0;
+    while(!syncMembers.IsEmpty() && syncMembers.GetMinimumKey() < end) {
+        if(parent.BreakRequested()) {
+            stopped = true;
+            break;
+        }
+        steps++;
+        bool untilCoreStepFinished = false;
+        if(Step(untilCoreStepFinished) && (stopOnBreak || BreakRequested())) {
+            stopped = true;
+            break;
+        }
+    }
+    windowEnd = INVALID;
+    slotLimit = 0;
+
+    return steps + slotSteps;
+}
+
+namespace {
+
+    //! Lets a fixed count of threads wait for each other
+    class WindowBarrier {
+        public:
+            WindowBarrier(unsigned int n): count(n), waiting(0), generation(0) {}
+            void Wait(void) {
+                std::unique_lock<std::mutex> lock(mutex);
+                unsigned long gen = generation;
+                if(++waiting == count) {
+                    waiting = 0;
+                    generation++;
+                    cond.notify_all();
+                } else
+                    cond.wait(lock, [&] { return gen != generation; });
+            }
+        private:
+            std::mutex mutex;
+            std::condition_variable cond;
+            unsigned int count;
+            unsigned int waiting;
+            unsigned long generation;
+    };
+
+}
+
+bool SystemClock::RunParallel(SystemClockOffset limit, bool stopOnBreak, long &steps, bool &stopped) {
+    for(SimulationContext *pc: partitions)
+        delete pc;
+    partitions.clear();
+    if(parallelThreads < 2 || currentTime >= limit)
+        return false;
+    std::vector<std::vector<std::pair<SystemClockOffset, SimulationMember *> > > groups;
+    std::vector<Net *> delayed;
+    if(!Partition(groups, delayed))
+        return false;
+
+    // every partition gets a own context, so SystemClock::Instance() gives its clock
+    std::vector<std::pair<AvrDevice *, SimulationContext *> > devices;
+    std::map<Pin *, unsigned int> pinPartition;
+    for(auto &group: groups) {
+        SimulationContext *pc = new SimulationContext();
+        pc->GetConsoleHandler().TakeOverSettings(GetSystemConsoleHandler());
+        SystemClock &clock = pc->GetSystemClock();
+        clock.currentTime = currentTime;
+        clock.breakSeen = breakSeen;
+        for(auto &member: group) {
+            AvrDevice *core = static_cast<AvrDevice *>(member.second);
+            devices.push_back(std::make_pair(core, core->context));
+            core->context = pc;
+            clock.syncMembers.Insert(member.first, member.second);
+            for(auto &pin: core->allPins)
+                pinPartition[pin.second] = partitions.size();
+        }
+        partitions.push_back(pc);
+    }
+    syncMembers.clear();
+
+    // a net with delay gets a delivery for every partition with pins on the
+    // net, a change has to arrive in a later window
+    SystemClockOffset window = parallelWindow;
+    std::vector<std::pair<NetDelivery *, unsigned int> > deliveries;
+    for(Net *net: delayed) {
+        window = std::min(window, net->GetDelay());
+        std::vector<std::vector<Pin *> > pins(partitions.size());
+        for(Pin *pin: *net)
+            pins[pinPartition[pin]].push_back(pin);
+        for(unsigned int k = 0; k < pins.size(); k++) {
+            if(pins[k].empty())
+                continue;
+            NetDelivery *d = new NetDelivery(net->delivery, pins[k]);
+            d->Schedule(partitions[k]->GetSystemClock());
+            deliveries.push_back(std::make_pair(d, k));
+        }
+        net->delivery.scheduled = false;
+        net->deferred = true;
+    }
+    // resolves the changes of a window, after all partitions are done with it
+    auto exchange = [&]() {
+        for(Net *net: delayed) {
+            net->Flush();
+            unsigned long long done = net->changesDone + net->changes.size();
+            for(auto &d: deliveries) {
+                if(d.first->net == net)
+                    done = std::min(done, d.first->next);
+            }
+            net->Trim(done);
+        }
+        for(auto &d: deliveries)
+            d.first->Schedule(partitions[d.second]->GetSystemClock());
+    };
+
+    unsigned int count = partitions.size();
+    unsigned int threads = std::min(parallelThreads, count);
+    std::vector<long> partSteps(count, 0);
+    std::vector<char> partStopped(count, false);
+    std::vector<std::exception_ptr> partError(count);
+    SystemClockOffset end = currentTime;
+    bool finish = false;
+    WindowBarrier barrier(threads);
+
+    // thread n steps partitions n, n + threads, ... in every window
+    auto stepPartitions = [&](unsigned int n) {
+        for(unsigned int k = n; k < count; k += threads) {
+            if(partStopped[k] || partError[k])
+                continue;
+            bool s = false;
+            try {
+                partitions[k]->Activate();
+                partSteps[k] += partitions[k]->GetSystemClock().StepWindow(end, *this, stopOnBreak, s);
+            } catch(...) {
+                partError[k] = std::current_exception();
+            }
+            partStopped[k] = s;
+        }
+    };
+    auto worker = [&](unsigned int n) {
+        for(;;) {
+            barrier.Wait();
+            if(finish)
+                break;
+            stepPartitions(n);
+            barrier.Wait();
+        }
+        SimulationContext::Deactivate();
+    };
+
+    SimulationContext &previous = SimulationContext::Current();
+    std::vector<std::thread> workers;
+    for(unsigned int n = 1; n < threads; n++)
+        workers.push_back(std::thread(worker, n));
+    for(;;) {
+        for(unsigned int k = 0; k < count; k++)
+            if(partStopped[k] || partError[k])
+                finish = true;
+        if(end >= limit || BreakRequested())
+            finish = true;
+        end = (limit - end > window) ? end + window : limit;
+        barrier.Wait();
+        if(finish)
+            break;
+        stepPartitions(0);
+        barrier.Wait();
+        exchange();
+    }
+    for(std::thread &t: workers)
+        t.join();
+    previous.Activate();
+
+    // move all members back to this clock
+    std::exception_ptr error;
+    for(unsigned int k = 0; k < count; k++) {
+        SystemClock &clock = partitions[k]->GetSystemClock();
+        currentTime = std::max(currentTime, clock.currentTime);
+        for(auto &member: clock.syncMembers) {
+            if(dynamic_cast<NetDelivery *>(member.second) == nullptr)
+                syncMembers.Insert(member.first, member.second);
+        }
+        clock.syncMembers.clear();
+        asyncMembers.insert(asyncMembers.end(), clock.asyncMembers.begin(), clock.asyncMembers.end());
+        clock.asyncMembers.clear();
+        steps += partSteps[k];
+        if(partStopped[k] || BreakRequested())
+            stopped = true;
+        if(partError[k] && !error)
+            error = partError[k];
+    }
+    for(auto &device: devices)
+        device.first->context = device.second;
+
+    // the delivery for all pins continues at the oldest change, which isn't set on all pins
+    for(Net *net: delayed) {
+        net->deferred = false;
+        net->Flush();
+        NetDelivery *oldest = nullptr;
+        for(auto &d: deliveries) {
+            if(d.first->net == net && (oldest == nullptr || d.first->next < oldest->next))
+                oldest = d.first;
+        }
+        if(oldest != nullptr) {
+            net->delivery.next = oldest->next;
+            net->delivery.input = oldest->input;
+        }
+        net->Trim(net->delivery.next);
+        net->delivery.Schedule(*this);
+    }
+    for(auto &d: deliveries)
+        delete d.first;
+
+    if(error) {
+        stopped = true;
+        std::rethrow_exception(error);
+    }
+    return true;
 }
 
 SystemClock& SystemClock::Instance() {
-    static SystemClock obj;
-    return obj;
+    return SimulationContext::Current().GetSystemClock();
 }
 
 SystemClockOffset SystemClock::Now() {
@@ -32,9 +32,14 @@
 #include "systemclocktypes.h"
 
 class SimulationMember;
+class SimulationContext;
+class Snapshot;
+class Net;
 
 /** A heap data structure optimized for obtaining Value of the smallest Key.
-    Example MinHeap<SystemClockOffset, SimulationMember*>. */
+    Example MinHeap<SystemClockOffset, SimulationMember*>. Values with the same
+    Key are ordered by their GetMemberNumber(), so the order doesn't depend on
+    the history of the heap. */
 template<typename Key, typename Value>
 class MinHeap : public std::vector<std::pair<Key,Value> >
 {
@@ -53,12 +58,19 @@ public:
         RemoveAtPositionAndInsertInternal(k, v, 0);
     }
     void RemoveAtPositionAndInsert(Key k, Value v, unsigned pos) {
-        if(k < (*this)[pos-1].first)
+        if(Less(k, v, (*this)[pos-1]))
             InsertInternal(k, v, pos);
         else
             RemoveAtPositionAndInsertInternal(k, v, pos);
     }
 protected:
+    //! Returns true, if item a has to come before item b
+    static bool Less(Key ka, Value va, const std::pair<Key,Value> &b) {
+        return ka < b.first || (ka == b.first && va->GetMemberNumber() < b.second->GetMemberNumber());
+    }
+    static bool Less(const std::pair<Key,Value> &a, Key kb, Value vb) {
+        return a.first < kb || (a.first == kb && a.second->GetMemberNumber() < vb->GetMemberNumber());
+    }
     // These are internal because a bad value of `pos' could violate the binary heap invariant.
     void InsertInternal(Key k, Value v, unsigned pos);
     void RemoveAtPositionAndInsertInternal(Key k, Value v, unsigned pos);
@@ -85,10 +97,35 @@ class SystemClock
         SystemClock(); //!< Do not this constructor from application code!
         SystemClock(const SystemClock &); //!< Do not this constructor from application code!
 
+        friend class SimulationContext;
+
     protected:
         SystemClockOffset currentTime;  //!< time in [ns] since start of simulation
         MinHeap<SystemClockOffset, SimulationMember *> syncMembers;  //!< earliest first
         std::vector<SimulationMember*> asyncMembers; //!< List of asynchron working simulation members, will be called every step!
+        SimulationMember *currentMember; //!< simulation member, which is processed by Step at the moment
+        SystemClockOffset slotLimit; //!< set by Run, Endless and RunTimeRange: members may continue their slot before this time, otherwise 0
+        long slotSteps; //!< count of steps, which members made by continuing their slot
+        volatile bool stopRequested; //!< set by Stop, stops Run, Endless or RunTimeRange of this clock
+        unsigned int breakSeen; //!< count of break signals at start of the run, a further signal stops it
+        SystemClockOffset windowEnd; //!< set by a parallel run: members may continue their slot only before this time
+
+        unsigned int parallelThreads; //!< count of threads for a parallel run, see SetParallel
+        SystemClockOffset parallelWindow; //!< time window, after which partitions synchronize
+        std::vector<SimulationContext *> partitions; //!< contexts of the last run, empty, if it was serial
+
+        //! Runs groups of devices in parallel till limit, see SetParallel
+        /*! Returns false, if this isn't possible, then nothing was done. Otherwise
+            steps is incremented by the count of done steps and stopped is set, if
+            Stop, a signal or (with stopOnBreak) a breakpoint stopped the run. */
+        bool RunParallel(SystemClockOffset limit, bool stopOnBreak, long &steps, bool &stopped);
+        //! Splits the members into partitions, returns false, if this isn't possible
+        /*! Nets with a propagation delay don't join devices, they are returned in delayed. */
+        bool Partition(std::vector<std::vector<std::pair<SystemClockOffset, SimulationMember *> > > &groups, std::vector<Net *> &delayed);
+        //! Returns true, if Stop was called or a break signal came since start of the run
+        bool BreakRequested(void) const;
+        //! Steps all members of a partition, which are due before end
+        long StepWindow(SystemClockOffset end, SystemClock &parent, bool stopOnBreak, bool &stopped);
         
     public:
         //! Returns the current simulation time
@@ -105,14 +142,54 @@ class SystemClock
         void AddAsyncMember(SimulationMember *dev);
         //! Process one simulation step
         int Step(bool &untilCoreStepFinished);
+        //! Asks, if a simulation member may do its next step within the current Step call
+        /*! This is possible, if sm is processed by Step called from Run, Endless
+            or RunTimeRange and no other simulation member is scheduled before
+            the next step of sm. If so, the simulation time is incremented by
+            period and true is returned. sm has then to do exactly one step
+            like in a own Step call. */
+        bool ContinueSlot(SimulationMember *sm, SystemClockOffset period);
+        //! Like ContinueSlot, but for up to maxSteps steps at once
+        /*! Only a multiple of stepGroup steps is granted. The simulation time
+            is incremented by period for every granted step and the count of
+            granted steps is returned. sm has then to account for all these
+            steps, like it would do in own Step calls. */
+        unsigned long long ContinueSlot(SimulationMember *sm, SystemClockOffset period, unsigned long long maxSteps, unsigned int stepGroup);
+        //! Returns, how many steps sm may continue its slot, up to maxSteps
+        /*! Like ContinueSlot, but the simulation time isn't incremented. sm
+            has to call AdvanceSlot for the steps, which it really does. */
+        unsigned long long SlotSteps(SimulationMember *sm, SystemClockOffset period, unsigned long long maxSteps) const;
+        //! Increments the simulation time for steps, which were granted by SlotSteps
+        void AdvanceSlot(SystemClockOffset period, unsigned long long steps) { currentTime += steps * period; slotSteps += steps; }
         //! Run simulation endless till SIGINT or SIGTERM signal, return the number of CPU cycles
         long Endless();
         //! Run simulation till given time is arrived or signal is cached
         long Run(SystemClockOffset maxRunTime);
         //! Like Run method, but stops on breakpoint or after given time offset
         long RunTimeRange(SystemClockOffset timeRange);
-        //! Returns the central SystemClock instance for the application
-        /*! There will be only one instance on a application! */
+        //! Run devices on several threads
+        /*! With threads > 1, Run, Endless and RunTimeRange split the devices into
+            groups and run every group on a own clock in a worker thread. The
+            groups synchronize after every window [ns] of simulation time, a
+            stop or breakpoint is honoured there.
+            Devices on a common net without delay are always in one group,
+            because a pin change is seen by all connected pins at the same
+            time. A net with a propagation delay (see Net::SetDelay, for
+            instance a bus, where a UART bit or a pin change needs some time to
+            arrive) doesn't join devices: the window is shortened to the
+            smallest delay of these nets, so a change arrives in a later window
+            in every case. The groups exchange their changes at the end of a
+            window.
+            The simulation is the same as a serial one, as far as all members
+            run to the given time, because members due at the same time are
+            always stepped in order of their GetMemberNumber(). If a parallel
+            run isn't possible (other members than devices, tracing, dumpers,
+            nets with other pins or only one group), the run is serial. */
+        void SetParallel(unsigned int threads, SystemClockOffset window = 100000);
+        //! Returns the count of device groups of the last run, 0, if it was serial
+        unsigned int GetParallelGroups(void) const { return partitions.size(); }
+        //! Returns the SystemClock instance of the current simulation context
+        /*! There is one instance for every SimulationContext, see there. */
         static SystemClock& Instance();
 
         static SystemClockOffset Now();
@@ -123,12 +200,20 @@ class SystemClock
             
             \todo This method is possibly obsolete! */
         void Reschedule(SimulationMember *sm, SystemClockOffset newTime);
+        //! Saves or restores the place of a simulation member in time table
+        /*! On restore, sm is removed from the time table, if it wasn't there
+            on save, see Snapshot. */
+        void CheckpointMember(Snapshot &snap, SimulationMember *sm);
+        //! Removes a simulation member from the time table
+        void Remove(SimulationMember *sm);
         //! Switches trace mode for all current found simulation members
         void SetTraceModeForAllMembers(int trace_on);
         //! Stop Run/Endless or Step asynchronously
         void Stop();
         //! Resets the simulation time and clears table for simulation members and async simulation members
         void ResetClock(void);
+
+        ~SystemClock();
 };
 
 #endif
@@ -0,0 +1,186 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "tracescope.h"
+#include "avrdevice.h"
+#include "flash.h"
+#include "irqsystem.h"
+#include "systemclock.h"
+#include "string2.h"
+
+#include <sstream>
+
+// parses a number from s till the end of s or a '-', returns false on error
+static bool ParseNumber(const std::string &s, unsigned long long &value, bool toDash) {
+    char *end;
+    if(!StringToUnsignedLongLong(s.c_str(), &value, &end, 0))
+        return false;
+    return *end == '\0' || (toDash && *end == '-');
+}
+
+// parses "<start>-<end>", end may be empty, if allowOpen is set, then end is -1
+static bool ParseInterval(const std::string &s, long long &start, long long &end, bool allowOpen) {
+    size_t dash = s.find('-');
+    if(dash == std::string::npos || dash == 0)
+        return false;
+    unsigned long long a, b;
+    if(!ParseNumber(s.substr(0, dash), a, false))
+        return false;
+    std::string rest = s.substr(dash + 1);
+    if(rest.empty()) {
+        if(!allowOpen)
+            return false;
+        start = a;
+        end = -1;
+        return true;
+    }
+    if(!ParseNumber(rest, b, false) || b <= a)
+        return false;
+    start = a;
+    end = b;
+    return true;
+}
+
+TraceScope::TraceScope(AvrDevice *_core):
+    core(_core) {}
+
+void TraceScope::AddRange(unsigned int start, unsigned int end, const std::string &name) {
+    Range r;
+    r.start = start;
+    r.end = end;
+    r.name = name;
+    ranges.push_back(r);
+
+    unsigned int words = core->Flash->GetSize() >> 1;
+    if(inRange.size() != words)
+        inRange.assign(words, false);
+    for(unsigned int w = start >> 1; w < ((end + 1) >> 1) && w < words; w++)
+        inRange[w] = true;
+    core->UpdateTraceScope();
+}
+
+bool TraceScope::AddFunction(const std::string &name) {
+    unsigned int start, end;
+    if(!core->Flash->GetSymbolRange(name, start, end))
+        return false;
+    AddRange(start, end, name);
+    return true;
+}
+
+void TraceScope::AddInterrupt(unsigned int vector) {
+    vectors.push_back(vector);
+    core->UpdateTraceScope();
+}
+
+void TraceScope::AddTimeWindow(SystemClockOffset start, SystemClockOffset end) {
+    Window w;
+    w.start = start;
+    w.end = end;
+    windows.push_back(w);
+    core->UpdateTraceScope();
+}
+
+bool TraceScope::Add(const std::string &spec) {
+    long long start, end;
+    if(spec.compare(0, 4, "irq:") == 0) {
+        unsigned long long vector;
+        if(!ParseNumber(spec.substr(4), vector, false) || vector >= core->irqSystem->GetVectorTableSize())
+            return false;
+        AddInterrupt((unsigned int)vector);
+        return true;
+    }
+    if(spec.compare(0, 5, "time:") == 0) {
+        if(!ParseInterval(spec.substr(5), start, end, true))
+            return false;
+        AddTimeWindow(start, end);
+        return true;
+    }
+    // a range starts with a digit, function names can't
+    if(!spec.empty() && spec[0] >= '0' && spec[0] <= '9') {
+        if(!ParseInterval(spec, start, end, false) || end > core->Flash->GetSize())
+            return false;
+        AddRange((unsigned int)start, (unsigned int)end, "");
+        return true;
+    }
+    return AddFunction(spec);
+}
+
+void TraceScope::Clear(void) {
+    ranges.clear();
+    vectors.clear();
+    windows.clear();
+    inRange.clear();
+    core->UpdateTraceScope();
+}
+
+bool TraceScope::InScope(unsigned int pc) const {
+    if(!windows.empty()) {
+        SystemClockOffset now = SystemClock::Now();
+        bool inWindow = false;
+        for(size_t i = 0; i < windows.size() && !inWindow; i++)
+            inWindow = now >= windows[i].start && (windows[i].end < 0 || now < windows[i].end);
+        if(!inWindow)
+            return false;
+    }
+
+    if(ranges.empty() && vectors.empty())
+        return true;
+    if(pc < inRange.size() && inRange[pc])
+        return true;
+    for(size_t i = 0; i < vectors.size(); i++)
+        if(core->irqSystem->IsHandlerActive(vectors[i]))
+            return true;
+    return false;
+}
+
+void TraceScope::Write(std::ostream &os) const {
+    for(size_t i = 0; i < ranges.size(); i++) {
+        os << std::hex << "0x" << ranges[i].start << "-0x" << ranges[i].end << std::dec;
+        if(!ranges[i].name.empty())
+            os << " " << ranges[i].name;
+        os << std::endl;
+    }
+    for(size_t i = 0; i < vectors.size(); i++) {
+        std::string name = core->GetInterruptVectorName(vectors[i]);
+        os << "irq:" << vectors[i];
+        if(!name.empty())
+            os << " " << name;
+        os << std::endl;
+    }
+    for(size_t i = 0; i < windows.size(); i++) {
+        os << "time:" << windows[i].start << "-";
+        if(windows[i].end >= 0)
+            os << windows[i].end;
+        os << std::endl;
+    }
+}
+
+std::string TraceScope::ToString(void) const {
+    std::ostringstream os;
+    Write(os);
+    return os.str();
+}
+
+// EOF
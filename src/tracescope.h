@@ -0,0 +1,108 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2026   Klaus Rudolph & other
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef TRACESCOPE
+#define TRACESCOPE
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "systemclocktypes.h"
+
+class AvrDevice;
+
+//! Restricts instruction trace and value dumps of a core to parts of the program
+/*! A scope is made of places and time windows. Places are address ranges in
+  flash, functions (from the symbol address till the next symbol, called
+  functions are not included) and interrupt vectors, which are in scope from
+  entering the vector till the return from the handler. Time windows are
+  intervals of simulation time. The core is in scope, if no place is set or
+  PC is in one of the places, and if no time window is set or the time is in
+  one of the windows.
+
+  The core checks the scope after every instruction for the next one, if
+  a scope is set, and suspends the trace and the dumps of DumpManager, as long
+  as it is out of scope. So time windows are checked with the resolution of
+  one cpu cycle. */
+class TraceScope {
+
+    private:
+        //! A address range in flash, in bytes, end is exclusive
+        struct Range {
+            unsigned int start; //!< first address
+            unsigned int end; //!< first address after range
+            std::string name; //!< function name or empty for a address range
+        };
+
+        //! A window of simulation time, end is exclusive
+        struct Window {
+            SystemClockOffset start; //!< start time in ns
+            SystemClockOffset end; //!< end time in ns, -1 for no end
+        };
+
+        AvrDevice *core; //!< core, which uses this scope
+        std::vector<Range> ranges; //!< all address ranges and functions
+        std::vector<unsigned int> vectors; //!< interrupt vectors
+        std::vector<Window> windows; //!< time windows
+        std::vector<bool> inRange; //!< true for flash words in one of ranges
+
+        //! Adds a range, start and end in bytes
+        void AddRange(unsigned int start, unsigned int end, const std::string &name);
+
+    public:
+        //! Creates a empty scope, which doesn't restrict anything
+        TraceScope(AvrDevice *core);
+
+        //! Adds a scope by a text specification
+        /*! Possible specifications are "irq:<vector>", "time:<start>-<end>"
+          with start and end in ns (end may be empty for no end), "<start>-<end>"
+          as hex or decimal byte addresses in flash, end is exclusive, or
+          a function name from the symbol table of the program.
+          @return false, if spec has a syntax error or the function isn't found */
+        bool Add(const std::string &spec);
+        //! Adds the flash range from start till end (exclusive), in bytes
+        void AddRange(unsigned int start, unsigned int end) { AddRange(start, end, ""); }
+        //! Adds a function by name, returns false, if symbol isn't found
+        bool AddFunction(const std::string &name);
+        //! Adds the handler of an interrupt vector
+        void AddInterrupt(unsigned int vector);
+        //! Adds a time window from start till end (exclusive) in ns, end -1 for no end
+        void AddTimeWindow(SystemClockOffset start, SystemClockOffset end);
+        //! Removes all scopes, then trace and dumps aren't restricted anymore
+        void Clear(void);
+
+        //! True, if a scope is set
+        bool IsSet(void) const { return !ranges.empty() || !vectors.empty() || !windows.empty(); }
+        //! True, if the instruction on flash word pc is in scope now
+        bool InScope(unsigned int pc) const;
+
+        //! Writes the scopes, one per line
+        void Write(std::ostream &os) const;
+        //! Returns the scopes as text, one per line
+        std::string ToString(void) const;
+};
+
+#endif
@@ -23,6 +23,7 @@
  *  $Id$
  */
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <stdlib.h>
@@ -31,6 +32,7 @@
 #include "avrdevice.h"
 #include "avrerror.h"
 #include "systemclock.h"
+#include "simulationcontext.h"
 
 
 TraceValue::TraceValue(size_t bits,
@@ -44,6 +46,9 @@ TraceValue::TraceValue(size_t bits,
     v(0xaffeaffe),
     f(0),
     _written(false),
+    dirtyList(nullptr),
+    inDirtyList(false),
+    activeIndex(0),
     _enabled(false) {}
 
 size_t TraceValue::bits() const { return b; }
@@ -69,6 +74,7 @@ void TraceValue::change(unsigned val) {
     if ((v != val) || !_written) {
         f |= CHANGE;
         v = val;
+        markDirty();
     }
 }
 
@@ -77,6 +83,7 @@ void TraceValue::change(unsigned val, unsigned mask) {
     if (((v & mask) != (val & mask)) || !_written) {
         f |= CHANGE;
         v = (v & ~mask) | (val & mask);
+        markDirty();
     }
 }
 
@@ -87,10 +94,12 @@ void TraceValue::write(unsigned val) {
     }
     f |= WRITE;
     _written = true;
+    markDirty();
 }
 
 void TraceValue::read() {
     f |= READ;
+    markDirty();
 }
 
 bool TraceValue::written() const { return _written;  }
@@ -145,16 +154,15 @@ void TraceValue::dump(Dumper &d) {
     f=0;
 }
 
-char TraceValue::VcdBit(int bitNo) const {
-    if (_written)
-        return (v & (1 << bitNo)) ? '1' : '0';
+char TraceValue::VcdBitOf(int bitNo, unsigned val, bool isWritten) const {
+    if (isWritten)
+        return (val & (1 << bitNo)) ? '1' : '0';
     else
         return 'x';
 }
 
-char TraceValueOutput::VcdBit(int bitNo) const {
-    unsigned val = value();
-    if(written()) {
+char TraceValueOutput::VcdBitOf(int bitNo, unsigned val, bool isWritten) const {
+    if(isWritten) {
         if(val == Pin::TRISTATE)
             return 'z';
         if((val == Pin::HIGH) || (val == Pin::PULLUP))
@@ -227,6 +235,7 @@ void TraceValueRegister::UnregisterTraceValue(TraceValue *t) {
             break;
         }
     }
+    _tvr_direct.erase(std::remove(_tvr_direct.begin(), _tvr_direct.end(), t), _tvr_direct.end());
 }
 
 TraceValueRegister* TraceValueRegister::GetScopeGroupByName(const std::string &name) {
@@ -379,19 +388,106 @@ bool WarnUnknown::enabled(const TraceValue *t) const {
     return true;
 }
 
-void DumpVCD::valout(const TraceValue *v) {
-    osbuffer << 'b';
-    for (int i = v->bits()-1; i >= 0; i--)
-        osbuffer << v->VcdBit(i);
+void DumpVCD::format(const Record &r, std::string &out) {
+    switch(r.kind) {
+        case TIME:
+            out += '#';
+            out += std::to_string(r.time);
+            break;
+        case VALUE:
+            out += 'b';
+            for (int i = r.value->bits()-1; i >= 0; i--)
+                out += r.value->VcdBitOf(i, r.val, r.written);
+            out += ' ';
+            out += std::to_string(r.id);
+            break;
+        case STROBE_ON:
+        case STROBE_OFF:
+            out += (r.kind == STROBE_ON) ? '1' : '0';
+            out += std::to_string(r.id);
+            break;
+    }
+    out += '\n';
+}
+
+void DumpVCD::put(RecordKind kind, unsigned id, const TraceValue *t) {
+    if(!writer.joinable())
+        return;
+    if(timePending) {
+        timePending = false;
+        put(TIME, 0);
+    }
+    size_t head = ringHead.load(std::memory_order_relaxed);
+    // wait for writer thread, if ring is full; the flag and the ring positions
+    // are sequentially consistent, so one side sees the change of the other
+    if(head - ringTail.load(std::memory_order_acquire) >= ringSize) {
+        std::unique_lock<std::mutex> lock(ringMutex);
+        producerWaiting.store(true);
+        ringFreed.wait(lock, [this, head] { return head - ringTail.load() < ringSize; });
+        producerWaiting.store(false);
+    }
+    Record &r = ring[head & (ringSize - 1)];
+    r.kind = kind;
+    r.id = id;
+    r.time = cycleTime;
+    r.value = t;
+    if(t != nullptr) {
+        r.val = t->value();
+        r.written = t->written();
+    }
+    ringHead.store(head + 1);
+    if(writerWaiting.load() && head + 1 - ringTail.load(std::memory_order_relaxed) >= ringBatch) {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ringFilled.notify_one();
+    }
+}
 
+void DumpVCD::writerLoop(void) {
+    std::string out;
+    for(;;) {
+        size_t tail = ringTail.load(std::memory_order_relaxed);
+        size_t head = ringHead.load(std::memory_order_acquire);
+        if(tail == head) {
+            if(!out.empty()) {
+                os->write(out.data(), out.size());
+                out.clear();
+            }
+            // stopWriter is set after the last record, so ring is empty now
+            if(stopWriter.load() && head == ringHead.load())
+                break;
+            // sleep till a batch of records is in ring, the timeout writes
+            // single changes, while the simulation is slow or waits
+            std::unique_lock<std::mutex> lock(ringMutex);
+            writerWaiting.store(true);
+            ringFilled.wait_for(lock, std::chrono::milliseconds(100),
+                [this, tail] { return stopWriter.load() || ringHead.load() - tail >= ringBatch; });
+            writerWaiting.store(false);
+            continue;
+        }
+        for(; tail != head; tail++)
+            format(ring[tail & (ringSize - 1)], out);
+        ringTail.store(tail);
+        if(producerWaiting.load()) {
+            std::lock_guard<std::mutex> lock(ringMutex);
+            ringFreed.notify_one();
+        }
+        if(out.size() >= 65536) {
+            os->write(out.data(), out.size());
+            out.clear();
+        }
+    }
 }
 
-void DumpVCD::flushbuffer(void) {
-    if(changesWritten) {
-        *os << osbuffer.str();
-        changesWritten = false;
+void DumpVCD::stopWriterThread(void) {
+    if(!writer.joinable())
+        return;
+    stopWriter.store(true);
+    {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ringFilled.notify_one();
     }
-    osbuffer.str("");
+    writer.join();
+    stopWriter.store(false);
 }
 
 DumpVCD::DumpVCD(std::ostream *_os,
@@ -401,8 +497,15 @@ DumpVCD::DumpVCD(std::ostream *_os,
     tscale(_tscale),
     rs(rstrobes),
     ws(wstrobes),
-    changesWritten(false),
-    os(_os)
+    os(_os),
+    ring(ringSize),
+    ringHead(0),
+    ringTail(0),
+    stopWriter(false),
+    writerWaiting(false),
+    producerWaiting(false),
+    cycleTime(0),
+    timePending(false)
 {}
 
 DumpVCD::DumpVCD(const std::string &_name,
@@ -412,8 +515,15 @@ DumpVCD::DumpVCD(const std::string &_name,
     tscale(_tscale),
     rs(rstrobes),
     ws(wstrobes),
-    changesWritten(false),
-    os(new std::ofstream(_name.c_str()))
+    os(new std::ofstream(_name.c_str())),
+    ring(ringSize),
+    ringHead(0),
+    ringTail(0),
+    stopWriter(false),
+    writerWaiting(false),
+    producerWaiting(false),
+    cycleTime(0),
+    timePending(false)
 {}
 
 void DumpVCD::setActiveSignals(const TraceSet &act) {
@@ -458,48 +568,47 @@ void DumpVCD::start() {
     *os << "$enddefinitions $end\n";
 
     // mark initial state
-    changesWritten = true;
-    osbuffer << "#0\n$dumpvars\n";
+    std::string out = "#0\n$dumpvars\n";
     n=0;
     for (iter i=tv.begin();
          i!=tv.end(); i++) {
-        valout(*i);
-        osbuffer << ' ' << n*(1+rs+ws) << '\n';
+        Record r = { 0, *i, n*(1+rs+ws), (*i)->value(), VALUE, (*i)->written() };
+        format(r, out);
         // reset RS, WS
         if (rs) {
-            osbuffer << "0" << n*(1+rs+ws)+1 << "\n";
+            out += "0" + std::to_string(n*(1+rs+ws)+1) + "\n";
         }
         if (ws) {
             if (rs)
-                osbuffer << "0" << n*(1+rs+ws)+2 << "\n";
+                out += "0" + std::to_string(n*(1+rs+ws)+2) + "\n";
             else
-                osbuffer << "0" << n*(1+rs+ws)+1 << "\n";
+                out += "0" + std::to_string(n*(1+rs+ws)+1) + "\n";
         }
         n++;
     }
-    osbuffer << "$end\n";
-    flushbuffer();
+    out += "$end\n";
+    os->write(out.data(), out.size());
+
+    // following changes are written by writer thread
+    stopWriterThread();
+    timePending = false;
+    writer = std::thread(&DumpVCD::writerLoop, this);
 }
 
 void DumpVCD::cycle() {
-    // flush the buffer
-    flushbuffer();
-    
-    // write new time marker to buffer
-    SystemClockOffset clock=SystemClock::Instance().GetCurrentTime();
-    osbuffer << "#" << clock << '\n';
+    // time marker is written with the first change in this cycle
+    cycleTime = SystemClock::Instance().GetCurrentTime();
+    timePending = true;
 
     // reset RS, WS states
     for (size_t i=0; i<marked.size(); i++)
-        osbuffer << "0" << marked[i] << "\n";
-    if(marked.size())
-        changesWritten = true;
+        put(STROBE_OFF, marked[i]);
     marked.clear();
 }
 
 void DumpVCD::stop() {
-    // flush the buffer
-    flushbuffer();
+    // write all changes
+    stopWriterThread();
     
     // write a last time marker to report end of dump
     SystemClockOffset clock=SystemClock::Instance().GetCurrentTime();
@@ -511,8 +620,7 @@ void DumpVCD::stop() {
 void DumpVCD::markRead(const TraceValue *t) {
     if (rs) {
         // mark read cycle
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1 << "\n";
-        changesWritten = true;
+        put(STROBE_ON, id2num[t]*(1+rs+ws)+1);
         // mark to disable @ next cycle
         marked.push_back(id2num[t]*(1+rs+ws)+1);
     }
@@ -520,44 +628,36 @@ void DumpVCD::markRead(const TraceValue *t) {
 
 void DumpVCD::markWrite(const TraceValue *t) {
     if (ws) {
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1+rs << "\n";
-        changesWritten = true;
+        put(STROBE_ON, id2num[t]*(1+rs+ws)+1+rs);
         marked.push_back(id2num[t]*(1+rs+ws)+1+rs);
     }
 }
 
 void DumpVCD::markChange(const TraceValue *t) {
-    valout(t);
-    osbuffer << " " << id2num[t]*(1+rs+ws) << "\n";
-    changesWritten = true;
+    put(VALUE, id2num[t]*(1+rs+ws), t);
 }
 
 bool DumpVCD::enabled(const TraceValue *t) const {
     return id2num.find(t)!=id2num.end();
 }
 
-DumpVCD::~DumpVCD() { delete os; }
-
-int DumpManager::_devidx = 0;
-DumpManager *::DumpManager::_instance = NULL;
+DumpVCD::~DumpVCD() {
+    stopWriterThread();
+    delete os;
+}
 
 DumpManager* DumpManager::Instance(void) {
-    if(_instance == NULL)
-        _instance = new DumpManager();
-    return _instance;
+    return SimulationContext::Current().GetDumpManager();
 }
 
 void DumpManager::Reset(void) {
-    if(_instance) {
-        _instance->detachAvrDevices();
-        delete _instance;
-    }
-    _instance = NULL;
-    _devidx = 0;
+    SimulationContext::Current().ResetDumpManager();
 }
 
 DumpManager::DumpManager() {
     singleDeviceApp = false;
+    _devidx = 0;
+    suspended = 0;
 }
 
 void DumpManager::appendDeviceName(std::string &s) {
@@ -589,6 +689,30 @@ void DumpManager::detachAvrDevices() {
         AvrDevice* d = *i;
         d->detachDumpManager();
     }
+    // this manager will be deleted, so values must not use dirty list anymore
+    for(std::vector<AvrDevice*>::iterator i = devices.begin(); i != devices.end(); i++) {
+        TraceSet *s = (*i)->GetAllTraceValuesRecursive();
+        for(TraceSet::iterator t = s->begin(); t != s->end(); t++) {
+            (*t)->dirtyList = nullptr;
+            (*t)->inDirtyList = false;
+        }
+        delete s;
+    }
+}
+
+void DumpManager::activate(TraceValue *t) {
+    t->activeIndex = active.size();
+    active.push_back(t);
+    t->inDirtyList = false;
+    if(t->sampled())
+        sampled.push_back(t);
+    else {
+        t->dirtyList = &dirty;
+        // accesses before activation are dumped in next cycle, a shadowed
+        // variable is compared in next cycle
+        if(t->flags() || t->shadow != nullptr)
+            t->markDirty();
+    }
 }
 
 TraceValue* DumpManager::seekValueByName(const std::string &name) {
@@ -620,7 +744,13 @@ void DumpManager::addDumper(Dumper *dump, const TraceSet &vals) {
     for(TraceSet::const_iterator i = vals.begin(); i != vals.end(); i++) {
         (*i)->enable();
         if(find(active.begin(), active.end(), *i) == active.end())
-            active.push_back(*i);
+            activate(*i);
+    }
+    // hardware, which counts lazy, has to count traced values on every cycle
+    // and traced memory cells have to be accessed by RWMemoryMember
+    for(std::vector<AvrDevice*>::iterator d = devices.begin(); d != devices.end(); d++) {
+        (*d)->RescheduleAllHardware();
+        (*d)->UpdateDirectMem();
     }
     
     // check, if dumper exists in dumps list
@@ -660,19 +790,56 @@ void DumpManager::start() {
 
 }
 
+void DumpManager::Suspend(bool suspend) {
+    if(suspend) {
+        suspended++;
+        return;
+    }
+    if(suspended == 0 || --suspended > 0)
+        return;
+    // only changes are reported for the time, dumpers were suspended
+    for(TraceSet::iterator i = dirty.begin(); i != dirty.end(); i++)
+        (*i)->f &= TraceValue::CHANGE;
+}
+
 void DumpManager::cycle() {
+    if(suspended > 0)
+        return;
+
     // First, call the Dumpers
     for (size_t i=0; i<dumps.size(); i++)
         dumps[i]->cycle();
 
-    // And then, update the TraceValues and dump them
-    for (TraceSet::iterator i=active.begin();
-         i!=active.end(); i++) {
+    // And then, update the sampled TraceValues, other values are in dirty
+    // list, if they were accessed or their owner signaled a change
+    for (TraceSet::iterator i=sampled.begin();
+         i!=sampled.end(); i++) {
         (*i)->cycle();
+        if ((*i)->flags()) {
+            dirty.push_back(*i);
+        }
+    }
+    if (dirty.empty())
+        return;
+
+    // dump them in order of active list
+    if (dirty.size() > 1)
+        std::sort(dirty.begin(), dirty.end(),
+                  [](const TraceValue *a, const TraceValue *b) { return a->activeIndex < b->activeIndex; });
+    for (TraceSet::iterator i=dirty.begin();
+         i!=dirty.end(); i++) {
+        (*i)->inDirtyList = false;
+        // a shadowed variable, which was signaled, is compared now
+        if ((*i)->shadow != nullptr && (*i)->dirtyList != nullptr) {
+            (*i)->cycle();
+            if (!(*i)->flags())
+                continue;
+        }
         for (size_t j=0; j<dumps.size(); j++)
             if (dumps[j]->enabled(*i))
                 (*i)->dump(*dumps[j]);
     }
+    dirty.clear();
 }
 
 void DumpManager::stopApplication(void) {
@@ -765,28 +932,28 @@ TraceSet DumpManager::load(const std::string &istr) {
 TraceValue* trace_direct(TraceValueRegister *t, const std::string &name, const bool *val) {
     TraceValue *tv=new TraceValue(1, t->GetTraceValuePrefix() + name,
                                   -1, val);
-    t->RegisterTraceValue(tv);
+    t->RegisterDirectValue(tv);
     return tv;
 }
 
 TraceValue* trace_direct(TraceValueRegister *t, const std::string &name, const uint8_t*val) {
     TraceValue* tv=new TraceValue(8, t->GetTraceValuePrefix() + name,
                                   -1, val);
-    t->RegisterTraceValue(tv);
+    t->RegisterDirectValue(tv);
     return tv;
 }
 
 TraceValue* trace_direct(TraceValueRegister *t, const std::string &name, const uint16_t*val) {
     TraceValue* tv=new TraceValue(16, t->GetTraceValuePrefix() + name,
                                   -1, val);
-    t->RegisterTraceValue(tv);
+    t->RegisterDirectValue(tv);
     return tv;
 }
 
 TraceValue* trace_direct(TraceValueRegister *t, const std::string &name, const uint32_t*val) {
     TraceValue* tv=new TraceValue(32, t->GetTraceValuePrefix() + name,
                                   -1, val);
-    t->RegisterTraceValue(tv);
+    t->RegisterDirectValue(tv);
     return tv;
 }
 
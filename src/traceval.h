@@ -30,6 +30,12 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "systemclocktypes.h"
 
 /* TODO, notes:
 
@@ -97,7 +103,9 @@ class Dumper;
   it with the internal state. This does not allow to trace read and write
   accesses, but all state changes will still be represented in the output file.
   This is helpful for e.g. tracing the hidden shadow states in various
-  parts of the AVR hardware, such as the timer double buffers.
+  parts of the AVR hardware, such as the timer double buffers. The owner of
+  such a value signals by sample() (or TraceValueRegister::SampleDirectValues),
+  that the variable may have changed, then it's compared in the next cycle.
   */
 class TraceValue {
     
@@ -149,6 +157,11 @@ class TraceValue {
         void write(unsigned val);
         //! Log a read access
         void read();
+        //! Signals, that the shadowed variable may have changed
+        /*! The owner of a value of trace_direct calls this after changing the
+          variable, then it's compared with the saved value by cycle() in the
+          next DumpManager::cycle(). Does nothing, if the value isn't active. */
+        void sample() { markDirty(); }
         
     
         /*! Gives true if this value has been written at one point during the
@@ -169,17 +182,27 @@ class TraceValue {
         //! Gives the current set of flag readings
         Atype flags() const;
         
-        //! Called at least once for each cycle if this trace value is activated
+        //! Called at least once for each cycle if this trace value is activated and sampled
         /*! This may check for updates to an underlying referenced value etc.
           and update the flags accordingly. */
         virtual void cycle();
+
+        /*! Returns true, if changes can be found only by calling cycle() on
+          each cycle. Other values are dumped only in cycles, in which they
+          were accessed by write, change, read or sample. */
+        virtual bool sampled() const { return false; }
         
         /*! Dump the state or state change somewhere. This also resets the current
           flags. */
         virtual void dump(Dumper &d);
         
         /*! Give back VCD coding of a bit */
-        virtual char VcdBit(int bitNo) const;
+        char VcdBit(int bitNo) const { return VcdBitOf(bitNo, v, _written); }
+
+        /*! Give back VCD coding of a bit for a saved value and written state.
+          This must not access the current state, because it's also called by
+          the writer thread of DumpVCD. */
+        virtual char VcdBitOf(int bitNo, unsigned val, bool isWritten) const;
 
     protected:
         //! Clear all access flags
@@ -187,6 +210,16 @@ class TraceValue {
         friend class TraceKeeper;
         
     private:
+        friend class DumpManager;
+
+        //! Appends this value to dirtyList, if it isn't there
+        void markDirty() {
+            if(dirtyList != nullptr && !inDirtyList) {
+                inDirtyList = true;
+                dirtyList->push_back(this);
+            }
+        }
+
         std::string _name;
     
         int _index;
@@ -204,6 +237,13 @@ class TraceValue {
         /*! Initialized to zero upon creation and any logged write will make this
           true. */
         bool _written;
+
+        //! List of accessed values in DumpManager, if this value is active
+        std::vector<TraceValue*> *dirtyList;
+        //! True, if this value is in dirtyList
+        bool inDirtyList;
+        //! Position in the active list of DumpManager, gives the order for dumping
+        size_t activeIndex;
     
         //! Tracing of this value enabled at all?
         /*! Note that it must additionally be enabled in the particular
@@ -218,7 +258,7 @@ class TraceValueOutput: public TraceValue {
         TraceValueOutput(const std::string &_name): TraceValue(1, _name) {}
 
         /*! Give back VCD coding of pin output driver  */
-        char VcdBit(int bitNo) const override;
+        char VcdBitOf(int bitNo, unsigned val, bool isWritten) const override;
 
 };
 
@@ -281,7 +321,13 @@ class WarnUnknown : public Dumper {
         AvrDevice *core;
 };
 
-/*! Produces value change dump files. */
+/*! Produces value change dump files.
+
+  The simulation only appends changes as binary records to a ring buffer. A
+  writer thread formats them and writes the file. A time marker is written
+  only for cycles, in which something has changed. The writer sleeps, till
+  a batch of records is in the ring (or at most 100ms), the simulation
+  sleeps, if the ring is full, both wait on a condition variable. */
 class DumpVCD : public Dumper {
     
     public:
@@ -323,19 +369,50 @@ class DumpVCD : public Dumper {
         std::map<const TraceValue*, size_t> id2num;
         const std::string tscale;
         const bool rs, ws;
-        bool changesWritten;
         
         // list of signals marked last cycle
         std::vector<int> marked;
         std::ostream *os;
-    
-        // buffer for change data
-        std::stringstream osbuffer;
-        
-        void valout(const TraceValue *v);
-        
-        //! writes content of osbuffer to os and empty osbuffer afterwards
-        void flushbuffer(void);
+
+#ifndef SWIG
+        //! Kinds of change records
+        enum RecordKind { TIME, VALUE, STROBE_ON, STROBE_OFF };
+
+        //! A change, which is passed to the writer thread
+        struct Record {
+            SystemClockOffset time; //!< time for a TIME record
+            const TraceValue *value; //!< trace value for a VALUE record
+            unsigned id; //!< VCD id of the signal
+            unsigned val; //!< value for a VALUE record
+            unsigned char kind; //!< see RecordKind
+            bool written; //!< written state for a VALUE record
+        };
+
+        static const size_t ringSize = 1 << 15; //!< count of records in ring, power of 2
+        static const size_t ringBatch = ringSize / 8; //!< count of records, which wake up the writer thread
+        std::vector<Record> ring; //!< ring buffer from simulation to writer thread
+        std::atomic<size_t> ringHead; //!< next record to write, only changed by simulation
+        std::atomic<size_t> ringTail; //!< next record to read, only changed by writer thread
+        std::atomic<bool> stopWriter; //!< tells writer thread to end, if ring is empty
+        std::atomic<bool> writerWaiting; //!< writer thread waits on ringFilled
+        std::atomic<bool> producerWaiting; //!< simulation waits on ringFreed
+        std::mutex ringMutex; //!< guards the waits on ringFilled and ringFreed
+        std::condition_variable ringFilled; //!< notified, if a batch of records is in ring or on stop
+        std::condition_variable ringFreed; //!< notified, if records are taken from a full ring
+        std::thread writer; //!< formats records and writes them to os
+
+        SystemClockOffset cycleTime; //!< time of current cycle
+        bool timePending; //!< time marker of current cycle isn't in ring till now
+
+        //! Appends a record to ring, before the time marker, if not done for this cycle
+        void put(RecordKind kind, unsigned id, const TraceValue *t = nullptr);
+        //! Appends VCD text for a record to out
+        static void format(const Record &r, std::string &out);
+        //! Main loop of writer thread
+        void writerLoop(void);
+        //! Writes all records in ring and ends writer thread
+        void stopWriterThread(void);
+#endif
 };
 
 /*! Manages all active Dumper instances for a given AvrDevice.
@@ -344,10 +421,10 @@ class DumpVCD : public Dumper {
 class DumpManager {
     
     public:
-        //! Singleton class access.
+        //! Access to the instance of the current simulation context
         static DumpManager* Instance(void);
         
-        //! Reset DumpManager instance (e.g. delete available instance)
+        //! Reset DumpManager instance of the current simulation context (e.g. delete available instance)
         static void Reset(void);
 
         //! Tell DumpManager, that we have only one device
@@ -374,6 +451,15 @@ class DumpManager {
         /*! Process one AVR clock cycle. Must be done after the AVR did all
           processing so that changed values etc. can be collected. */
         void cycle();
+
+        //! Returns true, if there is at least one dumper, which needs cycle calls
+        bool HasDumpers(void) const { return !dumps.empty(); }
+
+        //! Suspends or resumes the dumpers, calls are counted
+        /*! While suspended, cycle does nothing and accesses are collected. On
+          resume only the changes are dumped, reads and writes while suspended
+          are dropped. Used by the trace scope of a core. */
+        void Suspend(bool suspend);
     
         //! Destroys the DumpManager instance and shut down all dumpers
         ~DumpManager() { stopApplication(); }
@@ -400,6 +486,7 @@ class DumpManager {
     private:
         friend class TraceValueRegister;
         friend class AvrDevice;
+        friend class SimulationContext;
         
         //! Private instance constructor
         DumpManager();
@@ -424,6 +511,13 @@ class DumpManager {
         
         //! Set of active tracing values
         TraceSet active;
+        //! Active values, which have to be sampled on every cycle
+        TraceSet sampled;
+        //! Active values, which were accessed in this cycle
+        TraceSet dirty;
+
+        //! Sets the position in active list and adds value to sampled or dirty
+        void activate(TraceValue *t);
         //! Set of all traceable values (placeholder instance for all() method)
         TraceSet _all;
         
@@ -433,8 +527,10 @@ class DumpManager {
         //! Device list
         std::vector<AvrDevice*> devices;
 
-        static int _devidx;
-        static DumpManager *_instance;
+        //! Count of devices, for which a device name was created
+        int _devidx;
+        //! Count of Suspend(true) calls without Suspend(false)
+        int suspended;
 };
 
 //! Build a register for TraceValue's
@@ -449,6 +545,7 @@ class TraceValueRegister {
         std::string _tvr_scopeprefix; //!< the prefix scope for a TraceValue name
         valmap_t _tvr_values; //!< the registered TraceValue's
         regmap_t _tvr_registers; //!< the sub-registers
+        std::vector<TraceValue*> _tvr_direct; //!< the registered TraceValue's with shadow
         
         //! Registers a TraceValueRegister for this register, build a hierarchy
         void _tvr_registerTraceValues(TraceValueRegister *r);
@@ -485,8 +582,16 @@ class TraceValueRegister {
         const std::string GetScopeName(void) { return _tvr_scopename; }
         //! Registers a TraceValue for this register
         void RegisterTraceValue(TraceValue *t);
+        //! Registers a TraceValue with shadow (see trace_direct) for this register
+        void RegisterDirectValue(TraceValue *t) { RegisterTraceValue(t); _tvr_direct.push_back(t); }
         //! Unregisters a TraceValue, remove it from register
         void UnregisterTraceValue(TraceValue *t);
+        //! Signals, that the variables of the values of trace_direct may have changed
+        /*! Calls sample() for all values with shadow, which are registered here */
+        void SampleDirectValues(void) {
+            for(size_t i = 0; i < _tvr_direct.size(); i++)
+                _tvr_direct[i]->sample();
+        }
         //! Get a here registered TraceValueRegister by it's name
         TraceValueRegister* GetScopeGroupByName(const std::string &name);
         //! Get a here registered TraceValue by it's name
@@ -534,7 +639,9 @@ class TraceValueCoreRegister: public TraceValueRegister {
 };
 
 //! Register a directly traced bool value
-/*! \return pointer to the new registered TraceValue */
+/*! The owner has to signal changes of the value by TraceValue::sample()
+  or TraceValueRegister::SampleDirectValues().
+  \return pointer to the new registered TraceValue */
 TraceValue *trace_direct(TraceValueRegister *t, const std::string &name, const bool *val);
 
 //! Register a directly traced byte value
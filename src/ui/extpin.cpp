@@ -68,7 +68,7 @@ void ExtPin::SetNewValueFromUi(const std::string& s) {
     //outState= tmp.GetOutState();
     outState= tmp.outState;
 
-    connectedTo->CalcNet();
+    connectedTo->PinChanged(this);
 }
 
 
@@ -147,7 +147,7 @@ void ExtPinButton::SetNewValueFromUi(const std::string& s) {
     //outState= tmp.GetOutState();
     outState= tmp.outState;
 
-    connectedTo->CalcNet();
+    connectedTo->PinChanged(this);
 }
 
 
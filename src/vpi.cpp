@@ -352,11 +352,11 @@ static PLI_INT32 avr_trace_tf(char *xx) {
     VPI_END();
     
     if (tracename.length()) {
-    sysConHandler.SetTraceFile(tracename.c_str(), 1000000);
+    GetSystemConsoleHandler().SetTraceFile(tracename.c_str(), 1000000);
     for (size_t i=0; i < devices.size(); i++)
         devices[i]->trace_on=1;
     } else {
-    sysConHandler.StopTrace();
+    GetSystemConsoleHandler().StopTrace();
     for (size_t i=0; i < devices.size(); i++)
         devices[i]->trace_on=0;
     }